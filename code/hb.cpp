@@ -1,3 +1,5 @@
+#include <stdio.h> // snprintf
+
 #include "hb_types.h"
 #include "hb_simd.h"
 #include "hb_intrinsic.h"
@@ -9,16 +11,36 @@
 #include "hb_entity.h"
 #include "hb_voxel.h"
 #include "hb_render_group.h"
+#include "hb_asset.h"
+#include "hb_texture.h"
+#include "hb_bvh.h"
+#include "hb_sampler.h"
+#include "hb_brdf.h"
+#include "hb_ray.h"
+#include "hb_denoiser.h"
+#include "hb_bake.h"
+#include "hb_kernel.h"
+#include "hb_progressive_raytracer.h"
 #include "hb.h"
 
+#include "hb_kernel.cpp"
 #include "hb_mesh_loader.cpp"
 #include "hb_voxel.cpp"
+#include "hb_voxel_ray.cpp"
+#include "hb_sampler.cpp"
+#include "hb_brdf.cpp"
 #include "hb_ray.cpp"
+#include "hb_bvh.cpp"
+#include "hb_progressive_raytracer.cpp"
+#include "hb_denoiser.cpp"
+#include "hb_bake.cpp"
 #include "hb_simulation.cpp"
 #include "hb_entity.cpp"
 #include "hb_terrain.cpp"
+#include "hb_font.cpp"
 #include "hb_render_group.cpp"
 #include "hb_image_loader.cpp"
+#include "hb_texture.cpp"
 
 /*
     TODO(joon)
@@ -31,25 +53,48 @@ GAME_UPDATE_AND_RENDER(update_and_render)
 {
     GameState *game_state = (GameState *)platform_memory->permanent_memory;
     VoxelWorld *world = &game_state->world;
+
+    if(!hot_kernels.name)
+    {
+        // NOTE(joon) This happens on every code reload
+        init_hot_kernels(&hot_kernels);
+    }
+
     if(!game_state->is_initialized)
     {
         // TODO(joon) entity arena?
         game_state->max_entity_count = 1024;
         game_state->entities = (Entity *)malloc(sizeof(Entity) * game_state->max_entity_count);
 
+        game_state->transient_arena = start_memory_arena(platform_memory->transient_memory, megabytes(256));
+
+        initialize_voxel_world(world);
         //PlatformReadFileResult vox_file = platform_api->read_file("/Volumes/hb/hb_renderer/data/vox/chr_knight.vox");
         PlatformReadFileResult vox_file = platform_api->read_file("/Volumes/hb/hb_renderer/data/vox/monu10.vox");
-        load_vox_result loaded_vox = load_vox(vox_file.memory, vox_file.size);
-        platform_api->free_file_memory(vox_file.memory);
+        if(vox_file.memory)
+        {
+            load_vox_result loaded_vox = load_vox(vox_file.memory, vox_file.size);
+            platform_api->free_file_memory(vox_file.memory);
 
-        //add_voxel_entity_from_vox_file(game_state, loaded_vox);
-        free_loaded_vox(&loaded_vox);
+            // NOTE(joon) right after the raytracer arena. The chunks are relative to the base of this arena, 
+            // so it should only have the voxels(see allocate_voxel_chunk_from_vox_file)
+            game_state->voxel_arena = start_memory_arena((u8 *)platform_memory->permanent_memory + sizeof(GameState) + megabytes(16) + megabytes(64), 
+                                                         get_max_voxel_memory_size(world, (u32)loaded_vox.voxel_count));
+            allocate_voxel_chunk_from_vox_file(world, &game_state->voxel_arena, &game_state->transient_arena, loaded_vox);
 
-        game_state->transient_arena = start_memory_arena(platform_memory->transient_memory, megabytes(256));
+            free_loaded_vox(&loaded_vox);
+            free(loaded_vox.colorIDs);
+            free(loaded_vox.palette);
+        }
 
         game_state->mass_agg_arena = start_memory_arena((u8 *)platform_memory->transient_memory + game_state->transient_arena.total_size, megabytes(256));
         //add_flat_triangle_mass_agg_entity(game_state, &game_state->mass_agg_arena, V3(1, 1, 1), 1.0f, 15.0f);
 
+        // NOTE(joon) right after the font arena
+        game_state->raytracer_arena = start_memory_arena((u8 *)platform_memory->permanent_memory + sizeof(GameState) + megabytes(16), megabytes(64));
+        init_raytracer_instance_world(&game_state->instance_world, &game_state->raytracer_arena, 16, game_state->max_entity_count);
+        game_state->cube_mesh_index = add_cube_raytracer_mesh(&game_state->instance_world, &game_state->raytracer_arena, &game_state->transient_arena);
+
         //add_room_entity(game_state, V3(0, 0, 0), V3(100.0f, 100.0f, 100.0f), V3(0.3f, 0.3f, 0.3f));
         // add_floor_entity(game_state, V3(0, 0, -0.5f), V3(100.0f, 100.0f, 1.0f), V3(0.8f, 0.1f, 0.1f));
 
@@ -76,6 +121,12 @@ GAME_UPDATE_AND_RENDER(update_and_render)
 
         game_state->random_series = start_random_series(123123);
 
+        // NOTE(joon) font file should stay loaded, as the glyph outlines are read directly from the file
+        game_state->font_arena = start_memory_arena((u8 *)platform_memory->permanent_memory + sizeof(GameState), megabytes(16));
+        PlatformReadFileResult font_file = platform_api->read_file("/Users/mekalopo/Library/Fonts/InputMonoCompressed-Light.ttf");
+        game_state->debug_font = load_otf(&game_state->font_arena, font_file);
+        init_glyph_atlas(&game_state->glyph_atlas, &game_state->font_arena, 1024, 1024);
+
         game_state->camera = init_camera(V3(-10, 0, 5), V3(0, 0, 0), 1.0f);
         
         game_state->is_initialized = true;
@@ -113,6 +164,9 @@ GAME_UPDATE_AND_RENDER(update_and_render)
         camera->p -= camera_speed*camera_dir;
     }
 
+    // NOTE(joon) whatever voxel is at the center of the screen, which shows up in the debug text
+    VoxelRayHit picked_voxel = ray_intersect_with_voxel_world(world, (u8 *)game_state->voxel_arena.base, camera->p, camera_dir, 0.0f, 1000.0f);
+
     /*
         NOTE(joon) How we are going to update the entities (without the friction)
         - move the entities, without thinking about the interpenetration
@@ -143,6 +197,8 @@ GAME_UPDATE_AND_RENDER(update_and_render)
                 if(is_entity_flag_set(entity, Entity_Flag_Movable))
                 {
                     move_mass_agg_entity(game_state, entity, platform_input->dt_per_frame, platform_input->space);
+
+                    update_mass_agg_bvh(entity->mass_agg_bvh, platform_api->work_queue);
                 }
             }break;
 
@@ -151,6 +207,9 @@ GAME_UPDATE_AND_RENDER(update_and_render)
                 RigidBody *rb = &entity->rb;
                 // NOTE(joon) Always should happen for all rigid bodies at the start of their update
                 init_rigid_body_and_calculate_derived_parameters_for_frame(rb);
+                // NOTE(joon) the transform is from the start of the frame, so the ray queries are one step behind the physics
+                set_raytracer_instance_transform(&game_state->instance_world, entity->raytracer_instance_index, 
+                                                 get_cube_entity_instance_transform(entity));
 
 #if 0
                 if(!compare_with_epsilon(rb->inv_mass, 0.0f))
@@ -183,6 +242,34 @@ GAME_UPDATE_AND_RENDER(update_and_render)
         }
     }
 
+    // NOTE(joon) only the top level has to be built again, as the cube mesh itself never changes
+    update_raytracer_instance_world(&game_state->instance_world, &game_state->transient_arena);
+
+    // NOTE(joon) whatever cube is at the center of the screen, which gets highlighted & shows up in the debug text
+    InstanceHit picked_instance = ray_intersect_with_instance_world(&game_state->instance_world, camera->p, camera_dir, 0.0f, 1000.0f);
+    u32 picked_entity_index = (picked_instance.hit_t >= 0.0f) ? picked_instance.user_index : U32_Max;
+
+    // NOTE(joon) same for the mass aggs, where the closest face out of all of them is picked
+    MassAggHit picked_mass_agg_face = {};
+    picked_mass_agg_face.hit_t = -1.0f;
+    u32 picked_mass_agg_entity_index = U32_Max;
+    for(u32 entity_index = 0;
+        entity_index < game_state->entity_count;
+        ++entity_index)
+    {
+        Entity *entity = game_state->entities + entity_index;
+        if(entity->type == Entity_Type_Mass_Agg && entity->mass_agg_bvh)
+        {
+            r32 max_t = (picked_mass_agg_face.hit_t >= 0.0f) ? picked_mass_agg_face.hit_t : 1000.0f;
+            MassAggHit hit = ray_intersect_with_mass_agg(entity->mass_agg_bvh, camera->p, camera_dir, 0.0f, max_t);
+            if(hit.hit_t >= 0.0f)
+            {
+                picked_mass_agg_face = hit;
+                picked_mass_agg_entity_index = entity_index;
+            }
+        }
+    }
+
     // NOTE(joon) rendering code start
     RenderGroup render_group = {};
     start_render_group(&render_group, platform_render_push_buffer, &game_state->camera, V3(0, 0, 0));
@@ -219,10 +306,32 @@ GAME_UPDATE_AND_RENDER(update_and_render)
 
             case Entity_Type_Cube:
             {
+                v3 color = (entity_index == picked_entity_index) ? V3(1, 1, 0) : entity->color;
                 // TODO(joon) collision volume independent rendering?
-                push_cube(&render_group, entity->rb.p + entity->cv.offset, entity->cv.half_dim, entity->color, entity->rb.orientation);
+                push_cube(&render_group, entity->rb.p + entity->cv.offset, entity->cv.half_dim, color, entity->rb.orientation);
             }break;
         }
     }
+
+    char debug_text[256] = {};
+    u32 debug_text_length = snprintf(debug_text, array_count(debug_text), "%.2fms/frame\n%u entities\n%s kernels", 
+                                     1000.0f*platform_input->dt_per_frame, game_state->entity_count, hot_kernels.name);
+    if(picked_voxel.hit_t >= 0.0f)
+    {
+        debug_text_length += snprintf(debug_text + debug_text_length, array_count(debug_text) - debug_text_length, "\nvoxel (%u, %u, %u) %.2fm away",
+                                      picked_voxel.voxel_x, picked_voxel.voxel_y, picked_voxel.voxel_z, picked_voxel.hit_t);
+    }
+    if(picked_instance.hit_t >= 0.0f)
+    {
+        debug_text_length += snprintf(debug_text + debug_text_length, array_count(debug_text) - debug_text_length, "\nentity %u %.2fm away",
+                                      picked_entity_index, picked_instance.hit_t);
+    }
+    if(picked_mass_agg_face.hit_t >= 0.0f)
+    {
+        debug_text_length += snprintf(debug_text + debug_text_length, array_count(debug_text) - debug_text_length, "\nentity %u face %u %.2fm away",
+                                      picked_mass_agg_entity_index, picked_mass_agg_face.face_index, picked_mass_agg_face.hit_t);
+    }
+    push_text(&render_group, &game_state->glyph_atlas, &game_state->debug_font, &game_state->transient_arena,
+              debug_text, V2(10, 10), 24, V3(1, 1, 1));
 }
 
@@ -22,6 +22,16 @@ struct GameState
 
     MemoryArena mass_agg_arena;
 
+    // NOTE(joon) for the ray queries against the entities, where each cube entity is an instance of the same cube mesh
+    MemoryArena raytracer_arena;
+    RaytracerInstanceWorld instance_world;
+    u32 cube_mesh_index;
+
+    // NOTE(joon) font & text related stuffs
+    MemoryArena font_arena;
+    font_info debug_font;
+    GlyphAtlas glyph_atlas;
+
     // TODO(joon) seed this properly
     RandomSeries random_series;
 };
@@ -7,6 +7,7 @@ enum AssetType
 
     AssetType_Mesh,
     AssetType_Voxel,
+    AssetType_Texture,
 
     AssetType_Count,
 };
@@ -59,5 +60,35 @@ struct GameAssets
     u32 slot_count;
 };
 
+// NOTE(joon) cooked texture file looks like this :
+// CookedTextureHeader | CookedTextureMip[mip_count] | mip data...
+// all offsets are relative to the start of the header, so that we can just
+// map the whole file and point inside it without any fixups.
+#define Cooked_Texture_Magic four_cc("HBTX")
+#define Cooked_Texture_Version 1
+
+#pragma pack(push, 1)
+struct CookedTextureHeader
+{
+    u32 magic; // should be Cooked_Texture_Magic
+    u32 version;
+
+    u32 format; // TextureFormat
+    u32 width;
+    u32 height;
+
+    u32 mip_count;
+};
+
+struct CookedTextureMip
+{
+    u32 width;
+    u32 height;
+
+    u32 offset; // from the start of the CookedTextureHeader
+    u32 size;
+};
+#pragma pack(pop)
+
 #endif
 
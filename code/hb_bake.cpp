@@ -0,0 +1,502 @@
+// NOTE(joon) Only for the values that the bake produces, so the denormals are flushed to 0 and the values that are too big are clamped
+internal u16
+encode_half_float(r32 value)
+{
+    u32 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    u32 sign = (bits >> 16) & 0x8000;
+    i32 exponent = (i32)((bits >> 23) & 0xff) - 127 + 15;
+    u32 mantissa = bits & 0x7fffff;
+
+    u32 result = sign;
+    if(exponent > 0)
+    {
+        // NOTE(joon) rounding can carry into the exponent, which is what we want
+        u32 magnitude = ((u32)exponent << 10) + ((mantissa + 0x1000) >> 13);
+        result |= minimum(magnitude, 0x7bff);
+    }
+
+    return (u16)result;
+}
+
+internal r32
+decode_half_float(u16 value)
+{
+    u32 sign = ((u32)value & 0x8000) << 16;
+    u32 exponent = ((u32)value >> 10) & 0x1f;
+    u32 mantissa = (u32)value & 0x3ff;
+
+    u32 bits = sign;
+    if(exponent != 0)
+    {
+        bits |= ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    r32 result = 0.0f;
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+internal i8
+encode_snorm8(r32 value)
+{
+    r32 scaled = 127.0f*clamp(-1.0f, value, 1.0f);
+    i8 result = (i8)((scaled >= 0.0f) ? (scaled + 0.5f) : (scaled - 0.5f));
+
+    return result;
+}
+
+internal BakedLighting
+pack_baked_lighting(LightingBakeResult *bake_result)
+{
+    BakedLighting result = {};
+
+    for(u32 channel = 0;
+            channel < 3;
+            ++channel)
+    {
+        r32 irradiance = maximum(bake_result->irradiance.e[channel], 0.0f);
+        result.irradiance[channel] = encode_half_float(irradiance);
+
+        v3 gradient = V3(bake_result->irradiance_gradient[0].e[channel],
+                         bake_result->irradiance_gradient[1].e[channel],
+                         bake_result->irradiance_gradient[2].e[channel]);
+
+        v3 directionality = V3(0, 0, 0);
+        if(irradiance > 0.0f)
+        {
+            directionality = (1.0f / (2.0f*irradiance))*gradient;
+
+            // NOTE(joon) can only go outside of the unit sphere because of the noise
+            r32 directionality_length = length(directionality);
+            if(directionality_length > 1.0f)
+            {
+                directionality = (1.0f / directionality_length)*directionality;
+            }
+        }
+
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            result.directionality[channel][axis] = encode_snorm8(directionality.e[axis]);
+        }
+    }
+
+    result.ambient_occlusion = (u8)(255.0f*clamp01(bake_result->ambient_occlusion) + 0.5f);
+
+    return result;
+}
+
+// NOTE(joon) linear rgb, normal should be normalized
+internal v3
+get_baked_irradiance(BakedLighting *lighting, v3 normal)
+{
+    v3 result = {};
+
+    for(u32 channel = 0;
+            channel < 3;
+            ++channel)
+    {
+        v3 directionality = (1.0f / 127.0f)*V3((r32)lighting->directionality[channel][0],
+                                               (r32)lighting->directionality[channel][1],
+                                               (r32)lighting->directionality[channel][2]);
+
+        r32 irradiance = decode_half_float(lighting->irradiance[channel]);
+        result.e[channel] = maximum(irradiance*(1.0f + 2.0f*dot(directionality, normal)), 0.0f);
+    }
+
+    return result;
+}
+
+// NOTE(joon) 1 when nothing is blocking the light
+internal r32
+get_baked_ambient_occlusion(BakedLighting *lighting)
+{
+    r32 result = lighting->ambient_occlusion / 255.0f;
+
+    return result;
+}
+
+internal LightingBakeSettings
+get_default_lighting_bake_settings(void)
+{
+    LightingBakeSettings result = {};
+    result.ray_per_sample_count = 128;
+    result.ao_distance = 2.0f;
+    result.sky_color = V3(0.6f, 0.7f, 0.8f);
+    result.seed = 1234;
+
+    return result;
+}
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_bake_lighting)
+{
+    LightingBakeBatch *batch = (LightingBakeBatch *)data;
+
+    hot_kernels.bake_lighting(batch);
+    for(u32 sample_index = 0;
+            sample_index < batch->sample_count;
+            ++sample_index)
+    {
+        batch->output[sample_index] = pack_baked_lighting(batch->results + sample_index);
+    }
+}
+
+/*
+   NOTE(joon) Splits the samples of the bake(which has everything except the sample count & the counter) into the batches,
+   and waits until all of them are done. batches should have at least Lighting_Bake_Max_Batch_Count of them.
+   queue can be 0, in which case all the batches are done on this thread.
+*/
+internal void
+run_lighting_bake(LightingBakeBatch *bake, u32 sample_count, LightingBakeBatch *batches, thread_work_queue *queue)
+{
+    // NOTE(joon) a bit more batches than the number of the threads would ever be, so that the threads are kept busy
+    u32 batch_sample_count = maximum((sample_count + Lighting_Bake_Max_Batch_Count - 1) / Lighting_Bake_Max_Batch_Count, 16);
+
+    u32 batch_count = 0;
+    for(u32 first_sample = 0;
+            first_sample < sample_count;
+            first_sample += batch_sample_count)
+    {
+        LightingBakeBatch *batch = batches + batch_count++;
+        assert(batch_count <= Lighting_Bake_Max_Batch_Count);
+
+        *batch = *bake;
+        batch->positions = bake->positions + first_sample;
+        batch->normals = bake->normals + first_sample;
+        batch->sample_count = minimum(batch_sample_count, sample_count - first_sample);
+        batch->first_sample_index = bake->first_sample_index + first_sample;
+        batch->results = bake->results + first_sample;
+        batch->output = bake->output + first_sample;
+
+        if(queue)
+        {
+            queue->add_thread_work_queue_item(queue, thread_work_callback_bake_lighting, batch);
+        }
+        else
+        {
+            thread_work_callback_bake_lighting(batch);
+        }
+    }
+
+    if(queue)
+    {
+        queue->complete_all_thread_work_queue_items(queue);
+    }
+}
+
+internal LightingBakeSettings
+get_valid_lighting_bake_settings(LightingBakeSettings settings)
+{
+    LightingBakeSettings result = settings;
+    result.ray_per_sample_count = 16*((maximum(settings.ray_per_sample_count, 1) + 15)/16);
+
+    return result;
+}
+
+/*
+   NOTE(joon) One BakedLighting per position of the mesh, which goes into mesh->baked_lighting.
+   The mesh needs the vertex normals(one per position), and should be already inside the raytracer world at the same place,
+   so that it can block its own light.
+*/
+internal void
+bake_mesh_lighting(RaytracerWorld *world, RawMesh *mesh, MemoryArena *arena, MemoryArena *transient_arena, thread_work_queue *queue,
+                   LightingBakeSettings settings)
+{
+    assert(mesh->normals && mesh->normal_count == mesh->position_count);
+
+    u32 vertex_count = mesh->position_count;
+    mesh->baked_lighting = push_array(arena, BakedLighting, vertex_count);
+
+    TempMemory bake_memory = start_temp_memory(transient_arena,
+                                               (2*sizeof(v3) + sizeof(LightingBakeResult))*vertex_count +
+                                               sizeof(LightingBakeBatch)*Lighting_Bake_Max_Batch_Count + 1, false);
+    v3 *positions = push_array(&bake_memory, v3, vertex_count);
+    v3 *normals = push_array(&bake_memory, v3, vertex_count);
+    LightingBakeResult *results = push_array(&bake_memory, LightingBakeResult, vertex_count);
+    LightingBakeBatch *batches = push_array(&bake_memory, LightingBakeBatch, Lighting_Bake_Max_Batch_Count);
+
+    for(u32 vertex_index = 0;
+            vertex_index < vertex_count;
+            ++vertex_index)
+    {
+        normals[vertex_index] = normalize(mesh->normals[vertex_index]);
+        // NOTE(joon) so that the rays don't hit the triangles that the vertex belongs to
+        positions[vertex_index] = mesh->positions[vertex_index] + 0.001f*normals[vertex_index];
+    }
+
+    LightingBakeBatch bake = {};
+    bake.raytracer_world = world;
+    bake.settings = get_valid_lighting_bake_settings(settings);
+    bake.positions = positions;
+    bake.normals = normals;
+    bake.results = results;
+    bake.output = mesh->baked_lighting;
+    run_lighting_bake(&bake, vertex_count, batches, queue);
+
+    end_temp_memory(&bake_memory);
+}
+
+/*
+   NOTE(joon) Key of the face inside the chunk, where the voxel part is the morton code of the voxel.
+   The voxels come out of the octree in the morton order(children of a node are in the xyz bit order),
+   so the faces end up being sorted without sorting them.
+*/
+internal u32
+get_baked_voxel_face_key(u32 x, u32 y, u32 z, u32 face_index)
+{
+    // NOTE(joon) chunk_dim is never bigger than 256, see bake_voxel_world_lighting
+    u32 morton_code = 0;
+    for(u32 bit = 0;
+            bit < 8;
+            ++bit)
+    {
+        morton_code |= (((x >> bit) & 1) << (3*bit)) |
+                       (((y >> bit) & 1) << (3*bit + 1)) |
+                       (((z >> bit) & 1) << (3*bit + 2));
+    }
+
+    u32 result = (morton_code << 3) | face_index;
+
+    return result;
+}
+
+// NOTE(joon) x, y, z are inside the chunk. Returns 0 if the face was not baked(i.e covered by another voxel)
+internal BakedLighting *
+get_baked_voxel_face_lighting(VoxelChunkHash *chunk, u32 x, u32 y, u32 z, u32 face_index)
+{
+    BakedLighting *result = 0;
+
+    u32 key = get_baked_voxel_face_key(x, y, z, face_index);
+    u32 first = 0;
+    u32 one_past_last = chunk->baked_face_count;
+    while(first < one_past_last)
+    {
+        u32 middle = first + (one_past_last - first)/2;
+        u32 middle_key = chunk->baked_face_keys[middle];
+        if(middle_key == key)
+        {
+            result = chunk->baked_face_lighting + middle;
+            break;
+        }
+        else if(middle_key < key)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            one_past_last = middle;
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) Goes through the children in the order of their bit index, so the voxels come out in the morton order
+internal void
+gather_voxels_inside_chunk(VoxelOctree *octree, u32 level, u32 handle, u32 x, u32 y, u32 z, u32 dim,
+                           u8 *xs, u8 *ys, u8 *zs, u32 *voxel_count)
+{
+    u32 child_mask = get_voxel_octree_child_mask(octree, level, handle);
+    u32 half_dim = dim/2;
+    for(u32 child_index = 0;
+            child_index < 8;
+            ++child_index)
+    {
+        if(child_mask & (1 << child_index))
+        {
+            u32 child_x = x + ((child_index & 1) ? half_dim : 0);
+            u32 child_y = y + ((child_index & 2) ? half_dim : 0);
+            u32 child_z = z + ((child_index & 4) ? half_dim : 0);
+
+            if(half_dim == 1)
+            {
+                xs[*voxel_count] = (u8)child_x;
+                ys[*voxel_count] = (u8)child_y;
+                zs[*voxel_count] = (u8)child_z;
+                (*voxel_count)++;
+            }
+            else
+            {
+                gather_voxels_inside_chunk(octree, level + 1, get_voxel_octree_child_handle(octree, level, handle, child_index),
+                                           child_x, child_y, child_z, half_dim, xs, ys, zs, voxel_count);
+            }
+        }
+    }
+}
+
+// NOTE(joon) How many faces get baked at once, which keeps the temp memory of a chunk small no matter how many voxels it has
+#define Voxel_Lighting_Bake_Block_Face_Count 16384
+
+/*
+   NOTE(joon) Bakes the faces of the voxels that are not covered by another voxel, including the ones in the neighbouring chunks.
+   Each face is baked at its center, and goes into the chunk(baked_face_keys & baked_face_lighting) that the voxel belongs to.
+*/
+internal void
+bake_voxel_world_lighting(VoxelWorld *world, u8 *voxel_memory, MemoryArena *arena, MemoryArena *transient_arena, thread_work_queue *queue,
+                          LightingBakeSettings settings)
+{
+    u32 chunk_dim = world->chunk_dim;
+    // NOTE(joon) decode_voxels only takes u8 coordinates
+    assert(chunk_dim <= 256);
+
+    settings = get_valid_lighting_bake_settings(settings);
+
+    // NOTE(joon) so that each face gets its own rays, even across the chunks
+    u32 first_sample_index = 0;
+    for(u32 hash_index = 0;
+            hash_index < array_count(world->chunk_hashes);
+            ++hash_index)
+    {
+        VoxelChunkHash *chunk = world->chunk_hashes + hash_index;
+        if(chunk->first_node_offset == Empty_Hash)
+        {
+            continue;
+        }
+        VoxelOctree octree = get_voxel_octree(world, voxel_memory, chunk);
+
+        u32 voxel_count = chunk->voxel_count;
+        if(voxel_count == 0)
+        {
+            continue;
+        }
+
+        u32 block_face_count = Voxel_Lighting_Bake_Block_Face_Count;
+        TempMemory bake_memory = start_temp_memory(transient_arena,
+                                                   (6*sizeof(u8) + sizeof(b32) + 1)*voxel_count +
+                                                   (2*sizeof(v3) + sizeof(LightingBakeResult))*block_face_count +
+                                                   sizeof(LightingBakeBatch)*Lighting_Bake_Max_Batch_Count + 1, false);
+        u8 *xs = push_array(&bake_memory, u8, voxel_count);
+        u8 *ys = push_array(&bake_memory, u8, voxel_count);
+        u8 *zs = push_array(&bake_memory, u8, voxel_count);
+        u8 *neighbor_xs = push_array(&bake_memory, u8, voxel_count);
+        u8 *neighbor_ys = push_array(&bake_memory, u8, voxel_count);
+        u8 *neighbor_zs = push_array(&bake_memory, u8, voxel_count);
+        b32 *neighbor_exists = push_array(&bake_memory, b32, voxel_count);
+        // NOTE(joon) bit i is set when the face i is not covered
+        u8 *open_face_masks = push_array(&bake_memory, u8, voxel_count);
+        v3 *positions = push_array(&bake_memory, v3, block_face_count);
+        v3 *normals = push_array(&bake_memory, v3, block_face_count);
+        LightingBakeResult *results = push_array(&bake_memory, LightingBakeResult, block_face_count);
+        LightingBakeBatch *batches = push_array(&bake_memory, LightingBakeBatch, Lighting_Bake_Max_Batch_Count);
+
+        u32 gathered_voxel_count = 0;
+        gather_voxels_inside_chunk(&octree, 0, octree.root_node_index, 0, 0, 0, chunk_dim, xs, ys, zs, &gathered_voxel_count);
+        assert(gathered_voxel_count == voxel_count);
+        zero_memory(open_face_masks, voxel_count);
+
+        u32 chunk_min[3] = {chunk->x*chunk_dim, chunk->y*chunk_dim, chunk->z*chunk_dim};
+        u32 face_count = 0;
+        for(u32 face_index = 0;
+                face_index < Voxel_Face_Count;
+                ++face_index)
+        {
+            u32 axis = face_index/2;
+            i32 step = (face_index & 1) ? -1 : 1;
+
+            // NOTE(joon) the neighbours inside the chunk are decoded all at once, and the rest are looked up one by one
+            for(u32 voxel_index = 0;
+                    voxel_index < voxel_count;
+                    ++voxel_index)
+            {
+                i32 neighbor[3] = {xs[voxel_index], ys[voxel_index], zs[voxel_index]};
+                neighbor[axis] += step;
+                b32 is_inside_chunk = (neighbor[axis] >= 0 && neighbor[axis] < (i32)chunk_dim);
+
+                neighbor_xs[voxel_index] = is_inside_chunk ? (u8)neighbor[0] : xs[voxel_index];
+                neighbor_ys[voxel_index] = is_inside_chunk ? (u8)neighbor[1] : ys[voxel_index];
+                neighbor_zs[voxel_index] = is_inside_chunk ? (u8)neighbor[2] : zs[voxel_index];
+            }
+            hot_kernels.decode_voxels(&octree, neighbor_xs, neighbor_ys, neighbor_zs, voxel_count, neighbor_exists);
+
+            for(u32 voxel_index = 0;
+                    voxel_index < voxel_count;
+                    ++voxel_index)
+            {
+                i32 neighbor[3] = {xs[voxel_index], ys[voxel_index], zs[voxel_index]};
+                neighbor[axis] += step;
+
+                b32 is_covered = neighbor_exists[voxel_index];
+                if(neighbor[axis] < 0 || neighbor[axis] >= (i32)chunk_dim)
+                {
+                    // NOTE(joon) -1 wraps around to a chunk that can never exist
+                    is_covered = does_voxel_exist(world, voxel_memory,
+                                                  chunk_min[0] + neighbor[0], chunk_min[1] + neighbor[1], chunk_min[2] + neighbor[2]);
+                }
+
+                if(!is_covered)
+                {
+                    open_face_masks[voxel_index] |= (1 << face_index);
+                    face_count++;
+                }
+            }
+        }
+
+        if(face_count)
+        {
+            chunk->baked_face_keys = push_array(arena, u32, face_count);
+            chunk->baked_face_lighting = push_array(arena, BakedLighting, face_count);
+            chunk->baked_face_count = face_count;
+
+            LightingBakeBatch bake = {};
+            bake.voxel_world = world;
+            bake.voxel_memory = voxel_memory;
+            bake.settings = settings;
+            bake.positions = positions;
+            bake.normals = normals;
+            bake.results = results;
+
+            // NOTE(joon) faces are baked block by block, in the same order as the keys
+            u32 baked_face_count = 0;
+            u32 block_first_face = 0;
+            for(u32 voxel_index = 0;
+                    voxel_index < voxel_count;
+                    ++voxel_index)
+            {
+                for(u32 face_index = 0;
+                        face_index < Voxel_Face_Count;
+                        ++face_index)
+                {
+                    if(open_face_masks[voxel_index] & (1 << face_index))
+                    {
+                        v3 normal = V3(0, 0, 0);
+                        normal.e[face_index/2] = (face_index & 1) ? -1.0f : 1.0f;
+
+                        v3 voxel_center = V3((r32)(chunk_min[0] + xs[voxel_index]) + 0.5f,
+                                             (r32)(chunk_min[1] + ys[voxel_index]) + 0.5f,
+                                             (r32)(chunk_min[2] + zs[voxel_index]) + 0.5f);
+
+                        u32 block_face_index = baked_face_count - block_first_face;
+                        // NOTE(joon) a bit off the face, so that the rays don't start inside the voxel
+                        positions[block_face_index] = world->voxel_dim*(voxel_center + 0.501f*normal);
+                        normals[block_face_index] = normal;
+
+                        chunk->baked_face_keys[baked_face_count] = get_baked_voxel_face_key(xs[voxel_index], ys[voxel_index], zs[voxel_index],
+                                                                                            face_index);
+                        baked_face_count++;
+                    }
+                }
+
+                // NOTE(joon) a voxel can only add 6 faces, so the block can not overflow
+                if(baked_face_count - block_first_face > block_face_count - Voxel_Face_Count ||
+                   voxel_index == voxel_count - 1)
+                {
+                    bake.first_sample_index = first_sample_index + block_first_face;
+                    bake.output = chunk->baked_face_lighting + block_first_face;
+                    run_lighting_bake(&bake, baked_face_count - block_first_face, batches, queue);
+
+                    block_first_face = baked_face_count;
+                }
+            }
+            assert(baked_face_count == face_count);
+
+            first_sample_index += face_count;
+        }
+
+        end_temp_memory(&bake_memory);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef HB_BAKE_H
+#define HB_BAKE_H
+
+/*
+   NOTE(joon) Baked lighting for the rasterized meshes & voxels, so that they don't have to be flat colored.
+   Each sample(a vertex of a mesh, or a voxel face that is not covered) shoots rays over the hemisphere around its normal
+   with the simd ray kernels(see bake_lighting in hb_kernel_isa.cpp), and gets
+   - ambient occlusion : cosine weighted fraction of the rays that didn't hit anything within ao_distance
+   - irradiance : L0 & L1 spherical harmonics of the incoming light, already convolved with the cosine lobe.
+                  The light only comes from the sky & the emissive surfaces, there is no interreflection.
+   The bake is done once(i.e after loading), so that the runtime only needs to unpack it(see get_baked_irradiance).
+*/
+
+/*
+   NOTE(joon) 16 bytes per sample. Irradiance for the normal n is irradiance*(1 + 2*dot(directionality, n)) per channel,
+   where the directionality never goes outside of the unit sphere as long as the incoming light is not negative.
+*/
+struct BakedLighting
+{
+    // NOTE(joon) half floats, linear rgb
+    u16 irradiance[3];
+    // NOTE(joon) snorm8 xyz, one per channel
+    i8 directionality[3][3];
+    // NOTE(joon) unorm8, 255 when nothing is blocking the light
+    u8 ambient_occlusion;
+};
+
+// NOTE(joon) What the kernel gives back for each sample, before it gets packed into BakedLighting.
+// Irradiance for the normal n is irradiance + n.x*irradiance_gradient[0] + n.y*irradiance_gradient[1] + n.z*irradiance_gradient[2]
+struct LightingBakeResult
+{
+    v3 irradiance;
+    v3 irradiance_gradient[3];
+    r32 ambient_occlusion;
+};
+
+struct LightingBakeSettings
+{
+    // NOTE(joon) rounded up to a multiple of 16, so that every kernel shoots the same rays no matter the lane width
+    u32 ray_per_sample_count;
+    // NOTE(joon) in meters, the rays that hit something further than this still count as not occluded
+    r32 ao_distance;
+    // NOTE(joon) radiance of the rays that didn't hit any voxel. The raytracer world uses the emit color of material 0 instead
+    v3 sky_color;
+    u32 seed;
+};
+
+/*
+   NOTE(joon) One job of the bake, which should only have one of the raytracer world or the voxel world.
+   The positions should be already pushed a bit off the surface, along the normal.
+*/
+struct LightingBakeBatch
+{
+    RaytracerWorld *raytracer_world;
+
+    VoxelWorld *voxel_world;
+    u8 *voxel_memory;
+
+    LightingBakeSettings settings;
+
+    v3 *positions;
+    v3 *normals;
+    u32 sample_count;
+    // NOTE(joon) index of the first sample inside the whole bake, so that the samples get the same rays no matter which batch they are in
+    u32 first_sample_index;
+
+    // NOTE(joon) sample_count of them, the kernel fills up the results and the job packs them into the output
+    LightingBakeResult *results;
+    BakedLighting *output;
+};
+
+// NOTE(joon) All the batches can be in the work queue at the same time, so this should be less than the size of the queue
+#define Lighting_Bake_Max_Batch_Count 256
+
+// NOTE(joon) +x, -x, +y, -y, +z, -z
+#define Voxel_Face_Count 6
+
+#endif
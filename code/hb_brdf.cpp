@@ -0,0 +1,392 @@
+/*
+   NOTE(joon) Polynomial approximation of atan over [0, 1], and the rest of the range is folded into it.
+   The error is about 1e-5 radians, and the relative error stays the same for the small angles,
+   which matters for theta_h as the first few samples of the merl table are less than 0.01 degree apart.
+   Returns 0 when both x & y are 0.
+*/
+force_inline simd_f32
+atan2_approx(simd_f32 y, simd_f32 x)
+{
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+
+    simd_f32 abs_x = max(x, -x);
+    simd_f32 abs_y = max(y, -y);
+    simd_f32 ratio = min(abs_x, abs_y) / max(max(abs_x, abs_y), simd_f32_(Flt_Min));
+    simd_f32 ratio_square = ratio*ratio;
+
+    simd_f32 result = simd_f32_(-0.01172120f);
+    result = result*ratio_square + simd_f32_(0.05265332f);
+    result = result*ratio_square + simd_f32_(-0.11643287f);
+    result = result*ratio_square + simd_f32_(0.19354346f);
+    result = result*ratio_square + simd_f32_(-0.33262347f);
+    result = result*ratio_square + simd_f32_(0.99997726f);
+    result = result*ratio;
+
+    result = overwrite(result, compare_greater(abs_y, abs_x), simd_f32_(half_pi_32) - result);
+    result = overwrite(result, compare_less(x, simd_f32_0), simd_f32_(pi_32) - result);
+    result = overwrite(result, compare_less(y, simd_f32_0), -result);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Returns f of the brdf(not multiplied by the cos), and 0 for the lanes that are not active
+   or where either of the directions is below the surface.
+   Both directions point away from the surface, and everything should be normalized.
+*/
+internal simd_v3
+get_merl_brdf_value(MerlBrdf *brdf, simd_v3 normal, simd_v3 outgoing_dir, simd_v3 incoming_dir, simd_u32 is_lane_active_mask)
+{
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+    simd_v3 result = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+
+    simd_f32 cos_o = dot(normal, outgoing_dir);
+    simd_f32 cos_i = dot(normal, incoming_dir);
+    simd_u32 mask = is_lane_active_mask & compare_greater(cos_o, simd_f32_0) & compare_greater(cos_i, simd_f32_0);
+    if(!all_lanes_zero(mask))
+    {
+        simd_v3 half = normalize(outgoing_dir + incoming_dir);
+        simd_f32 cos_h = dot(normal, half);
+        simd_f32 cos_d = dot(incoming_dir, half);
+        simd_v3 normal_cross_half = cross(normal, half);
+
+        // NOTE(joon) atan2 of the sin & cos instead of acos, as the cos of the small theta_h are too close to 1 for r32
+        simd_f32 theta_h = atan2_approx(length(normal_cross_half), cos_h);
+        simd_f32 theta_d = atan2_approx(length(cross(incoming_dir, half)), cos_d);
+
+        // NOTE(joon) The difference frame has half as z, normal x half as y, and (cos_h*half - normal) as x.
+        // Both x & y are sin_h long, which cancels out inside the atan2
+        simd_f32 phi_d = atan2_approx(dot(incoming_dir, normal_cross_half), cos_d*cos_h - cos_i);
+        phi_d = overwrite(phi_d, compare_less(phi_d, simd_f32_0), phi_d + simd_f32_(pi_32));
+
+        // NOTE(joon) continuous index into the table, and the inactive lanes look up the first sample
+        // so that the gather never goes outside of the table
+        simd_f32 max_h = simd_f32_((r32)(Merl_Brdf_Theta_H_Count - 1));
+        simd_f32 max_d = simd_f32_((r32)(Merl_Brdf_Theta_D_Count - 1));
+        simd_f32 phi_d_count = simd_f32_((r32)Merl_Brdf_Phi_D_Count);
+        simd_f32 h = min(simd_f32_((r32)Merl_Brdf_Theta_H_Count)*sqrt(max(theta_h, simd_f32_0)*simd_f32_(1.0f/half_pi_32)), max_h);
+        simd_f32 d = min(simd_f32_((r32)Merl_Brdf_Theta_D_Count)*theta_d*simd_f32_(1.0f/half_pi_32), max_d);
+        simd_f32 p = phi_d_count*phi_d*simd_f32_(1.0f/pi_32);
+        p = overwrite(p, compare_greater_equal(p, phi_d_count), p - phi_d_count);
+
+        h = overwrite(simd_f32_0, mask, h);
+        d = overwrite(simd_f32_0, mask, d);
+        p = overwrite(simd_f32_0, mask, p);
+
+        simd_f32 h0 = convert_f32_from_u32(convert_u32_from_f32(h));
+        simd_f32 d0 = convert_f32_from_u32(convert_u32_from_f32(d));
+        simd_f32 p0 = convert_f32_from_u32(convert_u32_from_f32(p));
+        simd_f32 h1 = min(h0 + simd_f32_1, max_h);
+        simd_f32 d1 = min(d0 + simd_f32_1, max_d);
+        // NOTE(joon) phi_d wraps around
+        simd_f32 p1 = p0 + simd_f32_1;
+        p1 = overwrite(p1, compare_greater_equal(p1, phi_d_count), simd_f32_0);
+
+        simd_f32 h_t = h - h0;
+        simd_f32 d_t = d - d0;
+        simd_f32 p_t = p - p0;
+
+        simd_u32 h_stride = simd_u32_(Merl_Brdf_Theta_D_Count*Merl_Brdf_Phi_D_Count);
+        simd_u32 d_stride = simd_u32_(Merl_Brdf_Phi_D_Count);
+        simd_u32 h_indices[2] = {h_stride*convert_u32_from_f32(h0), h_stride*convert_u32_from_f32(h1)};
+        simd_u32 d_indices[2] = {d_stride*convert_u32_from_f32(d0), d_stride*convert_u32_from_f32(d1)};
+        simd_u32 p_indices[2] = {convert_u32_from_f32(p0), convert_u32_from_f32(p1)};
+        simd_f32 h_weights[2] = {simd_f32_1 - h_t, h_t};
+        simd_f32 d_weights[2] = {simd_f32_1 - d_t, d_t};
+        simd_f32 p_weights[2] = {simd_f32_1 - p_t, p_t};
+
+        r32 *r_table = brdf->table;
+        r32 *g_table = brdf->table + Merl_Brdf_Channel_Size;
+        r32 *b_table = brdf->table + 2*Merl_Brdf_Channel_Size;
+
+        // NOTE(joon) trilinear interpolation between the 8 samples around the index
+        for(u32 corner_index = 0;
+                corner_index < 8;
+                ++corner_index)
+        {
+            u32 h_corner = (corner_index >> 2) & 1;
+            u32 d_corner = (corner_index >> 1) & 1;
+            u32 p_corner = corner_index & 1;
+
+            simd_u32 index = h_indices[h_corner] + d_indices[d_corner] + p_indices[p_corner];
+            simd_f32 weight = h_weights[h_corner]*d_weights[d_corner]*p_weights[p_corner];
+
+            simd_v3 value = simd_v3_(gather(r_table, index), gather(g_table, index), gather(b_table, index));
+            result = result + weight*value;
+        }
+
+        result = overwrite(simd_v3_(V3(0.0f, 0.0f, 0.0f)), mask, result);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) table should be the one from load_merl_brdf, which has to stay alive as long as the brdf does.
+   Fills the cdfs for the importance sampling, see MerlBrdf.
+*/
+internal void
+build_merl_brdf(MerlBrdf *brdf, r32 *table, MemoryArena *arena)
+{
+    u32 marginal_cdf_size = Merl_Brdf_Sample_Theta_I_Count + 1;
+    u32 conditional_cdf_size = Merl_Brdf_Sample_Phi_Count + 1;
+
+    brdf->table = table;
+    brdf->marginal_cdfs = push_array(arena, r32, Merl_Brdf_Sample_Theta_O_Count*marginal_cdf_size);
+    brdf->conditional_cdfs = push_array(arena, r32, Merl_Brdf_Sample_Theta_O_Count*Merl_Brdf_Sample_Theta_I_Count*conditional_cdf_size);
+
+    r32 theta_o_bin_size = half_pi_32 / Merl_Brdf_Sample_Theta_O_Count;
+    r32 theta_i_bin_size = half_pi_32 / Merl_Brdf_Sample_Theta_I_Count;
+    r32 phi_bin_size = pi_32 / Merl_Brdf_Sample_Phi_Count;
+
+    simd_v3 normal = simd_v3_(V3(0.0f, 0.0f, 1.0f));
+    simd_v3 luminance_weight = simd_v3_(V3(0.2126f, 0.7152f, 0.0722f));
+
+    for(u32 theta_o_index = 0;
+            theta_o_index < Merl_Brdf_Sample_Theta_O_Count;
+            ++theta_o_index)
+    {
+        r32 theta_o = (theta_o_index + 0.5f)*theta_o_bin_size;
+        simd_v3 outgoing_dir = simd_v3_(V3(sinf(theta_o), 0.0f, cosf(theta_o)));
+
+        r32 *marginal_cdf = brdf->marginal_cdfs + theta_o_index*marginal_cdf_size;
+        r32 *conditional_cdfs = brdf->conditional_cdfs + theta_o_index*Merl_Brdf_Sample_Theta_I_Count*conditional_cdf_size;
+
+        // NOTE(joon) First, the weight of each cell goes into the slot of the cdf that will end up having it
+        r32 total_weight = 0.0f;
+        for(u32 theta_i_index = 0;
+                theta_i_index < Merl_Brdf_Sample_Theta_I_Count;
+                ++theta_i_index)
+        {
+            r32 *conditional_cdf = conditional_cdfs + theta_i_index*conditional_cdf_size;
+            for(u32 phi_index = 0;
+                    phi_index < Merl_Brdf_Sample_Phi_Count;
+                    phi_index += HB_LANE_WIDTH)
+            {
+                simd_f32 weight = simd_f32_(0.0f);
+
+                // NOTE(joon) 2x2 samples per cell, so that a narrow specular peak is not missed as easily
+                for(u32 sub_index = 0;
+                        sub_index < 4;
+                        ++sub_index)
+                {
+                    r32 theta_i = (theta_i_index + 0.25f + 0.5f*(sub_index & 1))*theta_i_bin_size;
+                    r32 sin_i = sinf(theta_i);
+                    r32 cos_i = cosf(theta_i);
+
+                    r32 incoming_x[HB_LANE_WIDTH];
+                    r32 incoming_y[HB_LANE_WIDTH];
+                    r32 incoming_z[HB_LANE_WIDTH];
+                    for(u32 lane = 0;
+                            lane < HB_LANE_WIDTH;
+                            ++lane)
+                    {
+                        r32 phi = (phi_index + lane + 0.25f + 0.5f*(sub_index >> 1))*phi_bin_size;
+                        incoming_x[lane] = sin_i*cosf(phi);
+                        incoming_y[lane] = sin_i*sinf(phi);
+                        incoming_z[lane] = cos_i;
+                    }
+
+                    simd_v3 value = get_merl_brdf_value(brdf, normal, outgoing_dir, simd_v3_load(incoming_x, incoming_y, incoming_z), simd_u32_(U32_Max));
+                    // NOTE(joon) The cells are uniform in theta & phi instead of the solid angle, hence the sin.
+                    weight += simd_f32_(0.25f*cos_i*sin_i)*dot(value, luminance_weight);
+                }
+
+                simd_f32_store(conditional_cdf + 1 + phi_index, weight);
+            }
+
+            for(u32 phi_index = 0;
+                    phi_index < Merl_Brdf_Sample_Phi_Count;
+                    ++phi_index)
+            {
+                total_weight += conditional_cdf[phi_index + 1];
+            }
+        }
+
+        // NOTE(joon) Every cell gets at least 1% of the average weight, so that the directions that the brdf has
+        // but the cells missed can still be sampled. If the whole row is black, this becomes uniform
+        r32 min_weight = 0.01f*total_weight / (Merl_Brdf_Sample_Theta_I_Count*Merl_Brdf_Sample_Phi_Count);
+        if(total_weight == 0.0f)
+        {
+            min_weight = 1.0f;
+        }
+
+        marginal_cdf[0] = 0.0f;
+        for(u32 theta_i_index = 0;
+                theta_i_index < Merl_Brdf_Sample_Theta_I_Count;
+                ++theta_i_index)
+        {
+            r32 *conditional_cdf = conditional_cdfs + theta_i_index*conditional_cdf_size;
+
+            conditional_cdf[0] = 0.0f;
+            for(u32 phi_index = 0;
+                    phi_index < Merl_Brdf_Sample_Phi_Count;
+                    ++phi_index)
+            {
+                conditional_cdf[phi_index + 1] = conditional_cdf[phi_index] + conditional_cdf[phi_index + 1] + min_weight;
+            }
+
+            r32 row_weight = conditional_cdf[Merl_Brdf_Sample_Phi_Count];
+            for(u32 phi_index = 1;
+                    phi_index < Merl_Brdf_Sample_Phi_Count;
+                    ++phi_index)
+            {
+                conditional_cdf[phi_index] /= row_weight;
+            }
+            conditional_cdf[Merl_Brdf_Sample_Phi_Count] = 1.0f;
+
+            marginal_cdf[theta_i_index + 1] = marginal_cdf[theta_i_index] + row_weight;
+        }
+
+        r32 theta_o_weight = marginal_cdf[Merl_Brdf_Sample_Theta_I_Count];
+        for(u32 theta_i_index = 1;
+                theta_i_index < Merl_Brdf_Sample_Theta_I_Count;
+                ++theta_i_index)
+        {
+            marginal_cdf[theta_i_index] /= theta_o_weight;
+        }
+        marginal_cdf[Merl_Brdf_Sample_Theta_I_Count] = 1.0f;
+    }
+}
+
+// NOTE(joon) binary search for the interval of the cdf(count + 1 values) that u falls into
+internal u32
+find_cdf_interval(r32 *cdf, u32 count, r32 u)
+{
+    u32 min = 0;
+    u32 max = count - 1;
+    while(min < max)
+    {
+        u32 mid = (min + max + 1) / 2;
+        if(cdf[mid] <= u)
+        {
+            min = mid;
+        }
+        else
+        {
+            max = mid - 1;
+        }
+    }
+
+    u32 result = min;
+
+    return result;
+}
+
+// NOTE(joon) The cdfs are built for the theta_o at the center of each bin,
+// so this picks the bin that the outgoing direction falls into.
+internal u32
+get_merl_brdf_theta_o_index(r32 theta_o)
+{
+    u32 result = minimum((u32)(theta_o / (half_pi_32 / Merl_Brdf_Sample_Theta_O_Count)), (u32)(Merl_Brdf_Sample_Theta_O_Count - 1));
+
+    return result;
+}
+
+// NOTE(joon) pdf of a direction in solid angle, given the cell it falls into.
+// Each cell covers both sides of phi, hence the 2
+internal r32
+get_merl_brdf_cell_pdf(MerlBrdf *brdf, u32 theta_o_index, u32 theta_i_index, u32 phi_index, r32 sin_i)
+{
+    r32 result = 0.0f;
+
+    if(sin_i > 0.0f)
+    {
+        r32 *marginal_cdf = brdf->marginal_cdfs + theta_o_index*(Merl_Brdf_Sample_Theta_I_Count + 1);
+        r32 *conditional_cdf = brdf->conditional_cdfs +
+                               (theta_o_index*Merl_Brdf_Sample_Theta_I_Count + theta_i_index)*(Merl_Brdf_Sample_Phi_Count + 1);
+
+        r32 cell_probability = (marginal_cdf[theta_i_index + 1] - marginal_cdf[theta_i_index]) *
+                               (conditional_cdf[phi_index + 1] - conditional_cdf[phi_index]);
+        r32 cell_size = 2.0f*(half_pi_32 / Merl_Brdf_Sample_Theta_I_Count)*(pi_32 / Merl_Brdf_Sample_Phi_Count);
+
+        result = cell_probability / (cell_size*sin_i);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Picks the incoming direction in proportion to the tabulated f * cos, using 4 random numbers between 0 & 1.
+   This is per lane, as the binary searches don't map well to simd.
+*/
+internal MerlBrdfSample
+sample_merl_brdf(MerlBrdf *brdf, v3 normal, v3 outgoing_dir, r32 u0, r32 u1, r32 u2, r32 u3)
+{
+    MerlBrdfSample result = {};
+
+    r32 cos_o = dot(normal, outgoing_dir);
+    if(cos_o > 0.0f)
+    {
+        // NOTE(joon) phi starts from the outgoing direction projected onto the surface,
+        // and if there is no such direction the brdf is the same for any phi anyway
+        v3 tangent = outgoing_dir - cos_o*normal;
+        r32 sin_o = length(tangent);
+        if(sin_o > 0.00001f)
+        {
+            tangent /= sin_o;
+        }
+        else
+        {
+            tangent = normalize(cross(normal, (normal.x*normal.x < 0.5f) ? V3(1.0f, 0.0f, 0.0f) : V3(0.0f, 1.0f, 0.0f)));
+        }
+        v3 bitangent = cross(normal, tangent);
+
+        u32 theta_o_index = get_merl_brdf_theta_o_index(atan2f(sin_o, cos_o));
+        r32 *marginal_cdf = brdf->marginal_cdfs + theta_o_index*(Merl_Brdf_Sample_Theta_I_Count + 1);
+        u32 theta_i_index = find_cdf_interval(marginal_cdf, Merl_Brdf_Sample_Theta_I_Count, u0);
+
+        r32 *conditional_cdf = brdf->conditional_cdfs +
+                               (theta_o_index*Merl_Brdf_Sample_Theta_I_Count + theta_i_index)*(Merl_Brdf_Sample_Phi_Count + 1);
+        u32 phi_index = find_cdf_interval(conditional_cdf, Merl_Brdf_Sample_Phi_Count, u1);
+
+        // NOTE(joon) uniform inside the cell, and half of u3 picks the side of phi
+        r32 theta_i = (theta_i_index + u2)*(half_pi_32 / Merl_Brdf_Sample_Theta_I_Count);
+        r32 phi_t = 2.0f*u3;
+        r32 phi_sign = 1.0f;
+        if(phi_t >= 1.0f)
+        {
+            phi_t -= 1.0f;
+            phi_sign = -1.0f;
+        }
+        r32 phi = phi_sign*(phi_index + phi_t)*(pi_32 / Merl_Brdf_Sample_Phi_Count);
+
+        r32 sin_i = sinf(theta_i);
+        result.incoming_dir = sin_i*(cosf(phi)*tangent + sinf(phi)*bitangent) + cosf(theta_i)*normal;
+        result.pdf = get_merl_brdf_cell_pdf(brdf, theta_o_index, theta_i_index, phi_index, sin_i);
+    }
+
+    return result;
+}
+
+// NOTE(joon) pdf of sample_merl_brdf picking the incoming direction, in solid angle
+internal r32
+get_merl_brdf_pdf(MerlBrdf *brdf, v3 normal, v3 outgoing_dir, v3 incoming_dir)
+{
+    r32 result = 0.0f;
+
+    r32 cos_o = dot(normal, outgoing_dir);
+    r32 cos_i = dot(normal, incoming_dir);
+    if(cos_o > 0.0f && cos_i > 0.0f)
+    {
+        v3 outgoing_tangent = outgoing_dir - cos_o*normal;
+        v3 incoming_tangent = incoming_dir - cos_i*normal;
+        r32 sin_o = length(outgoing_tangent);
+        r32 sin_i = length(incoming_tangent);
+
+        r32 phi = 0.0f;
+        if(sin_o > 0.00001f && sin_i > 0.00001f)
+        {
+            phi = acosf(clamp(-1.0f, dot(outgoing_tangent, incoming_tangent) / (sin_o*sin_i), 1.0f));
+        }
+
+        u32 theta_o_index = get_merl_brdf_theta_o_index(atan2f(sin_o, cos_o));
+        u32 theta_i_index = minimum((u32)(atan2f(sin_i, cos_i) / (half_pi_32 / Merl_Brdf_Sample_Theta_I_Count)), (u32)(Merl_Brdf_Sample_Theta_I_Count - 1));
+        u32 phi_index = minimum((u32)(phi / (pi_32 / Merl_Brdf_Sample_Phi_Count)), (u32)(Merl_Brdf_Sample_Phi_Count - 1));
+
+        result = get_merl_brdf_cell_pdf(brdf, theta_o_index, theta_i_index, phi_index, sin_i);
+    }
+
+    return result;
+}
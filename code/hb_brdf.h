@@ -0,0 +1,49 @@
+#ifndef HB_BRDF_H
+#define HB_BRDF_H
+
+/*
+    NOTE(joon) Measured isotropic brdf from the MERL database(Matusik et al. 2003), see load_merl_brdf.
+    Instead of the incoming & outgoing directions, the table is indexed with the angles of the half vector & the incoming direction
+    around the half vector(Rusinkiewicz 1998), so that the specular peak always falls into the same part of the table.
+    - theta_h : Merl_Brdf_Theta_H_Count samples over [0, pi/2], where sample i is at (i/90)^2 * pi/2
+                so that most of them are near the specular peak
+    - theta_d : Merl_Brdf_Theta_D_Count samples over [0, pi/2]
+    - phi_d : Merl_Brdf_Phi_D_Count samples over [0, pi), as the brdf is the same for phi_d & phi_d + pi
+    The values are trilinearly interpolated between the samples, see get_merl_brdf_value.
+
+    The table alone cannot be sampled directly, so build_merl_brdf also tabulates f * cos of the incoming direction
+    for Merl_Brdf_Sample_Theta_O_Count outgoing angles, as a piecewise constant distribution over
+    the incoming angle(theta_i) & the angle between the incoming & outgoing directions around the normal(phi).
+    Each outgoing angle gets a marginal cdf over theta_i, and each theta_i of it gets a conditional cdf over phi.
+    phi only goes from 0 to pi as the brdf is symmetric, and the sample picks either side with the same chance.
+*/
+#define Merl_Brdf_Theta_H_Count 90
+#define Merl_Brdf_Theta_D_Count 90
+#define Merl_Brdf_Phi_D_Count 180
+// NOTE(joon) number of values per channel
+#define Merl_Brdf_Channel_Size (Merl_Brdf_Theta_H_Count*Merl_Brdf_Theta_D_Count*Merl_Brdf_Phi_D_Count)
+
+#define Merl_Brdf_Sample_Theta_O_Count 32
+#define Merl_Brdf_Sample_Theta_I_Count 64
+// NOTE(joon) should be a multiple of the widest lane width(16), as build_merl_brdf fills a row of phi at once
+#define Merl_Brdf_Sample_Phi_Count 32
+
+struct MerlBrdf
+{
+    // NOTE(joon) r, g, b planes of Merl_Brdf_Channel_Size each, already scaled(see load_merl_brdf)
+    r32 *table;
+
+    // NOTE(joon) Merl_Brdf_Sample_Theta_I_Count + 1 values per theta_o, starting from 0 and ending with 1
+    r32 *marginal_cdfs;
+    // NOTE(joon) Merl_Brdf_Sample_Phi_Count + 1 values per theta_o per theta_i
+    r32 *conditional_cdfs;
+};
+
+struct MerlBrdfSample
+{
+    v3 incoming_dir;
+    // NOTE(joon) in solid angle, 0 if the sample is not usable(i.e the outgoing direction was below the surface)
+    r32 pdf;
+};
+
+#endif
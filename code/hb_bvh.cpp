@@ -0,0 +1,1024 @@
+/*
+    NOTE(joon) Binned SAH BVH builder
+    - For each node, the centroids of the primitives are put into Bvh_Bin_Count bins along each axis,
+      and the split plane that gives the lowest surface area heuristic cost among the bin boundaries is picked.
+      This is much cheaper than sorting the primitives, and the quality is almost the same.
+    - SAH cost = traversal cost + (left area * left count + right area * right count) / parent area
+      where the cost of intersecting a primitive is 1. If that's not better than making a leaf, we make a leaf.
+    - The top of the tree is built on the main thread, and the subtrees that are small enough are handed to the
+      thread work queue. Each job reserves a block of nodes that is big enough for its subtree(2n - 2 nodes for n primitives)
+*/
+
+#define Bvh_Bin_Count 16
+#define Bvh_Max_Leaf_Primitive_Count 8
+// NOTE(joon) relative to the cost of intersecting a single primitive
+#define Bvh_Traversal_Cost 1.0f
+// NOTE(joon) All the jobs can be in the work queue at the same time, so this should be less than the size of the queue
+#define Bvh_Max_Job_Count 64
+
+// NOTE(joon) The primitives get sorted along with their bounds, instead of going through the indices.
+// Otherwise every level of the build ends up being a bunch of cache misses
+struct BVHBuildPrimitive
+{
+    v3 min;
+    u32 index;
+    v3 max;
+    v3 centroid;
+};
+
+struct BVHBin
+{
+    v3 min;
+    v3 max;
+    u32 primitive_count;
+};
+
+// NOTE(joon) Range of nodes that belongs to a single build job
+struct BVHNodeBlock
+{
+    u32 next;
+    u32 one_past_last;
+};
+
+struct BVHBuildJob;
+struct BVHBuildContext
+{
+    BVH *bvh;
+
+    // NOTE(joon) same order as the primitive indices of the bvh
+    BVHBuildPrimitive *primitives;
+
+    // NOTE(joon) can be increased by the jobs at the same time
+    i32 volatile used_node_count;
+
+    thread_work_queue *queue;
+    BVHBuildJob *jobs;
+    u32 job_count;
+    u32 job_primitive_count_threshold;
+};
+
+struct BVHBuildJob
+{
+    BVHBuildContext *context;
+    u32 node_index;
+    u32 depth;
+};
+
+internal f32
+get_aabb_half_area(v3 min, v3 max)
+{
+    v3 dim = max - min;
+    f32 result = dim.x*dim.y + dim.y*dim.z + dim.z*dim.x;
+
+    return result;
+}
+
+internal u32
+get_bvh_bin_index(f32 centroid, f32 centroid_min, f32 bin_scale)
+{
+    u32 result = (u32)((centroid - centroid_min) * bin_scale);
+    result = minimum(result, Bvh_Bin_Count - 1);
+
+    return result;
+}
+
+internal u32
+allocate_bvh_node_pair(BVHBuildContext *context, BVHNodeBlock *block)
+{
+    u32 result = 0;
+    if(block)
+    {
+        result = block->next;
+        block->next += 2;
+        assert(block->next <= block->one_past_last);
+    }
+    else
+    {
+        result = atomic_add(&context->used_node_count, 2) - 2;
+    }
+
+    return result;
+}
+
+internal void subdivide_bvh_node(BVHBuildContext *context, u32 node_index, u32 depth, BVHNodeBlock *block);
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_build_bvh_subtree)
+{
+    BVHBuildJob *job = (BVHBuildJob *)data;
+    BVHBuildContext *context = job->context;
+    BVHNode *node = context->bvh->nodes + job->node_index;
+
+    BVHNodeBlock block = {};
+    u32 max_node_count = 2*node->primitive_count - 2;
+    block.next = atomic_add(&context->used_node_count, (i32)max_node_count) - max_node_count;
+    block.one_past_last = block.next + max_node_count;
+
+    subdivide_bvh_node(context, job->node_index, job->depth, &block);
+}
+
+/*
+   NOTE(joon) The node should already have the bounds and the range of the primitives.
+   block is 0 when this is called from the main thread, in which case the subtrees that are small enough
+   become a seperate job.
+*/
+internal void
+subdivide_bvh_node(BVHBuildContext *context, u32 node_index, u32 depth, BVHNodeBlock *block)
+{
+    BVH *bvh = context->bvh;
+    BVHNode *node = bvh->nodes + node_index;
+    u32 first = node->left_first;
+    u32 count = node->primitive_count;
+
+    if(count <= 1)
+    {
+        return;
+    }
+
+    // NOTE(joon) The traversals use a fixed stack of Bvh_Max_Traversal_Depth entries, which holds (depth of the tree + 1) nodes at most.
+    // SAH splits can get that deep when the primitives are spaced exponentially(i.e a lot of tiny triangles next to a big one),
+    // in which case the rest of the primitives just become a bigger leaf, as the leaves don't have a limit on the count anyway
+    if(depth >= Bvh_Max_Traversal_Depth - 1)
+    {
+        return;
+    }
+
+    v3 centroid_min = V3(Flt_Max, Flt_Max, Flt_Max);
+    v3 centroid_max = V3(-Flt_Max, -Flt_Max, -Flt_Max);
+    for(u32 i = first;
+            i < first + count;
+            ++i)
+    {
+        v3 centroid = context->primitives[i].centroid;
+        centroid_min = gather_min_elements(centroid_min, centroid);
+        centroid_max = gather_max_elements(centroid_max, centroid);
+    }
+
+    // NOTE(joon) bin along all three axis in one pass, as going through the primitives is the expensive part
+    BVHBin bins[3][Bvh_Bin_Count];
+    v3 bin_scale = {};
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        f32 extent = centroid_max.e[axis] - centroid_min.e[axis];
+        // NOTE(joon) if every centroid is on the same plane, everything goes into the first bin and this axis is never picked
+        bin_scale.e[axis] = (extent > 0.0f) ? (Bvh_Bin_Count / extent) : 0.0f;
+
+        for(u32 bin_index = 0;
+                bin_index < Bvh_Bin_Count;
+                ++bin_index)
+        {
+            BVHBin *bin = bins[axis] + bin_index;
+            bin->min = V3(Flt_Max, Flt_Max, Flt_Max);
+            bin->max = V3(-Flt_Max, -Flt_Max, -Flt_Max);
+            bin->primitive_count = 0;
+        }
+    }
+
+    for(u32 i = first;
+            i < first + count;
+            ++i)
+    {
+        BVHBuildPrimitive *primitive = context->primitives + i;
+
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            u32 bin_index = get_bvh_bin_index(primitive->centroid.e[axis], centroid_min.e[axis], bin_scale.e[axis]);
+
+            BVHBin *bin = bins[axis] + bin_index;
+            bin->min = gather_min_elements(bin->min, primitive->min);
+            bin->max = gather_max_elements(bin->max, primitive->max);
+            bin->primitive_count++;
+        }
+    }
+
+    f32 best_cost = Flt_Max;
+    u32 best_axis = 0;
+    u32 best_split = 0; // bins that are < best_split go to the left
+    BVHBin best_left = {};
+    BVHBin best_right = {};
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        BVHBin *axis_bins = bins[axis];
+
+        // NOTE(joon) sweep from both sides, so that we can get the cost of every split plane in linear time
+        BVHBin lefts[Bvh_Bin_Count - 1];
+        BVHBin rights[Bvh_Bin_Count - 1];
+        BVHBin left = axis_bins[0];
+        BVHBin right = axis_bins[Bvh_Bin_Count - 1];
+        for(u32 split = 1;
+                split < Bvh_Bin_Count;
+                ++split)
+        {
+            lefts[split - 1] = left;
+            rights[Bvh_Bin_Count - 1 - split] = right;
+
+            BVHBin *next_left = axis_bins + split;
+            left.min = gather_min_elements(left.min, next_left->min);
+            left.max = gather_max_elements(left.max, next_left->max);
+            left.primitive_count += next_left->primitive_count;
+
+            BVHBin *next_right = axis_bins + Bvh_Bin_Count - 1 - split;
+            right.min = gather_min_elements(right.min, next_right->min);
+            right.max = gather_max_elements(right.max, next_right->max);
+            right.primitive_count += next_right->primitive_count;
+        }
+
+        for(u32 split = 1;
+                split < Bvh_Bin_Count;
+                ++split)
+        {
+            BVHBin *split_left = lefts + split - 1;
+            BVHBin *split_right = rights + split - 1;
+            if(split_left->primitive_count && split_right->primitive_count)
+            {
+                f32 cost = get_aabb_half_area(split_left->min, split_left->max) * split_left->primitive_count +
+                           get_aabb_half_area(split_right->min, split_right->max) * split_right->primitive_count;
+                if(cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = split;
+                    best_left = *split_left;
+                    best_right = *split_right;
+                }
+            }
+        }
+    }
+
+    if(best_split == 0)
+    {
+        // NOTE(joon) all of the centroids are at the same point.
+        // TODO(joon) split by the count if there are too many of them?
+        return;
+    }
+
+    f32 node_area = get_aabb_half_area(node->min, node->max);
+    f32 split_cost = Bvh_Traversal_Cost + ((node_area > 0.0f) ? (best_cost / node_area) : 0.0f);
+    if(split_cost >= (f32)count && count <= Bvh_Max_Leaf_Primitive_Count)
+    {
+        return;
+    }
+
+    // NOTE(joon) partition the primitive indices in place, using the same binning as above so that the counts match
+    u32 left_index = first;
+    u32 right_index = first + count - 1;
+    while(left_index <= right_index)
+    {
+        BVHBuildPrimitive primitive = context->primitives[left_index];
+        u32 bin_index = get_bvh_bin_index(primitive.centroid.e[best_axis], centroid_min.e[best_axis], bin_scale.e[best_axis]);
+        if(bin_index < best_split)
+        {
+            left_index++;
+        }
+        else
+        {
+            context->primitives[left_index] = context->primitives[right_index];
+            context->primitives[right_index] = primitive;
+            if(right_index == 0)
+            {
+                break;
+            }
+            right_index--;
+        }
+    }
+    assert(left_index - first == best_left.primitive_count);
+
+    u32 left_child_index = allocate_bvh_node_pair(context, block);
+    // NOTE(joon) node pointer might have been a part of the block that is now being written by the other threads,
+    // but the nodes themselves never move so this is fine
+    BVHNode *left_child = bvh->nodes + left_child_index;
+    BVHNode *right_child = left_child + 1;
+
+    left_child->min = best_left.min;
+    left_child->max = best_left.max;
+    left_child->left_first = first;
+    left_child->primitive_count = best_left.primitive_count;
+
+    right_child->min = best_right.min;
+    right_child->max = best_right.max;
+    right_child->left_first = first + best_left.primitive_count;
+    right_child->primitive_count = best_right.primitive_count;
+
+    node->left_first = left_child_index;
+    node->primitive_count = 0;
+
+    for(u32 child_index = left_child_index;
+            child_index < left_child_index + 2;
+            ++child_index)
+    {
+        BVHNode *child = bvh->nodes + child_index;
+        if(!block &&
+            context->queue &&
+            child->primitive_count > 1 &&
+            child->primitive_count <= context->job_primitive_count_threshold &&
+            context->job_count < Bvh_Max_Job_Count)
+        {
+            BVHBuildJob *job = context->jobs + context->job_count++;
+            job->context = context;
+            job->node_index = child_index;
+            job->depth = depth + 1;
+
+            context->queue->add_thread_work_queue_item(context->queue, thread_work_callback_build_bvh_subtree, job);
+        }
+        else
+        {
+            subdivide_bvh_node(context, child_index, depth + 1, block);
+        }
+    }
+}
+
+/*
+   NOTE(joon) The nodes & the primitive indices of the bvh should be already allocated(2n - 1 nodes for n primitives), 
+   and the primitives should have their bounds & index. Everything else is filled here.
+*/
+internal void
+build_bvh_from_primitives(BVH *bvh, BVHBuildPrimitive *primitives, u32 primitive_count, 
+                          BVHBuildJob *jobs, thread_work_queue *queue)
+{
+    BVHBuildContext context = {};
+    context.bvh = bvh;
+    context.primitives = primitives;
+    context.jobs = jobs;
+    context.queue = queue;
+    // NOTE(joon) a bit more jobs than the number of the threads would ever be, so that the threads are kept busy
+    context.job_primitive_count_threshold = maximum(primitive_count / (Bvh_Max_Job_Count/2), 1024);
+
+    BVHNode *root = bvh->nodes;
+    root->min = V3(Flt_Max, Flt_Max, Flt_Max);
+    root->max = V3(-Flt_Max, -Flt_Max, -Flt_Max);
+    root->left_first = 0;
+    root->primitive_count = primitive_count;
+    for(u32 primitive_index = 0;
+            primitive_index < primitive_count;
+            ++primitive_index)
+    {
+        BVHBuildPrimitive *primitive = primitives + primitive_index;
+        primitive->centroid = 0.5f*(primitive->min + primitive->max);
+
+        root->min = gather_min_elements(root->min, primitive->min);
+        root->max = gather_max_elements(root->max, primitive->max);
+    }
+    context.used_node_count = 1;
+
+    subdivide_bvh_node(&context, 0, 0, 0);
+
+    if(queue)
+    {
+        queue->complete_all_thread_work_queue_items(queue);
+    }
+
+    for(u32 primitive_index = 0;
+            primitive_index < primitive_count;
+            ++primitive_index)
+    {
+        bvh->primitive_indices[primitive_index] = primitives[primitive_index].index;
+    }
+
+    bvh->primitive_count = primitive_count;
+    bvh->node_count = context.used_node_count;
+    assert(bvh->node_count <= 2*primitive_count - 1);
+}
+
+/*
+   NOTE(joon) queue can be 0, in which case the whole tree is built on this thread.
+   The bvh only keeps the indices to the triangles, so the triangles should stay where they are.
+*/
+internal void
+build_bvh(BVH *bvh, MemoryArena *arena, MemoryArena *transient_arena,
+          RaytracerTriangle *triangles, u32 triangle_count, thread_work_queue *queue)
+{
+    *bvh = {};
+    if(triangle_count == 0)
+    {
+        return;
+    }
+
+    // NOTE(joon) binary tree with n leaves has 2n - 1 nodes at most
+    u32 max_node_count = 2*triangle_count - 1;
+    bvh->nodes = push_array(arena, BVHNode, max_node_count);
+    bvh->primitive_indices = push_array(arena, u32, triangle_count);
+
+    TempMemory build_memory = start_temp_memory(transient_arena,
+                                                sizeof(BVHBuildPrimitive)*triangle_count + sizeof(BVHBuildJob)*Bvh_Max_Job_Count + 1, false);
+    BVHBuildPrimitive *primitives = push_array(&build_memory, BVHBuildPrimitive, triangle_count);
+    BVHBuildJob *jobs = push_array(&build_memory, BVHBuildJob, Bvh_Max_Job_Count);
+
+    for(u32 triangle_index = 0;
+            triangle_index < triangle_count;
+            ++triangle_index)
+    {
+        RaytracerTriangle *triangle = triangles + triangle_index;
+
+        BVHBuildPrimitive *primitive = primitives + triangle_index;
+        primitive->min = gather_min_elements(gather_min_elements(triangle->v0, triangle->v1), triangle->v2);
+        primitive->max = gather_max_elements(gather_max_elements(triangle->v0, triangle->v1), triangle->v2);
+        primitive->index = triangle_index;
+    }
+
+    build_bvh_from_primitives(bvh, primitives, triangle_count, jobs, queue);
+
+    end_temp_memory(&build_memory);
+}
+
+struct WideBVHBuildContext
+{
+    BVH *bvh;
+    WideBVH *wide_bvh;
+    RaytracerTriangle *triangles;
+
+    u32 max_node_count;
+    u32 max_pack_count;
+};
+
+internal u32
+get_triangle_pack_count(u32 primitive_count)
+{
+    u32 result = (primitive_count + Wide_Bvh_Width - 1) / Wide_Bvh_Width;
+
+    return result;
+}
+
+internal u32
+push_triangle_packs(WideBVHBuildContext *context, BVHNode *leaf)
+{
+    BVH *bvh = context->bvh;
+    WideBVH *wide_bvh = context->wide_bvh;
+
+    u32 result = wide_bvh->pack_count;
+    u32 pack_count = get_triangle_pack_count(leaf->primitive_count);
+    wide_bvh->pack_count += pack_count;
+    assert(wide_bvh->pack_count <= context->max_pack_count);
+
+    TrianglePack *packs = wide_bvh->packs + result;
+    zero_memory(packs, sizeof(TrianglePack)*pack_count);
+    for(u32 i = 0;
+            i < leaf->primitive_count;
+            ++i)
+    {
+        TrianglePack *pack = packs + i / Wide_Bvh_Width;
+        u32 lane = i % Wide_Bvh_Width;
+
+        u32 triangle_index = bvh->primitive_indices[leaf->left_first + i];
+        RaytracerTriangle *triangle = context->triangles + triangle_index;
+        v3 normal = normalize(cross(triangle->v1 - triangle->v0, triangle->v2 - triangle->v0));
+
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            pack->v0[axis][lane] = triangle->v0.e[axis];
+            pack->v1[axis][lane] = triangle->v1.e[axis];
+            pack->v2[axis][lane] = triangle->v2.e[axis];
+            pack->normal[axis][lane] = normal.e[axis];
+        }
+
+        pack->material_indices[lane] = triangle->material_index;
+        pack->triangle_indices[lane] = triangle_index;
+        pack->triangle_count++;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Starting from the binary node, keep opening up the interior child with the biggest surface area
+   until there are Wide_Bvh_Width children. Opening up the bigger ones first means the children end up having similar sizes,
+   which is what the SAH would have wanted anyway.
+*/
+internal u32
+collapse_bvh_node(WideBVHBuildContext *context, u32 binary_node_index)
+{
+    BVH *bvh = context->bvh;
+    WideBVH *wide_bvh = context->wide_bvh;
+
+    u32 result = wide_bvh->node_count++;
+    assert(wide_bvh->node_count <= context->max_node_count);
+
+    u32 children[Wide_Bvh_Width];
+    u32 child_count = 0;
+    children[child_count++] = binary_node_index;
+    while(child_count < Wide_Bvh_Width)
+    {
+        u32 biggest_child = U32_Max;
+        f32 biggest_area = -1.0f;
+        for(u32 child_index = 0;
+                child_index < child_count;
+                ++child_index)
+        {
+            BVHNode *child = bvh->nodes + children[child_index];
+            if(child->primitive_count == 0)
+            {
+                f32 area = get_aabb_half_area(child->min, child->max);
+                if(area > biggest_area)
+                {
+                    biggest_area = area;
+                    biggest_child = child_index;
+                }
+            }
+        }
+
+        if(biggest_child == U32_Max)
+        {
+            // NOTE(joon) every child is a leaf
+            break;
+        }
+
+        u32 left_child_index = bvh->nodes[children[biggest_child]].left_first;
+        children[biggest_child] = left_child_index;
+        children[child_count++] = left_child_index + 1;
+    }
+
+    WideBVHNode *node = wide_bvh->nodes + result;
+    zero_memory(node, sizeof(*node));
+    node->child_count = child_count;
+    for(u32 child_index = 0;
+            child_index < child_count;
+            ++child_index)
+    {
+        BVHNode *child = bvh->nodes + children[child_index];
+
+        node->min_x[child_index] = child->min.x;
+        node->min_y[child_index] = child->min.y;
+        node->min_z[child_index] = child->min.z;
+        node->max_x[child_index] = child->max.x;
+        node->max_y[child_index] = child->max.y;
+        node->max_z[child_index] = child->max.z;
+
+        if(child->primitive_count)
+        {
+            node->children[child_index] = push_triangle_packs(context, child);
+            node->child_pack_counts[child_index] = get_triangle_pack_count(child->primitive_count);
+        }
+        else
+        {
+            node->children[child_index] = collapse_bvh_node(context, children[child_index]);
+            node->child_pack_counts[child_index] = 0;
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) bvh should be already built with the same triangles. 
+   The binary bvh can be thrown away afterwards, if the packet traversal is not being used.
+*/
+internal void
+build_wide_bvh(WideBVH *wide_bvh, MemoryArena *arena, BVH *bvh, RaytracerTriangle *triangles)
+{
+    *wide_bvh = {};
+    if(bvh->node_count == 0)
+    {
+        return;
+    }
+
+    // NOTE(joon) Count the leaves first, so that we know exactly how much memory we need.
+    // Can't just go through the nodes linearly, as some of them might not be used
+    u32 leaf_count = 0;
+    u32 pack_count = 0;
+    u32 node_stack[Bvh_Max_Traversal_Depth];
+    u32 node_stack_count = 0;
+    node_stack[node_stack_count++] = 0;
+    while(node_stack_count)
+    {
+        BVHNode *node = bvh->nodes + node_stack[--node_stack_count];
+        if(node->primitive_count)
+        {
+            leaf_count++;
+            pack_count += get_triangle_pack_count(node->primitive_count);
+        }
+        else
+        {
+            assert(node_stack_count + 2 <= array_count(node_stack));
+            node_stack[node_stack_count++] = node->left_first;
+            node_stack[node_stack_count++] = node->left_first + 1;
+        }
+    }
+
+    WideBVHBuildContext context = {};
+    context.bvh = bvh;
+    context.wide_bvh = wide_bvh;
+    context.triangles = triangles;
+    // NOTE(joon) every wide node has at least two children, except for when the root itself is a leaf
+    context.max_node_count = maximum(leaf_count - 1, 1);
+    context.max_pack_count = pack_count;
+
+    wide_bvh->nodes = push_array(arena, WideBVHNode, context.max_node_count);
+    wide_bvh->packs = push_array(arena, TrianglePack, context.max_pack_count);
+
+    collapse_bvh_node(&context, 0);
+}
+
+internal void
+init_raytracer_instance_world(RaytracerInstanceWorld *world, MemoryArena *arena, u32 max_mesh_count, u32 max_instance_count)
+{
+    assert(max_mesh_count && max_instance_count);
+
+    *world = {};
+    world->meshes = push_array(arena, RaytracerMesh, max_mesh_count);
+    world->max_mesh_count = max_mesh_count;
+    world->instances = push_array(arena, RaytracerInstance, max_instance_count);
+    world->max_instance_count = max_instance_count;
+
+    // NOTE(joon) binary tree with n leaves has 2n - 1 nodes at most
+    u32 max_node_count = 2*max_instance_count - 1;
+    world->bvh.nodes = push_array(arena, BVHNode, max_node_count);
+    world->bvh.primitive_indices = push_array(arena, u32, max_instance_count);
+}
+
+// NOTE(joon) The triangles should be in the local space of the mesh, and should stay where they are. Returns the index of the mesh
+internal u32
+add_raytracer_mesh(RaytracerInstanceWorld *world, MemoryArena *arena, MemoryArena *transient_arena,
+                   RaytracerTriangle *triangles, u32 triangle_count, thread_work_queue *queue)
+{
+    assert(triangle_count);
+    assert(world->mesh_count < world->max_mesh_count);
+
+    u32 result = world->mesh_count++;
+    RaytracerMesh *mesh = world->meshes + result;
+    mesh->triangles = triangles;
+    mesh->triangle_count = triangle_count;
+
+    build_bvh(&mesh->bvh, arena, transient_arena, triangles, triangle_count, queue);
+    build_wide_bvh(&mesh->wide_bvh, arena, &mesh->bvh, triangles);
+
+    return result;
+}
+
+internal void
+set_raytracer_instance_transform(RaytracerInstanceWorld *world, u32 instance_index, m4x4 transform)
+{
+    RaytracerInstance *instance = world->instances + instance_index;
+    instance->transform = transform;
+    instance->inv_transform = inverse_affine(transform);
+
+    // NOTE(joon) Bounds of the transformed box without going through all 8 corners(Arvo 1990),
+    // each axis of the half dim gets projected onto the world axes
+    BVHNode *root = world->meshes[instance->mesh_index].bvh.nodes;
+    v3 center = 0.5f*(root->min + root->max);
+    v3 half_dim = 0.5f*(root->max - root->min);
+
+    v3 world_center = (transform*V4(center, 1.0f)).xyz;
+    v3 world_half_dim = {};
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        world_half_dim.e[axis] = abs_(transform.e[axis][0])*half_dim.x + 
+                                 abs_(transform.e[axis][1])*half_dim.y + 
+                                 abs_(transform.e[axis][2])*half_dim.z;
+    }
+
+    instance->min = world_center - world_half_dim;
+    instance->max = world_center + world_half_dim;
+}
+
+// NOTE(joon) Returns the index of the instance, which is also what the ray queries return(InstanceHit)
+internal u32
+add_raytracer_instance(RaytracerInstanceWorld *world, u32 mesh_index, m4x4 transform, u32 user_index)
+{
+    assert(mesh_index < world->mesh_count);
+    assert(world->instance_count < world->max_instance_count);
+
+    u32 result = world->instance_count++;
+    RaytracerInstance *instance = world->instances + result;
+    instance->mesh_index = mesh_index;
+    instance->user_index = user_index;
+    set_raytracer_instance_transform(world, result, transform);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Should be called after the instances have moved(or were added), and before the ray queries.
+   Only the top level gets built again, which is cheap enough to do every frame as long as there are not too many instances.
+*/
+internal void
+update_raytracer_instance_world(RaytracerInstanceWorld *world, MemoryArena *transient_arena)
+{
+    BVH *bvh = &world->bvh;
+    bvh->node_count = 0;
+    bvh->primitive_count = 0;
+
+    u32 instance_count = world->instance_count;
+    if(instance_count)
+    {
+        TempMemory build_memory = start_temp_memory(transient_arena, sizeof(BVHBuildPrimitive)*instance_count + 1, false);
+        BVHBuildPrimitive *primitives = push_array(&build_memory, BVHBuildPrimitive, instance_count);
+
+        for(u32 instance_index = 0;
+                instance_index < instance_count;
+                ++instance_index)
+        {
+            RaytracerInstance *instance = world->instances + instance_index;
+
+            BVHBuildPrimitive *primitive = primitives + instance_index;
+            primitive->min = instance->min;
+            primitive->max = instance->max;
+            primitive->index = instance_index;
+        }
+
+        // NOTE(joon) not worth the overhead of the jobs for the number of the instances that we have
+        build_bvh_from_primitives(bvh, primitives, instance_count, 0, 0);
+
+        end_temp_memory(&build_memory);
+    }
+}
+
+internal void
+get_particle_face_bounds(MassAgg *mass_agg, u32 face_index, v3 *min, v3 *max)
+{
+    ParticleFace *face = mass_agg->faces + face_index;
+    v3 p0 = mass_agg->particles[face->ID_0].p;
+    v3 p1 = mass_agg->particles[face->ID_1].p;
+    v3 p2 = mass_agg->particles[face->ID_2].p;
+
+    *min = gather_min_elements(gather_min_elements(p0, p1), p2);
+    *max = gather_max_elements(gather_max_elements(p0, p1), p2);
+}
+
+/*
+   NOTE(joon) Same cost as the builder, but for the whole subtree - 
+   traversal cost * area for each interior node, and primitive count * area for each leaf.
+   Should be divided by the area of the root, to be compared against the other trees.
+*/
+internal r32
+get_bvh_node_sah_cost(BVHNode *node)
+{
+    r32 area = get_aabb_half_area(node->min, node->max);
+    r32 result = (node->primitive_count ? (r32)node->primitive_count : Bvh_Traversal_Cost) * area;
+
+    return result;
+}
+
+/*
+   NOTE(joon) Refits the node & everything under it, and returns the SAH cost of the subtree.
+   The nodes that are at job_depth are not touched(and don't count towards the cost), 
+   as they are refitted by the jobs. Pass U32_Max to refit the whole subtree.
+*/
+internal r32
+refit_mass_agg_bvh_node(MassAgg *mass_agg, BVH *bvh, u32 node_index, u32 depth, u32 job_depth)
+{
+    r32 result = 0.0f;
+
+    BVHNode *node = bvh->nodes + node_index;
+    if(node->primitive_count)
+    {
+        node->min = V3(Flt_Max, Flt_Max, Flt_Max);
+        node->max = V3(-Flt_Max, -Flt_Max, -Flt_Max);
+        for(u32 i = node->left_first;
+                i < node->left_first + node->primitive_count;
+                ++i)
+        {
+            v3 face_min;
+            v3 face_max;
+            get_particle_face_bounds(mass_agg, bvh->primitive_indices[i], &face_min, &face_max);
+
+            node->min = gather_min_elements(node->min, face_min);
+            node->max = gather_max_elements(node->max, face_max);
+        }
+    }
+    else
+    {
+        BVHNode *left = bvh->nodes + node->left_first;
+        BVHNode *right = left + 1;
+        if(depth + 1 != job_depth)
+        {
+            result += refit_mass_agg_bvh_node(mass_agg, bvh, node->left_first, depth + 1, job_depth);
+            result += refit_mass_agg_bvh_node(mass_agg, bvh, node->left_first + 1, depth + 1, job_depth);
+        }
+
+        node->min = gather_min_elements(left->min, right->min);
+        node->max = gather_max_elements(left->max, right->max);
+    }
+
+    result += get_bvh_node_sah_cost(node);
+
+    return result;
+}
+
+// NOTE(joon) Keeps taking the refit jobs until there is none left
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_refit_mass_agg_bvh)
+{
+    MassAggBVH *mass_agg_bvh = (MassAggBVH *)data;
+
+    while(1)
+    {
+        u32 job_index = (u32)(atomic_increment(&mass_agg_bvh->next_refit_job_index) - 1);
+        if(job_index >= mass_agg_bvh->refit_job_count)
+        {
+            break;
+        }
+
+        MassAggBVHRefitJob *job = mass_agg_bvh->refit_jobs + job_index;
+        BVH *bvh = mass_agg_bvh->bvhs + mass_agg_bvh->current_bvh_index;
+        job->cost = refit_mass_agg_bvh_node(mass_agg_bvh->mass_agg, bvh, job->node_index, 0, U32_Max);
+
+        // NOTE(joon) atomic operations are full barriers, so the refitted nodes are visible to the thread that waits for the jobs
+        atomic_increment(&mass_agg_bvh->done_refit_job_count);
+    }
+}
+
+// NOTE(joon) The jobs are the subtrees at Mass_Agg_Bvh_Refit_Job_Depth, which only change when the tree gets built again
+internal void
+gather_mass_agg_bvh_refit_jobs(MassAggBVH *mass_agg_bvh)
+{
+    BVH *bvh = mass_agg_bvh->bvhs + mass_agg_bvh->current_bvh_index;
+    mass_agg_bvh->refit_job_count = 0;
+
+    u32 node_stack[Mass_Agg_Bvh_Max_Refit_Job_Count];
+    u32 depth_stack[Mass_Agg_Bvh_Max_Refit_Job_Count];
+    u32 stack_count = 0;
+    node_stack[stack_count] = 0;
+    depth_stack[stack_count] = 0;
+    stack_count++;
+    while(stack_count)
+    {
+        stack_count--;
+        u32 node_index = node_stack[stack_count];
+        u32 depth = depth_stack[stack_count];
+
+        BVHNode *node = bvh->nodes + node_index;
+        if(depth == Mass_Agg_Bvh_Refit_Job_Depth)
+        {
+            MassAggBVHRefitJob *job = mass_agg_bvh->refit_jobs + mass_agg_bvh->refit_job_count++;
+            job->node_index = node_index;
+        }
+        else if(node->primitive_count == 0)
+        {
+            // NOTE(joon) the leaves above the job depth are refitted with the rest of the top nodes
+            for(u32 child = 0;
+                    child < 2;
+                    ++child)
+            {
+                assert(stack_count < array_count(node_stack));
+                node_stack[stack_count] = node->left_first + child;
+                depth_stack[stack_count] = depth + 1;
+                stack_count++;
+            }
+        }
+    }
+}
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_rebuild_mass_agg_bvh)
+{
+    MassAggBVH *mass_agg_bvh = (MassAggBVH *)data;
+    BVH *bvh = mass_agg_bvh->bvhs + (1 - mass_agg_bvh->current_bvh_index);
+
+    // NOTE(joon) This is already on the other thread, so the build itself doesn't need to be split again
+    build_bvh_from_primitives(bvh, mass_agg_bvh->rebuild_primitives, mass_agg_bvh->mass_agg->face_count, 0, 0);
+
+    // NOTE(joon) atomic operations are full barriers, so the nodes are visible to the main thread after this
+    atomic_increment(&mass_agg_bvh->is_rebuild_done);
+}
+
+internal void
+start_mass_agg_bvh_rebuild(MassAggBVH *mass_agg_bvh, thread_work_queue *queue)
+{
+    MassAgg *mass_agg = mass_agg_bvh->mass_agg;
+    for(u32 face_index = 0;
+            face_index < mass_agg->face_count;
+            ++face_index)
+    {
+        BVHBuildPrimitive *primitive = mass_agg_bvh->rebuild_primitives + face_index;
+        get_particle_face_bounds(mass_agg, face_index, &primitive->min, &primitive->max);
+        primitive->index = face_index;
+    }
+
+    mass_agg_bvh->is_rebuilding = true;
+    mass_agg_bvh->is_rebuild_done = 0;
+    if(queue)
+    {
+        queue->add_thread_work_queue_item(queue, thread_work_callback_rebuild_mass_agg_bvh, mass_agg_bvh);
+    }
+    else
+    {
+        thread_work_callback_rebuild_mass_agg_bvh(mass_agg_bvh);
+    }
+}
+
+/*
+   NOTE(joon) Refits the current tree to where the particles are now, using the queue for the subtrees if there is one.
+   Also measures the cost of the tree, which decides when the tree needs to be built again.
+*/
+internal void
+refit_mass_agg_bvh(MassAggBVH *mass_agg_bvh, thread_work_queue *queue)
+{
+    MassAgg *mass_agg = mass_agg_bvh->mass_agg;
+    BVH *bvh = mass_agg_bvh->bvhs + mass_agg_bvh->current_bvh_index;
+
+    r32 cost = 0.0f;
+    if(queue && mass_agg_bvh->refit_job_count)
+    {
+        // NOTE(joon) the items that were left from the last refit can still be bumping the index
+        mass_agg_bvh->done_refit_job_count = 0;
+        i32 next_refit_job_index = 0;
+        do
+        {
+            next_refit_job_index = mass_agg_bvh->next_refit_job_index;
+        }
+        while(!atomic_compare_exchange(&mass_agg_bvh->next_refit_job_index, next_refit_job_index, 0));
+
+        for(u32 job_index = 0;
+                job_index < mass_agg_bvh->refit_job_count;
+                ++job_index)
+        {
+            queue->add_thread_work_queue_item(queue, thread_work_callback_refit_mass_agg_bvh, mass_agg_bvh);
+        }
+
+        /*
+           NOTE(joon) Instead of complete_all, which would also wait for the rebuild, this thread does the jobs that are left
+           and then only waits for the ones that the other threads took. 
+           The items that are still in the queue after that find no job, and the index stays past the jobs 
+           until the next refit, as the jobs can change when the tree gets swapped.
+        */
+        thread_work_callback_refit_mass_agg_bvh(mass_agg_bvh);
+        while(atomic_add(&mass_agg_bvh->done_refit_job_count, 0) != (i32)mass_agg_bvh->refit_job_count)
+        {
+        }
+        atomic_add(&mass_agg_bvh->next_refit_job_index, Mass_Agg_Bvh_Max_Refit_Job_Count);
+
+        for(u32 job_index = 0;
+                job_index < mass_agg_bvh->refit_job_count;
+                ++job_index)
+        {
+            cost += mass_agg_bvh->refit_jobs[job_index].cost;
+        }
+        cost += refit_mass_agg_bvh_node(mass_agg, bvh, 0, 0, Mass_Agg_Bvh_Refit_Job_Depth);
+    }
+    else
+    {
+        cost = refit_mass_agg_bvh_node(mass_agg, bvh, 0, 0, U32_Max);
+    }
+
+    r32 root_area = get_aabb_half_area(bvh->nodes[0].min, bvh->nodes[0].max);
+    mass_agg_bvh->cost = (root_area > 0.0f) ? (cost / root_area) : 0.0f;
+}
+
+/*
+   NOTE(joon) Should be called after the particles have moved, and before the ray queries(see ray_intersect_with_mass_agg).
+   queue can be 0, in which case both the refit & the rebuild happen on this thread.
+*/
+internal void
+update_mass_agg_bvh(MassAggBVH *mass_agg_bvh, thread_work_queue *queue)
+{
+    if(mass_agg_bvh->mass_agg->face_count)
+    {
+        if(mass_agg_bvh->is_rebuilding && atomic_add(&mass_agg_bvh->is_rebuild_done, 0))
+        {
+            mass_agg_bvh->is_rebuilding = false;
+            mass_agg_bvh->current_bvh_index = 1 - mass_agg_bvh->current_bvh_index;
+            mass_agg_bvh->rebuild_count++;
+            gather_mass_agg_bvh_refit_jobs(mass_agg_bvh);
+
+            // NOTE(joon) the faces have moved since the snapshot, so the new tree also needs to be refitted
+            refit_mass_agg_bvh(mass_agg_bvh, queue);
+            mass_agg_bvh->built_cost = mass_agg_bvh->cost;
+        }
+        else
+        {
+            refit_mass_agg_bvh(mass_agg_bvh, queue);
+        }
+
+        if(!mass_agg_bvh->is_rebuilding &&
+            mass_agg_bvh->cost > Mass_Agg_Bvh_Max_Cost_Ratio*mass_agg_bvh->built_cost)
+        {
+            start_mass_agg_bvh_rebuild(mass_agg_bvh, queue);
+        }
+    }
+}
+
+internal void
+init_mass_agg_bvh(MassAggBVH *mass_agg_bvh, MemoryArena *arena, MassAgg *mass_agg)
+{
+    *mass_agg_bvh = {};
+    mass_agg_bvh->mass_agg = mass_agg;
+
+    u32 face_count = mass_agg->face_count;
+    if(face_count)
+    {
+        // NOTE(joon) binary tree with n leaves has 2n - 1 nodes at most
+        u32 max_node_count = 2*face_count - 1;
+        for(u32 bvh_index = 0;
+                bvh_index < array_count(mass_agg_bvh->bvhs);
+                ++bvh_index)
+        {
+            BVH *bvh = mass_agg_bvh->bvhs + bvh_index;
+            bvh->nodes = push_array(arena, BVHNode, max_node_count);
+            bvh->primitive_indices = push_array(arena, u32, face_count);
+        }
+        mass_agg_bvh->rebuild_primitives = push_array(arena, BVHBuildPrimitive, face_count);
+
+        // NOTE(joon) the first build is done right away, so that the tree can be used before the first update
+        start_mass_agg_bvh_rebuild(mass_agg_bvh, 0);
+        update_mass_agg_bvh(mass_agg_bvh, 0);
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef HB_BVH_H
+#define HB_BVH_H
+
+// NOTE(joon) Size of the node stack that the traversal uses. 
+// As the farther child is pushed first, the stack never holds more than (depth of the tree + 1) nodes
+#define Bvh_Max_Traversal_Depth 64
+
+// NOTE(joon) 32 bytes, so that both children(which are always next to each other) fit inside a single cache line
+struct BVHNode
+{
+    v3 min;
+    // NOTE(joon) If primitive_count is 0, this is an index to the left child, and the right child is always left_first + 1.
+    // Otherwise, this is the first index to the primitive indices of the bvh
+    u32 left_first;
+
+    v3 max;
+    u32 primitive_count;
+};
+
+struct BVH
+{
+    // NOTE(joon) node 0 is always the root.
+    // Some of the nodes might not be used at all, as the nodes are handed out in blocks when the build is multithreaded
+    BVHNode *nodes;
+    u32 node_count;
+
+    u32 *primitive_indices;
+    u32 primitive_count;
+};
+
+/*
+    NOTE(joon) Wide bvh, collapsed from the binary one.
+    The bounds of the children are stored in SoA form, so that a single ray can be tested against all of them
+    using simd lanes, instead of using the lanes for different rays. This works better for the rays after the first bounce,
+    which go in all directions and don't visit the same nodes anyway.
+
+    The width does not depend on HB_LANE_WIDTH, as the same bvh is used by the kernels with different lane widths.
+*/
+#define Wide_Bvh_Width 8
+
+struct WideBVHNode
+{
+    r32 min_x[Wide_Bvh_Width];
+    r32 min_y[Wide_Bvh_Width];
+    r32 min_z[Wide_Bvh_Width];
+    r32 max_x[Wide_Bvh_Width];
+    r32 max_y[Wide_Bvh_Width];
+    r32 max_z[Wide_Bvh_Width];
+
+    // NOTE(joon) If the pack count is 0, this is an index to the child node. 
+    // Otherwise, this is the first index to the triangle packs
+    u32 children[Wide_Bvh_Width];
+    u32 child_pack_counts[Wide_Bvh_Width];
+
+    // NOTE(joon) Children are always packed to the front. 
+    // Can't mark the unused children with an inverted(min > max) bounds, as the slab test with infinite t would still 'hit' them
+    u32 child_count;
+};
+
+/*
+   NOTE(joon) Wide_Bvh_Width triangles, with everything that the intersection needs precomputed.
+   The vertices are indexed by the axis first, so that the watertight test can pick the axes that it wants per ray.
+   We store the vertices instead of the edges, because the watertight test only stays watertight
+   when the triangles that share an edge see the exact same vertex values.
+   Unused triangles are all zeros, and should be skipped using the triangle_count - 
+   the determinant of them is not guaranteed to be exactly 0 when the compiler fuses the multiply & add.
+*/
+struct TrianglePack
+{
+    r32 v0[3][Wide_Bvh_Width];
+    r32 v1[3][Wide_Bvh_Width];
+    r32 v2[3][Wide_Bvh_Width];
+
+    // NOTE(joon) normalized geometric normal, cross(v1 - v0, v2 - v0)
+    r32 normal[3][Wide_Bvh_Width];
+
+    u32 material_indices[Wide_Bvh_Width];
+    u32 triangle_indices[Wide_Bvh_Width];
+    u32 triangle_count;
+};
+
+struct WideBVH
+{
+    // NOTE(joon) node 0 is always the root
+    WideBVHNode *nodes;
+    u32 node_count;
+
+    TrianglePack *packs;
+    u32 pack_count;
+};
+
+/*
+   NOTE(joon) Bvh over the faces of a mass agg, which deforms every frame(see update_mass_agg_bvh).
+   - Instead of building it again, the tree is refitted - the bounds get updated from the leaves to the root using the new particle positions.
+     The tree stays valid, but gets worse as the faces move away from where they were when it was built.
+   - The quality is the SAH cost of the tree(see get_bvh_node_sah_cost), and once it gets Mass_Agg_Bvh_Max_Cost_Ratio times worse 
+     than the cost right after the build, a new tree is built in the background from a snapshot of the faces.
+     The refitted tree keeps being used until the new one is done, which then gets refitted to the current positions & swapped in.
+*/
+#define Mass_Agg_Bvh_Max_Cost_Ratio 1.5f
+// NOTE(joon) Subtrees under this depth are refitted as seperate jobs, and the nodes above them after all the jobs are done
+#define Mass_Agg_Bvh_Refit_Job_Depth 4
+#define Mass_Agg_Bvh_Max_Refit_Job_Count (1 << Mass_Agg_Bvh_Refit_Job_Depth)
+
+struct MassAggBVHRefitJob
+{
+    u32 node_index;
+
+    // NOTE(joon) SAH cost of the subtree, before being divided by the area of the root
+    r32 cost;
+};
+
+struct BVHBuildPrimitive;
+struct MassAggBVH
+{
+    MassAgg *mass_agg;
+
+    // NOTE(joon) One is being used, and the other one is for the rebuild. 
+    // Both have the nodes for all the faces, as the number of faces never change
+    BVH bvhs[2];
+    u32 current_bvh_index;
+
+    // NOTE(joon) right after the (re)build, and after the last refit
+    r32 built_cost;
+    r32 cost;
+
+    MassAggBVHRefitJob refit_jobs[Mass_Agg_Bvh_Max_Refit_Job_Count];
+    u32 refit_job_count;
+    // NOTE(joon) The jobs are taken by whoever gets to them first, including the thread that started the refit.
+    // That way the refit never has to wait for the other items in the queue(i.e the rebuild), see refit_mass_agg_bvh
+    i32 volatile next_refit_job_index;
+    i32 volatile done_refit_job_count;
+
+    // NOTE(joon) snapshot of the faces that the background rebuild uses, so that the particles can keep moving while it builds
+    BVHBuildPrimitive *rebuild_primitives;
+    b32 is_rebuilding;
+    i32 volatile is_rebuild_done;
+    u32 rebuild_count;
+};
+
+#endif
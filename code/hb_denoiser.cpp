@@ -0,0 +1,122 @@
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_denoise_band)
+{
+    RaytracerDenoiserBand *band = (RaytracerDenoiserBand *)data;
+
+    hot_kernels.denoise_raytraced_image_band(band);
+}
+
+// NOTE(joon) The planes are zeroed here, and the border should stay that way.
+internal void
+start_raytracer_denoiser(RaytracerDenoiser *denoiser, MemoryArena *arena, u32 width, u32 height)
+{
+    assert(width && height);
+
+    denoiser->width = width;
+    denoiser->height = height;
+    denoiser->stride = Denoiser_Border_Dim +
+                       Denoiser_Max_Lane_Width*((width + Denoiser_Max_Lane_Width - 1) / Denoiser_Max_Lane_Width) +
+                       Denoiser_Border_Dim;
+    denoiser->origin = Denoiser_Border_Dim;
+
+    u32 plane_size = denoiser->stride*height;
+    for(u32 plane_index = 0;
+            plane_index < 3;
+            ++plane_index)
+    {
+        denoiser->colors[0][plane_index] = push_array(arena, r32, plane_size);
+        denoiser->colors[1][plane_index] = push_array(arena, r32, plane_size);
+        denoiser->albedos[plane_index] = push_array(arena, r32, plane_size);
+        denoiser->normals[plane_index] = push_array(arena, r32, plane_size);
+
+        zero_memory(denoiser->colors[0][plane_index], sizeof(r32)*plane_size);
+        zero_memory(denoiser->colors[1][plane_index], sizeof(r32)*plane_size);
+        zero_memory(denoiser->albedos[plane_index], sizeof(r32)*plane_size);
+        zero_memory(denoiser->normals[plane_index], sizeof(r32)*plane_size);
+    }
+    denoiser->depths = push_array(arena, r32, plane_size);
+    zero_memory(denoiser->depths, sizeof(r32)*plane_size);
+
+    denoiser->band_count = (height + Denoiser_Band_Height - 1) / Denoiser_Band_Height;
+    denoiser->bands = push_array(arena, RaytracerDenoiserBand, denoiser->band_count);
+
+    // TODO(joon) These were tuned against a test scene with 4-16 rays per pixel, might need to be exposed per scene.
+    // More iterations blur out the soft shadows, which are mostly noise with that few rays
+    denoiser->iteration_count = 4;
+    denoiser->color_sigma = 1.0f;
+    denoiser->albedo_sigma = 0.1f;
+    denoiser->normal_sigma = 0.3f;
+    denoiser->depth_sigma = 0.05f;
+}
+
+/*
+   NOTE(joon) features should be the ones that were written by the raytracer(see RaytracerPixelFeature),
+   and pixels gets the denoised image in the same format as the raytracer output.
+   Each iteration depends on the whole result of the previous one, so this waits for all the bands of an iteration
+   before starting the next one. queue can be 0, in which case everything is done on this thread.
+*/
+internal void
+denoise_raytraced_image(RaytracerDenoiser *denoiser, RaytracerPixelFeature *features, u32 *pixels, thread_work_queue *queue)
+{
+    assert(denoiser->iteration_count && denoiser->iteration_count <= Denoiser_Max_Iteration_Count);
+    denoiser->pixels = pixels;
+
+    for(u32 y = 0;
+            y < denoiser->height;
+            ++y)
+    {
+        RaytracerPixelFeature *feature = features + y*denoiser->width;
+        u32 plane_index = denoiser->origin + y*denoiser->stride;
+        for(u32 x = 0;
+                x < denoiser->width;
+                ++x)
+        {
+            denoiser->colors[0][0][plane_index] = feature->color.r;
+            denoiser->colors[0][1][plane_index] = feature->color.g;
+            denoiser->colors[0][2][plane_index] = feature->color.b;
+
+            denoiser->albedos[0][plane_index] = feature->albedo.r;
+            denoiser->albedos[1][plane_index] = feature->albedo.g;
+            denoiser->albedos[2][plane_index] = feature->albedo.b;
+
+            denoiser->normals[0][plane_index] = feature->normal.x;
+            denoiser->normals[1][plane_index] = feature->normal.y;
+            denoiser->normals[2][plane_index] = feature->normal.z;
+
+            denoiser->depths[plane_index] = feature->depth;
+
+            feature++;
+            plane_index++;
+        }
+    }
+
+    for(u32 iteration_index = 0;
+            iteration_index < denoiser->iteration_count;
+            ++iteration_index)
+    {
+        for(u32 band_index = 0;
+                band_index < denoiser->band_count;
+                ++band_index)
+        {
+            RaytracerDenoiserBand *band = denoiser->bands + band_index;
+            band->denoiser = denoiser;
+            band->iteration_index = iteration_index;
+            band->min_y = band_index*Denoiser_Band_Height;
+            band->one_past_max_y = minimum(band->min_y + Denoiser_Band_Height, denoiser->height);
+
+            if(queue)
+            {
+                queue->add_thread_work_queue_item(queue, thread_work_callback_denoise_band, band);
+            }
+            else
+            {
+                thread_work_callback_denoise_band(band);
+            }
+        }
+
+        if(queue)
+        {
+            queue->complete_all_thread_work_queue_items(queue);
+        }
+    }
+}
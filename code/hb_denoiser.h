@@ -0,0 +1,62 @@
+#ifndef HB_DENOISER_H
+#define HB_DENOISER_H
+
+/*
+    NOTE(joon) Edge avoiding a-trous wavelet filter(Dammertz et al. 2010), for the images that only got a few rays per pixel.
+    Each iteration is a 5x5 B3 spline filter whose taps are 2^iteration_index pixels apart, so that 5 iterations
+    cover 125x125 pixels while each of them still only reads 25 pixels.
+    The weight of each tap gets multiplied by how similar the color, albedo, normal & depth are(see RaytracerPixelFeature),
+    so the noise gets blurred out but the geometric & material edges stay sharp.
+    The color term gets twice as strict every iteration, as the color itself gets smoother.
+
+    Every buffer is stored as planes of r32(SoA) with a border around them, so that the filter can load HB_LANE_WIDTH pixels
+    in a row directly. The taps that fall into the border get a weight of 0.
+*/
+#define Denoiser_Max_Iteration_Count 5
+// NOTE(joon) 2 taps * the tap distance of the last iteration,
+// and the right border also covers the last lanes that go past the width(16, which is the widest lane width that we support)
+#define Denoiser_Border_Dim (2 << (Denoiser_Max_Iteration_Count - 1))
+#define Denoiser_Max_Lane_Width 16
+// NOTE(joon) number of rows that a single work item filters
+#define Denoiser_Band_Height 16
+
+struct RaytracerDenoiser;
+struct RaytracerDenoiserBand
+{
+    RaytracerDenoiser *denoiser;
+    u32 iteration_index;
+    u32 min_y;
+    u32 one_past_max_y;
+};
+
+struct RaytracerDenoiser
+{
+    u32 width;
+    u32 height;
+    // NOTE(joon) in pixels, including the borders
+    u32 stride;
+    // NOTE(joon) offset of pixel(0, 0) inside each plane
+    u32 origin;
+
+    // NOTE(joon) ping-pongs between the iterations, and the last iteration also writes the sRGB pixels
+    r32 *colors[2][3];
+    r32 *albedos[3];
+    r32 *normals[3];
+    r32 *depths;
+    u32 *pixels;
+
+    u32 iteration_count;
+    r32 color_sigma;
+    r32 albedo_sigma;
+    r32 normal_sigma;
+    // NOTE(joon) relative to the depth of the pixel, so that the far away surfaces are not blurred more than the close ones
+    r32 depth_sigma;
+
+    // NOTE(joon) only used by the last iteration, should be the same as the one that the raytracer used
+    OutputEncoding output_encoding;
+
+    RaytracerDenoiserBand *bands;
+    u32 band_count;
+};
+
+#endif
@@ -20,12 +20,20 @@ add_entity(GameState *game_state, EntityType type, u32 flags)
     return entity;
 }
 
+internal void
+init_mass_agg_entity_bvh(Entity *entity, MemoryArena *arena)
+{
+    entity->mass_agg_bvh = push_struct(arena, MassAggBVH);
+    init_mass_agg_bvh(entity->mass_agg_bvh, arena, &entity->mass_agg);
+}
+
 internal Entity *
 add_cube_mass_agg_entity(GameState *game_state, MemoryArena *arena, v3 center, v3 dim, v3 color, f32 total_mass, f32 elastic_value)
 {
     // TODO(joon) test if mass is infinite, and set the entity flag accordingly
     Entity *result = add_entity(game_state, Entity_Type_Mass_Agg, Entity_Flag_Movable|Entity_Flag_Collides);
     result->mass_agg = init_cube_mass_agg(arena, center, dim, total_mass, elastic_value); 
+    init_mass_agg_entity_bvh(result, arena);
     result->color = color;
 
     return result;
@@ -38,6 +46,7 @@ add_mass_agg_entity_from_mesh(GameState *game_state, MemoryArena *arena, v3 cent
     Entity *result = add_entity(game_state, Entity_Type_Mass_Agg, Entity_Flag_Movable|Entity_Flag_Collides);
 
     result->mass_agg = init_mass_agg_from_mesh(arena, center, vertices, vertex_count, indices, index_count, scale, total_mass, elastic_value); 
+    init_mass_agg_entity_bvh(result, arena);
     result->color = color;
 
     return result;
@@ -48,6 +57,7 @@ add_flat_triangle_mass_agg_entity(GameState *game_state, MemoryArena *arena, v3
 {
     Entity *result = add_entity(game_state, Entity_Type_Mass_Agg, Entity_Flag_Movable|Entity_Flag_Collides);
     result->mass_agg = init_flat_triangle_mass_agg(arena, total_mass, elastic_value); 
+    init_mass_agg_entity_bvh(result, arena);
     result->color = color;
 
     return result;
@@ -65,6 +75,65 @@ add_floor_entity(GameState *game_state, v3 p, v3 dim, v3 color)
     return result;
 }
 
+// NOTE(joon) Cube from -1 to 1, so that the half dim of the cube entity can be used as the scale of the instance
+internal u32
+add_cube_raytracer_mesh(RaytracerInstanceWorld *world, MemoryArena *arena, MemoryArena *transient_arena)
+{
+    u32 triangle_count = 12;
+    RaytracerTriangle *triangles = push_array(arena, RaytracerTriangle, triangle_count);
+
+    // NOTE(joon) two triangles for each side of each axis
+    RaytracerTriangle *triangle = triangles;
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        v3 u = {};
+        v3 v = {};
+        u.e[(axis + 1) % 3] = 1.0f;
+        v.e[(axis + 2) % 3] = 1.0f;
+
+        for(u32 side = 0;
+                side < 2;
+                ++side)
+        {
+            v3 center = {};
+            center.e[axis] = side ? 1.0f : -1.0f;
+
+            triangle->v0 = center - u - v;
+            triangle->v1 = center + u - v;
+            triangle->v2 = center + u + v;
+            triangle++;
+
+            triangle->v0 = center - u - v;
+            triangle->v1 = center + u + v;
+            triangle->v2 = center - u + v;
+            triangle++;
+        }
+    }
+
+    u32 result = add_raytracer_mesh(world, arena, transient_arena, triangles, triangle_count, 0);
+
+    return result;
+}
+
+// NOTE(joon) RigidBody.transform should be up to date(see init_rigid_body_and_calculate_derived_parameters_for_frame)
+internal m4x4
+get_cube_entity_instance_transform(Entity *entity)
+{
+    m4x4 local_transform = M4x4();
+    local_transform.e[0][0] = entity->cv.half_dim.x;
+    local_transform.e[1][1] = entity->cv.half_dim.y;
+    local_transform.e[2][2] = entity->cv.half_dim.z;
+    local_transform.e[0][3] = entity->cv.offset.x;
+    local_transform.e[1][3] = entity->cv.offset.y;
+    local_transform.e[2][3] = entity->cv.offset.z;
+
+    m4x4 result = entity->rb.transform*local_transform;
+
+    return result;
+}
+
 internal Entity *
 add_cube_rigid_body_entity(GameState *game_state, v3 p, v3 half_dim, f32 inv_mass, v3 color)
 {
@@ -86,6 +155,10 @@ add_cube_rigid_body_entity(GameState *game_state, v3 p, v3 half_dim, f32 inv_mas
     result->rb = init_rigid_body(p, inv_mass, inertia_tensor);
     result->cv = init_collision_volume_cube(V3(0, 0, 0), half_dim);
 
+    init_rigid_body_and_calculate_derived_parameters_for_frame(&result->rb);
+    result->raytracer_instance_index = add_raytracer_instance(&game_state->instance_world, game_state->cube_mesh_index,
+                                                              get_cube_entity_instance_transform(result), (u32)(result - game_state->entities));
+
     return result;
 }
 
@@ -17,6 +17,7 @@ enum EntityFlag
     Entity_Flag_Collides = 4,
 };
 
+struct MassAggBVH;
 struct Entity
 {
     EntityType type;
@@ -28,12 +29,17 @@ struct Entity
     // TODO(joon) some kind of entity system, 
     // so that we don't have to store entity_specific things in all of the entities
     MassAgg mass_agg;
+    // NOTE(joon) for the ray queries, see update_mass_agg_bvh
+    MassAggBVH *mass_agg_bvh;
     RigidBody rb; // TODO(joon) make this a pointer!
 
     // TODO(joon) CollisionVolumeGroup!
     CollisionVolumeCube cv;
 
     AABB aabb; 
+
+    // NOTE(joon) only for the cubes for now, see get_cube_entity_instance_transform
+    u32 raytracer_instance_index;
 };
 
 #endif
@@ -51,16 +51,220 @@
     font_info font_info = load_otf(font);
     /*
        NOTE(joon): How to get glyph outline information
-       1. Get the glyph ID using cmap header & otf_glyph_id_finder
+       1. Get the glyph ID using the decoded cmap(GlyphIDTable)
        2. Get the glyph data offset from the 'loca' block, which has the offsets from the _start_ of the 'glyf' block
        3. 
     */
-    u16 b_glyph_id = otf_get_glyph_id(&font_info.glyph_id_finder, 'b');
+    u16 b_glyph_id = otf_get_glyph_id(&font_info, 'b');
     otf_get_glyph_data(&font_info, b_glyph_id);
 #endif
 
+// NOTE(joon) higher is better, 0 means that we cannot use this subtable
+internal u32
+get_cmap_subtable_score(u16 platform_id, u16 encoding_id, u16 format)
+{
+    u32 result = 0;
+
+    // NOTE(joon) platform 0 is unicode, platform 3 encoding 1 & 10 is windows unicode BMP & full unicode
+    b32 is_unicode = (platform_id == 0) || 
+                     (platform_id == 3 && (encoding_id == 1 || encoding_id == 10));
+    if(is_unicode)
+    {
+        if(format == 12)
+        {
+            // NOTE(joon) full unicode range
+            result = 2;
+        }
+        else if(format == 4)
+        {
+            // NOTE(joon) BMP only
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) The first pass only marks the pages that have any glyph, and the second pass fills up the glyph ids
+internal void
+set_glyph_id_table_entry(GlyphIDTable *table, u32 codepoint, u16 glyph_id, b32 is_marking_pages)
+{
+    if(glyph_id != 0 && glyph_id < table->glyph_count && codepoint <= Max_Codepoint)
+    {
+        u16 *page_index = table->page_indices + codepoint / Glyph_ID_Page_Size;
+        if(is_marking_pages)
+        {
+            *page_index = 1;
+        }
+        else
+        {
+            assert(*page_index != 0);
+            table->pages[(*page_index)*Glyph_ID_Page_Size + (codepoint % Glyph_ID_Page_Size)] = glyph_id;
+        }
+    }
+}
+
+internal void
+decode_cmap_subtable_format_4(GlyphIDTable *table, u8 *subtable, b32 is_marking_pages)
+{
+    otf_encoding_subtable_format_4_header *encoding_header = (otf_encoding_subtable_format_4_header *)subtable;
+    assert(big_to_little_endian(encoding_header->format) == 4);
+
+    u16 twice_of_segment_count = big_to_little_endian(encoding_header->twice_of_segment_count);
+    assert(twice_of_segment_count%2 == 0);
+    u16 segment_count = twice_of_segment_count/2;
+
+    otf_glyph_id_finder finder = {};
+    finder.segment_count = segment_count;
+    finder.end_character_codes = (u16 *)((u8 *)encoding_header + sizeof(*encoding_header));
+    finder.start_character_codes = (u16 *)((u8 *)finder.end_character_codes + sizeof(u16)*(segment_count + 1)); // +1 is because of the reserved value between endcode and startcode
+    finder.id_deltas = (i16 *)((u8 *)finder.start_character_codes + sizeof(u16)*(segment_count));
+    finder.id_range_offsets = (u16 *)((u8 *)finder.id_deltas + sizeof(i16)*(segment_count));
+    finder.glyph_id_array = (u16 *)((u8 *)finder.id_range_offsets + sizeof(u16)*(segment_count));
+
+    for(u32 segment_index = 0;
+            segment_index < finder.segment_count;
+            ++segment_index)
+    {
+        u32 start_character_code = big_to_little_endian(finder.start_character_codes[segment_index]);
+        u32 end_character_code = big_to_little_endian(finder.end_character_codes[segment_index]);
+        u16 id_delta = (u16)big_to_little_endian(finder.id_deltas[segment_index]);
+        u16 id_range_offset = big_to_little_endian(finder.id_range_offsets[segment_index]);
+
+        for(u32 c = start_character_code;
+                c <= end_character_code && c < 0xffff;
+                ++c)
+        {
+            u16 glyph_id = 0;
+            if(id_range_offset == 0)
+            {
+                // NOTE(joon) modulo 65536
+                glyph_id = (u16)(c + id_delta);
+            }
+            else
+            {
+                // NOTE(joon) id_range_offset is the offset in bytes from the id_range_offset itself
+                u16 *glyph_id_address = finder.id_range_offsets + segment_index + id_range_offset/2 + (c - start_character_code);
+                glyph_id = big_to_little_endian(*glyph_id_address);
+                if(glyph_id != 0)
+                {
+                    glyph_id = (u16)(glyph_id + id_delta);
+                }
+            }
+
+            set_glyph_id_table_entry(table, c, glyph_id, is_marking_pages);
+        }
+    }
+}
+
+internal void
+decode_cmap_subtable_format_12(GlyphIDTable *table, u8 *subtable, b32 is_marking_pages)
+{
+    otf_encoding_subtable_format_12_header *encoding_header = (otf_encoding_subtable_format_12_header *)subtable;
+    assert(big_to_little_endian(encoding_header->format) == 12);
+
+    u32 group_count = big_to_little_endian(encoding_header->group_count);
+    otf_sequential_map_group *groups = (otf_sequential_map_group *)(subtable + sizeof(*encoding_header));
+    for(u32 group_index = 0;
+            group_index < group_count;
+            ++group_index)
+    {
+        otf_sequential_map_group *group = groups + group_index;
+        u32 start_character_code = big_to_little_endian(group->start_character_code);
+        u32 end_character_code = minimum(big_to_little_endian(group->end_character_code), (u32)Max_Codepoint);
+        u32 start_glyph_id = big_to_little_endian(group->start_glyph_id);
+
+        for(u32 c = start_character_code;
+                c <= end_character_code;
+                ++c)
+        {
+            set_glyph_id_table_entry(table, c, (u16)(start_glyph_id + (c - start_character_code)), is_marking_pages);
+        }
+    }
+}
+
+/*
+   NOTE(joon) There can be multiple cmap subtables for different platforms & encodings.
+   We pick the one that covers the widest unicode range, and decode it into GlyphIDTable
+   so that we don't need to touch the font file again when we get the glyph id.
+*/
+internal GlyphIDTable
+decode_cmap_block(MemoryArena *arena, u8 *cmap_block, u32 glyph_count)
+{
+    GlyphIDTable result = {};
+    result.glyph_count = glyph_count;
+
+    otf_cmap_block_header *header = (otf_cmap_block_header *)cmap_block;
+    u16 entry_count = big_to_little_endian(header->entry_count);
+    otf_encoding *encodings = (otf_encoding *)(cmap_block + sizeof(*header));
+
+    u8 *best_subtable = 0;
+    u16 best_format = 0;
+    u32 best_score = 0;
+    for(u32 encoding_index = 0;
+            encoding_index < entry_count;
+            ++encoding_index)
+    {
+        otf_encoding *encoding = encodings + encoding_index;
+        u16 encoding_type = big_to_little_endian(encoding->type);
+        u16 encoding_subtype = big_to_little_endian(encoding->subtype);
+        u8 *subtable = cmap_block + big_to_little_endian(encoding->subtable_offset);
+
+        // NOTE(joon) every subtable format starts with the u16 format
+        u16 format = big_to_little_endian(*(u16 *)subtable);
+
+        u32 score = get_cmap_subtable_score(encoding_type, encoding_subtype, format);
+        if(score > best_score)
+        {
+            best_score = score;
+            best_subtable = subtable;
+            best_format = format;
+        }
+    }
+
+    result.page_indices = push_array(arena, u16, Glyph_ID_Page_Index_Count);
+    zero_memory(result.page_indices, sizeof(u16)*Glyph_ID_Page_Index_Count);
+
+    // NOTE(joon) first pass, mark the pages that are being used
+    if(best_format == 4)
+    {
+        decode_cmap_subtable_format_4(&result, best_subtable, true);
+    }
+    else if(best_format == 12)
+    {
+        decode_cmap_subtable_format_12(&result, best_subtable, true);
+    }
+
+    // NOTE(joon) page 0 is reserved for the empty page
+    result.page_count = 1;
+    for(u32 page_index_index = 0;
+            page_index_index < Glyph_ID_Page_Index_Count;
+            ++page_index_index)
+    {
+        if(result.page_indices[page_index_index])
+        {
+            result.page_indices[page_index_index] = (u16)result.page_count++;
+        }
+    }
+
+    result.pages = push_array(arena, u16, result.page_count*Glyph_ID_Page_Size);
+    zero_memory(result.pages, sizeof(u16)*result.page_count*Glyph_ID_Page_Size);
+
+    // NOTE(joon) second pass, fill up the glyph ids
+    if(best_format == 4)
+    {
+        decode_cmap_subtable_format_4(&result, best_subtable, false);
+    }
+    else if(best_format == 12)
+    {
+        decode_cmap_subtable_format_12(&result, best_subtable, false);
+    }
+
+    return result;
+}
+
 internal font_info
-load_otf(platform_read_file_result loaded_font)
+load_otf(MemoryArena *arena, PlatformReadFileResult loaded_font)
 {
     u8 *c = loaded_font.memory;
     otf_header *header = (otf_header *)c;
@@ -74,6 +278,10 @@ load_otf(platform_read_file_result loaded_font)
 
     font_info font_info = {};
 
+    u8 *cmap_block = 0;
+    u8 *hhea_block = 0;
+    u8 *hmtx_block = 0;
+
     for(u32 table_record_index = 0;
             table_record_index < table_count;
             ++table_record_index)
@@ -84,16 +292,16 @@ load_otf(platform_read_file_result loaded_font)
         u32	offset = big_to_little_endian(table_record->offset);
         u32	length = big_to_little_endian(table_record->length);
 
-        if(table_tag == convert_cc("head"))
+        if(table_tag == four_cc("head"))
         {
             otf_head_block_header *header = (otf_head_block_header *)(loaded_font.memory + offset);
             i16 major_version = big_to_little_endian(header->major_version);
             i16 minor_version = big_to_little_endian(header->minor_version);
-            i16 font_revision = big_to_little_endian(header->font_revision);
+            i32 font_revision = big_to_little_endian(header->font_revision);
 
             u32 check_sum_adjustment = big_to_little_endian(header->check_sum_adjustment);
             u32 magic_number = header->magic_number; // should be 0x5f0f3cf5
-            u16 flags = big_to_little_endian(header->check_sum_adjustment);
+            u16 flags = big_to_little_endian(header->flags);
             font_info.resolution = (u32)big_to_little_endian(header->unit_per_em);
             //i64 time_created = big_to_little_endian(header->time_created);
             //i64 time_modified = big_to_little_endian(header->time_modified);
@@ -108,38 +316,20 @@ load_otf(platform_read_file_result loaded_font)
 
             int a = 1;
         }
-        else if(table_tag == convert_cc("cmap"))
+        else if(table_tag == four_cc("cmap"))
         {
-            otf_cmap_block_header *header = (otf_cmap_block_header *)(loaded_font.memory + offset);
-            u16 version = big_to_little_endian(header->version);
-            u16 entry_count = big_to_little_endian(header->entry_count);
-
-            otf_encoding *encodings = (otf_encoding *)((u8 *)header + sizeof(*header));
-
-            u16 encoding_type = big_to_little_endian(encodings->type);
-            u16 encoding_subtype = big_to_little_endian(encodings->subtype);
-            u32 subtable_offset = big_to_little_endian(encodings->subtable_offset);
-
-            // TODO(joon) only supports unicode 2.0 for now
-            assert(encoding_type == 0 && encoding_subtype == 3);
-
-            otf_encoding_subtable_format_4_header *encoding_header = (otf_encoding_subtable_format_4_header *)((u8 *)header + subtable_offset);
-
-            u16 encoding_subtable_format = big_to_little_endian(encoding_header->format);
-            assert(encoding_subtable_format == 4);
-
-            u16 twice_of_segment_count = big_to_little_endian(encoding_header->twice_of_segment_count);
-            assert(twice_of_segment_count%2 == 0);
-            u16 segment_count = twice_of_segment_count/2;
-
-            font_info.glyph_id_finder.segment_count = segment_count;
-            font_info.glyph_id_finder.end_character_codes = (u16 *)((u8 *)encoding_header + sizeof(*encoding_header));
-            font_info.glyph_id_finder.start_character_codes = (u16 *)((u8 *)font_info.glyph_id_finder.end_character_codes + sizeof(u16)*(segment_count + 1)); // +1 is because of the reserved value between endcode and startcode
-            font_info.glyph_id_finder.id_deltas = (i16 *)((u8 *)font_info.glyph_id_finder.start_character_codes + sizeof(u16)*(segment_count));
-            font_info.glyph_id_finder.id_range_offsets = (u16 *)((u8 *)font_info.glyph_id_finder.id_deltas + sizeof(i16)*(segment_count));
-            font_info.glyph_id_finder.glyph_id_array = (u16 *)((u8 *)font_info.glyph_id_finder.id_range_offsets + sizeof(u16)*(segment_count));
+            // NOTE(joon) decoded after we know the glyph count
+            cmap_block = loaded_font.memory + offset;
+        }
+        else if(table_tag == four_cc("hhea"))
+        {
+            hhea_block = loaded_font.memory + offset;
+        }
+        else if(table_tag == four_cc("hmtx"))
+        {
+            hmtx_block = loaded_font.memory + offset;
         }
-        else if(table_tag == convert_cc("EBLC"))
+        else if(table_tag == four_cc("EBLC"))
         {
             otf_EBLC_block_header *header = (otf_EBLC_block_header *)(loaded_font.memory + offset);
 
@@ -150,205 +340,1193 @@ load_otf(platform_read_file_result loaded_font)
             font_info.start_of_eblc_block = loaded_font.memory + offset;
             font_info.bitmap_sizes = (otf_bitmap_size *)((u8 *)header + sizeof(otf_EBLC_block_header));
         }
-        else if(table_tag == convert_cc("EBDT"))
+        else if(table_tag == four_cc("EBDT"))
         {
             // embedded Bitmap Data Table
         }
-        else if(table_tag == convert_cc("maxp"))
+        else if(table_tag == four_cc("maxp"))
         {
             otf_maxp_block_header *header = (otf_maxp_block_header *)(loaded_font.memory + offset);
 
             font_info.glyph_count = big_to_little_endian(header->glyph_count);
+            if(big_to_little_endian(header->version) == 0x00010000)
+            {
+                otf_maxp_block_header_version_1 *header_1 = (otf_maxp_block_header_version_1 *)header;
+
+                // NOTE(joon) composite glyphs are flattened into one outline, so we need whichever one is bigger
+                font_info.max_point_count = maximum(big_to_little_endian(header_1->max_point_count), 
+                                                    big_to_little_endian(header_1->max_composite_point_count));
+                font_info.max_contour_count = maximum(big_to_little_endian(header_1->max_contour_count), 
+                                                      big_to_little_endian(header_1->max_composite_contour_count));
+            }
         }
-        else if(table_tag == convert_cc("loca"))
+        else if(table_tag == four_cc("loca"))
         {
             font_info.glyph_offsets = (void *)(loaded_font.memory + offset);
         }
-        else if(table_tag == convert_cc("glyf"))
+        else if(table_tag == four_cc("glyf"))
         {
             font_info.glyph_data = (loaded_font.memory + offset);
         }
     }
+
+    if(hhea_block && hmtx_block)
+    {
+        otf_hhea_block_header *hhea = (otf_hhea_block_header *)hhea_block;
+        font_info.ascent = big_to_little_endian(hhea->ascender);
+        font_info.descent = big_to_little_endian(hhea->descender);
+        font_info.line_gap = big_to_little_endian(hhea->line_gap);
+
+        u32 horizontal_metric_count = big_to_little_endian(hhea->horizontal_metric_count);
+        assert(horizontal_metric_count > 0);
+
+        otf_horizontal_metric *metrics = (otf_horizontal_metric *)hmtx_block;
+        font_info.advance_widths = push_array(arena, u16, font_info.glyph_count);
+        for(u32 glyph_index = 0;
+                glyph_index < font_info.glyph_count;
+                ++glyph_index)
+        {
+            u32 metric_index = minimum(glyph_index, horizontal_metric_count - 1);
+            font_info.advance_widths[glyph_index] = big_to_little_endian(metrics[metric_index].advance_width);
+        }
+    }
+
+    if(cmap_block)
+    {
+        font_info.glyph_id_table = decode_cmap_block(arena, cmap_block, font_info.glyph_count);
+    }
     
     return font_info;
 }
 
-// TODO(joon) only works for format 4 for now
-internal u16
-otf_get_glyph_id(otf_glyph_id_finder *finder, u16 c)
+// NOTE(joon) returns 0(missing glyph) if the font does not have the glyph for the code point, 
+// or does not have the cmap block at all
+inline u16
+otf_get_glyph_id(font_info *font_info, u32 codepoint)
 {
     u16 result = 0;
 
-    // TODO(joon) only works for ASCII codes for now
-    assert(c < 0xff);
-
-    u32 glyph_segment_index = 0;
-    for(u32 i = 0;
-            i < finder->segment_count;
-            ++i)
+    GlyphIDTable *table = &font_info->glyph_id_table;
+    if(table->page_indices && codepoint <= Max_Codepoint)
     {
-        if(c >= big_to_little_endian(finder->start_character_codes[i]) && 
-            c <= big_to_little_endian(finder->end_character_codes[i]))
-        {
-            glyph_segment_index = i;
-            break;
-        }
+        u32 page_index = table->page_indices[codepoint / Glyph_ID_Page_Size];
+        result = table->pages[page_index*Glyph_ID_Page_Size + (codepoint % Glyph_ID_Page_Size)];
     }
 
-    if(big_to_little_endian(finder->id_range_offsets[glyph_segment_index]) == 0)
-    {
-        result = c + big_to_little_endian(finder->id_deltas[glyph_segment_index]);
-    }
-    else
+    return result;
+}
+
+// NOTE(joon) in font units, 0 if the font does not have the 'hmtx' block or the glyph
+inline u16
+get_glyph_advance_width(font_info *font_info, u16 glyph_id)
+{
+    u16 result = 0;
+    if(font_info->advance_widths && glyph_id < font_info->glyph_count)
     {
-        result = *(&finder->id_range_offsets[glyph_segment_index] + 
-                        big_to_little_endian(finder->id_range_offsets[glyph_segment_index]/2) + 
-                        (c - big_to_little_endian(finder->start_character_codes[glyph_segment_index])));
+        result = font_info->advance_widths[glyph_id];
     }
 
     return result;
 }
 
+// NOTE(joon) glyph data is not aligned at all, so we read the big endian values byte by byte
+inline u16
+otf_read_u16(u8 *c)
+{
+    u16 result = (u16)((c[0] << 8) | c[1]);
 
-internal void
-otf_get_glyph_data(font_info *font_info, u16 glyph_id)
+    return result;
+}
+
+inline i16
+otf_read_i16(u8 *c)
 {
-    u32 offset_to_glyph_data = 0;
+    i16 result = (i16)otf_read_u16(c);
+
+    return result;
+}
+
+// NOTE(joon) 2.14 fixed point number, used for the scales of the composite glyph
+inline f32
+otf_read_f2dot14(u8 *c)
+{
+    f32 result = otf_read_i16(c) / 16384.0f;
 
+    return result;
+}
+
+// NOTE(joon) returns 0 if the glyph does not have any outline(i.e space)
+internal otf_glyf_desc *
+otf_get_glyph_desc(font_info *font_info, u16 glyph_id)
+{
+    assert(glyph_id < font_info->glyph_count);
+
+    u32 offset_to_glyph_data = 0;
+    u32 offset_to_next_glyph_data = 0;
     if(font_info->glyph_offset_type == 0)
     {
-        offset_to_glyph_data = big_to_little_endian(*((u16 *)font_info->glyph_offsets + glyph_id));
+        // NOTE(joon) short version stores the actual offset divided by 2
+        offset_to_glyph_data = 2*otf_read_u16((u8 *)((u16 *)font_info->glyph_offsets + glyph_id));
+        offset_to_next_glyph_data = 2*otf_read_u16((u8 *)((u16 *)font_info->glyph_offsets + glyph_id + 1));
     }
-    if(font_info->glyph_offset_type == 1)
+    else
     {
         offset_to_glyph_data = big_to_little_endian(*((u32 *)font_info->glyph_offsets + glyph_id));
+        offset_to_next_glyph_data = big_to_little_endian(*((u32 *)font_info->glyph_offsets + glyph_id + 1));
     }
 
-    otf_glyf_desc *glyph_desc = (otf_glyf_desc *)(font_info->glyph_data + offset_to_glyph_data);
-    // NOTE(joon): positive - simple glyph, negative - composite glyph
-    // https://docs.microsoft.com/en-us/typography/opentype/spec/glyf
-    i16 number_of_contours = big_to_little_endian(glyph_desc->number_of_contours); 
+    otf_glyf_desc *result = 0;
+    if(offset_to_next_glyph_data > offset_to_glyph_data)
+    {
+        result = (otf_glyf_desc *)(font_info->glyph_data + offset_to_glyph_data);
+    }
+
+    return result;
+}
+
+internal void
+otf_append_glyph_outline(font_info *font_info, GlyphOutline *outline, u16 glyph_id, u32 depth)
+{
+    otf_glyf_desc *glyph_desc = otf_get_glyph_desc(font_info, glyph_id);
+    if(glyph_desc)
+    {
+        // NOTE(joon): positive - simple glyph, negative - composite glyph
+        // https://docs.microsoft.com/en-us/typography/opentype/spec/glyf
+        i16 number_of_contours = otf_read_i16((u8 *)&glyph_desc->number_of_contours); 
 
-    i16 x_min = big_to_little_endian(glyph_desc->x_min);
-    i16 y_min = big_to_little_endian(glyph_desc->y_min);
+        if(number_of_contours >= 0)
+        {
+            /*
+                // simple glyph description
+                u16	end_points_of_contours[number_of_contours]; 
+                u16	instruction_count; // If zero, no instructions are present for this glyph, and this field is followed directly by the flags field.
+                u8	instructions[instruction_count]; // count == instruction_count
+                u8	flags[???]; // count should be gotten by actually parsing the flags
+
+                u8 or int16	dx_from_prev[last element of end_points_of_contours] // As the points can repeat, this does not correspond to the actual total points
+                u8 or int16	dy_from_prev[last element of end_points_of_contours]  
+            */
+            u8 *end_points_of_contours = (u8 *)glyph_desc + sizeof(*glyph_desc);
+            u16 instruction_count = otf_read_u16(end_points_of_contours + sizeof(u16)*number_of_contours);
+            u8 *flags = end_points_of_contours + sizeof(u16)*number_of_contours + sizeof(u16) + instruction_count;
+
+            u32 first_point_index = outline->point_count;
+            u32 point_count = 0;
+            if(number_of_contours > 0)
+            {
+                point_count = otf_read_u16(end_points_of_contours + sizeof(u16)*(number_of_contours - 1)) + 1;
+            }
+            assert(first_point_index + point_count <= outline->max_point_count);
+            assert(outline->contour_count + number_of_contours <= outline->max_contour_count);
 
-    i16 x_max = big_to_little_endian(glyph_desc->x_max);
-    i16 y_max = big_to_little_endian(glyph_desc->x_max);
+            for(i32 contour_index = 0;
+                    contour_index < number_of_contours;
+                    ++contour_index)
+            {
+                outline->contour_end_indices[outline->contour_count++] = 
+                    (u16)(first_point_index + otf_read_u16(end_points_of_contours + sizeof(u16)*contour_index));
+            }
 
-    if(number_of_contours >= 0)
+            // NOTE(joon) As the flags can repeat, we don't know where the coordinates are until we parse all the flags.
+            // Expand them into the is_on_curve array first, and strip them down to the on curve bit at the end.
+            u8 *point_flags = outline->is_on_curve + first_point_index;
+            u8 *c = flags;
+            for(u32 point_index = 0;
+                    point_index < point_count;
+                    )
+            {
+                u8 flag = *c++;
+                u32 repeat_count = 1;
+                if(flag & Otf_Glyph_Flag_Repeat)
+                {
+                    repeat_count += *c++;
+                }
+
+                while(repeat_count-- > 0 && point_index < point_count)
+                {
+                    point_flags[point_index++] = flag;
+                }
+            }
+
+            // NOTE(joon) coordinates are stored as a delta from the previous point
+            i32 x = 0;
+            for(u32 point_index = 0;
+                    point_index < point_count;
+                    ++point_index)
+            {
+                u8 flag = point_flags[point_index];
+                if(flag & Otf_Glyph_Flag_X_Short)
+                {
+                    i32 dx = *c++;
+                    x += (flag & Otf_Glyph_Flag_X_Same_Or_Positive) ? dx : -dx;
+                }
+                else if(!(flag & Otf_Glyph_Flag_X_Same_Or_Positive))
+                {
+                    x += otf_read_i16(c);
+                    c += sizeof(i16);
+                }
+
+                outline->points[first_point_index + point_index].x = (f32)x;
+            }
+
+            i32 y = 0;
+            for(u32 point_index = 0;
+                    point_index < point_count;
+                    ++point_index)
+            {
+                u8 flag = point_flags[point_index];
+                if(flag & Otf_Glyph_Flag_Y_Short)
+                {
+                    i32 dy = *c++;
+                    y += (flag & Otf_Glyph_Flag_Y_Same_Or_Positive) ? dy : -dy;
+                }
+                else if(!(flag & Otf_Glyph_Flag_Y_Same_Or_Positive))
+                {
+                    y += otf_read_i16(c);
+                    c += sizeof(i16);
+                }
+
+                outline->points[first_point_index + point_index].y = (f32)y;
+                point_flags[point_index] = (flag & Otf_Glyph_Flag_On_Curve);
+            }
+
+            outline->point_count += point_count;
+        }
+        else
+        {
+            // NOTE(joon) composite glyph is made of other glyphs, each with its own transform
+            assert(depth < 16);
+
+            u8 *c = (u8 *)glyph_desc + sizeof(*glyph_desc);
+            u16 flags = 0;
+            do
+            {
+                flags = otf_read_u16(c);
+                u16 component_glyph_id = otf_read_u16(c + 2);
+                c += 2*sizeof(u16);
+
+                f32 dx = 0.0f;
+                f32 dy = 0.0f;
+                if(flags & Otf_Component_Flag_Args_Are_Words)
+                {
+                    dx = otf_read_i16(c);
+                    dy = otf_read_i16(c + 2);
+                    c += 2*sizeof(i16);
+                }
+                else
+                {
+                    dx = (i8)c[0];
+                    dy = (i8)c[1];
+                    c += 2;
+                }
+
+                if(!(flags & Otf_Component_Flag_Args_Are_XY_Values))
+                {
+                    // TODO(joon) args are the point indices that should be matched, which is rarely used.
+                    // Not supported for now
+                    dx = 0.0f;
+                    dy = 0.0f;
+                }
+
+                // NOTE(joon) x' = xx*x + yx*y + dx, y' = xy*x + yy*y + dy
+                f32 xx = 1.0f;
+                f32 xy = 0.0f;
+                f32 yx = 0.0f;
+                f32 yy = 1.0f;
+                if(flags & Otf_Component_Flag_Have_Scale)
+                {
+                    xx = yy = otf_read_f2dot14(c);
+                    c += 2;
+                }
+                else if(flags & Otf_Component_Flag_Have_XY_Scale)
+                {
+                    xx = otf_read_f2dot14(c);
+                    yy = otf_read_f2dot14(c + 2);
+                    c += 4;
+                }
+                else if(flags & Otf_Component_Flag_Have_Two_By_Two)
+                {
+                    xx = otf_read_f2dot14(c);
+                    xy = otf_read_f2dot14(c + 2);
+                    yx = otf_read_f2dot14(c + 4);
+                    yy = otf_read_f2dot14(c + 6);
+                    c += 8;
+                }
+
+                u32 first_point_index = outline->point_count;
+                otf_append_glyph_outline(font_info, outline, component_glyph_id, depth + 1);
+
+                for(u32 point_index = first_point_index;
+                        point_index < outline->point_count;
+                        ++point_index)
+                {
+                    v2 p = outline->points[point_index];
+                    outline->points[point_index] = V2(xx*p.x + yx*p.y + dx, 
+                                                      xy*p.x + yy*p.y + dy);
+                }
+            }while(flags & Otf_Component_Flag_More_Components);
+        }
+    }
+}
+
+internal u64
+get_glyph_outline_memory_size(font_info *font_info)
+{
+    u64 result = font_info->max_point_count*(sizeof(v2) + sizeof(u8)) + 
+                 font_info->max_contour_count*sizeof(u16);
+
+    return result;
+}
+
+internal GlyphOutline
+otf_get_glyph_outline(TempMemory *temp_memory, font_info *font_info, u16 glyph_id)
+{
+    GlyphOutline result = {};
+
+    otf_glyf_desc *glyph_desc = otf_get_glyph_desc(font_info, glyph_id);
+    if(glyph_desc)
     {
-        /*
-            // simple glyph description
-            u16	end_points_of_contours[number_of_contours]; 
-            u16	instruction_count; // If zero, no instructions are present for this glyph, and this field is followed directly by the flags field.
-            u8	instructions[instruction_count]; // count == instruction_count
-            u8	flags[???]; // count should be gotten by actually parsing the flags
+        assert(font_info->max_point_count > 0 && font_info->max_contour_count > 0);
+
+        result.max_point_count = font_info->max_point_count;
+        result.max_contour_count = font_info->max_contour_count;
+        result.points = push_array(temp_memory, v2, result.max_point_count);
+        result.is_on_curve = push_array(temp_memory, u8, result.max_point_count);
+        result.contour_end_indices = push_array(temp_memory, u16, result.max_contour_count);
+
+        result.x_min = otf_read_i16((u8 *)&glyph_desc->x_min);
+        result.y_min = otf_read_i16((u8 *)&glyph_desc->y_min);
+        result.x_max = otf_read_i16((u8 *)&glyph_desc->x_max);
+        result.y_max = otf_read_i16((u8 *)&glyph_desc->y_max);
+
+        otf_append_glyph_outline(font_info, &result, glyph_id, 0);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Glyph rasterizer
+
+   Instead of testing each pixel against the outline, each line segment 'accumulates' the signed area
+   that it covers into the accumulation buffer. The coverage of a pixel is then the running sum
+   of the accumulation buffer along the scanline(clamped to 0~1), which gives us an exact analytic coverage
+   of the flattened outline without any supersampling. Curves are flattened based on how much they deviate from the straight line.
+
+   To make the running sum SIMD friendly, the accumulation buffer is interleaved by HB_LANE_WIDTH scanlines,
+   so that each lane sums one scanline.
+*/
+struct GlyphRasterizer
+{
+    f32 *accumulation;
 
-            u8 or int16	dx_from_prev[last element of end_points_of_contours] // As the points can repeat, this does not correspond to the actual total points
-            u8 or int16	dy_from_prev[last element of end_points_of_contours]  
-        */
+    u32 width;
+    u32 height; // rounded up to HB_LANE_WIDTH
+    u32 stride; // width + 2, as the line can touch x == width + 1
+};
 
-        assert(number_of_contours > 0);
+inline f32 *
+get_glyph_accumulation(GlyphRasterizer *rasterizer, i32 x, u32 y)
+{
+    u32 row_group_index = y / HB_LANE_WIDTH;
+    u32 lane = y % HB_LANE_WIDTH;
+
+    f32 *result = rasterizer->accumulation + HB_LANE_WIDTH*(row_group_index*rasterizer->stride + x) + lane;
 
-        u16 *end_points_of_contours = (u16 *)((u8 *)glyph_desc + sizeof(*glyph_desc));
+    return result;
+}
+
+internal void
+rasterize_glyph_line(GlyphRasterizer *rasterizer, v2 p0, v2 p1)
+{
+    if(p0.y != p1.y)
+    {
+        f32 dir = 1.0f;
+        if(p0.y > p1.y)
+        {
+            dir = -1.0f;
+            v2 temp = p0;
+            p0 = p1;
+            p1 = temp;
+        }
 
-        u16 instruction_count = big_to_little_endian(*(u16 *)((u8 *)end_points_of_contours + sizeof(u16)*number_of_contours));
-        u8 *instructions = (u8 *)end_points_of_contours + sizeof(u16)*number_of_contours + sizeof(u16);
-        u8 *flags = instructions + instruction_count;
+        f32 max_x = (f32)rasterizer->width;
+        p0.x = clamp(0.0f, p0.x, max_x);
+        p1.x = clamp(0.0f, p1.x, max_x);
 
-        u16 n = big_to_little_endian(end_points_of_contours[number_of_contours - 1]) + 1;
+        f32 dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+        f32 x = p0.x;
+        if(p0.y < 0.0f)
+        {
+            x -= p0.y*dxdy;
+        }
 
-        // As we do not know how many flags there are(which means we also only know where the dxs & dys are
-        // inside the simple glphy description), we have to first parse the flags
-        // while  the flag_count < end_points_of_contours[number_of_contours - 1] + 1
-        u32 flag_count = 0;
-        u8 *f = flags;
-        u32 x_coord_bytes = 0;
-        u32 y_coord_bytes = 0;
-        while(flag_count < n)
+        u32 start_y = (u32)maximum(p0.y, 0.0f);
+        u32 end_y = (u32)minimum(ceilf(p1.y), (f32)rasterizer->height);
+        for(u32 y = start_y;
+                y < end_y;
+                ++y)
         {
-            u8 flag = *f;
-            if(flag & 0x8)
+            f32 dy = minimum((f32)(y + 1), p1.y) - maximum((f32)y, p0.y);
+            f32 next_x = x + dxdy*dy;
+            f32 d = dy*dir;
+
+            f32 x0 = minimum(x, next_x);
+            f32 x1 = maximum(x, next_x);
+            f32 x0_floor = floorf(x0);
+            i32 x0i = (i32)x0_floor;
+            f32 x1_ceil = ceilf(x1);
+            i32 x1i = (i32)x1_ceil;
+
+            if(x1i <= x0i + 1)
             {
-                // if repeat, the next byte is the number of how many times this flag should repeat
-                flag_count += *(++f);
-                f++;
+                // NOTE(joon) the line stays inside one pixel
+                f32 xmf = 0.5f*(x + next_x) - x0_floor;
+                *get_glyph_accumulation(rasterizer, x0i, y) += d - d*xmf;
+                *get_glyph_accumulation(rasterizer, x0i + 1, y) += d*xmf;
             }
             else
             {
-                flag_count++;
-                f++;
+                f32 s = 1.0f / (x1 - x0);
+                f32 x0f = x0 - x0_floor;
+                f32 a0 = 0.5f*s*(1.0f - x0f)*(1.0f - x0f);
+                f32 x1f = x1 - x1_ceil + 1.0f;
+                f32 am = 0.5f*s*x1f*x1f;
+
+                *get_glyph_accumulation(rasterizer, x0i, y) += d*a0;
+                if(x1i == x0i + 2)
+                {
+                    *get_glyph_accumulation(rasterizer, x0i + 1, y) += d*(1.0f - a0 - am);
+                }
+                else
+                {
+                    f32 a1 = s*(1.5f - x0f);
+                    *get_glyph_accumulation(rasterizer, x0i + 1, y) += d*(a1 - a0);
+                    for(i32 xi = x0i + 2;
+                            xi < x1i - 1;
+                            ++xi)
+                    {
+                        *get_glyph_accumulation(rasterizer, xi, y) += d*s;
+                    }
+
+                    f32 a2 = a1 + (x1i - x0i - 3)*s;
+                    *get_glyph_accumulation(rasterizer, x1i - 1, y) += d*(1.0f - a2 - am);
+                }
+
+                *get_glyph_accumulation(rasterizer, x1i, y) += d*am;
+            }
+
+            x = next_x;
+        }
+    }
+}
+
+internal void
+rasterize_glyph_quadratic_bezier(GlyphRasterizer *rasterizer, v2 p0, v2 p1, v2 p2)
+{
+    f32 dev_x = p0.x - 2.0f*p1.x + p2.x;
+    f32 dev_y = p0.y - 2.0f*p1.y + p2.y;
+    f32 dev_square = dev_x*dev_x + dev_y*dev_y;
+
+    if(dev_square < 0.333f)
+    {
+        // NOTE(joon) close enough to the straight line
+        rasterize_glyph_line(rasterizer, p0, p2);
+    }
+    else
+    {
+        f32 tolerance = 3.0f;
+        u32 segment_count = 1 + (u32)floorf(sqrtf(sqrtf(tolerance*dev_square)));
+        f32 dt = 1.0f / segment_count;
+
+        v2 p = p0;
+        f32 t = 0.0f;
+        for(u32 segment_index = 0;
+                segment_index < segment_count - 1;
+                ++segment_index)
+        {
+            t += dt;
+            f32 one_minus_t = 1.0f - t;
+            v2 next_p = V2(one_minus_t*one_minus_t*p0.x + 2.0f*one_minus_t*t*p1.x + t*t*p2.x,
+                           one_minus_t*one_minus_t*p0.y + 2.0f*one_minus_t*t*p1.y + t*t*p2.y);
+
+            rasterize_glyph_line(rasterizer, p, next_p);
+            p = next_p;
+        }
+
+        rasterize_glyph_line(rasterizer, p, p2);
+    }
+}
+
+// NOTE(joon) converts font units(y up) to the bitmap space(y down)
+inline v2
+get_glyph_bitmap_p(v2 p, f32 scale, f32 bitmap_x, f32 bitmap_top)
+{
+    v2 result = V2(scale*p.x - bitmap_x, bitmap_top - scale*p.y);
+
+    return result;
+}
+
+internal void
+rasterize_glyph_outline(GlyphRasterizer *rasterizer, GlyphOutline *outline, f32 scale, f32 bitmap_x, f32 bitmap_top)
+{
+    u32 first_point_index = 0;
+    for(u32 contour_index = 0;
+            contour_index < outline->contour_count;
+            ++contour_index)
+    {
+        u32 end_point_index = outline->contour_end_indices[contour_index];
+        u32 point_count = end_point_index + 1 - first_point_index;
+
+        v2 *points = outline->points + first_point_index;
+        u8 *is_on_curve = outline->is_on_curve + first_point_index;
+
+        if(point_count >= 2)
+        {
+            u32 first_on_curve_index = U32_Max;
+            for(u32 point_index = 0;
+                    point_index < point_count;
+                    ++point_index)
+            {
+                if(is_on_curve[point_index])
+                {
+                    first_on_curve_index = point_index;
+                    break;
+                }
             }
 
-            if(flag & 0x2)
+            v2 start_p = {};
+            v2 control_p = {};
+            b32 has_control_p = false;
+            u32 first_k = 1;
+            u32 start_index = first_on_curve_index;
+            if(first_on_curve_index == U32_Max)
             {
-                // x is one byte long, and the sign depends on the 0x10 bit
-                x_coord_bytes++;
+                // NOTE(joon) every point is off curve, so start from the implied on curve point
+                start_p = (points[0] + points[1]) / 2.0f;
+                control_p = points[1];
+                has_control_p = true;
+                first_k = 2;
+                start_index = 0;
             }
             else
             {
-                if(flag & 0x10)
+                start_p = points[first_on_curve_index];
+            }
+
+            v2 current_p = start_p;
+            for(u32 k = first_k;
+                    k <= point_count;
+                    ++k)
+            {
+                u32 point_index = (start_index + k) % point_count;
+                v2 p = points[point_index];
+
+                if(is_on_curve[point_index])
                 {
-                    // same as prev
+                    if(has_control_p)
+                    {
+                        rasterize_glyph_quadratic_bezier(rasterizer, 
+                                                         get_glyph_bitmap_p(current_p, scale, bitmap_x, bitmap_top), 
+                                                         get_glyph_bitmap_p(control_p, scale, bitmap_x, bitmap_top), 
+                                                         get_glyph_bitmap_p(p, scale, bitmap_x, bitmap_top));
+                    }
+                    else
+                    {
+                        rasterize_glyph_line(rasterizer, 
+                                             get_glyph_bitmap_p(current_p, scale, bitmap_x, bitmap_top), 
+                                             get_glyph_bitmap_p(p, scale, bitmap_x, bitmap_top));
+                    }
+
+                    current_p = p;
+                    has_control_p = false;
                 }
                 else
                 {
-                    // x is two bytes long, and intrepreted as signed integer
-                    x_coord_bytes += 2;
+                    if(has_control_p)
+                    {
+                        v2 mid_p = (control_p + p) / 2.0f;
+                        rasterize_glyph_quadratic_bezier(rasterizer, 
+                                                         get_glyph_bitmap_p(current_p, scale, bitmap_x, bitmap_top), 
+                                                         get_glyph_bitmap_p(control_p, scale, bitmap_x, bitmap_top), 
+                                                         get_glyph_bitmap_p(mid_p, scale, bitmap_x, bitmap_top));
+                        current_p = mid_p;
+                    }
+
+                    control_p = p;
+                    has_control_p = true;
                 }
             }
 
-            if(flag & 0x4)
+            // NOTE(joon) close the contour
+            if(has_control_p)
             {
-                // y is one byte long, and the sign depends on the 0x20 bit
-                y_coord_bytes++;
+                rasterize_glyph_quadratic_bezier(rasterizer, 
+                                                 get_glyph_bitmap_p(current_p, scale, bitmap_x, bitmap_top), 
+                                                 get_glyph_bitmap_p(control_p, scale, bitmap_x, bitmap_top), 
+                                                 get_glyph_bitmap_p(start_p, scale, bitmap_x, bitmap_top));
             }
             else
             {
-                if(flag & 0x20)
+                rasterize_glyph_line(rasterizer, 
+                                     get_glyph_bitmap_p(current_p, scale, bitmap_x, bitmap_top), 
+                                     get_glyph_bitmap_p(start_p, scale, bitmap_x, bitmap_top));
+            }
+        }
+
+        first_point_index = end_point_index + 1;
+    }
+}
+
+// NOTE(joon) running sum of the accumulation buffer, HB_LANE_WIDTH scanlines at a time
+internal void
+resolve_glyph_coverage(GlyphRasterizer *rasterizer, u32 width, u32 height, u8 *dest, u32 dest_pitch)
+{
+    simd_f32 one = simd_f32_(1.0f);
+    simd_f32 max_value = simd_f32_(255.0f);
+    simd_f32 half = simd_f32_(0.5f);
+
+    for(u32 row_group_y = 0;
+            row_group_y < rasterizer->height;
+            row_group_y += HB_LANE_WIDTH)
+    {
+        simd_f32 sum = simd_f32_(0.0f);
+        for(u32 x = 0;
+                x < width;
+                ++x)
+        {
+            sum += simd_f32_load(get_glyph_accumulation(rasterizer, x, row_group_y));
+
+            simd_f32 coverage = min(max(sum, -sum), one);
+            simd_u32 value = convert_u32_from_f32(coverage*max_value + half);
+
+            for(u32 lane = 0;
+                    lane < HB_LANE_WIDTH;
+                    ++lane)
+            {
+                u32 y = row_group_y + lane;
+                if(y < height)
+                {
+                    dest[y*dest_pitch + x] = (u8)get_lane(value, lane);
+                }
+            }
+        }
+    }
+}
+
+// NOTE(joon) pixel_size is the size of the em square in pixels
+internal f32
+get_font_scale(font_info *font_info, u32 pixel_size)
+{
+    f32 result = (f32)pixel_size / (f32)font_info->resolution;
+
+    return result;
+}
+
+struct GlyphBitmapDim
+{
+    i32 x; // left edge, relative to the pen position
+    i32 top; // top edge, relative to the baseline(y up)
+    u32 width;
+    u32 height;
+};
+
+internal GlyphBitmapDim
+get_glyph_bitmap_dim(otf_glyf_desc *glyph_desc, f32 scale)
+{
+    GlyphBitmapDim result = {};
+
+    if(glyph_desc)
+    {
+        i32 x0 = (i32)floorf(scale*otf_read_i16((u8 *)&glyph_desc->x_min));
+        i32 x1 = (i32)ceilf(scale*otf_read_i16((u8 *)&glyph_desc->x_max));
+        i32 y0 = (i32)floorf(scale*otf_read_i16((u8 *)&glyph_desc->y_min));
+        i32 y1 = (i32)ceilf(scale*otf_read_i16((u8 *)&glyph_desc->y_max));
+
+        result.x = x0;
+        result.top = y1;
+        result.width = (u32)(x1 - x0);
+        result.height = (u32)(y1 - y0);
+    }
+
+    return result;
+}
+
+internal u64
+get_glyph_rasterizer_memory_size(u32 width, u32 height)
+{
+    u32 rounded_height = HB_LANE_WIDTH*((height + HB_LANE_WIDTH - 1) / HB_LANE_WIDTH);
+    u64 result = sizeof(f32)*(width + 2)*rounded_height;
+
+    return result;
+}
+
+// NOTE(joon) temp memory should be zeroed, as we use it as the accumulation buffer.
+// dest should be able to hold dim.height rows of dim.width bytes
+internal void
+rasterize_glyph(TempMemory *temp_memory, GlyphOutline *outline, f32 scale, GlyphBitmapDim dim, u8 *dest, u32 dest_pitch)
+{
+    if(dim.width > 0 && dim.height > 0)
+    {
+        GlyphRasterizer rasterizer = {};
+        rasterizer.width = dim.width;
+        rasterizer.height = HB_LANE_WIDTH*((dim.height + HB_LANE_WIDTH - 1) / HB_LANE_WIDTH);
+        rasterizer.stride = dim.width + 2;
+        rasterizer.accumulation = (f32 *)push_size(temp_memory, get_glyph_rasterizer_memory_size(dim.width, dim.height));
+
+        rasterize_glyph_outline(&rasterizer, outline, scale, (f32)dim.x, (f32)dim.top);
+        resolve_glyph_coverage(&rasterizer, dim.width, dim.height, dest, dest_pitch);
+    }
+}
+
+internal void
+clear_glyph_atlas(GlyphAtlas *atlas)
+{
+    atlas->skyline_count = 1;
+    atlas->skyline[0].x = 0;
+    atlas->skyline[0].y = 0;
+    atlas->skyline[0].width = atlas->width;
+
+    for(u32 entry_index = 0;
+            entry_index < array_count(atlas->entries);
+            ++entry_index)
+    {
+        atlas->entries[entry_index].key = Glyph_Atlas_Empty_Key;
+    }
+    atlas->entry_count = 0;
+
+    zero_memory(atlas->pixels, atlas->width*atlas->height);
+    atlas->generation++;
+    atlas->clear_count++;
+}
+
+internal void
+init_glyph_atlas(GlyphAtlas *atlas, MemoryArena *arena, u32 width, u32 height)
+{
+    atlas->width = width;
+    atlas->height = height;
+    atlas->pixels = push_array(arena, u8, width*height);
+
+    clear_glyph_atlas(atlas);
+}
+
+// NOTE(joon) finds the position where the top of the rect would be the lowest
+internal b32
+find_glyph_atlas_skyline_position(GlyphAtlas *atlas, u32 width, u32 height, 
+                                  u32 *best_node_index, u32 *best_x, u32 *best_y)
+{
+    b32 result = false;
+
+    u32 best_bottom = U32_Max;
+    u32 best_node_width = U32_Max;
+    for(u32 node_index = 0;
+            node_index < atlas->skyline_count;
+            ++node_index)
+    {
+        GlyphAtlasSkylineNode *node = atlas->skyline + node_index;
+        if(node->x + width > atlas->width)
+        {
+            break;
+        }
+
+        // NOTE(joon) the rect should sit on the highest node that it spans
+        u32 y = 0;
+        u32 remaining_width = width;
+        for(u32 span_index = node_index;
+                remaining_width > 0;
+                ++span_index)
+        {
+            GlyphAtlasSkylineNode *span_node = atlas->skyline + span_index;
+            y = maximum(y, span_node->y);
+            remaining_width = (span_node->width >= remaining_width) ? 0 : remaining_width - span_node->width;
+        }
+
+        u32 bottom = y + height;
+        if(bottom <= atlas->height)
+        {
+            if(bottom < best_bottom || 
+              (bottom == best_bottom && node->width < best_node_width))
+            {
+                best_bottom = bottom;
+                best_node_width = node->width;
+
+                *best_node_index = node_index;
+                *best_x = node->x;
+                *best_y = y;
+
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+internal void
+remove_glyph_atlas_skyline_node(GlyphAtlas *atlas, u32 node_index)
+{
+    for(u32 i = node_index;
+            i < atlas->skyline_count - 1;
+            ++i)
+    {
+        atlas->skyline[i] = atlas->skyline[i + 1];
+    }
+    atlas->skyline_count--;
+}
+
+internal b32
+add_glyph_atlas_skyline_level(GlyphAtlas *atlas, u32 node_index, u32 x, u32 y, u32 width)
+{
+    b32 result = false;
+    if(atlas->skyline_count < array_count(atlas->skyline))
+    {
+        for(u32 i = atlas->skyline_count;
+                i > node_index;
+                --i)
+        {
+            atlas->skyline[i] = atlas->skyline[i - 1];
+        }
+        atlas->skyline_count++;
+
+        GlyphAtlasSkylineNode *new_node = atlas->skyline + node_index;
+        new_node->x = x;
+        new_node->y = y;
+        new_node->width = width;
+
+        // NOTE(joon) shrink or remove the nodes that are now covered by the new node
+        u32 node_end_x = x + width;
+        while(node_index + 1 < atlas->skyline_count)
+        {
+            GlyphAtlasSkylineNode *node = atlas->skyline + node_index + 1;
+            if(node->x < node_end_x)
+            {
+                u32 shrink = node_end_x - node->x;
+                if(node->width > shrink)
                 {
-                    // same as prev
+                    node->x += shrink;
+                    node->width -= shrink;
+                    break;
                 }
                 else
                 {
-                    // y is two bytes long, and intrepreted as signed integer
-                    y_coord_bytes += 2;
+                    remove_glyph_atlas_skyline_node(atlas, node_index + 1);
                 }
             }
+            else
+            {
+                break;
+            }
         }
 
-        u8 *x_coords = f;
-        u8 *y_coords = f + x_coord_bytes;
+        // NOTE(joon) merge the neighbours with the same height
+        for(u32 i = 0;
+                i + 1 < atlas->skyline_count;
+                )
+        {
+            if(atlas->skyline[i].y == atlas->skyline[i + 1].y)
+            {
+                atlas->skyline[i].width += atlas->skyline[i + 1].width;
+                remove_glyph_atlas_skyline_node(atlas, i + 1);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+// NOTE(joon) 1 texel gap between the glyphs, so that the bilinear filtering does not bleed
+#define Glyph_Atlas_Padding 1
+
+internal b32
+allocate_glyph_atlas_rect(GlyphAtlas *atlas, u32 width, u32 height, u32 *x, u32 *y)
+{
+    b32 result = false;
+
+    u32 padded_width = width + Glyph_Atlas_Padding;
+    u32 padded_height = height + Glyph_Atlas_Padding;
+    u32 node_index = 0;
+    if(find_glyph_atlas_skyline_position(atlas, padded_width, padded_height, &node_index, x, y))
+    {
+        result = add_glyph_atlas_skyline_level(atlas, node_index, *x, *y + padded_height, padded_width);
+    }
+
+    return result;
+}
+
+inline u32
+get_glyph_atlas_key(u16 glyph_id, u32 pixel_size)
+{
+    assert(pixel_size < 0xffff);
+    u32 result = glyph_id | (pixel_size << 16);
+
+    return result;
+}
+
+// NOTE(joon) returns the entry with the key, or the empty entry where the key should go
+internal GlyphAtlasEntry *
+find_glyph_atlas_entry(GlyphAtlas *atlas, u32 key)
+{
+    GlyphAtlasEntry *result = 0;
 
-        for(u32 flag_index = 0;
-                flag_index <= flag_count;
-                ++flag_index)
+    u32 entry_count = array_count(atlas->entries);
+    u32 first_index = (key*2654435761u) % entry_count;
+    u32 search_index = first_index;
+    while(!result)
+    {
+        GlyphAtlasEntry *search = atlas->entries + search_index;
+        if(search->key == key || search->key == Glyph_Atlas_Empty_Key)
+        {
+            result = search;
+        }
+        else
         {
-            u8 flag = flags[flag_index];
+            search_index = (search_index + 1) % entry_count;
+            assert(search_index != first_index); // every entry is full!
         }
     }
-    else
+
+    return result;
+}
+
+/*
+   NOTE(joon) Returns the cached glyph, or rasterizes it into the atlas if it's not there.
+   As the atlas gets cleared when it's full, the entries that were returned before might not be valid anymore
+   if this function rasterized a new glyph - so the caller should not hold onto the entries across the calls
+   unless the atlas generation stayed the same.
+*/
+internal GlyphAtlasEntry *
+get_glyph_atlas_entry(GlyphAtlas *atlas, font_info *font_info, MemoryArena *transient_arena, u16 glyph_id, u32 pixel_size)
+{
+    u32 key = get_glyph_atlas_key(glyph_id, pixel_size);
+    GlyphAtlasEntry *result = find_glyph_atlas_entry(atlas, key);
+
+    if(result->key != key)
     {
-        assert(number_of_contours == -1);
-        // composite glyph description
+        if(atlas->entry_count >= 3*array_count(atlas->entries)/4)
+        {
+            // NOTE(joon) keep the hash table sparse enough so that the probing stays short
+            clear_glyph_atlas(atlas);
+            result = find_glyph_atlas_entry(atlas, key);
+        }
+
+        f32 scale = get_font_scale(font_info, pixel_size);
+        GlyphBitmapDim dim = get_glyph_bitmap_dim(otf_get_glyph_desc(font_info, glyph_id), scale);
+
+        u32 x = 0;
+        u32 y = 0;
+        if(dim.width > 0 && dim.height > 0)
+        {
+            if(!allocate_glyph_atlas_rect(atlas, dim.width, dim.height, &x, &y))
+            {
+                clear_glyph_atlas(atlas);
+                result = find_glyph_atlas_entry(atlas, key);
+
+                b32 allocated = allocate_glyph_atlas_rect(atlas, dim.width, dim.height, &x, &y);
+                assert(allocated); // glyph is bigger than the whole atlas
+            }
+
+            // NOTE(joon) zeroed, as the rasterizer uses it as the accumulation buffer
+            TempMemory temp_memory = start_temp_memory(transient_arena, 
+                                                       get_glyph_outline_memory_size(font_info) + 
+                                                       get_glyph_rasterizer_memory_size(dim.width, dim.height) + 64);
+            GlyphOutline outline = otf_get_glyph_outline(&temp_memory, font_info, glyph_id);
+            rasterize_glyph(&temp_memory, &outline, scale, dim, atlas->pixels + y*atlas->width + x, atlas->width);
+            end_temp_memory(&temp_memory);
+
+            atlas->generation++;
+        }
+
+        result->key = key;
+        result->x = (u16)x;
+        result->y = (u16)y;
+        result->width = (u16)dim.width;
+        result->height = (u16)dim.height;
+        result->offset_x = (i16)dim.x;
+        result->offset_y = (i16)(-dim.top);
+
+        atlas->entry_count++;
     }
+
+    return result;
 }
 
+// NOTE(joon) returns the code point and advances the string, invalid bytes are returned as they are
+internal u32
+decode_utf8(char **string)
+{
+    u8 *c = (u8 *)*string;
+
+    u32 result = c[0];
+    u32 byte_count = 1;
+    if((c[0] & 0xe0) == 0xc0 && (c[1] & 0xc0) == 0x80)
+    {
+        result = ((c[0] & 0x1f) << 6) | (c[1] & 0x3f);
+        byte_count = 2;
+    }
+    else if((c[0] & 0xf0) == 0xe0 && (c[1] & 0xc0) == 0x80 && (c[2] & 0xc0) == 0x80)
+    {
+        result = ((c[0] & 0x0f) << 12) | ((c[1] & 0x3f) << 6) | (c[2] & 0x3f);
+        byte_count = 3;
+    }
+    else if((c[0] & 0xf8) == 0xf0 && (c[1] & 0xc0) == 0x80 && (c[2] & 0xc0) == 0x80 && (c[3] & 0xc0) == 0x80)
+    {
+        result = ((c[0] & 0x07) << 18) | ((c[1] & 0x3f) << 12) | ((c[2] & 0x3f) << 6) | (c[3] & 0x3f);
+        byte_count = 4;
+    }
 
+    *string += byte_count;
 
+    return result;
+}
 
+/*
+   NOTE(joon) When the atlas gets cleared, the text entries that were pushed before in the same frame
+   (and the first part of the entry that is being pushed) point to texels that are not there anymore.
+   Each text entry keeps the glyph ids, so we put those glyphs back into the atlas and fix up the instances.
+   Only the atlas position can change, the size and the offset of a glyph stay the same.
+*/
+internal void
+restore_frame_text_glyphs(RenderGroup *render_group, GlyphAtlas *atlas, MemoryArena *transient_arena)
+{
+    PlatformRenderPushBuffer *render_push_buffer = render_group->render_push_buffer;
+
+    // NOTE(joon) the atlas can be cleared again while putting the glyphs back, which is fine once
+    // (the old glyphs from the previous frames were taking the space), but the second time means that
+    // the glyphs of this frame cannot fit in the atlas together
+    u32 pass_count = 0;
+    while(render_group->text_atlas_clear_count != atlas->clear_count && 
+          pass_count < 2)
+    {
+        render_group->text_atlas_clear_count = atlas->clear_count;
 
+        for(u32 text_entry_index = 0;
+                text_entry_index < render_group->text_entry_count;
+                ++text_entry_index)
+        {
+            RenderEntryText *entry = (RenderEntryText *)(render_push_buffer->base + render_group->text_entry_offsets[text_entry_index]);
+            TextGlyphInstance *instances = (TextGlyphInstance *)(entry + 1);
+            u16 *glyph_ids = (u16 *)(instances + entry->glyph_count);
 
+            for(u32 glyph_index = 0;
+                    glyph_index < entry->glyph_count;
+                    ++glyph_index)
+            {
+                GlyphAtlasEntry *glyph = get_glyph_atlas_entry(atlas, entry->font, transient_arena, glyph_ids[glyph_index], entry->pixel_size);
 
+                TextGlyphInstance *instance = instances + glyph_index;
+                instance->atlas_x = glyph->x;
+                instance->atlas_y = glyph->y;
+            }
+        }
 
+        pass_count++;
+    }
 
+    // NOTE(joon) Make the atlas bigger!
+    assert(render_group->text_atlas_clear_count == atlas->clear_count);
+}
 
+/*
+   NOTE(joon) Lays out the string and pushes one TextGlyphInstance per visible glyph, all in one contiguous entry.
+   top_left is in pixels from the top left corner of the screen, and pixel_size is the size of the em square.
 
+   This lives here instead of hb_render_group.cpp because the platform layer also includes hb_render_group.cpp,
+   and it does not know anything about the fonts.
+   
+   If the atlas gets full while laying out, the glyphs that were pushed before in the same frame are put back
+   into the atlas, see restore_frame_text_glyphs.
+*/
+internal void
+push_text(RenderGroup *render_group, GlyphAtlas *atlas, font_info *font_info, MemoryArena *transient_arena,
+          char *string, v2 top_left, u32 pixel_size, v3 color)
+{
+    PlatformRenderPushBuffer *render_push_buffer = render_group->render_push_buffer;
 
+    // NOTE(joon) the byte count is always bigger or equal to the glyph count
+    u32 max_glyph_count = 0;
+    while(string[max_glyph_count] != '\0')
+    {
+        max_glyph_count++;
+    }
 
+    if(render_group->text_entry_count == 0)
+    {
+        render_group->text_atlas_clear_count = atlas->clear_count;
+    }
+    assert(render_group->text_entry_count < array_count(render_group->text_entry_offsets));
+
+    u32 entry_offset = render_push_buffer->used;
+    RenderEntryText *entry = (RenderEntryText *)(render_push_buffer->base + entry_offset);
+    TextGlyphInstance *instances = (TextGlyphInstance *)(entry + 1);
+    // NOTE(joon) glyph ids are gathered after the room for the instances, and moved next to the instances
+    // when we know how many glyphs are visible
+    u16 *max_glyph_ids = (u16 *)(instances + max_glyph_count);
+    assert(entry_offset + get_render_entry_text_size(max_glyph_count) <= render_push_buffer->total_size);
+
+    entry->header.type = RenderEntryType_Text;
+    entry->glyph_count = 0;
+    entry->font = font_info;
+    entry->pixel_size = pixel_size;
+
+    u32 packed_color = (round_r32_to_u32(255.0f*clamp01(color.r)) << 0) |
+                       (round_r32_to_u32(255.0f*clamp01(color.g)) << 8) |
+                       (round_r32_to_u32(255.0f*clamp01(color.b)) << 16) |
+                       (0xffu << 24);
+
+    f32 scale = get_font_scale(font_info, pixel_size);
+    f32 line_advance = scale*(font_info->ascent - font_info->descent + font_info->line_gap);
+
+    f32 pen_x = top_left.x;
+    f32 baseline_y = top_left.y + scale*font_info->ascent;
+
+    char *c = string;
+    while(*c != '\0')
+    {
+        u32 codepoint = decode_utf8(&c);
+        if(codepoint == '\n')
+        {
+            pen_x = top_left.x;
+            baseline_y += line_advance;
+        }
+        else
+        {
+            u16 glyph_id = otf_get_glyph_id(font_info, codepoint);
+            GlyphAtlasEntry *glyph = get_glyph_atlas_entry(atlas, font_info, transient_arena, glyph_id, pixel_size);
 
+            if(glyph->width > 0 && glyph->height > 0)
+            {
+                max_glyph_ids[entry->glyph_count] = glyph_id;
+
+                TextGlyphInstance *instance = instances + entry->glyph_count++;
+                instance->x = (i16)(round_r32_to_i32(pen_x) + glyph->offset_x);
+                instance->y = (i16)(round_r32_to_i32(baseline_y) + glyph->offset_y);
+                instance->atlas_x = glyph->x;
+                instance->atlas_y = glyph->y;
+                instance->width = glyph->width;
+                instance->height = glyph->height;
+                instance->color = packed_color;
+            }
 
+            pen_x += scale*get_glyph_advance_width(font_info, glyph_id);
+        }
+    }
 
+    u16 *glyph_ids = (u16 *)(instances + entry->glyph_count);
+    memmove(glyph_ids, max_glyph_ids, sizeof(u16)*entry->glyph_count);
 
+    render_group->text_entry_offsets[render_group->text_entry_count++] = entry_offset;
+    render_push_buffer->used += get_render_entry_text_size(entry->glyph_count);
 
+    restore_frame_text_glyphs(render_group, atlas, transient_arena);
 
+    render_push_buffer->glyph_atlas_pixels = atlas->pixels;
+    render_push_buffer->glyph_atlas_width = atlas->width;
+    render_push_buffer->glyph_atlas_height = atlas->height;
+    render_push_buffer->glyph_atlas_generation = atlas->generation;
+}
@@ -142,6 +142,54 @@ struct otf_encoding_subtable_format_4_header
 };
 
 
+struct otf_encoding_subtable_format_12_header
+{
+    u16 format; // should be 12
+    u16 reserved;
+    u32 length; // including the header
+    u32 language;
+    u32 group_count;
+
+    // NOTE(joon) followed by otf_sequential_map_group[group_count]
+};
+
+struct otf_sequential_map_group
+{
+    u32 start_character_code;
+    u32 end_character_code;
+    u32 start_glyph_id; // glyph id of the start_character_code, and it increments by 1 until the end_character_code
+};
+
+struct otf_hhea_block_header
+{
+    u16 major_version;
+    u16 minor_version;
+
+    // NOTE(joon) in font units, baseline is 0
+    i16 ascender;
+    i16 descender;
+    i16 line_gap;
+
+    u16 advance_width_max;
+    i16 min_left_side_bearing;
+    i16 min_right_side_bearing;
+    i16 x_max_extent;
+    i16 caret_slope_rise;
+    i16 caret_slope_run;
+    i16 caret_offset;
+    i16 reserved[4];
+    i16 metric_data_format; // should be 0
+    u16 horizontal_metric_count; // number of the otf_horizontal_metric in the 'hmtx' block
+};
+
+// NOTE(joon) 'hmtx' block has horizontal_metric_count of these, followed by the left side bearings of the rest of the glyphs.
+// Glyphs after the horizontal_metric_count share the advance width of the last metric(usually monospaced glyphs at the end)
+struct otf_horizontal_metric
+{
+    u16 advance_width;
+    i16 left_side_bearing;
+};
+
 struct otf_maxp_block_header
 {
     // NOTE(joon) Just includes maxp header from version 0.5
@@ -149,6 +197,27 @@ struct otf_maxp_block_header
     u16 glyph_count;
 };
 
+// NOTE(joon) version 1.0 is only used by the fonts with the 'glyf' block, and it tells us
+// how much memory we need to decode any glyph outline in the font
+struct otf_maxp_block_header_version_1
+{
+    u32 version; // should be 0x00010000
+    u16 glyph_count;
+    u16 max_point_count; // in a simple glyph
+    u16 max_contour_count; // in a simple glyph
+    u16 max_composite_point_count;
+    u16 max_composite_contour_count;
+    u16 max_zones;
+    u16 max_twilight_points;
+    u16 max_storage;
+    u16 max_function_defs;
+    u16 max_instruction_defs;
+    u16 max_stack_elements;
+    u16 max_size_of_instructions;
+    u16 max_component_elements;
+    u16 max_component_depth;
+};
+
 // _Each_ data block inside the 'glyf' block starts with this header
 struct otf_glyf_desc
 {
@@ -195,6 +264,7 @@ struct otf_bitmap_size
 };
 #pragma pack(pop)
 
+// NOTE(joon) Only used while decoding the format 4 cmap subtable
 struct otf_glyph_id_finder
 {
     u16 segment_count;
@@ -209,6 +279,27 @@ struct otf_glyph_id_finder
     u16 *glyph_id_array; 
 };
 
+/*
+   NOTE(joon) Decoded cmap, so that getting the glyph id is just two loads without touching the font file.
+   Whole unicode range is divided into the pages of 256 code points, and each page index points to the page that has the glyph ids.
+   Page 0 is always filled with 0(missing glyph), and all the pages without any glyph point to it.
+   For the fonts that only cover a few scripts, this is only a few kilobytes.
+*/
+#define Glyph_ID_Page_Size 256
+#define Max_Codepoint 0x10ffff
+#define Glyph_ID_Page_Index_Count ((Max_Codepoint + 1) / Glyph_ID_Page_Size)
+
+struct GlyphIDTable
+{
+    u16 *page_indices; // Glyph_ID_Page_Index_Count
+    u16 *pages; // page_count*Glyph_ID_Page_Size
+    u32 page_count;
+
+    // NOTE(joon) from the 'maxp' block. The glyph ids that are not less than this are stored as 0(missing glyph),
+    // so that a broken cmap cannot make us read past the per glyph arrays
+    u32 glyph_count;
+};
+
 struct font_info
 {
     u32 glyph_count;
@@ -226,7 +317,102 @@ struct font_info
     void *glyph_offsets; // Access to glyf tabletype is undefined because it can be differ based on loc_offset_type
     u8 *glyph_data; // Also a start of the 'glyf' header
 
-    otf_glyph_id_finder glyph_id_finder;
+    // NOTE(joon) from the 'maxp' block, used to allocate the GlyphOutline
+    u32 max_point_count;
+    u32 max_contour_count;
+
+    //////////// layout related data ////////////
+    // NOTE(joon) in font units, descent is usually negative
+    i32 ascent;
+    i32 descent;
+    i32 line_gap;
+    u16 *advance_widths; // glyph_count, decoded from the 'hmtx' block
+
+    GlyphIDTable glyph_id_table;
+};
+
+// NOTE(joon) simple glyph flags
+#define Otf_Glyph_Flag_On_Curve 0x01
+#define Otf_Glyph_Flag_X_Short 0x02
+#define Otf_Glyph_Flag_Y_Short 0x04
+#define Otf_Glyph_Flag_Repeat 0x08
+#define Otf_Glyph_Flag_X_Same_Or_Positive 0x10 // if X_Short is set, this is the sign. If not, x is same as the previous one
+#define Otf_Glyph_Flag_Y_Same_Or_Positive 0x20
+
+// NOTE(joon) composite glyph flags
+#define Otf_Component_Flag_Args_Are_Words 0x0001
+#define Otf_Component_Flag_Args_Are_XY_Values 0x0002
+#define Otf_Component_Flag_Have_Scale 0x0008
+#define Otf_Component_Flag_More_Components 0x0020
+#define Otf_Component_Flag_Have_XY_Scale 0x0040
+#define Otf_Component_Flag_Have_Two_By_Two 0x0080
+
+// NOTE(joon) Decoded outline of a glyph in font units(y up). Composite glyphs are flattened into one outline.
+// Consecutive off curve points have an implied on curve point in the middle of them
+struct GlyphOutline
+{
+    v2 *points;
+    u8 *is_on_curve;
+    u32 point_count;
+    u32 max_point_count;
+
+    u16 *contour_end_indices; // inclusive
+    u32 contour_count;
+    u32 max_contour_count;
+
+    i16 x_min;
+    i16 y_min;
+    i16 x_max;
+    i16 y_max;
+};
+
+/*
+   NOTE(joon) Glyph atlas is a single 8 bit coverage texture that caches the rasterized glyphs by (glyph_id, pixel size).
+   Glyphs are packed using the skyline(bottom-left) method, and when the atlas gets full,
+   we just throw everything away and start again, which is fine as long as the glyphs that are needed in a frame fit in the atlas.
+   generation is bumped whenever the pixels change, so that the renderer knows when to upload the atlas again.
+   clear_count is only bumped when everything is thrown away, which is how push_text knows that the glyphs
+   that were pushed before in the same frame need to be put back into the atlas.
+*/
+struct GlyphAtlasSkylineNode
+{
+    u32 x;
+    u32 y; // the lowest y that is free starting from x to x + width
+    u32 width;
+};
+
+#define Glyph_Atlas_Empty_Key U32_Max
+
+struct GlyphAtlasEntry
+{
+    u32 key; // glyph_id | pixel_size << 16
+
+    // NOTE(joon) in texels
+    u16 x;
+    u16 y;
+    u16 width;
+    u16 height;
+
+    // NOTE(joon) in pixels, from the pen position on the baseline to the top left corner of the bitmap(y down)
+    i16 offset_x;
+    i16 offset_y;
+};
+
+struct GlyphAtlas
+{
+    u32 width;
+    u32 height;
+    u8 *pixels; // coverage, 1 byte per texel
+
+    u32 generation;
+    u32 clear_count;
+
+    GlyphAtlasSkylineNode skyline[256];
+    u32 skyline_count;
+
+    // NOTE(joon) open addressing hash table
+    GlyphAtlasEntry entries[2048];
+    u32 entry_count;
 };
 
 
@@ -33,9 +33,41 @@ load_bmp(char *file_name)
 
 }
 
+internal u32
+get_bmp_file_size(u32 width, u32 height)
+{
+    u32 result = sizeof(bmp_file_header) + sizeof(u32)*width*height;
+
+    return result;
+}
+
+// NOTE(joon) 32 bit bmp with the alpha, pixels should be 0xAARRGGBB & the first row is the bottom one.
+// dest should be at least get_bmp_file_size
 internal void
-export_bmp()
+export_bmp(u8 *dest, u32 *pixels, u32 width, u32 height)
 {
+    u32 pixel_size = sizeof(u32)*width*height;
+
+    bmp_file_header *header = (bmp_file_header *)dest;
+    *header = {};
+    header->file_header = 0x4D42; // 'BM'
+    header->file_size = sizeof(bmp_file_header) + pixel_size;
+    header->pixel_offset = sizeof(bmp_file_header);
+
+    // NOTE(joon) everything from the header_size to the end of the struct
+    header->header_size = sizeof(bmp_file_header) - 14;
+    header->width = width;
+    header->height = height;
+    header->color_plane_count = 1;
+    header->bits_per_pixel = 32;
+    header->compression = 3; // BI_BITFIELDS, so that the masks are used
+    header->image_size = pixel_size;
+    header->red_mask = 0x00ff0000;
+    header->green_mask = 0x0000ff00;
+    header->blue_mask = 0x000000ff;
+    header->alpha_mask = 0xff000000;
+
+    memcpy(dest + sizeof(bmp_file_header), pixels, pixel_size);
 }
 
 /*
@@ -134,6 +166,126 @@ export_png()
 {
 }
 
+#pragma pack(push, 1)
+struct tga_header
+{
+    u8 id_length; // size of the image id field that comes right after the header
+    u8 color_map_type; // 0 : no color map, 1 : has color map
+    u8 image_type; // 2 : true color, 3 : grayscale, 10 : RLE true color, 11 : RLE grayscale
+
+    u16 color_map_first_entry_index;
+    u16 color_map_length;
+    u8 color_map_entry_size; // in bits
+
+    u16 x_origin;
+    u16 y_origin;
+    u16 width;
+    u16 height;
+    u8 bits_per_pixel; // 8, 24, or 32
+    u8 image_descriptor; // bit 0-3 : alpha bit count, bit 5 : top left origin if set
+};
+#pragma pack(pop)
+
+// NOTE(joon) tga stores the pixels in B G R (A) order
+internal u32
+read_tga_pixel(u8 *c, u32 bytes_per_pixel)
+{
+    u32 result = 0;
+    switch(bytes_per_pixel)
+    {
+        case 1:
+        {
+            u32 l = c[0];
+            result = (0xffu << 24) | (l << 16) | (l << 8) | l;
+        }break;
+
+        case 3:
+        {
+            result = (0xffu << 24) | ((u32)c[0] << 16) | ((u32)c[1] << 8) | (u32)c[2];
+        }break;
+
+        case 4:
+        {
+            result = ((u32)c[3] << 24) | ((u32)c[0] << 16) | ((u32)c[1] << 8) | (u32)c[2];
+        }break;
+
+        default :
+        {
+            invalid_code_path;
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) Only supports the true color & grayscale images(both raw and RLE), which are the only ones that the tools are exporting.
+// The result is always top-down, with the pixels in the same layout as LoadedImage.
+internal LoadedImage
+load_tga(MemoryArena *arena, PlatformReadFileResult file)
+{
+    LoadedImage result = {};
+
+    tga_header *header = (tga_header *)file.memory;
+    assert(header->image_type == 2 || header->image_type == 3 || 
+           header->image_type == 10 || header->image_type == 11);
+    assert(header->bits_per_pixel == 8 || header->bits_per_pixel == 24 || header->bits_per_pixel == 32);
+
+    b32 is_rle = (header->image_type >= 10);
+    b32 is_top_left_origin = (header->image_descriptor & (1 << 5));
+    u32 bytes_per_pixel = header->bits_per_pixel / 8;
+
+    result.width = header->width;
+    result.height = header->height;
+    result.pixels = push_array(arena, u32, result.width*result.height);
+
+    u8 *c = file.memory + sizeof(tga_header) + header->id_length;
+    if(header->color_map_type == 1)
+    {
+        // NOTE(joon) true color images can still have a color map, which we don't need
+        c += header->color_map_length*((header->color_map_entry_size + 7) / 8);
+    }
+    u8 *end = file.memory + file.size;
+
+    u32 pixel_count = result.width*result.height;
+    u32 pixel_index = 0;
+    while(pixel_index < pixel_count)
+    {
+        u32 run_count = 1;
+        b32 is_run_repeating = false;
+        if(is_rle)
+        {
+            u8 packet_header = *c++;
+            run_count = (packet_header & 0x7f) + 1;
+            is_run_repeating = (packet_header & 0x80);
+        }
+
+        u32 pixel = 0;
+        for(u32 run_index = 0;
+                run_index < run_count && pixel_index < pixel_count;
+                ++run_index)
+        {
+            if(run_index == 0 || !is_run_repeating)
+            {
+                assert(c + bytes_per_pixel <= end);
+                pixel = read_tga_pixel(c, bytes_per_pixel);
+                c += bytes_per_pixel;
+            }
+
+            u32 x = pixel_index % result.width;
+            u32 y = pixel_index / result.width;
+            if(!is_top_left_origin)
+            {
+                y = result.height - 1 - y;
+            }
+
+            result.pixels[y*result.width + x] = pixel;
+            pixel_index++;
+        }
+    }
+
+    return result;
+}
+
 // TODO(joon) hdr support?
 
 
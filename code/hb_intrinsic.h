@@ -18,14 +18,16 @@
 
 // TODO(joon) macos has two different versions of this - with and without 'barrier'.
 // Find out whether we acutally need the barrier(for now, we use the version with barrier)
-#define atomic_compare_exchange(ptr, expected, desired) OSAtomicCompareAndSwapIntBarrier(ptr, expected, desired)
-#define atomic_compare_exchange_64(ptr, expected, desired) OSAtomicCompareAndSwap64Barrier(ptr, expected, desired)
+// NOTE(joon) OSAtomic functions take the pointer as the last argument
+#define atomic_compare_exchange(ptr, expected, desired) OSAtomicCompareAndSwapIntBarrier(expected, desired, ptr)
+#define atomic_compare_exchange_64(ptr, expected, desired) OSAtomicCompareAndSwap64Barrier(expected, desired, ptr)
 
 #define atomic_increment(ptr) OSAtomicIncrement32Barrier(ptr)
 #define atomic_increment_64(ptr) OSAtomicIncrement64Barrier(ptr)
 
-#define atomic_add(ptr, value_to_add) OSAtomicAdd32Barrier(ptr, value_to_add)
-#define atomic_add_64(ptr, value_to_add) OSAtomicAdd64Barrier(ptr, value_to_add)
+// NOTE(joon) returns the new value, same as __sync_add_and_fetch
+#define atomic_add(ptr, value_to_add) OSAtomicAdd32Barrier(value_to_add, ptr)
+#define atomic_add_64(ptr, value_to_add) OSAtomicAdd64Barrier(value_to_add, ptr)
 
 #elif HB_LLVM
 // TODO(joon) Can also be used for GCC, because this is a GCC extension of Clang?
@@ -47,7 +49,7 @@
 
 #endif
 
-inline u32
+static inline u32
 count_set_bit(u32 value, u32 size_in_bytes)
 {
     u32 result = 0;
@@ -66,7 +68,7 @@ count_set_bit(u32 value, u32 size_in_bytes)
     return result;
 }
 
-inline u32
+static inline u32
 find_most_significant_bit(u8 value)
 {
     u32 result = 0;
@@ -86,59 +88,83 @@ find_most_significant_bit(u8 value)
     return result;
 }
 
+static inline u32
+count_set_bit_u64(u64 value)
+{
+    u32 result = 0;
+
+#if HB_LLVM
+    result = (u32)__builtin_popcountll(value);
+#else
+    while(value)
+    {
+        value &= (value - 1);
+        result++;
+    }
+#endif
+
+    return result;
+}
+
 #define sin(value) sin_(value)
 #define cos(value) cos_(value)
 #define acos(value) acos_(value)
 #define atan2(y, x) atan2_(y, x)
 
-inline r32
+static inline r32
 sin_(r32 rad)
 {
     // TODO(joon) : intrinsic?
     return sinf(rad);
 }
 
-inline r32
+static inline r32
 cos_(r32 rad)
 {
     // TODO(joon) : intrinsic?
     return cosf(rad);
 }
 
-inline r32
+static inline r32
 acos_(r32 rad)
 {
     return acosf(rad);
 }
 
-inline r32
+static inline r32
 atan2_(r32 y, r32 x)
 {
     return atan2f(y, x);
 }
 
-inline i32
+static inline r32
+abs_(r32 value)
+{
+    return fabsf(value);
+}
+
+static inline i32
 round_r32_to_i32(r32 value)
 {
     // TODO(joon) : intrinsic?
     return (i32)roundf(value);
 }
 
-inline u32
+static inline u32
 round_r32_to_u32(r32 value)
 {
     // TODO(joon) : intrinsic?
     return (u32)roundf(value);
 }
 
-inline r32
+static inline r32
 power(r32 base, u32 exponent)
 {
     r32 result = powf(base, exponent);
     return result;
 }
 
-inline u32
+static inline u32
 power(u32 base, u32 exponent)
 {
     u32 result = 1;
@@ -156,7 +182,7 @@ power(u32 base, u32 exponent)
 }
 
 // TODO(joon) this function can go wrong so easily...
-inline u64
+static inline u64
 pointer_diff(void *start, void *end)
 {
     //assert(start && end);
@@ -168,7 +194,7 @@ pointer_diff(void *start, void *end)
 #include <string.h>
 // TODO/Joon: intrinsic zero memory?
 // TODO(joon): can be faster using wider vectors
-inline void
+static inline void
 zero_memory(void *memory, u64 size)
 {
     // TODO/joon: What if there's no neon support
@@ -198,7 +224,7 @@ zero_memory(void *memory, u64 size)
 }
 
 // TODO(joon): Intrinsic?
-inline u8
+static inline u8
 reverse_bits(u8 value)
 {
     u8 result = 0;
@@ -216,4 +242,97 @@ reverse_bits(u8 value)
     return result;
 }
 
+// NOTE(joon) Ordered from the lowest to the highest, so that the levels can be compared
+enum CpuFeatureLevel
+{
+    CpuFeatureLevel_NEON, // every ARM64 cpu has this
+    CpuFeatureLevel_SSE41, // the minimum for x64, as the 4 wide simd lane needs it
+    CpuFeatureLevel_AVX2,
+    CpuFeatureLevel_AVX512,
+};
+
+#if HB_X64
+#if HB_MSVC
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static inline void
+cpuid(u32 leaf, u32 subleaf, u32 *eax, u32 *ebx, u32 *ecx, u32 *edx)
+{
+#if HB_MSVC
+    int registers[4];
+    __cpuidex(registers, leaf, subleaf);
+    *eax = registers[0];
+    *ebx = registers[1];
+    *ecx = registers[2];
+    *edx = registers[3];
+#else
+    __cpuid_count(leaf, subleaf, *eax, *ebx, *ecx, *edx);
+#endif
+}
+
+// NOTE(joon) Tells us which register states the OS saves on a context switch.
+// The cpu might support AVX, but we cannot use it if the OS does not save the ymm/zmm registers
+static inline u64
+get_xcr0(void)
+{
+#if HB_MSVC
+    u64 result = _xgetbv(0);
+#else
+    u32 eax;
+    u32 edx;
+    asm volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    u64 result = ((u64)edx << 32) | eax;
+#endif
+
+    return result;
+}
+#endif
+
+static inline CpuFeatureLevel
+get_cpu_feature_level(void)
+{
+#if HB_ARM
+    CpuFeatureLevel result = CpuFeatureLevel_NEON;
+#elif HB_X64
+    CpuFeatureLevel result = CpuFeatureLevel_SSE41;
+
+    u32 eax, ebx, ecx, edx;
+    cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    u32 max_leaf = eax;
+
+    // TODO(joon) We do not have anything below SSE4.1 to fall back to, so we don't even check the bit(ecx bit 19) for it
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    b32 has_osxsave = (ecx & (1 << 27));
+    b32 has_avx = (ecx & (1 << 28));
+
+    if(max_leaf >= 7 && has_osxsave && has_avx)
+    {
+        u64 xcr0 = get_xcr0();
+        // NOTE(joon) xmm & ymm states
+        b32 os_saves_ymm = ((xcr0 & 0x6) == 0x6);
+        // NOTE(joon) xmm, ymm, opmask, and the upper halves of zmm0-15 & zmm16-31
+        b32 os_saves_zmm = ((xcr0 & 0xe6) == 0xe6);
+
+        cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        b32 has_avx2 = (ebx & (1 << 5));
+        b32 has_avx512f = (ebx & (1 << 16));
+
+        if(os_saves_ymm && has_avx2)
+        {
+            result = CpuFeatureLevel_AVX2;
+
+            if(os_saves_zmm && has_avx512f)
+            {
+                result = CpuFeatureLevel_AVX512;
+            }
+        }
+    }
+#endif
+
+    return result;
+}
+
 #endif
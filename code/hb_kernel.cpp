@@ -0,0 +1,46 @@
+#include "hb_kernel.h"
+
+// NOTE(joon) Function pointers are pointing into the game code, so this should not survive the code reload.
+// That's why this is a global instead of being inside the game state
+global HotKernels hot_kernels;
+
+#define set_hot_kernels(kernels, isa, level) \
+    (kernels)->feature_level = level; \
+    (kernels)->name = (char *)#isa; \
+    (kernels)->render_raytraced_image_tile = render_raytraced_image_tile_##isa; \
+    (kernels)->generate_vertex_normals = generate_vertex_normals_##isa; \
+    (kernels)->accumulate_spring_forces = accumulate_spring_forces_##isa; \
+    (kernels)->decode_voxels = decode_voxels_##isa; \
+    (kernels)->trace_voxel_rays = trace_voxel_rays_##isa; \
+    (kernels)->bake_lighting = bake_lighting_##isa; \
+    (kernels)->denoise_raytraced_image_band = denoise_raytraced_image_band_##isa;
+
+internal void
+init_hot_kernels(HotKernels *kernels)
+{
+    CpuFeatureLevel feature_level = get_cpu_feature_level();
+
+#if HB_ARM
+    set_hot_kernels(kernels, neon, CpuFeatureLevel_NEON);
+#elif HB_X64
+    switch(feature_level)
+    {
+        case CpuFeatureLevel_AVX512:
+        {
+            set_hot_kernels(kernels, avx512, CpuFeatureLevel_AVX512);
+        }break;
+
+        case CpuFeatureLevel_AVX2:
+        {
+            set_hot_kernels(kernels, avx2, CpuFeatureLevel_AVX2);
+        }break;
+
+        default:
+        {
+            set_hot_kernels(kernels, sse41, CpuFeatureLevel_SSE41);
+        }break;
+    }
+#endif
+
+    printf("hot kernels : %s\n", kernels->name);
+}
@@ -0,0 +1,73 @@
+#ifndef HB_KERNEL_H
+#define HB_KERNEL_H
+
+/*
+    NOTE(joon) Hot kernels are the routines that are worth compiling once per ISA level.
+    hb_kernel_isa.cpp is compiled multiple times(see the makefile), each with a different HB_LANE_WIDTH & HB_KERNEL_ISA,
+    and the game code picks the best one at startup using cpuid. This way, one binary can use AVX2 or AVX-512
+    where they exist, and still run on the machines that only have SSE4.1.
+
+    The arguments should never contain any simd types, as the layout of them differs per lane width.
+*/
+
+#define RENDER_RAYTRACED_IMAGE_TILE(name) RaytracerOutput (name)(RaytracerData *data)
+typedef RENDER_RAYTRACED_IMAGE_TILE(render_raytraced_image_tile_kernel);
+
+// NOTE(joon) simd version of generate_vertex_normals
+#define GENERATE_VERTEX_NORMALS(name) void (name)(MemoryArena *permanent_arena, MemoryArena *transient_arena, RawMesh *raw_mesh)
+typedef GENERATE_VERTEX_NORMALS(generate_vertex_normals_kernel);
+
+// NOTE(joon) accumulates the elastic force of every connection into this_frame_force of the particles
+#define ACCUMULATE_SPRING_FORCES(name) void (name)(MassAgg *mass_agg)
+typedef ACCUMULATE_SPRING_FORCES(accumulate_spring_forces_kernel);
+
+// NOTE(joon) looks up voxel_count voxels(inside the chunk) in the octree of the chunk all at once
+#define DECODE_VOXELS(name) void (name)(VoxelOctree *octree, u8 *xs, u8 *ys, u8 *zs, u32 voxel_count, b32 *exists)
+typedef DECODE_VOXELS(decode_voxels_kernel);
+
+// NOTE(joon) simd version of ray_intersect_with_voxel_world, where each lane traces a different ray.
+// voxel_memory is what the offsets of the chunks are relative to
+#define TRACE_VOXEL_RAYS(name) void (name)(VoxelWorld *world, u8 *voxel_memory, v3 *ray_origins, v3 *ray_dirs, u32 ray_count, r32 max_t, VoxelRayHit *hits)
+typedef TRACE_VOXEL_RAYS(trace_voxel_rays_kernel);
+
+// NOTE(joon) ambient occlusion & irradiance of each sample inside the batch, see hb_bake.h
+#define BAKE_LIGHTING(name) void (name)(LightingBakeBatch *batch)
+typedef BAKE_LIGHTING(bake_lighting_kernel);
+
+// NOTE(joon) one a-trous iteration of the rows inside the band, see hb_denoiser.h
+#define DENOISE_RAYTRACED_IMAGE_BAND(name) void (name)(RaytracerDenoiserBand *band)
+typedef DENOISE_RAYTRACED_IMAGE_BAND(denoise_raytraced_image_band_kernel);
+
+struct HotKernels
+{
+    CpuFeatureLevel feature_level;
+    char *name; // shows up in the profiler output
+
+    render_raytraced_image_tile_kernel *render_raytraced_image_tile;
+    generate_vertex_normals_kernel *generate_vertex_normals;
+    accumulate_spring_forces_kernel *accumulate_spring_forces;
+    decode_voxels_kernel *decode_voxels;
+    trace_voxel_rays_kernel *trace_voxel_rays;
+    bake_lighting_kernel *bake_lighting;
+    denoise_raytraced_image_band_kernel *denoise_raytraced_image_band;
+};
+
+#define declare_hot_kernels(isa) \
+    RENDER_RAYTRACED_IMAGE_TILE(render_raytraced_image_tile_##isa); \
+    GENERATE_VERTEX_NORMALS(generate_vertex_normals_##isa); \
+    ACCUMULATE_SPRING_FORCES(accumulate_spring_forces_##isa); \
+    DECODE_VOXELS(decode_voxels_##isa); \
+    TRACE_VOXEL_RAYS(trace_voxel_rays_##isa); \
+    BAKE_LIGHTING(bake_lighting_##isa); \
+    DENOISE_RAYTRACED_IMAGE_BAND(denoise_raytraced_image_band_##isa);
+
+// NOTE(joon) Should match with the HB_KERNEL_ISA values that the makefile uses
+#if HB_ARM
+declare_hot_kernels(neon)
+#elif HB_X64
+declare_hot_kernels(sse41)
+declare_hot_kernels(avx2)
+declare_hot_kernels(avx512)
+#endif
+
+#endif
@@ -0,0 +1,891 @@
+/*
+    NOTE(joon) Unlike the other cpp files, this one is _not_ a part of the unity build(hb.cpp).
+    This gets compiled once per ISA level with the matching HB_LANE_WIDTH & compiler flags(i.e -D HB_KERNEL_ISA=avx2 -D HB_LANE_WIDTH=8 -mavx2),
+    and the names of the kernels get the ISA as a suffix(i.e generate_vertex_normals_avx2). See hb_kernel.h & the makefile.
+
+    Every function that the headers below define should have internal linkage(internal, force_inline), including the plain inline ones.
+    Otherwise each ISA object gets its own weak copy of them, and the linker is free to pick the avx512 one for the whole program.
+*/
+#ifndef HB_KERNEL_ISA
+#error "HB_KERNEL_ISA should be defined"
+#endif
+
+#include "hb_types.h"
+#include "hb_simd.h"
+#include "hb_intrinsic.h"
+#include "hb_platform.h"
+#include "hb_math.h"
+#include "hb_random.h"
+#include "hb_simulation.h"
+#include "hb_render_group.h"
+#include "hb_voxel.h"
+#include "hb_bvh.h"
+#include "hb_sampler.h"
+#include "hb_brdf.h"
+#include "hb_ray.h"
+#include "hb_denoiser.h"
+#include "hb_bake.h"
+#include "hb_kernel.h"
+
+#include "hb_sampler.cpp"
+#include "hb_brdf.cpp"
+#include "hb_voxel_ray.cpp"
+#include "hb_ray.cpp"
+
+#define kernel_name__(name, isa) name##_##isa
+#define kernel_name_(name, isa) kernel_name__(name, isa)
+#define kernel_name(name) kernel_name_(name, HB_KERNEL_ISA)
+
+RENDER_RAYTRACED_IMAGE_TILE(kernel_name(render_raytraced_image_tile))
+{
+    RaytracerOutput result = {};
+    if(data->use_wavefront)
+    {
+        result = render_raytraced_image_tile_wavefront(data);
+    }
+    else
+    {
+        result = render_raytraced_image_tile_simd(data);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Each lane handles one face, so this works for any lane width.
+   The indices & positions are gathered lane by lane, and the face normals are scattered lane by lane,
+   as the faces that are in the same batch can share the same vertex.
+*/
+GENERATE_VERTEX_NORMALS(kernel_name(generate_vertex_normals))
+{
+    assert(!raw_mesh->normals);
+
+    raw_mesh->normal_count = raw_mesh->position_count;
+    raw_mesh->normals = push_array(permanent_arena, v3, raw_mesh->normal_count);
+
+    TempMemory mesh_construction_temp_memory = start_temp_memory(transient_arena, megabytes(16), true);
+
+    // NOTE(joon): padded by the lane width, so that we can always load the full lane
+    u32 padded_position_count = raw_mesh->position_count + HB_LANE_WIDTH;
+    r32 *normal_sum_x = push_array(&mesh_construction_temp_memory, r32, padded_position_count);
+    r32 *normal_sum_y = push_array(&mesh_construction_temp_memory, r32, padded_position_count);
+    r32 *normal_sum_z = push_array(&mesh_construction_temp_memory, r32, padded_position_count);
+
+    u32 face_count = raw_mesh->index_count / 3;
+    for(u32 face_index = 0;
+            face_index < face_count;
+            face_index += HB_LANE_WIDTH)
+    {
+        u32 lane_count = minimum(HB_LANE_WIDTH, face_count - face_index);
+
+        r32 v0_x[HB_LANE_WIDTH] = {};
+        r32 v0_y[HB_LANE_WIDTH] = {};
+        r32 v0_z[HB_LANE_WIDTH] = {};
+        r32 v1_x[HB_LANE_WIDTH] = {};
+        r32 v1_y[HB_LANE_WIDTH] = {};
+        r32 v1_z[HB_LANE_WIDTH] = {};
+        r32 v2_x[HB_LANE_WIDTH] = {};
+        r32 v2_y[HB_LANE_WIDTH] = {};
+        r32 v2_z[HB_LANE_WIDTH] = {};
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            u32 *indices = raw_mesh->indices + 3*(face_index + lane);
+
+            v3 v0 = raw_mesh->positions[indices[0]];
+            v3 v1 = raw_mesh->positions[indices[1]];
+            v3 v2 = raw_mesh->positions[indices[2]];
+
+            v0_x[lane] = v0.x;
+            v0_y[lane] = v0.y;
+            v0_z[lane] = v0.z;
+            v1_x[lane] = v1.x;
+            v1_y[lane] = v1.y;
+            v1_z[lane] = v1.z;
+            v2_x[lane] = v2.x;
+            v2_y[lane] = v2.y;
+            v2_z[lane] = v2.z;
+        }
+
+        simd_v3 v0 = simd_v3_load(v0_x, v0_y, v0_z);
+        simd_v3 v1 = simd_v3_load(v1_x, v1_y, v1_z);
+        simd_v3 v2 = simd_v3_load(v2_x, v2_y, v2_z);
+
+        // NOTE(joon): e0 = v1 - v0, e1 = v2 - v0, normal = cross(e0, e1);
+        simd_v3 face_normal = cross(v1 - v0, v2 - v0);
+
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            u32 *indices = raw_mesh->indices + 3*(face_index + lane);
+
+            v3 lane_face_normal = get_lane(face_normal, lane);
+            for(u32 i = 0;
+                    i < 3;
+                    ++i)
+            {
+                normal_sum_x[indices[i]] += lane_face_normal.x;
+                normal_sum_y[indices[i]] += lane_face_normal.y;
+                normal_sum_z[indices[i]] += lane_face_normal.z;
+            }
+        }
+    }
+
+    // NOTE(joon): The scalar version divides the sum by the hit count first,
+    // but that does not change the direction so we can just normalize the sum
+    for(u32 normal_index = 0;
+            normal_index < raw_mesh->normal_count;
+            normal_index += HB_LANE_WIDTH)
+    {
+        u32 lane_count = minimum(HB_LANE_WIDTH, raw_mesh->normal_count - normal_index);
+
+        simd_v3 normal = normalize(simd_v3_load(normal_sum_x + normal_index,
+                                                normal_sum_y + normal_index,
+                                                normal_sum_z + normal_index));
+
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            raw_mesh->normals[normal_index + lane] = get_lane(normal, lane);
+        }
+    }
+
+    end_temp_memory(&mesh_construction_temp_memory);
+}
+
+// NOTE(joon) Forces are computed HB_LANE_WIDTH connections at a time,
+// but added to the particles lane by lane in the same order as the scalar version as the connections can share the particles
+ACCUMULATE_SPRING_FORCES(kernel_name(accumulate_spring_forces))
+{
+    simd_f32 elastic_value = simd_f32_(mass_agg->elastic_value);
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+
+    for(u32 connection_index = 0;
+            connection_index < mass_agg->connection_count;
+            connection_index += HB_LANE_WIDTH)
+    {
+        u32 lane_count = minimum(HB_LANE_WIDTH, mass_agg->connection_count - connection_index);
+
+        r32 p0_x[HB_LANE_WIDTH] = {};
+        r32 p0_y[HB_LANE_WIDTH] = {};
+        r32 p0_z[HB_LANE_WIDTH] = {};
+        r32 p1_x[HB_LANE_WIDTH] = {};
+        r32 p1_y[HB_LANE_WIDTH] = {};
+        r32 p1_z[HB_LANE_WIDTH] = {};
+        r32 rest_lengths[HB_LANE_WIDTH] = {};
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            PiecewiseMassParticleConnection *connection = mass_agg->connections + connection_index + lane;
+
+            v3 p0 = mass_agg->particles[connection->ID_0].p;
+            v3 p1 = mass_agg->particles[connection->ID_1].p;
+
+            p0_x[lane] = p0.x;
+            p0_y[lane] = p0.y;
+            p0_z[lane] = p0.z;
+            p1_x[lane] = p1.x;
+            p1_y[lane] = p1.y;
+            p1_z[lane] = p1.z;
+            rest_lengths[lane] = connection->rest_length;
+        }
+
+        simd_v3 delta = simd_v3_load(p1_x, p1_y, p1_z) - simd_v3_load(p0_x, p0_y, p0_z);
+        simd_f32 delta_length = length(delta);
+        simd_f32 length_diff = delta_length - simd_f32_load(rest_lengths);
+
+        // NOTE(joon) same as abs(length_diff) > 0.0f. The lanes past the connection count have 0 for everything,
+        // so they never pass this test
+        simd_u32 apply_mask = compare_not_equal(length_diff, simd_f32_0);
+        if(!all_lanes_zero(apply_mask))
+        {
+            simd_v3 elastic_force = (elastic_value * length_diff) * (delta/delta_length);
+
+            for(u32 lane = 0;
+                    lane < lane_count;
+                    ++lane)
+            {
+                if(get_lane(apply_mask, lane))
+                {
+                    PiecewiseMassParticleConnection *connection = mass_agg->connections + connection_index + lane;
+                    v3 lane_elastic_force = get_lane(elastic_force, lane);
+
+                    mass_agg->particles[connection->ID_0].this_frame_force += lane_elastic_force;
+                    mass_agg->particles[connection->ID_1].this_frame_force -= lane_elastic_force;
+                }
+            }
+        }
+    }
+}
+
+/*
+   NOTE(joon) Same traversal as get_voxel, but each lane walks down the tree for a different voxel.
+   Because the chunk dim is a power of 2, instead of subtracting half dim every level,
+   we can just test the bit of the coordinate that matches with the half dim of that level.
+   The nodes are read lane by lane, only for the lanes that still exist, as the handles of the other lanes are meaningless.
+*/
+DECODE_VOXELS(kernel_name(decode_voxels))
+{
+    simd_u32 simd_u32_1 = simd_u32_(1);
+    u32 chunk_dim = octree->chunk_dim;
+    u32 lod = octree->lod;
+
+    for(u32 voxel_index = 0;
+            voxel_index < voxel_count;
+            voxel_index += HB_LANE_WIDTH)
+    {
+        u32 lane_count = minimum(HB_LANE_WIDTH, voxel_count - voxel_index);
+
+        u32 lane_x[HB_LANE_WIDTH] = {};
+        u32 lane_y[HB_LANE_WIDTH] = {};
+        u32 lane_z[HB_LANE_WIDTH] = {};
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            lane_x[lane] = xs[voxel_index + lane];
+            lane_y[lane] = ys[voxel_index + lane];
+            lane_z[lane] = zs[voxel_index + lane];
+        }
+        simd_u32 x = simd_u32_load(lane_x);
+        simd_u32 y = simd_u32_load(lane_y);
+        simd_u32 z = simd_u32_load(lane_z);
+
+        simd_u32 exist_mask = get_first_lanes_mask(lane_count);
+        simd_u32 handle = simd_u32_(octree->root_node_index);
+
+        for(u32 level = 0;
+                level < lod;
+                ++level)
+        {
+            simd_u32 half_dim = simd_u32_(chunk_dim >> (level + 1));
+            simd_u32 bit_index = (is_lane_non_zero(x & half_dim) & simd_u32_1) | 
+                                 (is_lane_non_zero(y & half_dim) & simd_u32_(2)) | 
+                                 (is_lane_non_zero(z & half_dim) & simd_u32_(4));
+
+            // TODO(joon): gather?
+            u32 lane_exists[HB_LANE_WIDTH];
+            u32 lane_handles[HB_LANE_WIDTH];
+            u32 lane_bit_indices[HB_LANE_WIDTH];
+            simd_u32_store(lane_exists, exist_mask);
+            simd_u32_store(lane_handles, handle);
+            simd_u32_store(lane_bit_indices, bit_index);
+
+            u32 lane_child_masks[HB_LANE_WIDTH];
+            u32 lane_child_handles[HB_LANE_WIDTH];
+            for(u32 lane = 0;
+                    lane < HB_LANE_WIDTH;
+                    ++lane)
+            {
+                lane_child_masks[lane] = 0;
+                lane_child_handles[lane] = 0;
+                if(lane_exists[lane])
+                {
+                    lane_child_masks[lane] = get_voxel_octree_child_mask(octree, level, lane_handles[lane]);
+                    if(level + 1 < lod && (lane_child_masks[lane] & (1 << lane_bit_indices[lane])))
+                    {
+                        lane_child_handles[lane] = get_voxel_octree_child_handle(octree, level, lane_handles[lane], lane_bit_indices[lane]);
+                    }
+                }
+            }
+
+            exist_mask = exist_mask & is_lane_non_zero((simd_u32_load(lane_child_masks) >> bit_index) & simd_u32_1);
+            if(all_lanes_zero(exist_mask))
+            {
+                break;
+            }
+
+            handle = simd_u32_load(lane_child_handles);
+        }
+
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            exists[voxel_index + lane] = (get_lane(exist_mask, lane) != 0);
+        }
+    }
+}
+
+/*
+   NOTE(joon) Same hierarchical DDA as ray_intersect_with_voxel_chunk, but each lane traces a different ray.
+   Every step, the lanes walk down from their own restart level to find the empty octant(or the voxel) that they are in,
+   and then all of them jump to the exit of their octant at once. The nodes are read lane by lane like decode_voxels,
+   only for the lanes that are still walking down, so the lanes that are done never read outside of the nodes.
+   The chunks are visited one by one, and each lane only accepts the hits that are closer than the one that it already has.
+*/
+TRACE_VOXEL_RAYS(kernel_name(trace_voxel_rays))
+{
+    simd_u32 simd_u32_0 = simd_u32_(0);
+    simd_u32 simd_u32_1 = simd_u32_(1);
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+
+    u32 chunk_dim = world->chunk_dim;
+    u32 lod = world->lod;
+    simd_u32 simd_chunk_dim = simd_u32_(chunk_dim);
+    simd_u32 max_cell = simd_u32_(chunk_dim - 1);
+
+    r32 inv_voxel_dim = 1.0f / world->voxel_dim;
+
+    for(u32 ray_index = 0;
+            ray_index < ray_count;
+            ray_index += HB_LANE_WIDTH)
+    {
+        u32 lane_count = minimum(HB_LANE_WIDTH, ray_count - ray_index);
+
+        // NOTE(joon) in the raw voxel space, which doesn't change t
+        r32 lane_origins[3][HB_LANE_WIDTH] = {};
+        r32 lane_dirs[3][HB_LANE_WIDTH] = {};
+        r32 lane_inv_dirs[3][HB_LANE_WIDTH] = {};
+        for(u32 lane = 0;
+                lane < HB_LANE_WIDTH;
+                ++lane)
+        {
+            for(u32 axis = 0;
+                    axis < 3;
+                    ++axis)
+            {
+                r32 d = 1.0f;
+                if(lane < lane_count)
+                {
+                    lane_origins[axis][lane] = inv_voxel_dim*ray_origins[ray_index + lane].e[axis];
+                    d = inv_voxel_dim*ray_dirs[ray_index + lane].e[axis];
+                }
+                lane_dirs[axis][lane] = d;
+
+                // NOTE(joon) see get_safe_inverse_ray_dir
+                if(d == 0.0f)
+                {
+                    d = 1e-20f;
+                }
+                lane_inv_dirs[axis][lane] = 1.0f / d;
+            }
+        }
+
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            hits[ray_index + lane] = {};
+            hits[ray_index + lane].hit_t = -1.0f;
+        }
+
+        simd_f32 origin[3];
+        simd_f32 dir[3];
+        simd_f32 inv_dir[3];
+        simd_u32 is_dir_positive[3];
+        // NOTE(joon) normal of the face that the ray goes through when it steps along that axis, which faces against the ray
+        simd_f32 step_normal[3];
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            origin[axis] = simd_f32_load(lane_origins[axis]);
+            dir[axis] = simd_f32_load(lane_dirs[axis]);
+            inv_dir[axis] = simd_f32_load(lane_inv_dirs[axis]);
+            is_dir_positive[axis] = compare_greater(inv_dir[axis], simd_f32_0);
+            step_normal[axis] = overwrite(simd_f32_1, is_dir_positive[axis], -simd_f32_1);
+        }
+
+        simd_u32 lane_mask = get_first_lanes_mask(lane_count);
+        simd_f32 closest_t = simd_f32_(max_t);
+
+        for(u32 hash_index = 0;
+                hash_index < array_count(world->chunk_hashes);
+                ++hash_index)
+        {
+            VoxelChunkHash *chunk = world->chunk_hashes + hash_index;
+            if(chunk->first_node_offset == Empty_Hash)
+            {
+                continue;
+            }
+
+            VoxelOctree octree = get_voxel_octree(world, voxel_memory, chunk);
+            u32 chunk_min[3] = {chunk->x*chunk_dim, chunk->y*chunk_dim, chunk->z*chunk_dim};
+
+            // NOTE(joon) chunk voxel space from here
+            simd_f32 chunk_origin[3];
+            simd_f32 t_near[3];
+            simd_f32 t_far[3];
+            for(u32 axis = 0;
+                    axis < 3;
+                    ++axis)
+            {
+                chunk_origin[axis] = origin[axis] - simd_f32_((r32)chunk_min[axis]);
+
+                simd_f32 t0 = -chunk_origin[axis]*inv_dir[axis];
+                simd_f32 t1 = (simd_f32_((r32)chunk_dim) - chunk_origin[axis])*inv_dir[axis];
+                t_near[axis] = min(t0, t1);
+                t_far[axis] = max(t0, t1);
+            }
+
+            simd_f32 t = max(max(max(t_near[0], t_near[1]), t_near[2]), simd_f32_0);
+            simd_f32 end_t = min(min(min(t_far[0], t_far[1]), t_far[2]), closest_t);
+
+            simd_u32 is_active = lane_mask & compare_less_equal(t, end_t);
+            if(all_lanes_zero(is_active))
+            {
+                continue;
+            }
+
+            simd_u32 is_entry_axis[3];
+            is_entry_axis[1] = compare_greater_equal(t_near[1], t_near[0]) & compare_greater_equal(t_near[1], t_near[2]);
+            is_entry_axis[2] = (~is_entry_axis[1]) & compare_greater_equal(t_near[2], t_near[0]) & compare_greater_equal(t_near[2], t_near[1]);
+            is_entry_axis[0] = ~(is_entry_axis[1] | is_entry_axis[2]);
+
+            simd_u32 cell[3];
+            simd_f32 normal[3];
+            for(u32 axis = 0;
+                    axis < 3;
+                    ++axis)
+            {
+                // NOTE(joon) negative values become 0
+                cell[axis] = convert_u32_from_f32(chunk_origin[axis] + t*dir[axis]);
+                cell[axis] = overwrite(cell[axis], compare_greater(cell[axis], max_cell), max_cell);
+
+                normal[axis] = overwrite(simd_f32_0, is_entry_axis[axis], step_normal[axis]);
+            }
+
+            // NOTE(joon) see VoxelOctree
+            simd_u32 handles[Max_Voxel_Lod];
+            handles[0] = simd_u32_(octree.root_node_index);
+            simd_u32 restart_level = simd_u32_0;
+
+            while(!all_lanes_zero(is_active))
+            {
+                simd_u32 octant_dim = simd_u32_0;
+                simd_u32 is_resolved = ~is_active;
+                for(u32 level = 0;
+                        level < lod;
+                        ++level)
+                {
+                    simd_u32 is_walking = (~is_resolved) & compare_greater_equal(simd_u32_(level), restart_level);
+                    if(all_lanes_zero(is_walking))
+                    {
+                        continue;
+                    }
+
+                    simd_u32 half_dim = simd_u32_(chunk_dim >> (level + 1));
+                    simd_u32 bit_index = (is_lane_non_zero(cell[0] & half_dim) & simd_u32_1) | 
+                                         (is_lane_non_zero(cell[1] & half_dim) & simd_u32_(2)) |
+                                         (is_lane_non_zero(cell[2] & half_dim) & simd_u32_(4));
+
+                    // TODO(joon): gather?
+                    u32 lane_is_walking[HB_LANE_WIDTH];
+                    u32 lane_handles[HB_LANE_WIDTH];
+                    u32 lane_bit_indices[HB_LANE_WIDTH];
+                    simd_u32_store(lane_is_walking, is_walking);
+                    simd_u32_store(lane_handles, handles[level]);
+                    simd_u32_store(lane_bit_indices, bit_index);
+
+                    u32 lane_child_masks[HB_LANE_WIDTH];
+                    u32 lane_child_handles[HB_LANE_WIDTH];
+                    for(u32 lane = 0;
+                            lane < HB_LANE_WIDTH;
+                            ++lane)
+                    {
+                        lane_child_masks[lane] = 0;
+                        lane_child_handles[lane] = 0;
+                        if(lane_is_walking[lane])
+                        {
+                            lane_child_masks[lane] = get_voxel_octree_child_mask(&octree, level, lane_handles[lane]);
+                            if(level + 1 < lod && (lane_child_masks[lane] & (1 << lane_bit_indices[lane])))
+                            {
+                                lane_child_handles[lane] = get_voxel_octree_child_handle(&octree, level, lane_handles[lane], lane_bit_indices[lane]);
+                            }
+                        }
+                    }
+
+                    simd_u32 has_child = is_lane_non_zero((simd_u32_load(lane_child_masks) >> bit_index) & simd_u32_1);
+                    simd_u32 is_empty = is_walking & (~has_child);
+                    octant_dim = overwrite(octant_dim, is_empty, half_dim);
+                    is_resolved = is_resolved | is_empty;
+
+                    if(level + 1 < lod)
+                    {
+                        handles[level + 1] = overwrite(handles[level + 1], is_walking & has_child, simd_u32_load(lane_child_handles));
+                    }
+                }
+
+                simd_u32 is_hit = is_active & compare_equal(octant_dim, simd_u32_0);
+                if(!all_lanes_zero(is_hit))
+                {
+                    closest_t = overwrite(closest_t, is_hit, t);
+                    for(u32 lane = 0;
+                            lane < lane_count;
+                            ++lane)
+                    {
+                        if(get_lane(is_hit, lane))
+                        {
+                            u32 x = get_lane(cell[0], lane);
+                            u32 y = get_lane(cell[1], lane);
+                            u32 z = get_lane(cell[2], lane);
+
+                            VoxelRayHit *hit = hits + ray_index + lane;
+                            hit->hit_t = get_lane(t, lane);
+                            hit->hit_normal = V3(get_lane(normal[0], lane), get_lane(normal[1], lane), get_lane(normal[2], lane));
+                            hit->color_id = get_voxel(&octree, x, y, z).color_id;
+                            hit->color = world->palette[hit->color_id];
+                            hit->voxel_x = chunk_min[0] + x;
+                            hit->voxel_y = chunk_min[1] + y;
+                            hit->voxel_z = chunk_min[2] + z;
+                        }
+                    }
+
+                    is_active = is_active & (~is_hit);
+                }
+
+                if(all_lanes_zero(is_active))
+                {
+                    break;
+                }
+
+                simd_u32 octant_min[3];
+                simd_f32 axis_t[3];
+                for(u32 axis = 0;
+                        axis < 3;
+                        ++axis)
+                {
+                    octant_min[axis] = cell[axis] & (~(octant_dim - simd_u32_1));
+
+                    simd_u32 boundary = overwrite(octant_min[axis], is_dir_positive[axis], octant_min[axis] + octant_dim);
+                    axis_t[axis] = (convert_f32_from_u32(boundary) - chunk_origin[axis])*inv_dir[axis];
+                }
+
+                simd_f32 exit_t = min(min(axis_t[0], axis_t[1]), axis_t[2]);
+                simd_u32 is_exit_axis[3];
+                is_exit_axis[0] = compare_less_equal(axis_t[0], axis_t[1]) & compare_less_equal(axis_t[0], axis_t[2]);
+                is_exit_axis[1] = (~is_exit_axis[0]) & compare_less_equal(axis_t[1], axis_t[2]);
+                is_exit_axis[2] = ~(is_exit_axis[0] | is_exit_axis[1]);
+
+                is_active = is_active & compare_less_equal(exit_t, end_t);
+
+                simd_u32 changed_bits = simd_u32_0;
+                for(u32 axis = 0;
+                        axis < 3;
+                        ++axis)
+                {
+                    // NOTE(joon) wraps around when the ray goes out from the negative side, which is also outside of the chunk
+                    simd_u32 step_cell = overwrite(octant_min[axis] - simd_u32_1, is_dir_positive[axis], octant_min[axis] + octant_dim);
+                    is_active = is_active & (~(is_exit_axis[axis] & compare_greater_equal(step_cell, simd_chunk_dim)));
+
+                    simd_u32 octant_max = octant_min[axis] + octant_dim - simd_u32_1;
+                    simd_u32 next_cell = convert_u32_from_f32(chunk_origin[axis] + exit_t*dir[axis]);
+                    next_cell = overwrite(next_cell, compare_less(next_cell, octant_min[axis]), octant_min[axis]);
+                    next_cell = overwrite(next_cell, compare_greater(next_cell, octant_max), octant_max);
+                    next_cell = overwrite(next_cell, is_exit_axis[axis], step_cell);
+
+                    changed_bits = changed_bits | (cell[axis] ^ next_cell);
+                    cell[axis] = next_cell;
+
+                    normal[axis] = overwrite(simd_f32_0, is_exit_axis[axis], step_normal[axis]);
+                }
+
+                // NOTE(joon) first level where the cell went into a different child
+                restart_level = simd_u32_(lod);
+                for(i32 level = (i32)lod - 1;
+                        level >= 0;
+                        --level)
+                {
+                    simd_u32 half_dim = simd_u32_(chunk_dim >> (level + 1));
+                    restart_level = overwrite(restart_level, is_lane_non_zero(changed_bits & half_dim), simd_u32_((u32)level));
+                }
+
+                t = exit_t;
+            }
+        }
+
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            VoxelRayHit *hit = hits + ray_index + lane;
+            if(hit->hit_t >= 0.0f)
+            {
+                hit->hit_p = ray_origins[ray_index + lane] + hit->hit_t*ray_dirs[ray_index + lane];
+            }
+        }
+    }
+}
+
+/*
+   NOTE(joon) Each lane is a different ray of the same sample, spread uniformly over the hemisphere(pdf = 1/2pi).
+   With N rays, the L0 & L1 of the incoming radiance convolved with the cosine lobe(pi & 2pi/3) become
+   irradiance = pi/(2N)*sum(L), irradiance_gradient = pi/N*sum(L*dir), and the cosine weighted ambient occlusion is 2/N*sum(visible*cos).
+*/
+BAKE_LIGHTING(kernel_name(bake_lighting))
+{
+    LightingBakeSettings *settings = &batch->settings;
+    assert(settings->ray_per_sample_count % HB_LANE_WIDTH == 0);
+
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+    simd_v3 simd_V30 = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+    simd_u32 all_lanes_mask = simd_u32_(0xffffffff);
+    simd_f32 ao_distance = simd_f32_(settings->ao_distance);
+    simd_v3 sky_color = simd_v3_(settings->sky_color);
+
+    SimdSampler sampler = start_simd_sampler(SamplerType_Sobol, settings->seed, 0);
+
+    for(u32 sample_index = 0;
+            sample_index < batch->sample_count;
+            ++sample_index)
+    {
+        v3 origin = batch->positions[sample_index];
+        simd_v3 normal = simd_v3_(batch->normals[sample_index]);
+
+        simd_v3 radiance_sum = simd_V30;
+        simd_v3 radiance_dir_sums[3] = {simd_V30, simd_V30, simd_V30};
+        simd_f32 ao_sum = simd_f32_0;
+
+        for(u32 first_ray_index = 0;
+                first_ray_index < settings->ray_per_sample_count;
+                first_ray_index += HB_LANE_WIDTH)
+        {
+            start_simd_sampler_pixel(&sampler, batch->first_sample_index + sample_index, 0, first_ray_index);
+            simd_v3 ray_dir = get_unit_vector(get_sample_2d(&sampler));
+
+            // NOTE(joon) flipping the directions that are under the surface keeps the distribution uniform
+            simd_f32 cos_theta = dot(ray_dir, normal);
+            simd_u32 is_below_mask = compare_less(cos_theta, simd_f32_0);
+            ray_dir = overwrite(ray_dir, is_below_mask, -ray_dir);
+            cos_theta = overwrite(cos_theta, is_below_mask, -cos_theta);
+
+            r32 dir_x[HB_LANE_WIDTH];
+            r32 dir_y[HB_LANE_WIDTH];
+            r32 dir_z[HB_LANE_WIDTH];
+            simd_v3_store(dir_x, dir_y, dir_z, ray_dir);
+
+            simd_f32 hit_t = simd_f32_(Flt_Max);
+            simd_v3 radiance = simd_V30;
+            if(batch->raytracer_world)
+            {
+                RaytracerWorld *world = batch->raytracer_world;
+                SimdRayIntersectResult hit = ray_intersect_with_raytracer_world(world, simd_v3_(origin), ray_dir, all_lanes_mask, true,
+                                                                                simd_f32_(Flt_Max));
+                hit_t = hit.hit_t;
+
+                // NOTE(joon) the rays that didn't hit anything have the material 0, which is the sky
+                r32 emit_r[HB_LANE_WIDTH];
+                r32 emit_g[HB_LANE_WIDTH];
+                r32 emit_b[HB_LANE_WIDTH];
+                for(u32 lane = 0;
+                        lane < HB_LANE_WIDTH;
+                        ++lane)
+                {
+                    RaytracerMaterial *lane_hit_material = world->materials + get_lane(hit.hit_mat_index, lane);
+
+                    emit_r[lane] = lane_hit_material->emit_color.r;
+                    emit_g[lane] = lane_hit_material->emit_color.g;
+                    emit_b[lane] = lane_hit_material->emit_color.b;
+                }
+                radiance = simd_v3_load(emit_r, emit_g, emit_b);
+            }
+            else
+            {
+                v3 ray_origins[HB_LANE_WIDTH];
+                v3 ray_dirs[HB_LANE_WIDTH];
+                for(u32 lane = 0;
+                        lane < HB_LANE_WIDTH;
+                        ++lane)
+                {
+                    ray_origins[lane] = origin;
+                    ray_dirs[lane] = V3(dir_x[lane], dir_y[lane], dir_z[lane]);
+                }
+
+                VoxelRayHit hits[HB_LANE_WIDTH];
+                kernel_name(trace_voxel_rays)(batch->voxel_world, batch->voxel_memory, ray_origins, ray_dirs, HB_LANE_WIDTH, Flt_Max, hits);
+
+                r32 lane_hit_t[HB_LANE_WIDTH];
+                for(u32 lane = 0;
+                        lane < HB_LANE_WIDTH;
+                        ++lane)
+                {
+                    lane_hit_t[lane] = (hits[lane].hit_t >= 0.0f) ? hits[lane].hit_t : Flt_Max;
+                }
+                hit_t = simd_f32_load(lane_hit_t);
+
+                // NOTE(joon) voxels don't emit anything, so only the rays that escaped bring the light in
+                radiance = overwrite(simd_V30, compare_equal(hit_t, simd_f32_(Flt_Max)), sky_color);
+            }
+
+            radiance_sum = radiance_sum + radiance;
+            radiance_dir_sums[0] = radiance_dir_sums[0] + simd_f32_load(dir_x)*radiance;
+            radiance_dir_sums[1] = radiance_dir_sums[1] + simd_f32_load(dir_y)*radiance;
+            radiance_dir_sums[2] = radiance_dir_sums[2] + simd_f32_load(dir_z)*radiance;
+
+            simd_f32 visibility = overwrite(simd_f32_1, compare_less(hit_t, ao_distance), simd_f32_0);
+            ao_sum += visibility*cos_theta;
+        }
+
+        r32 ray_count = (r32)settings->ray_per_sample_count;
+        LightingBakeResult *result = batch->results + sample_index;
+        result->irradiance = (pi_32/(2.0f*ray_count))*add_all_lanes(radiance_sum);
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            result->irradiance_gradient[axis] = (pi_32/ray_count)*add_all_lanes(radiance_dir_sums[axis]);
+        }
+        result->ambient_occlusion = (2.0f/ray_count)*add_all_lanes(ao_sum);
+    }
+}
+
+// NOTE(joon) exp(-x) for x >= 0, using (1 - x/16)^16. Becomes exactly 0 at x = 16, where exp(-16) is ~1e-7 anyway
+internal simd_f32
+exp_negative_approx(simd_f32 x)
+{
+    simd_f32 result = max(simd_f32_(1.0f) - x*simd_f32_(1.0f/16.0f), simd_f32_(0.0f));
+    result = result*result;
+    result = result*result;
+    result = result*result;
+    result = result*result;
+
+    return result;
+}
+
+/*
+   NOTE(joon) HB_LANE_WIDTH pixels of a row at once, where the taps are loaded straight from the planes
+   as the border is wide enough for the farthest tap of the last iteration.
+   The lanes that go past the width are filtered as well(with all weights being 0), 
+   and written as 0 to the border so that the border never has anything other than 0.
+*/
+DENOISE_RAYTRACED_IMAGE_BAND(kernel_name(denoise_raytraced_image_band))
+{
+    RaytracerDenoiser *denoiser = band->denoiser;
+    assert(HB_LANE_WIDTH <= Denoiser_Max_Lane_Width);
+    assert(band->iteration_index < denoiser->iteration_count);
+
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_v3 simd_V30 = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+
+    i32 step = 1 << band->iteration_index;
+    r32 **in_colors = denoiser->colors[band->iteration_index & 1];
+    r32 **out_colors = denoiser->colors[(band->iteration_index + 1) & 1];
+    b32 is_last_iteration = (band->iteration_index + 1 == denoiser->iteration_count);
+
+    // NOTE(joon) B3 spline, the 2D weights are the product of the two
+    r32 tap_weights[5] = {1.0f/16.0f, 1.0f/4.0f, 3.0f/8.0f, 1.0f/4.0f, 1.0f/16.0f};
+
+    r32 color_sigma = denoiser->color_sigma / (r32)step;
+    simd_f32 inv_color_sigma_square = simd_f32_(1.0f / (color_sigma*color_sigma));
+    simd_f32 inv_albedo_sigma_square = simd_f32_(1.0f / (denoiser->albedo_sigma*denoiser->albedo_sigma));
+    simd_f32 inv_normal_sigma_square = simd_f32_(1.0f / (denoiser->normal_sigma*denoiser->normal_sigma));
+    // NOTE(joon) the taps that are farther away are allowed to have a bigger depth difference
+    simd_f32 depth_sigma = simd_f32_(denoiser->depth_sigma*(r32)step);
+    // NOTE(joon) so that the pixels with depth 0(which didn't hit anything) don't divide by 0
+    simd_f32 min_depth = simd_f32_(0.0001f);
+
+    r32 lane_offsets[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        lane_offsets[lane] = (r32)lane;
+    }
+    simd_f32 simd_lane_offsets = simd_f32_load(lane_offsets);
+    simd_f32 simd_width = simd_f32_((r32)denoiser->width);
+    simd_f32 exposure_scale = simd_f32_(powf(2.0f, denoiser->output_encoding.exposure));
+
+    for(u32 y = band->min_y;
+            y < band->one_past_max_y;
+            ++y)
+    {
+        for(u32 x = 0;
+                x < denoiser->width;
+                x += HB_LANE_WIDTH)
+        {
+            u32 center = denoiser->origin + y*denoiser->stride + x;
+
+            simd_v3 color = simd_v3_load(in_colors[0] + center, in_colors[1] + center, in_colors[2] + center);
+            simd_v3 albedo = simd_v3_load(denoiser->albedos[0] + center, denoiser->albedos[1] + center, denoiser->albedos[2] + center);
+            simd_v3 normal = simd_v3_load(denoiser->normals[0] + center, denoiser->normals[1] + center, denoiser->normals[2] + center);
+            simd_f32 depth = simd_f32_load(denoiser->depths + center);
+            simd_f32 inv_depth_scale = simd_f32_(1.0f) / (max(depth, min_depth)*depth_sigma);
+
+            // NOTE(joon) which lanes are inside the image for each horizontal tap, which is the same for all rows
+            simd_f32 lane_x = simd_f32_((r32)x) + simd_lane_offsets;
+            simd_u32 tap_x_masks[5];
+            for(i32 tap_x = 0;
+                    tap_x < 5;
+                    ++tap_x)
+            {
+                simd_f32 sample_x = lane_x + simd_f32_((r32)((tap_x - 2)*step));
+                tap_x_masks[tap_x] = compare_greater_equal(sample_x, simd_f32_0) & compare_less(sample_x, simd_width);
+            }
+
+            simd_f32 weight_sum = simd_f32_0;
+            simd_v3 color_sum = simd_V30;
+            for(i32 tap_y = 0;
+                    tap_y < 5;
+                    ++tap_y)
+            {
+                i32 sample_y = (i32)y + (tap_y - 2)*step;
+                if(sample_y < 0 || sample_y >= (i32)denoiser->height)
+                {
+                    continue;
+                }
+
+                for(i32 tap_x = 0;
+                        tap_x < 5;
+                        ++tap_x)
+                {
+                    u32 sample = (u32)((i32)denoiser->origin + sample_y*(i32)denoiser->stride + (i32)x + (tap_x - 2)*step);
+
+                    simd_v3 sample_color = simd_v3_load(in_colors[0] + sample, in_colors[1] + sample, in_colors[2] + sample);
+                    simd_v3 sample_albedo = simd_v3_load(denoiser->albedos[0] + sample, denoiser->albedos[1] + sample, denoiser->albedos[2] + sample);
+                    simd_v3 sample_normal = simd_v3_load(denoiser->normals[0] + sample, denoiser->normals[1] + sample, denoiser->normals[2] + sample);
+                    simd_f32 depth_diff = simd_f32_load(denoiser->depths + sample) - depth;
+
+                    simd_f32 exponent = length_square(sample_color - color)*inv_color_sigma_square + 
+                                        length_square(sample_albedo - albedo)*inv_albedo_sigma_square + 
+                                        length_square(sample_normal - normal)*inv_normal_sigma_square + 
+                                        max(depth_diff, -depth_diff)*inv_depth_scale;
+
+                    simd_f32 weight = simd_f32_(tap_weights[tap_y]*tap_weights[tap_x])*exp_negative_approx(exponent);
+                    weight = overwrite(simd_f32_0, tap_x_masks[tap_x], weight);
+
+                    weight_sum = weight_sum + weight;
+                    color_sum = color_sum + weight*sample_color;
+                }
+            }
+
+            // NOTE(joon) the center tap always has a non-zero weight for the lanes that are inside the image
+            simd_v3 result_color = overwrite(simd_V30, tap_x_masks[2], color_sum/weight_sum);
+            simd_v3_store(out_colors[0] + center, out_colors[1] + center, out_colors[2] + center, result_color);
+
+            if(is_last_iteration)
+            {
+                // NOTE(joon) the planes are padded, so the lanes past the width can be loaded as well
+                simd_u32 encoded_color = encode_output_color(exposure_scale*simd_f32_load(out_colors[0] + center), 
+                                                             exposure_scale*simd_f32_load(out_colors[1] + center), 
+                                                             exposure_scale*simd_f32_load(out_colors[2] + center), 
+                                                             denoiser->output_encoding.tone_map_type, 
+                                                             get_ordered_dither(&denoiser->output_encoding, x, y));
+
+                u32 lane_count = minimum(HB_LANE_WIDTH, denoiser->width - x);
+                u32 *pixel = denoiser->pixels + y*denoiser->width + x;
+                if(lane_count == HB_LANE_WIDTH)
+                {
+                    simd_u32_store(pixel, encoded_color);
+                }
+                else
+                {
+                    u32 lane_pixels[HB_LANE_WIDTH];
+                    simd_u32_store(lane_pixels, encoded_color);
+                    for(u32 lane = 0;
+                            lane < lane_count;
+                            ++lane)
+                    {
+                        pixel[lane] = lane_pixels[lane];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -7,7 +7,7 @@
 
 // TODO(joon) This function is not actually 'safe'...
 // need better name here
-inline b32
+internal inline b32
 compare_with_epsilon(f32 a, f32 b, f32 epsilon = 0.00005f)
 {
     b32 result = true;
@@ -22,7 +22,7 @@ compare_with_epsilon(f32 a, f32 b, f32 epsilon = 0.00005f)
     return result;
 }
 
-inline f32
+internal inline f32
 safe_ratio(f32 nom, f32 denom)
 {
     f32 result = Flt_Max;
@@ -36,26 +36,26 @@ safe_ratio(f32 nom, f32 denom)
     return result;
 }
 
-inline f32
+internal inline f32
 square(f32 value)
 {
     return value*value;
 }
 
-inline f32
+internal inline f32
 lerp(f32 min, f32 t, f32 max)
 {
     return min + t*(max-min);
 }
 
-inline v2
+internal inline v2
 V2(void)
 {
     v2 result = {};
     return result;
 }
 
-inline v2
+internal inline v2
 V2(f32 x, f32 y)
 {
     v2 result = {};
@@ -66,13 +66,13 @@ V2(f32 x, f32 y)
     return result;
 }
 
-inline f32
+internal inline f32
 length(v2 a)
 {
     return sqrtf(a.x*a.x + a.y*a.y);
 }
 
-inline v2
+internal inline v2
 V2i(i32 x, i32 y)
 {
     v2 result = {};
@@ -83,14 +83,14 @@ V2i(i32 x, i32 y)
     return result;
 }
 
-inline f32
+internal inline f32
 length_square(v2 a)
 {
     return a.x*a.x + a.y*a.y;
 }
 
 
-inline v2&
+internal inline v2&
 operator+=(v2 &v, v2 a)
 {
     v.x += a.x;
@@ -99,7 +99,7 @@ operator+=(v2 &v, v2 a)
     return v;
 }
 
-inline v2&
+internal inline v2&
 operator-=(v2 &v, v2 a)
 {
     v.x -= a.x;
@@ -108,7 +108,7 @@ operator-=(v2 &v, v2 a)
     return v;
 }
 
-inline v2
+internal inline v2
 operator-(v2 a)
 {
     v2 result = {};
@@ -119,7 +119,7 @@ operator-(v2 a)
     return result;
 }
 
-inline v2
+internal inline v2
 operator+(v2 a, v2 b)
 {
     v2 result = {};
@@ -130,7 +130,7 @@ operator+(v2 a, v2 b)
     return result;
 }
 
-inline v2
+internal inline v2
 operator-(v2 a, v2 b)
 {
     v2 result = {};
@@ -140,7 +140,7 @@ operator-(v2 a, v2 b)
 
     return result;
 }
-inline v2
+internal inline v2
 operator/(v2 a, f32 value)
 {
     v2 result = {};
@@ -151,7 +151,7 @@ operator/(v2 a, f32 value)
     return result;
 }
 
-inline v2
+internal inline v2
 operator*(f32 value, v2 &a)
 {
     v2 result = {};
@@ -162,7 +162,7 @@ operator*(f32 value, v2 &a)
     return result;
 }
 
-inline v3
+internal inline v3
 V3()
 {
     v3 result = {};
@@ -170,7 +170,7 @@ V3()
     return result;
 }
 
-inline v3
+internal inline v3
 V3(f32 x, f32 y, f32 z)
 {
     v3 result = {};
@@ -182,13 +182,13 @@ V3(f32 x, f32 y, f32 z)
     return result;
 }
 
-inline f32
+internal inline f32
 length(v3 a)
 {
     return sqrtf(a.x*a.x + a.y*a.y + a.z*a.z);
 }
 
-inline v3&
+internal inline v3&
 operator+=(v3 &v, v3 a)
 {
     v.x += a.x;
@@ -198,7 +198,7 @@ operator+=(v3 &v, v3 a)
     return v;
 }
 
-inline v3&
+internal inline v3&
 operator-=(v3 &v, v3 a)
 {
     v.x -= a.x;
@@ -208,7 +208,7 @@ operator-=(v3 &v, v3 a)
     return v;
 }
 
-inline v3
+internal inline v3
 operator-(v3 a)
 {
     v3 result = {};
@@ -220,7 +220,7 @@ operator-(v3 a)
     return result;
 }
 
-inline v3
+internal inline v3
 operator+(v3 a, v3 b)
 {
     v3 result = {};
@@ -232,7 +232,7 @@ operator+(v3 a, v3 b)
     return result;
 }
 
-inline v3
+internal inline v3
 operator-(v3 a, v3 b)
 {
     v3 result = {};
@@ -243,7 +243,7 @@ operator-(v3 a, v3 b)
 
     return result;
 }
-inline v3
+internal inline v3
 operator/(v3 a, f32 value)
 {
     v3 result = {};
@@ -255,7 +255,7 @@ operator/(v3 a, f32 value)
     return result;
 }
 
-inline v3&
+internal inline v3&
 operator/=(v3 &a, f32 value)
 {
     a.x /= value;
@@ -265,7 +265,7 @@ operator/=(v3 &a, f32 value)
     return a;
 }
 
-inline v3&
+internal inline v3&
 operator*=(v3 &a, f32 value)
 {
     a.x *= value;
@@ -275,7 +275,7 @@ operator*=(v3 &a, f32 value)
     return a;
 }
 
-inline v3
+internal inline v3
 operator*(f32 value, v3 a)
 {
     v3 result = {};
@@ -289,7 +289,7 @@ operator*(f32 value, v3 a)
 
 // RHS!!!!
 // NOTE(joon) : This assumes the vectors ordered counter clockwisely
-inline v3
+internal inline v3
 cross(v3 a, v3 b)
 {
     v3 result = {};
@@ -301,43 +301,43 @@ cross(v3 a, v3 b)
     return result;
 }
 
-inline f32
+internal inline f32
 length_square(v3 a)
 {
     return a.x*a.x + a.y*a.y + a.z*a.z;
 }
 
-inline v3
+internal inline v3
 normalize(v3 a)
 {
     return a/length(a);
 }
 
-inline v3
+internal inline v3
 norm(v3 a)
 {
     return normalize(a);
 }
 
-inline b32
+internal inline b32
 is_normalized(v3 a)
 {
     return (a.x <= 1.0f && a.y <= 1.0f && a.z <= 1.0f);
 }
 
-inline f32
+internal inline f32
 dot(v3 a, v3 b)
 {
     return a.x*b.x + a.y*b.y + a.z*b.z;
 }
 
-inline v3
+internal inline v3
 hadamard(v3 a, v3 b)
 {
     return V3(a.x*b.x, a.y*b.y, a.z*b.z);
 }
 
-inline v3
+internal inline v3
 lerp(v3 min, f32 t, v3 max)
 {
     v3 result = {};
@@ -349,7 +349,7 @@ lerp(v3 min, f32 t, v3 max)
     return result;
 }
 
-inline f32
+internal inline f32
 max_element(v3 a)
 {
     f32 result = maximum(maximum(a.x, a.y), a.z);
@@ -357,7 +357,7 @@ max_element(v3 a)
     return result;
 }
 
-inline f32
+internal inline f32
 min_element(v3 a)
 {
     f32 result = minimum(minimum(a.x, a.y), a.z);
@@ -365,7 +365,7 @@ min_element(v3 a)
     return result;
 }
 
-inline v3
+internal inline v3
 gather_min_elements(v3 a, v3 b)
 {
     v3 result = {};
@@ -377,7 +377,7 @@ gather_min_elements(v3 a, v3 b)
     return result;
 }
 
-inline v3
+internal inline v3
 gather_max_elements(v3 a, v3 b)
 {
     v3 result = {};
@@ -389,14 +389,14 @@ gather_max_elements(v3 a, v3 b)
     return result;
 }
 
-inline v4
+internal inline v4
 V4(void)
 {
     v4 result = {};
     return result;
 }
 
-inline v4
+internal inline v4
 V4(f32 x, f32 y, f32 z, f32 w)
 {
     v4 result = {};
@@ -408,7 +408,7 @@ V4(f32 x, f32 y, f32 z, f32 w)
     return result;
 }
 
-inline v4
+internal inline v4
 V4(v3 xyz, f32 w)
 {
     v4 result = {};
@@ -418,20 +418,20 @@ V4(v3 xyz, f32 w)
     return result;
 }
 
-inline f32
+internal inline f32
 length_square(v4 a)
 {
     return a.x*a.x + a.y*a.y + a.z*a.z + a.w*a.w;
 }
 
-inline f32
+internal inline f32
 dot(v4 a, v4 b)
 {
     f32 result = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
     return result;
 }
 
-inline v4
+internal inline v4
 operator/(v4 a, f32 value)
 {
     v4 result = {};
@@ -444,25 +444,25 @@ operator/(v4 a, f32 value)
     return result;
 }
 
-inline f32
+internal inline f32
 length(v4 a)
 {
     return sqrtf(length_square(a));
 }
 
-inline v4
+internal inline v4
 normalize(v4 a)
 {
     return a/length(a);
 }
 
-inline v4
+internal inline v4
 norm(v4 a)
 {
     return normalize(a);
 }
 
-inline v4
+internal inline v4
 operator+(v4 &a, v4 &b)
 {
     v4 result = {};
@@ -475,7 +475,7 @@ operator+(v4 &a, v4 &b)
     return result;
 }
 
-inline v4
+internal inline v4
 operator-(v4 &a, v4 &b)
 {
     v4 result = {};
@@ -488,7 +488,7 @@ operator-(v4 &a, v4 &b)
     return result;
 }
 
-inline v4
+internal inline v4
 operator*(f32 value, v4 &a)
 {
     v4 result = {};
@@ -501,7 +501,7 @@ operator*(f32 value, v4 &a)
     return result;
 }
 
-inline v4&
+internal inline v4&
 operator*=(v4 &a, f32 value)
 {
     a.x *= value;
@@ -512,7 +512,7 @@ operator*=(v4 &a, f32 value)
     return a;
 }
 
-inline b32
+internal inline b32
 clip_space_top_is_one(void)
 {
     b32 result = false;
@@ -525,7 +525,7 @@ clip_space_top_is_one(void)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 M3x3(f32 e00, f32 e01, f32 e02,
     f32 e10, f32 e11, f32 e12, 
     f32 e20, f32 e21, f32 e22)
@@ -539,7 +539,7 @@ M3x3(f32 e00, f32 e01, f32 e02,
 }
 
 // NOTE(joon) returns identity matrix
-inline m3x3
+internal inline m3x3
 M3x3(void)
 {
     m3x3 result = {};
@@ -551,7 +551,7 @@ M3x3(void)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 M3x3(m4x4 m)
 {
     m3x3 result = {};
@@ -562,7 +562,7 @@ M3x3(m4x4 m)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 operator *(m3x3 a, m3x3 b)
 {
     m3x3 result = {}; 
@@ -581,7 +581,7 @@ operator *(m3x3 a, m3x3 b)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 operator *(f32 value, m3x3 m)
 {
     m3x3 result = m;
@@ -595,7 +595,7 @@ operator *(f32 value, m3x3 m)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 operator +(m3x3 a, m3x3 b)
 {
     m3x3 result = {};
@@ -607,7 +607,7 @@ operator +(m3x3 a, m3x3 b)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 operator -(m3x3 a, m3x3 b)
 {
     m3x3 result = {};
@@ -619,7 +619,7 @@ operator -(m3x3 a, m3x3 b)
     return result;
 }
 
-inline m3x3
+internal inline m3x3
 transpose(m3x3 m)
 {
     m3x3 result = {};
@@ -639,7 +639,7 @@ transpose(m3x3 m)
     return result;
 }
 
-inline v3
+internal inline v3
 operator *(m3x3 a, v3 b)
 {
     v3 result = {};
@@ -651,7 +651,7 @@ operator *(m3x3 a, v3 b)
     return result;
 }
 
-inline m3x3&
+internal inline m3x3&
 operator *=(m3x3 &m, f32 value)
 {
     m.rows[0] *= value;
@@ -661,7 +661,7 @@ operator *=(m3x3 &m, f32 value)
     return m;
 }
 
-inline m3x3
+internal inline m3x3
 inverse(m3x3 m)
 {
     m3x3 result = {};
@@ -695,7 +695,7 @@ inverse(m3x3 m)
 
 
 // NOTE(joon) rotate along x axis
-inline m3x3
+internal inline m3x3
 x_rotate(f32 rad)
 {
     // same as 2d rotation, without x value changing
@@ -715,7 +715,7 @@ x_rotate(f32 rad)
 }
 
 // NOTE(joon) rotate along y axis
-inline m3x3
+internal inline m3x3
 y_rotate(f32 rad)
 {
     // same as 2d rotation, without y value changing
@@ -737,7 +737,7 @@ y_rotate(f32 rad)
 }
 
 // NOTE(joon) rotate along z axis
-inline m3x3 
+internal inline m3x3 
 z_rotate(f32 rad)
 {
     // same as 2d rotation, without x value changing
@@ -756,7 +756,7 @@ z_rotate(f32 rad)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 M4x4(f32 e00, f32 e01, f32 e02, f32 e03,
     f32 e10, f32 e11, f32 e12, f32 e13,
     f32 e20, f32 e21, f32 e22, f32 e23,
@@ -771,7 +771,7 @@ M4x4(f32 e00, f32 e01, f32 e02, f32 e03,
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 M4x4(void)
 {
     m4x4 result = {};
@@ -784,7 +784,7 @@ M4x4(void)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 M4x4(m3x3 m)
 {
     m4x4 result = {};
@@ -796,7 +796,7 @@ M4x4(m3x3 m)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 operator *(m4x4 a, m4x4 b)
 {
     m4x4 result = {}; 
@@ -823,7 +823,7 @@ operator *(m4x4 a, m4x4 b)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 operator *(f32 value, m4x4 m)
 {
     m4x4 result = m;
@@ -837,7 +837,7 @@ operator *(f32 value, m4x4 m)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 operator +(m4x4 a, m4x4 b)
 {
     m4x4 result = {};
@@ -850,7 +850,7 @@ operator +(m4x4 a, m4x4 b)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 operator -(m4x4 a, m4x4 b)
 {
     m4x4 result = {};
@@ -863,7 +863,7 @@ operator -(m4x4 a, m4x4 b)
     return result;
 }
 
-inline m4x4
+internal inline m4x4
 transpose(m4x4 m)
 {
     m4x4 result = {};
@@ -883,7 +883,24 @@ transpose(m4x4 m)
     return result;
 }
 
-inline v4
+// NOTE(joon) Only works for the affine transforms(last row being 0, 0, 0, 1), 
+// which is everything that we build from the rotation, scale & translation
+internal inline m4x4
+inverse_affine(m4x4 m)
+{
+    m3x3 inv = inverse(M3x3(m));
+    v3 inv_translation = -(inv*V3(m.e[0][3], m.e[1][3], m.e[2][3]));
+
+    m4x4 result = M4x4(inv);
+    result.e[0][3] = inv_translation.x;
+    result.e[1][3] = inv_translation.y;
+    result.e[2][3] = inv_translation.z;
+    result.e[3][3] = 1.0f;
+
+    return result;
+}
+
+internal inline v4
 operator *(m4x4 a, v4 b)
 {
     v4 result = {};
@@ -896,7 +913,7 @@ operator *(m4x4 a, v4 b)
     return result;
 }
 
-inline f32 
+internal inline f32 
 clamp(f32 min, f32 value, f32 max)
 {
     f32 result = value;
@@ -911,14 +928,14 @@ clamp(f32 min, f32 value, f32 max)
 
     return result;
 }
-inline f32 
+internal inline f32 
 clamp01(f32 value)
 {
     return clamp(0.0f, value, 1.0f);
 }
 
 
-inline u32
+internal inline u32
 clamp(u32 min, u32 value, u32 max)
 {
     u32 result = value;
@@ -934,7 +951,7 @@ clamp(u32 min, u32 value, u32 max)
     return result;
 }
 
-inline i32
+internal inline i32
 clamp(i32 min, i32 value, i32 max)
 {
     i32 result = value;
@@ -955,7 +972,7 @@ clamp(i32 min, i32 value, i32 max)
 // 0x11 22 33 44
 //    3  2  1  0 - little endian
 //    0  1  2  3 - big endian
-inline u32
+internal inline u32
 big_to_little_endian(u32 big)
 {
     u32 a = ((u8 *)&big)[0];
@@ -969,7 +986,7 @@ big_to_little_endian(u32 big)
     return result;
 }
 
-inline u16
+internal inline u16
 big_to_little_endian(u16 big)
 {
     u16 result = (((u8 *)&big)[0] << 8) | (((u8 *)&big)[1] << 0);
@@ -977,30 +994,30 @@ big_to_little_endian(u16 big)
     return result;
 }
 
-inline i16 
+internal inline i16 
 big_to_little_endian(i16 big)
 {
-    i16 result = (((i8 *)&big)[0] << 8) | (((i8 *)&big)[1] << 0);
+    i16 result = (i16)((((u8 *)&big)[0] << 8) | (((u8 *)&big)[1] << 0));
 
     return result;
 }
 
-inline i32 
+internal inline i32 
 big_to_little_endian(i32 big)
 {
-    i32 result = (((i8 *)&big)[0] << 8) | (((i8 *)&big)[1] << 0);
+    i32 result = (i32)big_to_little_endian((u32)big);
 
     return result;
 }
 
-inline u64
+internal inline u64
 big_to_little_endian(u64 byte_count)
 {
     u64 result = 0;
     return result;
 }
 
-inline quat
+internal inline quat
 Quat(f32 s, v3 v)
 {
     quat result = {};
@@ -1011,7 +1028,7 @@ Quat(f32 s, v3 v)
 }
 
 // NOTE(joon) returns rotation quaternion
-inline quat
+internal inline quat
 Quat(v3 axis, f32 rad)
 {
     quat result = {};
@@ -1021,7 +1038,7 @@ Quat(v3 axis, f32 rad)
     return result;
 }
 
-inline quat
+internal inline quat
 operator +(quat a, quat b)
 {
     quat result = {};
@@ -1032,7 +1049,7 @@ operator +(quat a, quat b)
     return result;
 }
 
-inline quat
+internal inline quat
 operator *(quat a, quat b)
 {
     quat result = {};
@@ -1043,7 +1060,7 @@ operator *(quat a, quat b)
     return result;
 }
 
-inline quat
+internal inline quat
 operator *(f32 value, quat q)
 {
     quat result = q;
@@ -1053,7 +1070,7 @@ operator *(f32 value, quat q)
     return result;
 }
 
-inline quat
+internal inline quat
 operator /(quat q, f32 value)
 {
     quat result = {};
@@ -1063,7 +1080,7 @@ operator /(quat q, f32 value)
     return result;
 }
 
-inline quat &
+internal inline quat &
 operator +=(quat &a, quat b)
 {
     a.s += b.s;
@@ -1072,7 +1089,7 @@ operator +=(quat &a, quat b)
     return a;
 }
 
-inline quat &
+internal inline quat &
 operator *=(quat &q, f32 value)
 {
     q.s *= value;
@@ -1081,7 +1098,7 @@ operator *=(quat &q, f32 value)
     return q;
 }
 
-inline quat &
+internal inline quat &
 operator /=(quat &q, f32 value)
 {
     q.s /= value;
@@ -1092,7 +1109,7 @@ operator /=(quat &q, f32 value)
 
 // TODO(joon) make quaternion based on the orientation
 
-inline f32
+internal inline f32
 length_square(quat q)
 {
     f32 result = length_square(q.v) + q.s*q.s;
@@ -1100,7 +1117,7 @@ length_square(quat q)
     return result;
 }
 
-inline f32
+internal inline f32
 length(quat q)
 {
     f32 result = sqrt(length_square(q));
@@ -1108,7 +1125,7 @@ length(quat q)
     return result;
 }
 
-inline quat
+internal inline quat
 normalize(quat q)
 {
     quat result = q/length(q);
@@ -1116,13 +1133,13 @@ normalize(quat q)
     return result;
 }
 
-inline quat
+internal inline quat
 norm(quat q)
 {
     return normalize(q);
 }
 
-inline quat
+internal inline quat
 conjugate(quat q)
 {
     quat result = q;
@@ -1131,7 +1148,7 @@ conjugate(quat q)
     return result;
 }
 
-inline quat
+internal inline quat
 inverse(quat q)
 {
     quat result = conjugate(q) / length_square(q);
@@ -1139,7 +1156,7 @@ inverse(quat q)
     return result;
 }
 
-inline b32
+internal inline b32
 is_pure_quat(quat q)
 {
     b32 result = false;
@@ -1152,7 +1169,7 @@ is_pure_quat(quat q)
     return result;
 }
 
-inline b32
+internal inline b32
 does_quat_represent_orientation(quat q)
 {
     b32 result = compare_with_epsilon(q.s, 0.0f) && compare_with_epsilon(length_square(q.v), 1.0f);
@@ -1161,7 +1178,7 @@ does_quat_represent_orientation(quat q)
 }
 
 // NOTE(joon) This matrix is an orthogonal matrix, so inverse == transpose
-inline m3x3
+internal inline m3x3
 rotation_quat_to_m3x3(quat q)
 {
     // NOTE(joon) q is a unit-norm quaterion, whether pure or non-pure
@@ -1189,7 +1206,7 @@ rotation_quat_to_m3x3(quat q)
 // multiplying those two quaternions will make the q unpure.
 // so we basically need to multiply it by inverse rot_q, 
 // which makes q pure again. This is also why we are only using half_rad instead of rad
-inline quat
+internal inline quat
 rotate(quat q, v3 axis, f32 rad)
 {
     assert(compare_with_epsilon(length_square(axis), 1.0f));
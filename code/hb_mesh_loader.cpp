@@ -1615,6 +1615,7 @@ generate_unit_sphere_mesh(u32 desired_column_count, u32 desired_row_count)
     return result;
 }
 
+// NOTE(joon) Returns the r, g, b planes of Merl_Brdf_Channel_Size each, see MerlBrdf & build_merl_brdf
 internal f32 *
 load_merl_brdf(PlatformReadFileResult file)
 {
@@ -1626,19 +1627,27 @@ load_merl_brdf(PlatformReadFileResult file)
     i32 dim_0 = *(i32 *)(memory);
     i32 dim_1 = *(i32 *)(memory + sizeof(i32));
     i32 dim_2 = *(i32 *)(memory + 2*sizeof(i32));
-    assert(dim_0 == 90 && dim_1 == 90 && dim_2 == 180);
+    assert(dim_0 == Merl_Brdf_Theta_H_Count && dim_1 == Merl_Brdf_Theta_D_Count && dim_2 == Merl_Brdf_Phi_D_Count);
 
-    u32 brdf_table_element_count = 3 * 90 * 90 * 180;
+    u32 brdf_table_element_count = 3 * Merl_Brdf_Channel_Size;
     f32 *brdf_table = (f32 *)malloc(brdf_table_element_count * sizeof(f32));
 
+    // NOTE(joon) each channel is stored with its own scale(see BRDFRead.cpp that comes with the database)
+    r64 channel_scales[3] = {1.0/1500.0, 1.15/1500.0, 1.66/1500.0};
+
     memory += 3*sizeof(i32);
     for(u32 element_index = 0;
             element_index < brdf_table_element_count;
             ++element_index)
     {
-        brdf_table[element_index] = *((float *)memory);
+        // NOTE(joon) the values are not aligned to 8 bytes because of the header
+        r64 value;
+        memcpy(&value, memory, sizeof(r64));
+
+        // NOTE(joon) the directions that were not measured are negative
+        brdf_table[element_index] = (f32)maximum(value*channel_scales[element_index / Merl_Brdf_Channel_Size], 0.0);
 
-        memory += sizeof(double);
+        memory += sizeof(r64);
     }
 
     return brdf_table;
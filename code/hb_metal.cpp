@@ -85,6 +85,32 @@ metal_flush_managed_buffer(MetalManagedBuffer *buffer)
     }
 }
 
+// NOTE(joon) single channel 8 bit texture, mostly for the glyph atlas
+internal id<MTLTexture>
+metal_create_r8_texture(id<MTLDevice> device, u32 width, u32 height)
+{
+    MTLTextureDescriptor *descriptor = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatR8Unorm
+                                                            width:width
+                                                            height:height
+                                                            mipmapped:NO];
+    descriptor.usage = MTLTextureUsageShaderRead;
+    descriptor.storageMode = MTLStorageModeManaged;
+
+    id<MTLTexture> result = [device newTextureWithDescriptor:descriptor];
+
+    return result;
+}
+
+internal void
+metal_write_r8_texture(id<MTLTexture> texture, u8 *pixels, u32 width, u32 height)
+{
+    MTLRegion region = MTLRegionMake2D(0, 0, width, height);
+    [texture replaceRegion:region
+            mipmapLevel:0
+            withBytes:pixels
+            bytesPerRow:width];
+}
+
 // NOTE(joon) wrapping functions
 // TODO(joon) might do some interesting things by inserting something here...(i.e renderdoc?)
 internal void
@@ -133,6 +159,13 @@ metal_set_vertex_buffer(id<MTLRenderCommandEncoder> render_encoder, id<MTLBuffer
                     atIndex:index];
 }
 
+internal void
+metal_set_fragment_texture(id<MTLRenderCommandEncoder> render_encoder, id<MTLTexture> texture, u32 index)
+{
+    [render_encoder setFragmentTexture:texture
+                    atIndex:index];
+}
+
 internal void
 metal_draw_non_indexed(id<MTLRenderCommandEncoder> render_encoder, MTLPrimitiveType primitive_type, 
                         u32 vertex_start, u32 vertex_count)
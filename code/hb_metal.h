@@ -30,6 +30,14 @@ struct MetalRenderContext
     id<MTLRenderPipelineState> voxel_pipeline_state;
     id<MTLRenderPipelineState> cube_pipeline_state;
     id<MTLRenderPipelineState> line_pipeline_state;
+    id<MTLRenderPipelineState> text_pipeline_state;
+
+    id<MTLDepthStencilState> text_depth_state; // compare : always, write : disabled
+
+    // NOTE(joon) 8 bit coverage atlas, only re-uploaded when the generation from the game code changes
+    id<MTLTexture> glyph_atlas_texture;
+    u32 glyph_atlas_generation;
+    MetalManagedBuffer text_glyph_instance_buffer;
 
     MetalManagedBuffer voxel_position_buffer;
     MetalManagedBuffer voxel_color_buffer;
@@ -58,11 +58,16 @@ typedef PLATFORM_WRITE_ENTIRE_FILE(platform_write_entire_file);
 #define PLATFORM_FREE_FILE_MEMORY(name) void (name)(void *memory)
 typedef PLATFORM_FREE_FILE_MEMORY(platform_free_file_memory);
 
+struct thread_work_queue;
 struct PlatformAPI
 {
     platform_read_file *read_file;
     platform_write_entire_file *write_entire_file;
     platform_free_file_memory *free_file_memory;
+
+    // NOTE(joon) worker threads of the platform layer. Nothing waits for the items at the end of the frame,
+    // so the jobs can go across the frames(i.e the mass agg bvh rebuild), and whoever needs the result should wait for it.
+    thread_work_queue *work_queue;
 };
 
 struct PlatformInput
@@ -234,7 +239,8 @@ struct debug_cycle_counter
     u32 hit_count;
 };
 
-u64 rdtsc(void)
+internal u64
+rdtsc(void)
 {
 	u64 val;
 #if HB_ARM 
@@ -253,7 +259,6 @@ global debug_cycle_counter debug_cycle_counters[debug_cycle_counter_count];
 
 #define PLATFORM_DEBUG_PRINT_CYCLE_COUNTERS(name) void (name)(debug_cycle_counter *debug_cycle_counters)
 
-struct thread_work_queue;
 #define THREAD_WORK_CALLBACK(name) void name(void *data)
 typedef THREAD_WORK_CALLBACK(thread_work_callback);
 
@@ -272,14 +277,21 @@ typedef PLATFORM_COMPLETE_ALL_THREAD_WORK_QUEUE_ITEMS(platform_complete_all_thre
 #define PLATFORM_ADD_THREAD_WORK_QUEUE_ITEM(name) void name(thread_work_queue *queue, thread_work_callback *threadWorkCallback, void *data)
 typedef PLATFORM_ADD_THREAD_WORK_QUEUE_ITEM(platform_add_thread_work_queue_item);
 
-// IMPORTANT(joon): There is no safeguard for the situation where one work takes too long, and meanwhile the work queue was filled so quickly
-// causing writeItem == readItem
+// IMPORTANT(joon): Both indices wrap around, but there is no safeguard for the situation where 
+// the queue was filled faster than it was consumed, causing add_index to catch up with work_index.
+// So there should never be more than array_count(items) - 1 items in the queue at once
 struct thread_work_queue
 {
     // NOTE(joon) : volatile forces the compiler not to optimize the value out, and always to the load(as other thread can change it)
     int volatile work_index; // index to the queue that is currently under work
     int volatile add_index;
 
+    // NOTE(joon) completion_goal is only touched by the thread that adds the items, and completion_count goes up
+    // after an item is done(not when it was taken), so that complete_all_thread_work_queue_items can also wait for
+    // the items that the other threads are still working on
+    int volatile completion_goal;
+    int volatile completion_count;
+
     thread_work_item items[1024];
 
     // now this can be passed onto other codes, such as seperate game code to be used as rendering 
@@ -291,11 +303,20 @@ struct PlatformRenderPushBuffer
 {
     // NOTE(joon) provided by the platform layer
     f32 width_over_height; 
+    u32 width; // in pixels, used for the screen space entries(i.e text)
+    u32 height;
 
     // NOTE(joon) game code needs to fill these up
     m4x4 proj_view;
     v3 clear_color;
 
+    // NOTE(joon) 8 bit coverage atlas that the text entries are referring to.
+    // The platform layer should upload the pixels again whenever the generation changes
+    u8 *glyph_atlas_pixels;
+    u32 glyph_atlas_width;
+    u32 glyph_atlas_height;
+    u32 glyph_atlas_generation;
+
     u8 *base;
     u32 total_size;
     u32 used;
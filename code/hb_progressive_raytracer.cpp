@@ -0,0 +1,293 @@
+// NOTE(joon) Compacts the even bits of the morton code, so that (x, y) = (compact(code), compact(code >> 1))
+internal u32
+compact_morton_code_bits(u32 code)
+{
+    u32 result = code & 0x55555555;
+    result = (result | (result >> 1)) & 0x33333333;
+    result = (result | (result >> 2)) & 0x0f0f0f0f;
+    result = (result | (result >> 4)) & 0x00ff00ff;
+    result = (result | (result >> 8)) & 0x0000ffff;
+
+    return result;
+}
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_render_progressive_tile)
+{
+    ProgressiveRaytracerTile *tile = (ProgressiveRaytracerTile *)data;
+    ProgressiveRaytracer *raytracer = tile->raytracer;
+
+    u64 begin_tick = rdtsc();
+    RaytracerOutput output = hot_kernels.render_raytraced_image_tile(&tile->data);
+    tile->tick_count = rdtsc() - begin_tick;
+
+    atomic_add_64(&raytracer->bounced_ray_count, (i64)output.bounced_ray_count);
+    atomic_add(&raytracer->converged_pixel_count, (i32)output.converged_pixel_count);
+
+    // NOTE(joon) should come last, as the main thread reads everything above once all the tiles are finished
+    atomic_add(&raytracer->finished_tile_count, 1);
+}
+
+internal r32
+get_progressive_raytracer_block_cost(ProgressiveRaytracer *raytracer, u32 min_x, u32 min_y, u32 dim)
+{
+    r32 result = 0.0f;
+
+    u32 min_cell_x = min_x / Progressive_Raytracer_Min_Tile_Dim;
+    u32 min_cell_y = min_y / Progressive_Raytracer_Min_Tile_Dim;
+    u32 one_past_max_cell_x = minimum((min_x + dim) / Progressive_Raytracer_Min_Tile_Dim, raytracer->cell_count_x);
+    u32 one_past_max_cell_y = minimum((min_y + dim) / Progressive_Raytracer_Min_Tile_Dim, raytracer->cell_count_y);
+    for(u32 cell_y = min_cell_y;
+            cell_y < one_past_max_cell_y;
+            ++cell_y)
+    {
+        for(u32 cell_x = min_cell_x;
+                cell_x < one_past_max_cell_x;
+                ++cell_x)
+        {
+            result += raytracer->cell_costs[cell_y*raytracer->cell_count_x + cell_x];
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Quadtree split of the block, where the children are visited in morton order.
+   pending_block_count is the number of blocks that are waiting to be visited, each of which needs at least one tile
+   so that we never run out of the tiles before covering the whole image.
+*/
+internal void
+push_progressive_raytracer_tiles(ProgressiveRaytracer *raytracer, u32 min_x, u32 min_y, u32 dim, r32 target_cost, u32 *pending_block_count)
+{
+    u32 width = raytracer->data.output_width;
+    u32 height = raytracer->data.output_height;
+    assert(min_x < width && min_y < height);
+
+    (*pending_block_count)--;
+
+    u32 half_dim = dim / 2;
+    u32 child_count = 1;
+    if(min_x + half_dim < width)
+    {
+        child_count *= 2;
+    }
+    if(min_y + half_dim < height)
+    {
+        child_count *= 2;
+    }
+
+    if(dim > Progressive_Raytracer_Min_Tile_Dim &&
+       raytracer->tile_count + *pending_block_count + child_count <= Progressive_Raytracer_Max_Tile_Count &&
+       get_progressive_raytracer_block_cost(raytracer, min_x, min_y, dim) > target_cost)
+    {
+        *pending_block_count += child_count;
+        for(u32 child_index = 0;
+                child_index < 4;
+                ++child_index)
+        {
+            u32 child_min_x = min_x + (child_index & 1) * half_dim;
+            u32 child_min_y = min_y + (child_index >> 1) * half_dim;
+            if(child_min_x < width && child_min_y < height)
+            {
+                push_progressive_raytracer_tiles(raytracer, child_min_x, child_min_y, half_dim, target_cost, pending_block_count);
+            }
+        }
+    }
+    else
+    {
+        u32 tile_index = raytracer->tile_count++;
+        ProgressiveRaytracerTile *tile = raytracer->tiles + tile_index;
+        tile->raytracer = raytracer;
+        tile->tick_count = 0;
+
+        tile->data = raytracer->data;
+        tile->data.min_x = min_x;
+        tile->data.min_y = min_y;
+        tile->data.one_past_max_x = minimum(min_x + dim, width);
+        tile->data.one_past_max_y = minimum(min_y + dim, height);
+        // NOTE(joon) different per tile & per pass. The kernel hashes it, so it's fine for the seeds to be next to each other
+        tile->data.random_seed = raytracer->data.random_seed +
+                                 raytracer->pass_index*Progressive_Raytracer_Max_Tile_Count + tile_index;
+    }
+}
+
+/*
+   NOTE(joon) data should have everything except the pixels, accumulation and the tile bounds.
+   data->ray_per_pixel_count is the number of rays that each pixel gets per pass.
+   To start over(i.e the camera has moved), just call this again.
+*/
+internal void
+start_progressive_raytracer(ProgressiveRaytracer *raytracer, MemoryArena *arena, RaytracerData *data,
+                            progressive_raytracer_callback *callback, void *callback_data)
+{
+    assert(data->output_width && data->output_height);
+    u32 pixel_count = data->output_width * data->output_height;
+
+    raytracer->data = *data;
+    raytracer->data.pixels = push_array(arena, u32, pixel_count);
+    raytracer->data.accumulation = push_array(arena, RaytracerPixelAccumulation, pixel_count);
+    zero_memory(raytracer->data.pixels, sizeof(u32)*pixel_count);
+    zero_memory(raytracer->data.accumulation, sizeof(RaytracerPixelAccumulation)*pixel_count);
+
+    raytracer->cell_count_x = (data->output_width + Progressive_Raytracer_Min_Tile_Dim - 1) / Progressive_Raytracer_Min_Tile_Dim;
+    raytracer->cell_count_y = (data->output_height + Progressive_Raytracer_Min_Tile_Dim - 1) / Progressive_Raytracer_Min_Tile_Dim;
+    u32 cell_count = raytracer->cell_count_x * raytracer->cell_count_y;
+    raytracer->cell_costs = push_array(arena, r32, cell_count);
+    // NOTE(joon) we don't know anything about the cost before the first pass, so every cell costs the same
+    for(u32 cell_index = 0;
+            cell_index < cell_count;
+            ++cell_index)
+    {
+        raytracer->cell_costs[cell_index] = 1.0f;
+    }
+
+    raytracer->pass_index = 0;
+    raytracer->is_pass_running = false;
+    raytracer->is_converged = false;
+    raytracer->max_pass_count = 0;
+    raytracer->bounced_ray_count = 0;
+    raytracer->tile_count = 0;
+
+    raytracer->callback = callback;
+    raytracer->callback_data = callback_data;
+}
+
+internal void
+start_progressive_raytracer_pass(ProgressiveRaytracer *raytracer, thread_work_queue *queue)
+{
+    u32 root_block_count_x = (raytracer->data.output_width + Progressive_Raytracer_Max_Tile_Dim - 1) / Progressive_Raytracer_Max_Tile_Dim;
+    u32 root_block_count_y = (raytracer->data.output_height + Progressive_Raytracer_Max_Tile_Dim - 1) / Progressive_Raytracer_Max_Tile_Dim;
+    u32 pending_block_count = root_block_count_x * root_block_count_y;
+    assert(pending_block_count <= Progressive_Raytracer_Max_Tile_Count);
+
+    r32 total_cost = 0.0f;
+    for(u32 cell_index = 0;
+            cell_index < raytracer->cell_count_x * raytracer->cell_count_y;
+            ++cell_index)
+    {
+        total_cost += raytracer->cell_costs[cell_index];
+    }
+    r32 target_cost = total_cost / Progressive_Raytracer_Target_Tile_Count;
+
+    // NOTE(joon) the root blocks are also visited in morton order, skipping the ones that are outside of the image
+    u32 root_block_dim = 1;
+    while(root_block_dim < maximum(root_block_count_x, root_block_count_y))
+    {
+        root_block_dim *= 2;
+    }
+
+    raytracer->tile_count = 0;
+    for(u32 code = 0;
+            code < root_block_dim*root_block_dim;
+            ++code)
+    {
+        u32 block_x = compact_morton_code_bits(code);
+        u32 block_y = compact_morton_code_bits(code >> 1);
+        if(block_x < root_block_count_x && block_y < root_block_count_y)
+        {
+            push_progressive_raytracer_tiles(raytracer,
+                                             block_x*Progressive_Raytracer_Max_Tile_Dim, block_y*Progressive_Raytracer_Max_Tile_Dim,
+                                             Progressive_Raytracer_Max_Tile_Dim, target_cost, &pending_block_count);
+        }
+    }
+    assert(pending_block_count == 0);
+
+    raytracer->finished_tile_count = 0;
+    raytracer->converged_pixel_count = 0;
+    raytracer->is_pass_running = true;
+
+    for(u32 tile_index = 0;
+            tile_index < raytracer->tile_count;
+            ++tile_index)
+    {
+        if(queue)
+        {
+            queue->add_thread_work_queue_item(queue, thread_work_callback_render_progressive_tile, raytracer->tiles + tile_index);
+        }
+        else
+        {
+            thread_work_callback_render_progressive_tile(raytracer->tiles + tile_index);
+        }
+    }
+}
+
+internal void
+end_progressive_raytracer_pass(ProgressiveRaytracer *raytracer)
+{
+    // NOTE(joon) spread the cost of each tile evenly to its cells, for the next pass to use
+    for(u32 tile_index = 0;
+            tile_index < raytracer->tile_count;
+            ++tile_index)
+    {
+        ProgressiveRaytracerTile *tile = raytracer->tiles + tile_index;
+
+        u32 min_cell_x = tile->data.min_x / Progressive_Raytracer_Min_Tile_Dim;
+        u32 min_cell_y = tile->data.min_y / Progressive_Raytracer_Min_Tile_Dim;
+        u32 one_past_max_cell_x = (tile->data.one_past_max_x + Progressive_Raytracer_Min_Tile_Dim - 1) / Progressive_Raytracer_Min_Tile_Dim;
+        u32 one_past_max_cell_y = (tile->data.one_past_max_y + Progressive_Raytracer_Min_Tile_Dim - 1) / Progressive_Raytracer_Min_Tile_Dim;
+
+        // NOTE(joon) even the tiles that have fully converged cost something, and a cell that costs 0 would never be split again
+        r32 cell_cost = maximum((r32)tile->tick_count, 1.0f) /
+                        (r32)((one_past_max_cell_x - min_cell_x) * (one_past_max_cell_y - min_cell_y));
+        for(u32 cell_y = min_cell_y;
+                cell_y < one_past_max_cell_y;
+                ++cell_y)
+        {
+            for(u32 cell_x = min_cell_x;
+                    cell_x < one_past_max_cell_x;
+                    ++cell_x)
+            {
+                raytracer->cell_costs[cell_y*raytracer->cell_count_x + cell_x] = cell_cost;
+            }
+        }
+    }
+
+    u32 pixel_count = raytracer->data.output_width * raytracer->data.output_height;
+    raytracer->is_converged = ((u32)raytracer->converged_pixel_count == pixel_count);
+    raytracer->is_pass_running = false;
+
+    if(raytracer->callback)
+    {
+        raytracer->callback(raytracer->data.pixels, raytracer->data.output_width, raytracer->data.output_height,
+                            raytracer->pass_index, (u32)raytracer->converged_pixel_count, raytracer->callback_data);
+    }
+
+    raytracer->pass_index++;
+}
+
+internal b32
+is_progressive_raytracer_finished(ProgressiveRaytracer *raytracer)
+{
+    b32 result = raytracer->is_converged ||
+                 (raytracer->max_pass_count && raytracer->pass_index >= raytracer->max_pass_count);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Never waits for the tiles, so this can be called every frame.
+   Finishes the pass if all of its tiles are done, and starts the next one if the image has not converged yet
+   (or has not reached max_pass_count).
+   queue can be 0, in which case the whole pass is rendered on this thread.
+   For an offline render, keep calling this(and complete_all_thread_work_queue_items, so that this thread also helps)
+   until it returns true.
+*/
+internal b32
+update_progressive_raytracer(ProgressiveRaytracer *raytracer, thread_work_queue *queue)
+{
+    if(raytracer->is_pass_running &&
+       atomic_add(&raytracer->finished_tile_count, 0) == (i32)raytracer->tile_count)
+    {
+        end_progressive_raytracer_pass(raytracer);
+    }
+
+    if(!raytracer->is_pass_running && !is_progressive_raytracer_finished(raytracer))
+    {
+        start_progressive_raytracer_pass(raytracer, queue);
+    }
+
+    b32 result = !raytracer->is_pass_running && is_progressive_raytracer_finished(raytracer);
+
+    return result;
+}
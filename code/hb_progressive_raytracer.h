@@ -0,0 +1,67 @@
+#ifndef HB_PROGRESSIVE_RAYTRACER_H
+#define HB_PROGRESSIVE_RAYTRACER_H
+
+/*
+    NOTE(joon) Renders the image in passes, instead of splitting it into tiles once and waiting for all of them.
+    Each pass adds ray_per_pixel_count rays to every pixel that has not converged yet(see RaytracerPixelAccumulation),
+    so the first pass is already a usable preview and the image keeps getting better until all pixels have converged.
+    - The tiles of a pass go into the work queue in morton order, so the image fills in as blocks rather than rows
+      and the tiles that are next to each other(and therefore touch the same part of the bvh) are rendered together.
+    - The tile sizes of the next pass are picked from how long the tiles of this pass took. The cost of each tile is spread
+      over a grid of small cells, and the image is cut into a quadtree where a block is split until it costs less than
+      1/Progressive_Raytracer_Target_Tile_Count of the whole pass. The expensive parts get small tiles that keep all threads busy
+      until the very last tile, and the parts that have already converged get big ones.
+*/
+
+// NOTE(joon) called on the main thread after each pass, pixels is the mean of all the rays that each pixel got so far
+#define PROGRESSIVE_RAYTRACER_CALLBACK(name) void (name)(u32 *pixels, u32 width, u32 height, u32 pass_index, u32 converged_pixel_count, void *data)
+typedef PROGRESSIVE_RAYTRACER_CALLBACK(progressive_raytracer_callback);
+
+#define Progressive_Raytracer_Target_Tile_Count 128
+// NOTE(joon) Should be less than the size of the thread work queue, as the whole pass goes into the queue at once
+#define Progressive_Raytracer_Max_Tile_Count 512
+// NOTE(joon) both should be a power of 2, and the min tile dim is also the dim of the cost cells
+#define Progressive_Raytracer_Min_Tile_Dim 8
+#define Progressive_Raytracer_Max_Tile_Dim 256
+
+struct ProgressiveRaytracer;
+struct ProgressiveRaytracerTile
+{
+    ProgressiveRaytracer *raytracer;
+    RaytracerData data;
+
+    // NOTE(joon) written by the worker thread
+    u64 tick_count;
+};
+
+struct ProgressiveRaytracer
+{
+    // NOTE(joon) Everything except the tile bounds & the seed, which are different per tile.
+    // pixels & accumulation point to the buffers that are owned by the raytracer
+    RaytracerData data;
+
+    u32 pass_index;
+    b32 is_pass_running;
+    b32 is_converged;
+    // NOTE(joon) 0 to keep going until every pixel has converged
+    u32 max_pass_count;
+
+    // NOTE(joon) Progressive_Raytracer_Min_Tile_Dim^2 pixels per cell, cost of each cell during the last pass in rdtsc ticks
+    // (which are not always cpu cycles, i.e arm uses the virtual counter)
+    r32 *cell_costs;
+    u32 cell_count_x;
+    u32 cell_count_y;
+
+    ProgressiveRaytracerTile tiles[Progressive_Raytracer_Max_Tile_Count];
+    u32 tile_count;
+
+    // NOTE(joon) updated by the worker threads
+    i32 volatile finished_tile_count;
+    i32 volatile converged_pixel_count;
+    i64 volatile bounced_ray_count;
+
+    progressive_raytracer_callback *callback;
+    void *callback_data;
+};
+
+#endif
@@ -2,7 +2,7 @@
 #define HB_RANDOM_H
 // NOTE(joon): xorshift promises a huge speed boost comparing to rand(with the fact that it is really easy to use simd),
 // but is not particulary well distributed(close to blue noise) rand function.
-// TODO(joon): use PCG later?
+// See Pcg32 below, and the samplers in hb_sampler.h for the raytracer
 internal void
 xor_shift_32(u32 *state)
 {
@@ -15,6 +15,20 @@ xor_shift_32(u32 *state)
     *state = x;
 }
 
+// NOTE(joon) Murmur3 finalizer. xorshift states that only differ by a few bits(i.e seeds like frame_index) stay correlated
+// for a long time, so the seeds should go through this first
+internal inline u32
+hash_u32(u32 value)
+{
+    value ^= value >> 16;
+    value *= 0x85ebca6b;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35;
+    value ^= value >> 16;
+
+    return value;
+}
+
 struct RandomSeries
 {
     u32 next_random;
@@ -41,8 +55,7 @@ random_between_0_1(RandomSeries *series)
 internal r32
 random_between(RandomSeries *series, r32 min, r32 max)
 {
-    xor_shift_32(&series->next_random);
-
+    // NOTE(joon) random_between_0_1 already advances the series
     return min + (max-min)*random_between_0_1(series);
 }
 
@@ -55,7 +68,7 @@ random_between_minus_1_1(RandomSeries *series)
     return result;
 }
 
-inline r32
+internal inline r32
 random_range(RandomSeries *series, r32 value, r32 range)
 {
     r32 half_range = range/2.0f;
@@ -66,7 +79,7 @@ random_range(RandomSeries *series, r32 value, r32 range)
 }
 
 // TODO(joon) NOT truely random !!!
-inline f32
+internal inline f32
 random_f32(RandomSeries *series)
 {
     xor_shift_32(&series->next_random);
@@ -76,7 +89,7 @@ random_f32(RandomSeries *series)
     return result;
 }
 
-inline u32
+internal inline u32
 random_between_u32(RandomSeries *series, u32 min, u32 max)
 {
     xor_shift_32(&series->next_random);
@@ -84,7 +97,7 @@ random_between_u32(RandomSeries *series, u32 min, u32 max)
     return (u32)(series->next_random%(max-min) + min);
 }
 
-inline u32
+internal inline u32
 random_u32(RandomSeries *series)
 {
     xor_shift_32(&series->next_random);
@@ -92,7 +105,7 @@ random_u32(RandomSeries *series)
     return series->next_random;
 }
 
-inline i32
+internal inline i32
 random_between_i32(RandomSeries *series, i32 min, i32 max)
 {
     xor_shift_32(&series->next_random);
@@ -100,13 +113,61 @@ random_between_i32(RandomSeries *series, i32 min, i32 max)
     return (i32)series->next_random%(max-min) + min;
 }
 
-inline v3
+internal inline v3
 random_normalized_v3(RandomSeries *series)
 {
     v3 result = normalize(V3(random_f32(series), random_f32(series), random_f32(series)));
     return result;
 }
 
+/*
+   NOTE(joon) PCG32(O'Neill 2014), 64 bit lcg with a permuted 32 bit output.
+   Each stream is a different sequence, so the threads(or anything else that needs its own numbers) 
+   can use the same seed with different streams and still never be correlated.
+*/
+struct Pcg32
+{
+    u64 state;
+    // NOTE(joon) always odd
+    u64 increment;
+};
+
+internal u32
+random_u32(Pcg32 *pcg)
+{
+    u64 old_state = pcg->state;
+    pcg->state = old_state*6364136223846793005ULL + pcg->increment;
+
+    u32 xor_shifted = (u32)(((old_state >> 18) ^ old_state) >> 27);
+    u32 rotation = (u32)(old_state >> 59);
+
+    u32 result = (xor_shifted >> rotation) | (xor_shifted << ((32 - rotation) & 31));
+
+    return result;
+}
+
+internal Pcg32
+start_pcg32(u64 seed, u64 stream)
+{
+    Pcg32 result = {};
+    result.increment = (stream << 1) | 1;
+
+    random_u32(&result);
+    result.state += seed;
+    random_u32(&result);
+
+    return result;
+}
+
+// NOTE(joon) [0, 1), only using the top 24 bits so that the result never rounds up to 1
+internal r32
+random_between_0_1(Pcg32 *pcg)
+{
+    r32 result = (random_u32(pcg) >> 8)*(1.0f / 16777216.0f);
+
+    return result;
+}
+
 #endif
 
 
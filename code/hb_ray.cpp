@@ -7,75 +7,9 @@
 #include "hb_platform.h"
 #include "hb_math.h"
 #include "hb_random.h"
+#include "hb_ray.h"
 #endif
 
-#if 0
-struct material
-{
-    r32 reflectivity; // 0.0f being very rough like a chalk, and 1 being really relfective(like mirror)
-    v3 emit_color; // things like sky, lightbulb have this value
-    v3 reflection_color;
-
-    r32 *brdf_table;
-};
-
-// TODO(joon): SIMD these!
-struct plane
-{
-    r32 d;
-    v3 normal;
-
-    u32 material_index;
-};
-
-struct sphere
-{
-    v3 center;
-    r32 radius;
-
-    u32 material_index;
-};
-
-struct triangle
-{
-    v3 v0;
-    v3 v1;
-    v3 v2;
-
-    u32 material_index;
-};
-
-struct world
-{
-    material *materials;
-    u32 material_count;
-
-    plane *planes;
-    u32 plane_count;
-
-    sphere *spheres;
-    u32 sphere_count;
-
-    triangle *triangles;
-    u32 triangle_count;
-
-    u32 total_tile_count;
-    volatile u32 rendered_tile_count;
-
-    volatile u64 total_ray_count;
-    volatile u64 bounced_ray_count;
-};
-#endif
-
-struct RayIntersectResult
-{
-    // NOTE(joon): instead of having a boolean value inside the struct, this value will be initialized to a negative value
-    // and when we want to check if there was a hit, we just check if hit_t >= 0.0f 
-    r32 hit_t;
-
-    v3 hit_normal;
-};
-
 internal RayIntersectResult
 ray_intersect_with_aab(v3 min, v3 max, v3 ray_origin, v3 ray_dir)
 {
@@ -249,7 +183,7 @@ ray_intersect_with_sphere(v3 center, r32 r, v3 ray_origin, v3 ray_dir)
     r32 c = dot(rel_ray_origin, rel_ray_origin) - r*r;
 
     r32 root_term = b*b - 4.0f*a*c;
-    r32 sqrt_root_term = sqrt(root_term);
+    r32 sqrt_root_term = sqrtf(root_term);
 
 
     r32 tolerance = 0.00001f;
@@ -259,7 +193,7 @@ ray_intersect_with_sphere(v3 center, r32 r, v3 ray_origin, v3 ray_dir)
         r32 tp = (-b + sqrt_root_term)/a;
 
         // two intersection points
-        r32 t = (-b - sqrt(root_term))/(2*a);
+        r32 t = (-b - sqrtf(root_term))/(2*a);
         if(t > hit_t_threshold)
         {
             result.hit_t = t;
@@ -296,436 +230,2947 @@ linear_to_srgb(r32 linear_value)
     }
     else
     {
-        result = 1.055f*pow(linear_value, 1/2.4f) - 0.055f;
+        result = 1.055f*powf(linear_value, 1/2.4f) - 0.055f;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) simd version of linear_to_srgb, without the pow. The x^(1/2.4) part is approximated as a polynomial of
+   x^(1/2), x^(1/4) & x^(1/8)(from http://chilliant.blogspot.com/2012/08/srgb-approximations-for-hlsl.html),
+   which stays within 0.25/255 of the exact curve. linear_value should be already clamped to [0, 1]
+*/
+force_inline simd_f32
+linear_to_srgb(simd_f32 linear_value)
+{
+    simd_f32 sqrt_1 = sqrt(linear_value);
+    simd_f32 sqrt_2 = sqrt(sqrt_1);
+    simd_f32 sqrt_3 = sqrt(sqrt_2);
+
+    simd_f32 result = simd_f32_(0.662002687f)*sqrt_1 + simd_f32_(0.684122060f)*sqrt_2 - 
+                      simd_f32_(0.323583601f)*sqrt_3 - simd_f32_(0.0225411470f)*linear_value;
+    result = overwrite(result, compare_less_equal(linear_value, simd_f32_(0.0031308f)), simd_f32_(12.92f)*linear_value);
+
+    return result;
+}
+
+// NOTE(joon) both of the curves are per channel, so this doesn't need the other channels
+force_inline simd_f32
+tone_map(simd_f32 value, ToneMapType type)
+{
+    simd_f32 result = value;
+
+    switch(type)
+    {
+        case ToneMapType_None:
+        {
+        }break;
+
+        case ToneMapType_Reinhard:
+        {
+            result = value / (simd_f32_(1.0f) + value);
+        }break;
+
+        case ToneMapType_ACES:
+        {
+            simd_f32 numerator = value*(simd_f32_(2.51f)*value + simd_f32_(0.03f));
+            simd_f32 denominator = value*(simd_f32_(2.43f)*value + simd_f32_(0.59f)) + simd_f32_(0.14f);
+            result = numerator / denominator;
+        }break;
+
+        default : 
+        {
+            invalid_code_path;
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) tone map -> clamp -> sRGB -> dither -> quantize, for HB_LANE_WIDTH values of a single channel at once.
+   The dither is in 1/255 units, and is added before the rounding.
+*/
+force_inline simd_u32
+encode_output_channel(simd_f32 value, ToneMapType tone_map_type, simd_f32 dither)
+{
+    value = tone_map(value, tone_map_type);
+
+    // NOTE(joon) max first, so that the NaNs become 0
+    simd_f32 linear_value = min(max(value, simd_f32_(0.0f)), simd_f32_(1.0f));
+
+    simd_u32 result = convert_u32_from_f32(simd_f32_(255.0f)*linear_to_srgb(linear_value) + simd_f32_(0.5f) + dither);
+
+    return result;
+}
+
+// NOTE(joon) packs to 0xAARRGGBB(BGRA8 in memory), which is what the platform layers expect
+force_inline simd_u32
+encode_output_color(simd_f32 r, simd_f32 g, simd_f32 b, ToneMapType tone_map_type, simd_f32 dither)
+{
+    simd_u32 result = simd_u32_(0xff000000) | 
+                      (encode_output_channel(r, tone_map_type, dither) << 16) | 
+                      (encode_output_channel(g, tone_map_type, dither) << 8) | 
+                      encode_output_channel(b, tone_map_type, dither);
+
+    return result;
+}
+
+/*
+   NOTE(joon) 4x4 bayer matrix, centered around 0 so that the dither doesn't make the image brighter on average.
+   The lane width is always a multiple of 4, so each lane keeps the same column of the pattern throughout the row
+   as long as x moves by the lane width.
+*/
+internal simd_f32
+get_ordered_dither(OutputEncoding *encoding, u32 x, u32 y)
+{
+    local_persist u32 bayer_matrix[4][4] = 
+    {
+        { 0,  8,  2, 10},
+        {12,  4, 14,  6},
+        { 3, 11,  1,  9},
+        {15,  7, 13,  5},
+    };
+
+    r32 lane_dither[HB_LANE_WIDTH] = {};
+    if(encoding->use_dithering)
+    {
+        for(u32 lane = 0;
+                lane < HB_LANE_WIDTH;
+                ++lane)
+        {
+            lane_dither[lane] = ((r32)bayer_matrix[y & 3][(x + lane) & 3] + 0.5f)/16.0f - 0.5f;
+        }
+    }
+
+    simd_f32 result = simd_f32_load(lane_dither);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Writes the linear colors of the pixels from (x, y) to (x + pixel_count - 1, y) to dest,
+   after multiplying them with color_scale(i.e 1/ray count, if the colors are sums).
+*/
+internal void
+encode_output_pixels(OutputEncoding *encoding, r32 *r, r32 *g, r32 *b, r32 color_scale, 
+                     u32 pixel_count, u32 x, u32 y, u32 *dest)
+{
+    ToneMapType tone_map_type = encoding->tone_map_type;
+    simd_f32 scale = simd_f32_(color_scale*powf(2.0f, encoding->exposure));
+    simd_f32 dither = get_ordered_dither(encoding, x, y);
+
+    u32 pixel_index = 0;
+    for(;
+            pixel_index + HB_LANE_WIDTH <= pixel_count;
+            pixel_index += HB_LANE_WIDTH)
+    {
+        simd_u32 encoded_color = encode_output_color(scale*simd_f32_load(r + pixel_index), 
+                                                     scale*simd_f32_load(g + pixel_index), 
+                                                     scale*simd_f32_load(b + pixel_index), tone_map_type, dither);
+        simd_u32_store(dest + pixel_index, encoded_color);
+    }
+
+    if(pixel_index < pixel_count)
+    {
+        u32 lane_count = pixel_count - pixel_index;
+        simd_u32 encoded_color = encode_output_color(scale*simd_f32_load_first_lanes(r + pixel_index, lane_count),
+                                                     scale*simd_f32_load_first_lanes(g + pixel_index, lane_count),
+                                                     scale*simd_f32_load_first_lanes(b + pixel_index, lane_count), tone_map_type, dither);
+
+        u32 lane_pixels[HB_LANE_WIDTH];
+        simd_u32_store(lane_pixels, encoded_color);
+        for(u32 lane = 0;
+                lane < lane_count;
+                ++lane)
+        {
+            dest[pixel_index + lane] = lane_pixels[lane];
+        }
+    }
+}
+
+/*
+   NOTE(joon) A pixel has converged when the standard error of its mean luminance is small enough compared to the mean itself.
+   Black pixels(which can only happen with 0 variance) count as converged as soon as they have enough rays.
+*/
+internal b32
+is_pixel_converged(RaytracerPixelAccumulation *accumulation, u32 min_ray_count, r32 max_relative_error)
+{
+    b32 result = false;
+
+    u32 ray_count = accumulation->ray_count;
+    if(ray_count >= maximum(min_ray_count, 2))
+    {
+        r64 mean = accumulation->luminance_sum / (r64)ray_count;
+        r64 variance = (accumulation->luminance_square_sum - mean*accumulation->luminance_sum) / (r64)(ray_count - 1);
+        // NOTE(joon) can go slightly negative because of the floating point error
+        variance = maximum(variance, 0.0);
+
+        r64 standard_error = sqrt(variance / (r64)ray_count);
+        result = (standard_error <= (r64)max_relative_error*mean);
+    }
+
+    return result;
+}
+
+internal r32
+get_luminance(v3 color)
+{
+    r32 result = dot(color, V3(0.2126f, 0.7152f, 0.0722f));
+
+    return result;
+}
+
+// NOTE(joon) Material 0 is the sky, which is never in the light list even for the triangles that use it
+internal b32
+is_raytracer_light_material(RaytracerWorld *world, u32 material_index)
+{
+    b32 result = (material_index != 0 && 
+                  get_luminance(world->materials[material_index].emit_color) > 0.0f);
+
+    return result;
+}
+
+internal r32
+get_raytracer_light_power(RaytracerWorld *world, RaytracerLight *light)
+{
+    r32 result = 0.0f;
+
+    switch(light->type)
+    {
+        case RaytracerLightType_Triangle:
+        {
+            RaytracerTriangle *triangle = world->triangles + light->primitive_index;
+            r32 area = 0.5f*length(cross(triangle->v1 - triangle->v0, triangle->v2 - triangle->v0));
+            result = area*get_luminance(world->materials[triangle->material_index].emit_color);
+        }break;
+
+        case RaytracerLightType_Sphere:
+        {
+            RaytracerSphere *sphere = world->spheres + light->primitive_index;
+            r32 area = 4.0f*pi_32*sphere->radius*sphere->radius;
+            result = area*get_luminance(world->materials[sphere->material_index].emit_color);
+        }break;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Builds the list of the emissive triangles & spheres, and the alias table(Vose's method) on top of it
+   so that picking a light in proportion to its power is O(1) no matter how many lights there are.
+*/
+internal void
+build_raytracer_light_list(RaytracerWorld *world, MemoryArena *arena, MemoryArena *transient_arena)
+{
+    world->lights = 0;
+    world->light_count = 0;
+    world->total_light_power = 0.0f;
+
+    u32 light_count = 0;
+    for(u32 triangle_index = 0;
+            triangle_index < world->triangle_count;
+            ++triangle_index)
+    {
+        light_count += is_raytracer_light_material(world, world->triangles[triangle_index].material_index);
+    }
+    for(u32 sphere_index = 0;
+            sphere_index < world->sphere_count;
+            ++sphere_index)
+    {
+        light_count += is_raytracer_light_material(world, world->spheres[sphere_index].material_index);
+    }
+
+    if(light_count)
+    {
+        world->lights = push_array(arena, RaytracerLight, light_count);
+        for(u32 triangle_index = 0;
+                triangle_index < world->triangle_count;
+                ++triangle_index)
+        {
+            if(is_raytracer_light_material(world, world->triangles[triangle_index].material_index))
+            {
+                RaytracerLight *light = world->lights + world->light_count++;
+                light->type = RaytracerLightType_Triangle;
+                light->primitive_index = triangle_index;
+            }
+        }
+        for(u32 sphere_index = 0;
+                sphere_index < world->sphere_count;
+                ++sphere_index)
+        {
+            if(is_raytracer_light_material(world, world->spheres[sphere_index].material_index))
+            {
+                RaytracerLight *light = world->lights + world->light_count++;
+                light->type = RaytracerLightType_Sphere;
+                light->primitive_index = sphere_index;
+            }
+        }
+        assert(world->light_count == light_count);
+
+        TempMemory alias_memory = start_temp_memory(transient_arena, (sizeof(r32) + 2*sizeof(u32))*light_count + 1, false);
+        // NOTE(joon) power of each light * light count / total power, so that the average becomes 1
+        r32 *scaled_powers = push_array(&alias_memory, r32, light_count);
+        u32 *small_indices = push_array(&alias_memory, u32, light_count);
+        u32 *large_indices = push_array(&alias_memory, u32, light_count);
+
+        for(u32 light_index = 0;
+                light_index < light_count;
+                ++light_index)
+        {
+            scaled_powers[light_index] = get_raytracer_light_power(world, world->lights + light_index);
+            world->total_light_power += scaled_powers[light_index];
+        }
+
+        u32 small_count = 0;
+        u32 large_count = 0;
+        for(u32 light_index = 0;
+                light_index < light_count;
+                ++light_index)
+        {
+            scaled_powers[light_index] *= (r32)light_count / world->total_light_power;
+            if(scaled_powers[light_index] < 1.0f)
+            {
+                small_indices[small_count++] = light_index;
+            }
+            else
+            {
+                large_indices[large_count++] = light_index;
+            }
+        }
+
+        // NOTE(joon) Each slot gets filled up to 1 with a small light & the rest with a large one,
+        // and the large one goes back to the list with what's left
+        while(small_count && large_count)
+        {
+            u32 small_index = small_indices[--small_count];
+            u32 large_index = large_indices[--large_count];
+
+            world->lights[small_index].alias_probability = scaled_powers[small_index];
+            world->lights[small_index].alias_index = large_index;
+
+            scaled_powers[large_index] = (scaled_powers[large_index] + scaled_powers[small_index]) - 1.0f;
+            if(scaled_powers[large_index] < 1.0f)
+            {
+                small_indices[small_count++] = large_index;
+            }
+            else
+            {
+                large_indices[large_count++] = large_index;
+            }
+        }
+
+        // NOTE(joon) whatever is left should be 1, except for the floating point error
+        while(large_count)
+        {
+            u32 light_index = large_indices[--large_count];
+            world->lights[light_index].alias_probability = 1.0f;
+            world->lights[light_index].alias_index = light_index;
+        }
+        while(small_count)
+        {
+            u32 light_index = small_indices[--small_count];
+            world->lights[light_index].alias_probability = 1.0f;
+            world->lights[light_index].alias_index = light_index;
+        }
+
+        end_temp_memory(&alias_memory);
+    }
+}
+
+struct RaytracerLightSample
+{
+    v3 p;
+    v3 normal;
+    v3 emit_color;
+
+    // NOTE(joon) probability of picking the light * 1/area of the light, which is just the luminance / total power
+    r32 area_pdf;
+};
+
+// NOTE(joon) u0, u1 and u2 should be in [0, 1)
+internal RaytracerLightSample
+sample_raytracer_light(RaytracerWorld *world, r32 u0, r32 u1, r32 u2)
+{
+    RaytracerLightSample result = {};
+    assert(world->light_count);
+
+    r32 scaled_u0 = u0*(r32)world->light_count;
+    u32 light_index = minimum((u32)scaled_u0, world->light_count - 1);
+    RaytracerLight *light = world->lights + light_index;
+    if(scaled_u0 - (r32)light_index >= light->alias_probability)
+    {
+        light = world->lights + light->alias_index;
+    }
+
+    u32 material_index = 0;
+    switch(light->type)
+    {
+        case RaytracerLightType_Triangle:
+        {
+            RaytracerTriangle *triangle = world->triangles + light->primitive_index;
+
+            // NOTE(joon) uniform over the area
+            r32 sqrt_u1 = sqrtf(u1);
+            r32 b0 = 1.0f - sqrt_u1;
+            r32 b1 = u2*sqrt_u1;
+            result.p = b0*triangle->v0 + b1*triangle->v1 + (1.0f - b0 - b1)*triangle->v2;
+            result.normal = normalize(cross(triangle->v1 - triangle->v0, triangle->v2 - triangle->v0));
+
+            material_index = triangle->material_index;
+        }break;
+
+        case RaytracerLightType_Sphere:
+        {
+            RaytracerSphere *sphere = world->spheres + light->primitive_index;
+
+            // NOTE(joon) uniform over the whole sphere, the half that is facing away gets rejected by the cosine
+            r32 z = 1.0f - 2.0f*u1;
+            r32 r = sqrtf(maximum(1.0f - z*z, 0.0f));
+            r32 phi = 2.0f*pi_32*u2;
+            result.normal = V3(r*cosf(phi), r*sinf(phi), z);
+            result.p = sphere->center + sphere->radius*result.normal;
+
+            material_index = sphere->material_index;
+        }break;
+    }
+
+    result.emit_color = world->materials[material_index].emit_color;
+    result.area_pdf = get_luminance(result.emit_color) / world->total_light_power;
+
+    return result;
+}
+
+/*
+   NOTE(joon) Returns the distance to the slab entry for each lane, or Flt_Max for the lanes that miss the node,
+   are dead, or already hit something closer.
+*/
+force_inline simd_f32
+ray_intersect_with_bvh_node(BVHNode *node, simd_v3 ray_origin, simd_v3 inv_ray_dir, simd_f32 min_hit_t, simd_u32 is_ray_alive_mask)
+{
+    simd_v3 t0 = (simd_v3_(node->min) - ray_origin) * inv_ray_dir;
+    simd_v3 t1 = (simd_v3_(node->max) - ray_origin) * inv_ray_dir;
+
+    simd_f32 t_near = max_component(min(t0, t1));
+    simd_f32 t_far = min_component(max(t0, t1));
+
+    simd_u32 hit_mask = is_ray_alive_mask & 
+                        compare_greater_equal(t_far, t_near) & 
+                        compare_greater_equal(t_far, simd_f32_(0.0f)) & 
+                        compare_less(t_near, min_hit_t);
+
+    simd_f32 result = overwrite(simd_f32_(Flt_Max), hit_mask, t_near);
+
+    return result;
+}
+
+// NOTE(joon) How many children(or triangles) of the wide bvh can be tested at once
+#if HB_LANE_WIDTH < Wide_Bvh_Width
+#define Wide_Bvh_Lane_Count HB_LANE_WIDTH
+#else
+#define Wide_Bvh_Lane_Count Wide_Bvh_Width
+#endif
+
+struct WideBVHStackEntry
+{
+    u32 index;
+    u32 pack_count;
+    // NOTE(joon) distance to the entry of the node, so that we can skip it if we've found something closer after pushing it
+    r32 t;
+};
+
+/*
+   NOTE(joon) Watertight ray triangle intersection, from 'Watertight Ray/Triangle Intersection' by Woop, Benthin & Wald.
+   The vertices are moved to the ray space where the ray starts at the origin and goes along +z, 
+   and the test is done in 2D using the edge functions. Because the edge functions of two triangles that share an edge
+   are computed using the exact same values, a ray can never slip through the crack between them, which Moller-Trumbore can do.
+*/
+struct WatertightRay
+{
+    v3 origin;
+
+    // NOTE(joon) kz is the axis where the ray direction is the biggest, and kx & ky are the rest of them
+    // (swapped if the direction is negative, to keep the winding)
+    u32 kx;
+    u32 ky;
+    u32 kz;
+
+    // NOTE(joon) shear constants
+    r32 sx;
+    r32 sy;
+    r32 sz;
+};
+
+internal WatertightRay
+get_watertight_ray(v3 ray_origin, v3 ray_dir)
+{
+    WatertightRay result = {};
+    result.origin = ray_origin;
+
+    result.kz = 0;
+    if(abs_(ray_dir.y) > abs_(ray_dir.e[result.kz]))
+    {
+        result.kz = 1;
+    }
+    if(abs_(ray_dir.z) > abs_(ray_dir.e[result.kz]))
+    {
+        result.kz = 2;
+    }
+    result.kx = (result.kz + 1) % 3;
+    result.ky = (result.kx + 1) % 3;
+    if(ray_dir.e[result.kz] < 0.0f)
+    {
+        u32 temp = result.kx;
+        result.kx = result.ky;
+        result.ky = temp;
+    }
+
+    result.sx = ray_dir.e[result.kx] / ray_dir.e[result.kz];
+    result.sy = ray_dir.e[result.ky] / ray_dir.e[result.kz];
+    result.sz = 1.0f / ray_dir.e[result.kz];
+
+    return result;
+}
+
+/*
+   NOTE(joon) Tests one ray against all triangles inside the pack, and updates the hit & closest_t 
+   if there was a hit that is in [min_t, closest_t)
+*/
+internal void
+ray_intersect_with_triangle_pack(TrianglePack *pack, WatertightRay *ray, r32 min_t, r32 *closest_t, WideBVHHit *hit)
+{
+    simd_f32 origin_x = simd_f32_(ray->origin.e[ray->kx]);
+    simd_f32 origin_y = simd_f32_(ray->origin.e[ray->ky]);
+    simd_f32 origin_z = simd_f32_(ray->origin.e[ray->kz]);
+    simd_f32 sx = simd_f32_(ray->sx);
+    simd_f32 sy = simd_f32_(ray->sy);
+    simd_f32 sz = simd_f32_(ray->sz);
+    simd_f32 zero = simd_f32_(0.0f);
+
+    for(u32 lane_base = 0;
+            lane_base < pack->triangle_count;
+            lane_base += Wide_Bvh_Lane_Count)
+    {
+        // NOTE(joon) vertices relative to the ray origin
+        simd_f32 a_z = simd_f32_load_first_lanes(pack->v0[ray->kz] + lane_base, Wide_Bvh_Lane_Count) - origin_z;
+        simd_f32 b_z = simd_f32_load_first_lanes(pack->v1[ray->kz] + lane_base, Wide_Bvh_Lane_Count) - origin_z;
+        simd_f32 c_z = simd_f32_load_first_lanes(pack->v2[ray->kz] + lane_base, Wide_Bvh_Lane_Count) - origin_z;
+
+        // NOTE(joon) shear & scale, so that the ray direction becomes (0, 0, 1)
+        simd_f32 a_x = simd_f32_load_first_lanes(pack->v0[ray->kx] + lane_base, Wide_Bvh_Lane_Count) - origin_x - sx*a_z;
+        simd_f32 a_y = simd_f32_load_first_lanes(pack->v0[ray->ky] + lane_base, Wide_Bvh_Lane_Count) - origin_y - sy*a_z;
+        simd_f32 b_x = simd_f32_load_first_lanes(pack->v1[ray->kx] + lane_base, Wide_Bvh_Lane_Count) - origin_x - sx*b_z;
+        simd_f32 b_y = simd_f32_load_first_lanes(pack->v1[ray->ky] + lane_base, Wide_Bvh_Lane_Count) - origin_y - sy*b_z;
+        simd_f32 c_x = simd_f32_load_first_lanes(pack->v2[ray->kx] + lane_base, Wide_Bvh_Lane_Count) - origin_x - sx*c_z;
+        simd_f32 c_y = simd_f32_load_first_lanes(pack->v2[ray->ky] + lane_base, Wide_Bvh_Lane_Count) - origin_y - sy*c_z;
+
+        // NOTE(joon) scaled barycentric coordinates
+        // TODO(joon) The paper falls back to double precision when any of these are exactly 0, 
+        // which only matters when the ray hits the edge or the vertex exactly
+        simd_f32 u = c_x*b_y - c_y*b_x;
+        simd_f32 v = a_x*c_y - a_y*c_x;
+        simd_f32 w = b_x*a_y - b_y*a_x;
+
+        simd_f32 det = u + v + w;
+
+        // NOTE(joon) the ray is inside the triangle if all of them have the same sign(both sides of the triangle count)
+        simd_u32 has_negative_mask = compare_less(u, zero) | compare_less(v, zero) | compare_less(w, zero);
+        simd_u32 has_positive_mask = compare_greater(u, zero) | compare_greater(v, zero) | compare_greater(w, zero);
+        simd_u32 inside_mask = ~(has_negative_mask & has_positive_mask) & compare_not_equal(det, zero);
+
+        if(!all_lanes_zero(inside_mask))
+        {
+            simd_f32 hit_t = (u*(sz*a_z) + v*(sz*b_z) + w*(sz*c_z)) / det;
+
+            simd_u32 hit_mask = inside_mask &
+                                compare_greater_equal(hit_t, simd_f32_(min_t)) &
+                                compare_less(hit_t, simd_f32_(*closest_t));
+
+            if(!all_lanes_zero(hit_mask))
+            {
+                r32 lane_hit_t[HB_LANE_WIDTH];
+                simd_f32_store(lane_hit_t, overwrite(simd_f32_(Flt_Max), hit_mask, hit_t));
+                for(u32 lane = 0;
+                        lane < Wide_Bvh_Lane_Count;
+                        ++lane)
+                {
+                    if(lane_base + lane < pack->triangle_count && lane_hit_t[lane] < *closest_t)
+                    {
+                        u32 pack_lane = lane_base + lane;
+                        *closest_t = lane_hit_t[lane];
+
+                        hit->hit_t = lane_hit_t[lane];
+                        hit->hit_normal = V3(pack->normal[0][pack_lane], pack->normal[1][pack_lane], pack->normal[2][pack_lane]);
+                        hit->material_index = pack->material_indices[pack_lane];
+                        hit->triangle_index = pack->triangle_indices[pack_lane];
+                    }
+                }
+            }
+        }
     }
+}
+
+/*
+   NOTE(joon) Single ray traversal of the wide bvh, where the simd lanes are used to test all children of a node at once.
+   Only returns the hits that are in [min_t, max_t).
+*/
+internal WideBVHHit
+ray_intersect_with_wide_bvh(WideBVH *wide_bvh, v3 ray_origin, v3 ray_dir, r32 min_t, r32 max_t)
+{
+    WideBVHHit result = {};
+    result.hit_t = -1.0f;
+
+    r32 closest_t = max_t;
+
+    simd_v3 simd_ray_origin = simd_v3_(ray_origin);
+    simd_v3 inv_ray_dir = simd_v3_(V3(1.0f/ray_dir.x, 1.0f/ray_dir.y, 1.0f/ray_dir.z));
+
+    WatertightRay watertight_ray = get_watertight_ray(ray_origin, ray_dir);
+
+    WideBVHStackEntry stack[Bvh_Max_Traversal_Depth*(Wide_Bvh_Width - 1) + 1];
+    u32 stack_count = 0;
+
+    WideBVHStackEntry *root = stack + stack_count++;
+    root->index = 0;
+    root->pack_count = 0;
+    root->t = min_t;
+
+    while(stack_count)
+    {
+        WideBVHStackEntry entry = stack[--stack_count];
+        if(entry.t >= closest_t)
+        {
+            continue;
+        }
+
+        if(entry.pack_count)
+        {
+            for(u32 pack_index = entry.index;
+                    pack_index < entry.index + entry.pack_count;
+                    ++pack_index)
+            {
+                ray_intersect_with_triangle_pack(wide_bvh->packs + pack_index, &watertight_ray, min_t, &closest_t, &result);
+            }
+        }
+        else
+        {
+            WideBVHNode *node = wide_bvh->nodes + entry.index;
+
+            r32 child_t[Wide_Bvh_Width];
+            for(u32 lane_base = 0;
+                    lane_base < node->child_count;
+                    lane_base += Wide_Bvh_Lane_Count)
+            {
+                simd_v3 child_min = simd_v3_(simd_f32_load_first_lanes(node->min_x + lane_base, Wide_Bvh_Lane_Count),
+                                             simd_f32_load_first_lanes(node->min_y + lane_base, Wide_Bvh_Lane_Count),
+                                             simd_f32_load_first_lanes(node->min_z + lane_base, Wide_Bvh_Lane_Count));
+                simd_v3 child_max = simd_v3_(simd_f32_load_first_lanes(node->max_x + lane_base, Wide_Bvh_Lane_Count),
+                                             simd_f32_load_first_lanes(node->max_y + lane_base, Wide_Bvh_Lane_Count),
+                                             simd_f32_load_first_lanes(node->max_z + lane_base, Wide_Bvh_Lane_Count));
+
+                simd_v3 t0 = (child_min - simd_ray_origin) * inv_ray_dir;
+                simd_v3 t1 = (child_max - simd_ray_origin) * inv_ray_dir;
+
+                simd_f32 t_near = max_component(min(t0, t1));
+                simd_f32 t_far = min_component(max(t0, t1));
+
+                simd_u32 hit_mask = compare_greater_equal(t_far, t_near) &
+                                    compare_greater_equal(t_far, simd_f32_(0.0f)) &
+                                    compare_less(t_near, simd_f32_(closest_t));
+
+                r32 lane_t[HB_LANE_WIDTH];
+                simd_f32_store(lane_t, overwrite(simd_f32_(Flt_Max), hit_mask, t_near));
+                for(u32 lane = 0;
+                        lane < Wide_Bvh_Lane_Count;
+                        ++lane)
+                {
+                    child_t[lane_base + lane] = lane_t[lane];
+                }
+            }
+
+            // NOTE(joon) sort the children that were hit from the farthest to the nearest, 
+            // so that the nearest one gets popped first
+            u32 hit_children[Wide_Bvh_Width];
+            u32 hit_child_count = 0;
+            for(u32 child_index = 0;
+                    child_index < node->child_count;
+                    ++child_index)
+            {
+                r32 t = child_t[child_index];
+                if(t < Flt_Max)
+                {
+                    u32 insert_index = hit_child_count++;
+                    while(insert_index > 0 && child_t[hit_children[insert_index - 1]] < t)
+                    {
+                        hit_children[insert_index] = hit_children[insert_index - 1];
+                        insert_index--;
+                    }
+                    hit_children[insert_index] = child_index;
+                }
+            }
+
+            assert(stack_count + hit_child_count <= array_count(stack));
+            for(u32 i = 0;
+                    i < hit_child_count;
+                    ++i)
+            {
+                u32 child_index = hit_children[i];
+
+                WideBVHStackEntry *child_entry = stack + stack_count++;
+                child_entry->index = node->children[child_index];
+                child_entry->pack_count = node->child_pack_counts[child_index];
+                child_entry->t = child_t[child_index];
+            }
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) Single ray version of the one above, returns Flt_Max when the ray misses the node or the node starts after max_t
+force_inline r32
+ray_intersect_with_bvh_node(BVHNode *node, v3 ray_origin, v3 inv_ray_dir, r32 max_t)
+{
+    v3 t0 = hadamard(node->min - ray_origin, inv_ray_dir);
+    v3 t1 = hadamard(node->max - ray_origin, inv_ray_dir);
+
+    r32 t_near = max_element(gather_min_elements(t0, t1));
+    r32 t_far = min_element(gather_max_elements(t0, t1));
+
+    r32 result = Flt_Max;
+    if(t_far >= t_near && t_far >= 0.0f && t_near < max_t)
+    {
+        result = t_near;
+    }
+
+    return result;
+}
+
+struct BVHStackEntry
+{
+    u32 node_index;
+    // NOTE(joon) distance to the entry of the node, same as WideBVHStackEntry
+    r32 t;
+};
+
+/*
+   NOTE(joon) Single ray query against the two level bvh(see RaytracerInstanceWorld), 
+   which should be updated with update_raytracer_instance_world after the instances have moved.
+   The ray direction does not need to be normalized, and because the ray is transformed into the local space as it is,
+   t stays the same in both spaces even when the transform has a scale.
+   Only returns the hits that are in [min_t, max_t).
+*/
+internal InstanceHit
+ray_intersect_with_instance_world(RaytracerInstanceWorld *world, v3 ray_origin, v3 ray_dir, r32 min_t, r32 max_t)
+{
+    InstanceHit result = {};
+    result.hit_t = -1.0f;
+
+    BVH *bvh = &world->bvh;
+    if(bvh->node_count)
+    {
+        r32 closest_t = max_t;
+        v3 inv_ray_dir = V3(1.0f/ray_dir.x, 1.0f/ray_dir.y, 1.0f/ray_dir.z);
+
+        BVHStackEntry stack[Bvh_Max_Traversal_Depth];
+        u32 stack_count = 0;
+
+        BVHStackEntry *root = stack + stack_count++;
+        root->node_index = 0;
+        root->t = ray_intersect_with_bvh_node(bvh->nodes, ray_origin, inv_ray_dir, closest_t);
+
+        while(stack_count)
+        {
+            BVHStackEntry entry = stack[--stack_count];
+            if(entry.t >= closest_t)
+            {
+                continue;
+            }
+
+            BVHNode *node = bvh->nodes + entry.node_index;
+            if(node->primitive_count)
+            {
+                for(u32 i = node->left_first;
+                        i < node->left_first + node->primitive_count;
+                        ++i)
+                {
+                    u32 instance_index = bvh->primitive_indices[i];
+                    RaytracerInstance *instance = world->instances + instance_index;
+                    RaytracerMesh *mesh = world->meshes + instance->mesh_index;
+
+                    v3 local_ray_origin = (instance->inv_transform*V4(ray_origin, 1.0f)).xyz;
+                    v3 local_ray_dir = (instance->inv_transform*V4(ray_dir, 0.0f)).xyz;
+
+                    WideBVHHit hit = ray_intersect_with_wide_bvh(&mesh->wide_bvh, local_ray_origin, local_ray_dir, min_t, closest_t);
+                    if(hit.hit_t >= 0.0f)
+                    {
+                        closest_t = hit.hit_t;
+
+                        result.hit_t = hit.hit_t;
+                        // NOTE(joon) normals go through the inverse transpose, so that they stay perpendicular to the surface when there is a scale
+                        result.hit_normal = normalize(transpose(M3x3(instance->inv_transform))*hit.hit_normal);
+                        result.instance_index = instance_index;
+                        result.user_index = instance->user_index;
+                        result.material_index = hit.material_index;
+                        result.triangle_index = hit.triangle_index;
+                    }
+                }
+            }
+            else
+            {
+                u32 near_index = node->left_first;
+                u32 far_index = node->left_first + 1;
+                r32 near_t = ray_intersect_with_bvh_node(bvh->nodes + near_index, ray_origin, inv_ray_dir, closest_t);
+                r32 far_t = ray_intersect_with_bvh_node(bvh->nodes + far_index, ray_origin, inv_ray_dir, closest_t);
+                if(far_t < near_t)
+                {
+                    u32 temp_index = near_index;
+                    near_index = far_index;
+                    far_index = temp_index;
+
+                    r32 temp_t = near_t;
+                    near_t = far_t;
+                    far_t = temp_t;
+                }
+
+                // NOTE(joon) farther one first, so that the nearer one gets popped first
+                assert(stack_count + 2 <= array_count(stack));
+                if(far_t < Flt_Max)
+                {
+                    BVHStackEntry *far_entry = stack + stack_count++;
+                    far_entry->node_index = far_index;
+                    far_entry->t = far_t;
+                }
+                if(near_t < Flt_Max)
+                {
+                    BVHStackEntry *near_entry = stack + stack_count++;
+                    near_entry->node_index = near_index;
+                    near_entry->t = near_t;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Single ray query against the faces of the mass agg, which should be updated with update_mass_agg_bvh after the particles have moved.
+   Only returns the hits that are in [min_t, max_t).
+*/
+internal MassAggHit
+ray_intersect_with_mass_agg(MassAggBVH *mass_agg_bvh, v3 ray_origin, v3 ray_dir, r32 min_t, r32 max_t)
+{
+    MassAggHit result = {};
+    result.hit_t = -1.0f;
+
+    MassAgg *mass_agg = mass_agg_bvh->mass_agg;
+    BVH *bvh = mass_agg_bvh->bvhs + mass_agg_bvh->current_bvh_index;
+    if(bvh->node_count)
+    {
+        r32 closest_t = max_t;
+        v3 inv_ray_dir = V3(1.0f/ray_dir.x, 1.0f/ray_dir.y, 1.0f/ray_dir.z);
+
+        BVHStackEntry stack[Bvh_Max_Traversal_Depth];
+        u32 stack_count = 0;
+
+        BVHStackEntry *root = stack + stack_count++;
+        root->node_index = 0;
+        root->t = ray_intersect_with_bvh_node(bvh->nodes, ray_origin, inv_ray_dir, closest_t);
+
+        while(stack_count)
+        {
+            BVHStackEntry entry = stack[--stack_count];
+            if(entry.t >= closest_t)
+            {
+                continue;
+            }
+
+            BVHNode *node = bvh->nodes + entry.node_index;
+            if(node->primitive_count)
+            {
+                for(u32 i = node->left_first;
+                        i < node->left_first + node->primitive_count;
+                        ++i)
+                {
+                    u32 face_index = bvh->primitive_indices[i];
+                    ParticleFace *face = mass_agg->faces + face_index;
+
+                    RayIntersectResult hit = ray_intersect_with_triangle(mass_agg->particles[face->ID_0].p, 
+                                                                         mass_agg->particles[face->ID_1].p, 
+                                                                         mass_agg->particles[face->ID_2].p, 
+                                                                         ray_origin, ray_dir);
+                    if(hit.hit_t >= min_t && hit.hit_t < closest_t)
+                    {
+                        closest_t = hit.hit_t;
+
+                        result.hit_t = hit.hit_t;
+                        result.hit_normal = hit.hit_normal;
+                        result.face_index = face_index;
+                    }
+                }
+            }
+            else
+            {
+                u32 near_index = node->left_first;
+                u32 far_index = node->left_first + 1;
+                r32 near_t = ray_intersect_with_bvh_node(bvh->nodes + near_index, ray_origin, inv_ray_dir, closest_t);
+                r32 far_t = ray_intersect_with_bvh_node(bvh->nodes + far_index, ray_origin, inv_ray_dir, closest_t);
+                if(far_t < near_t)
+                {
+                    u32 temp_index = near_index;
+                    near_index = far_index;
+                    far_index = temp_index;
+
+                    r32 temp_t = near_t;
+                    near_t = far_t;
+                    far_t = temp_t;
+                }
+
+                // NOTE(joon) farther one first, so that the nearer one gets popped first
+                assert(stack_count + 2 <= array_count(stack));
+                if(far_t < Flt_Max)
+                {
+                    BVHStackEntry *far_entry = stack + stack_count++;
+                    far_entry->node_index = far_index;
+                    far_entry->t = far_t;
+                }
+                if(near_t < Flt_Max)
+                {
+                    BVHStackEntry *near_entry = stack + stack_count++;
+                    near_entry->node_index = near_index;
+                    near_entry->t = near_t;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Watertight test for the packet traversal, where the lanes are the rays instead of the triangles.
+   The axes have to be the same for all lanes(kx, ky, kz are used to pick the vertex components), 
+   which is almost always true for the first rays of a pixel as they only differ by the jitter.
+*/
+struct SimdWatertightRay
+{
+    u32 kx;
+    u32 ky;
+    u32 kz;
+
+    // NOTE(joon) origin components that match kx, ky, kz
+    simd_f32 origin_x;
+    simd_f32 origin_y;
+    simd_f32 origin_z;
+
+    simd_f32 sx;
+    simd_f32 sy;
+    simd_f32 sz;
+};
+
+// NOTE(joon) returns false if the live lanes do not agree on the axes, in which case the packet should use Moller-Trumbore instead
+internal b32
+get_simd_watertight_ray(SimdWatertightRay *result, simd_v3 ray_origin, simd_v3 ray_dir, simd_u32 is_ray_alive_mask)
+{
+    b32 is_valid = true;
+    b32 found_live_lane = false;
+
+    r32 origin_x[HB_LANE_WIDTH];
+    r32 origin_y[HB_LANE_WIDTH];
+    r32 origin_z[HB_LANE_WIDTH];
+    simd_v3_store(origin_x, origin_y, origin_z, ray_origin);
+
+    r32 dir_x[HB_LANE_WIDTH];
+    r32 dir_y[HB_LANE_WIDTH];
+    r32 dir_z[HB_LANE_WIDTH];
+    simd_v3_store(dir_x, dir_y, dir_z, ray_dir);
+
+    u32 is_ray_alive[HB_LANE_WIDTH];
+    simd_u32_store(is_ray_alive, is_ray_alive_mask);
+
+    r32 lane_origin_x[HB_LANE_WIDTH] = {};
+    r32 lane_origin_y[HB_LANE_WIDTH] = {};
+    r32 lane_origin_z[HB_LANE_WIDTH] = {};
+    r32 lane_sx[HB_LANE_WIDTH] = {};
+    r32 lane_sy[HB_LANE_WIDTH] = {};
+    r32 lane_sz[HB_LANE_WIDTH] = {};
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        if(is_ray_alive[lane])
+        {
+            WatertightRay ray = get_watertight_ray(V3(origin_x[lane], origin_y[lane], origin_z[lane]), 
+                                                   V3(dir_x[lane], dir_y[lane], dir_z[lane]));
+            if(!found_live_lane)
+            {
+                result->kx = ray.kx;
+                result->ky = ray.ky;
+                result->kz = ray.kz;
+                found_live_lane = true;
+            }
+            else if(result->kx != ray.kx || result->ky != ray.ky || result->kz != ray.kz)
+            {
+                is_valid = false;
+                break;
+            }
+
+            lane_origin_x[lane] = ray.origin.e[ray.kx];
+            lane_origin_y[lane] = ray.origin.e[ray.ky];
+            lane_origin_z[lane] = ray.origin.e[ray.kz];
+            lane_sx[lane] = ray.sx;
+            lane_sy[lane] = ray.sy;
+            lane_sz[lane] = ray.sz;
+        }
+    }
+
+    if(is_valid && found_live_lane)
+    {
+        result->origin_x = simd_f32_load(lane_origin_x);
+        result->origin_y = simd_f32_load(lane_origin_y);
+        result->origin_z = simd_f32_load(lane_origin_z);
+        result->sx = simd_f32_load(lane_sx);
+        result->sy = simd_f32_load(lane_sy);
+        result->sz = simd_f32_load(lane_sz);
+    }
+    else
+    {
+        is_valid = false;
+    }
+
+    return is_valid;
+}
+
+// NOTE(joon) returns Flt_Max for the lanes that miss the triangle
+force_inline simd_f32
+ray_intersect_with_triangle_watertight(SimdWatertightRay *ray, v3 v0, v3 v1, v3 v2)
+{
+    simd_f32 zero = simd_f32_(0.0f);
+
+    simd_f32 a_z = simd_f32_(v0.e[ray->kz]) - ray->origin_z;
+    simd_f32 b_z = simd_f32_(v1.e[ray->kz]) - ray->origin_z;
+    simd_f32 c_z = simd_f32_(v2.e[ray->kz]) - ray->origin_z;
+
+    simd_f32 a_x = simd_f32_(v0.e[ray->kx]) - ray->origin_x - ray->sx*a_z;
+    simd_f32 a_y = simd_f32_(v0.e[ray->ky]) - ray->origin_y - ray->sy*a_z;
+    simd_f32 b_x = simd_f32_(v1.e[ray->kx]) - ray->origin_x - ray->sx*b_z;
+    simd_f32 b_y = simd_f32_(v1.e[ray->ky]) - ray->origin_y - ray->sy*b_z;
+    simd_f32 c_x = simd_f32_(v2.e[ray->kx]) - ray->origin_x - ray->sx*c_z;
+    simd_f32 c_y = simd_f32_(v2.e[ray->ky]) - ray->origin_y - ray->sy*c_z;
+
+    simd_f32 u = c_x*b_y - c_y*b_x;
+    simd_f32 v = a_x*c_y - a_y*c_x;
+    simd_f32 w = b_x*a_y - b_y*a_x;
+
+    simd_f32 det = u + v + w;
+
+    simd_u32 has_negative_mask = compare_less(u, zero) | compare_less(v, zero) | compare_less(w, zero);
+    simd_u32 has_positive_mask = compare_greater(u, zero) | compare_greater(v, zero) | compare_greater(w, zero);
+    simd_u32 inside_mask = ~(has_negative_mask & has_positive_mask) & compare_not_equal(det, zero);
+
+    simd_f32 result = simd_f32_(Flt_Max);
+    if(!all_lanes_zero(inside_mask))
+    {
+        simd_f32 hit_t = (u*(ray->sz*a_z) + v*(ray->sz*b_z) + w*(ray->sz*c_z)) / det;
+        result = overwrite(result, inside_mask, hit_t);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) : 
+   Moller-Trumbore line triangle intersection argorithm
+
+   |t| =       1           |(T x E1) * E2|
+   |u| = -------------  x  |(ray_dir x E2) * T |
+   |v| = (ray_dir x E2)    |(T x E1) * ray_dir |
+
+   where T = ray_origin - v0, E1 = v1 - v0, E2 = v2 - v0,
+   ray  = ray_origin + t * ray_dir;
+
+   u & v = barycentric coordinates of the triangle, as a triangle can be represented in a form of 
+   (1 - u - v)*v0 + u*v1 + v*v2;
+
+   Note that there are a lot of same cross products, which we can calculate just once and reuse
+   v0, v1, v2 can be in any order.
+   Returns Flt_Max for the lanes that miss the triangle.
+*/
+force_inline simd_f32
+ray_intersect_with_triangle_moller_trumbore(simd_v3 ray_origin, simd_v3 ray_dir, v3 v0, v3 e1, v3 e2)
+{
+    simd_f32 zero = simd_f32_(0.0f);
+
+    // NOTE(joon): The edges are the same for all lanes, so they are computed once and duplicated
+    simd_v3 simd_e1 = simd_v3_(e1);
+    simd_v3 simd_e2 = simd_v3_(e2);
+
+    simd_v3 cross_ray_e2 = cross(ray_dir, simd_e2);
+    simd_f32 det = dot(cross_ray_e2, simd_e1);
+
+    simd_f32 result = simd_f32_(Flt_Max);
+
+    // if the determinant is 0, it means the ray is parallel to the triangle
+    simd_u32 det_is_non_zero_mask = compare_not_equal(det, zero);
+    if(!all_lanes_zero(det_is_non_zero_mask))
+    {
+        simd_v3 T = ray_origin - simd_v3_(v0);
+        simd_v3 a = cross(T, simd_e1);
+
+        simd_f32 hit_t = dot(a, simd_e2) / det;
+        // NOTE(joon): barycentric coordinates of u and v, the last coordinate w = (1 - u - v)
+        simd_f32 u = dot(cross_ray_e2, T) / det;
+        simd_f32 v = dot(a, ray_dir) / det;
+
+        simd_u32 hit_mask = det_is_non_zero_mask &
+                            compare_greater_equal(u, zero) & 
+                            compare_greater_equal(v, zero) & 
+                            compare_less_equal(u+v, simd_f32_(1.0f));
+        result = overwrite(result, hit_mask, hit_t);
+    }
+
+    return result;
+}
+
+struct SimdRayIntersectResult
+{
+    // NOTE(joon) Flt_Max for the lanes that didn't hit anything, and hit_mat_index is 0 for them
+    simd_f32 hit_t;
+    simd_v3 hit_p;
+    simd_v3 hit_normal; // not normalized
+    simd_u32 hit_mat_index;
+    // NOTE(joon) the lanes that hit a triangle or a sphere, which can be in the light list unlike the planes
+    simd_u32 is_light_primitive_mask;
+};
+
+/*
+   NOTE(joon) Finds the closest hit of each live lane against everything inside the world.
+   The packet bvh traversal works best when the rays are coherent(i.e primary rays), 
+   and the wide bvh is better for the rays that go in all directions(use_wide_bvh).
+   Only the hits that are closer than max_hit_t count, and hit_t stays as max_hit_t for the lanes that didn't hit anything.
+*/
+internal SimdRayIntersectResult
+ray_intersect_with_raytracer_world(RaytracerWorld *world, simd_v3 ray_origin, simd_v3 ray_dir, simd_u32 is_ray_alive_mask, b32 use_wide_bvh,
+                                   simd_f32 max_hit_t)
+{
+    SimdRayIntersectResult result = {};
+
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_u32 simd_u32_0 = simd_u32_(0);
+    simd_v3 simd_V30 = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+
+    BVH *bvh = &world->bvh;
+    WideBVH *wide_bvh = &world->wide_bvh;
+
+    // TODO(joon) : completely made up number
+    r32 min_hit_distance = 0.0001f;
+    simd_f32 hit_t_threshold = simd_f32_(min_hit_distance);
+
+    simd_f32 min_hit_t = max_hit_t;
+
+    simd_u32 hit_mat_index = simd_u32_0;
+    // NOTE(joon) planes are tested first, so this only needs to be set by the spheres & triangles
+    simd_u32 is_light_primitive_mask = simd_u32_0;
+
+    // NOTE(joon): Want to get rid of this value.. but sphere needs this to calculate the normal :(
+    simd_v3 next_ray_origin = simd_V30;
+    simd_v3 next_normal = simd_V30;
+
+    for(u32 plane_index = 0;
+            plane_index < world->plane_count;
+            ++plane_index)
+    {
+        RaytracerPlane *plane = world->planes + plane_index;
+        
+        //simd_v3 plane_normal = normal;
+        simd_v3 plane_normal = simd_v3_(plane->normal);
+        simd_f32 plane_d = simd_f32_(plane->d);
+
+        // NOTE(joon) : if the denominator is 0, it means that the ray is parallel to the plane
+        simd_f32 denom = dot(plane_normal, ray_dir);
+
+        simd_u32 denom_mask = compare_not_equal(denom, simd_f32_0);// if denom is not 0, 
+        
+        if(!all_lanes_zero(denom_mask))
+        {
+            // TODO(joon): We might just be dividing by 0... is this safe?
+            simd_f32 hit_t = (dot(-plane_normal, ray_origin) - plane_d)/denom;
+
+            // TODO(joon): denom_mask might not be necessary?
+            simd_u32 min_t_update_mask = denom_mask & compare_greater(hit_t, hit_t_threshold) & compare_less(hit_t, min_hit_t); 
+
+            if(!all_lanes_zero(min_t_update_mask))
+            {
+                // NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+                min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
+                next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
+                next_normal = overwrite(next_normal, min_t_update_mask, plane_normal);
+
+                simd_u32 this_plane_mat_index = simd_u32_(plane->material_index);
+                hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_plane_mat_index);
+            }
+        }
+    }
+
+    for(u32 sphere_index = 0;
+            sphere_index < world->sphere_count;
+            ++sphere_index)
+    {
+        RaytracerSphere *sphere = world->spheres + sphere_index;
+
+        simd_v3 sphere_center = simd_v3_(sphere->center);
+
+        simd_f32 sphere_radius_square = simd_f32_(sphere->radius * sphere->radius);
+
+        simd_v3 rel_ray_origin = ray_origin - sphere_center;
+        // NOTE(joon): We are using a simplified version of the solutions for the quadratic formula
+        // which is (-b +/ sqrt(b^2 - ac))/a, where b is half of the original b
+        simd_f32 a = dot(ray_dir, ray_dir);
+        simd_f32 b = dot(ray_dir, rel_ray_origin);
+        simd_f32 c = dot(rel_ray_origin, rel_ray_origin) - sphere_radius_square;
+
+        simd_f32 root_term = b*b - a*c;
+        simd_u32 root_term_is_positive_mask = compare_greater_equal(root_term, simd_f32_0);
+
+        if(!all_lanes_zero(root_term_is_positive_mask))
+        {
+            simd_f32 sqrt_root_term = sqrt(root_term);
+
+            simd_f32 minus_b = -b;
+            simd_f32 num0 = (-b - sqrt_root_term);
+            simd_f32 num1 = (-b + sqrt_root_term);
+
+            simd_f32 tn = (num0)/a;
+            simd_f32 tp = (num1)/a;
+
+            simd_f32 hit_t = tp;
+            // if tn is greater than the threshold & less than tp, we should replace tp with tn 
+            simd_u32 hit_t_overwrite_mask = compare_greater(tn, hit_t_threshold) & compare_less(tn, tp);
+            hit_t = overwrite(hit_t, hit_t_overwrite_mask, tn);
+
+            simd_u32 min_t_update_mask = compare_greater(hit_t, hit_t_threshold) & compare_less(hit_t, min_hit_t);
+            if(!all_lanes_zero(min_t_update_mask))
+            {
+                min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
+                next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
+                next_normal = overwrite(next_normal, min_t_update_mask, next_ray_origin - sphere_center);
+
+                simd_u32 this_sphere_mat_index = simd_u32_(sphere->material_index);
+                hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_sphere_mat_index);
+                is_light_primitive_mask = is_light_primitive_mask | min_t_update_mask;
+            }
+        }
+    }
+
+    if(use_wide_bvh && wide_bvh->node_count)
+    {
+        /*
+           NOTE(joon) After the first bounce, the rays in the packet go in all directions, 
+           and the packet traversal ends up visiting the union of the nodes that each ray wants.
+           So instead, trace the rays one by one through the wide bvh, where the lanes are used for the children.
+        */
+        r32 lane_ray_origin_x[HB_LANE_WIDTH];
+        r32 lane_ray_origin_y[HB_LANE_WIDTH];
+        r32 lane_ray_origin_z[HB_LANE_WIDTH];
+        simd_v3_store(lane_ray_origin_x, lane_ray_origin_y, lane_ray_origin_z, ray_origin);
+
+        r32 lane_ray_dir_x[HB_LANE_WIDTH];
+        r32 lane_ray_dir_y[HB_LANE_WIDTH];
+        r32 lane_ray_dir_z[HB_LANE_WIDTH];
+        simd_v3_store(lane_ray_dir_x, lane_ray_dir_y, lane_ray_dir_z, ray_dir);
+
+        r32 lane_min_hit_t[HB_LANE_WIDTH];
+        simd_f32_store(lane_min_hit_t, min_hit_t);
+
+        u32 lane_is_ray_alive[HB_LANE_WIDTH];
+        simd_u32_store(lane_is_ray_alive, is_ray_alive_mask);
+
+        r32 lane_hit_t[HB_LANE_WIDTH];
+        r32 lane_normal_x[HB_LANE_WIDTH];
+        r32 lane_normal_y[HB_LANE_WIDTH];
+        r32 lane_normal_z[HB_LANE_WIDTH];
+        u32 lane_mat_index[HB_LANE_WIDTH];
+        for(u32 lane = 0;
+                lane < HB_LANE_WIDTH;
+                ++lane)
+        {
+            lane_hit_t[lane] = Flt_Max;
+            lane_normal_x[lane] = 0.0f;
+            lane_normal_y[lane] = 0.0f;
+            lane_normal_z[lane] = 0.0f;
+            lane_mat_index[lane] = 0;
+
+            if(lane_is_ray_alive[lane])
+            {
+                v3 lane_ray_origin = V3(lane_ray_origin_x[lane], lane_ray_origin_y[lane], lane_ray_origin_z[lane]);
+                v3 lane_ray_dir = V3(lane_ray_dir_x[lane], lane_ray_dir_y[lane], lane_ray_dir_z[lane]);
+
+                WideBVHHit hit = ray_intersect_with_wide_bvh(wide_bvh, lane_ray_origin, lane_ray_dir, min_hit_distance, lane_min_hit_t[lane]);
+                if(hit.hit_t >= 0.0f)
+                {
+                    lane_hit_t[lane] = hit.hit_t;
+                    lane_normal_x[lane] = hit.hit_normal.x;
+                    lane_normal_y[lane] = hit.hit_normal.y;
+                    lane_normal_z[lane] = hit.hit_normal.z;
+                    lane_mat_index[lane] = hit.material_index;
+                }
+            }
+        }
+
+        simd_f32 hit_t = simd_f32_load(lane_hit_t);
+        simd_u32 min_t_update_mask = compare_less(hit_t, min_hit_t);
+        if(!all_lanes_zero(min_t_update_mask))
+        {
+            min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
+            next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
+            next_normal = overwrite(next_normal, min_t_update_mask, simd_v3_load(lane_normal_x, lane_normal_y, lane_normal_z));
+            hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, simd_u32_load(lane_mat_index));
+            is_light_primitive_mask = is_light_primitive_mask | min_t_update_mask;
+        }
+    }
+    else if(bvh->node_count)
+    {
+        /*
+            NOTE(joon) Ordered bvh traversal. All lanes walk the same nodes, and a node is visited if any of the live lanes
+            hit it before their closest hit so far. Both children are tested at once, and the nearer one is visited first
+            so that min_hit_t shrinks quickly and the farther one can be culled.
+        */
+        simd_v3 inv_ray_dir = simd_v3_(V3(1.0f, 1.0f, 1.0f)) / ray_dir;
+
+        SimdWatertightRay watertight_ray = {};
+        b32 is_packet_watertight = get_simd_watertight_ray(&watertight_ray, ray_origin, ray_dir, is_ray_alive_mask);
+
+        u32 node_stack[Bvh_Max_Traversal_Depth];
+        u32 node_stack_count = 0;
+
+        simd_f32 root_hit_t = ray_intersect_with_bvh_node(bvh->nodes, ray_origin, inv_ray_dir, min_hit_t, is_ray_alive_mask);
+        if(!all_lanes_zero(compare_less(root_hit_t, simd_f32_(Flt_Max))))
+        {
+            node_stack[node_stack_count++] = 0;
+        }
+
+        while(node_stack_count)
+        {
+            BVHNode *node = bvh->nodes + node_stack[--node_stack_count];
+
+            if(node->primitive_count)
+            {
+                for(u32 primitive_index = node->left_first;
+                        primitive_index < node->left_first + node->primitive_count;
+                        ++primitive_index)
+                {
+                    RaytracerTriangle *triangle = world->triangles + bvh->primitive_indices[primitive_index];
+                    v3 e1 = triangle->v1 - triangle->v0;
+                    v3 e2 = triangle->v2 - triangle->v0;
+
+                    simd_f32 hit_t = {};
+                    if(is_packet_watertight)
+                    {
+                        hit_t = ray_intersect_with_triangle_watertight(&watertight_ray, triangle->v0, triangle->v1, triangle->v2);
+                    }
+                    else
+                    {
+                        hit_t = ray_intersect_with_triangle_moller_trumbore(ray_origin, ray_dir, triangle->v0, e1, e2);
+                    }
+
+                    simd_u32 min_t_update_mask = compare_greater_equal(hit_t, hit_t_threshold) & 
+                                                 compare_less(hit_t, min_hit_t);
+                    if(!all_lanes_zero(min_t_update_mask))
+                    {
+                        // NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+                        min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
+                        next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
+                        next_normal = overwrite(next_normal, min_t_update_mask, simd_v3_(normalize(cross(e1, e2))));
+
+                        // TODO(joon): calculate normal based on the ray dir, so that the next normal is facing the incoming ray dir
+                        // otherwise, the reflection vector will be totally busted?
+                        simd_u32 this_triangle_mat_index = simd_u32_(triangle->material_index);
+                        hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_triangle_mat_index);
+                        is_light_primitive_mask = is_light_primitive_mask | min_t_update_mask;
+                    }
+                }
+            }
+            else
+            {
+                u32 near_child_index = node->left_first;
+                u32 far_child_index = node->left_first + 1;
+
+                simd_f32 near_hit_t = ray_intersect_with_bvh_node(bvh->nodes + near_child_index, ray_origin, inv_ray_dir, min_hit_t, is_ray_alive_mask);
+                simd_f32 far_hit_t = ray_intersect_with_bvh_node(bvh->nodes + far_child_index, ray_origin, inv_ray_dir, min_hit_t, is_ray_alive_mask);
+
+                // TODO(joon) This only looks at the closest lane. Might be better to count how many lanes are closer to each child?
+                f32 near_min_t = min_component(near_hit_t);
+                f32 far_min_t = min_component(far_hit_t);
+                if(far_min_t < near_min_t)
+                {
+                    u32 temp_index = near_child_index;
+                    near_child_index = far_child_index;
+                    far_child_index = temp_index;
+
+                    f32 temp_t = near_min_t;
+                    near_min_t = far_min_t;
+                    far_min_t = temp_t;
+                }
+
+                // NOTE(joon) push the farther one first, so that the nearer one gets popped first.
+                // The builder keeps the tree shallow enough for the stack to never be full, but the count is still checked
+                // (instead of just being asserted) so that the compiler can also see the bound
+                assert(node_stack_count + 2 <= array_count(node_stack));
+                if(far_min_t < Flt_Max && node_stack_count < array_count(node_stack))
+                {
+                    node_stack[node_stack_count++] = far_child_index;
+                }
+                if(near_min_t < Flt_Max && node_stack_count < array_count(node_stack))
+                {
+                    node_stack[node_stack_count++] = near_child_index;
+                }
+            }
+        }
+    }
+
+    if(world->voxel_world)
+    {
+        // NOTE(joon) Same as the wide bvh, each lane traces its own ray through the voxel world, 
+        // and only looks for the voxels that are closer than the closest hit so far
+        r32 lane_ray_origin_x[HB_LANE_WIDTH];
+        r32 lane_ray_origin_y[HB_LANE_WIDTH];
+        r32 lane_ray_origin_z[HB_LANE_WIDTH];
+        simd_v3_store(lane_ray_origin_x, lane_ray_origin_y, lane_ray_origin_z, ray_origin);
+
+        r32 lane_ray_dir_x[HB_LANE_WIDTH];
+        r32 lane_ray_dir_y[HB_LANE_WIDTH];
+        r32 lane_ray_dir_z[HB_LANE_WIDTH];
+        simd_v3_store(lane_ray_dir_x, lane_ray_dir_y, lane_ray_dir_z, ray_dir);
+
+        r32 lane_min_hit_t[HB_LANE_WIDTH];
+        simd_f32_store(lane_min_hit_t, min_hit_t);
+
+        u32 lane_is_ray_alive[HB_LANE_WIDTH];
+        simd_u32_store(lane_is_ray_alive, is_ray_alive_mask);
+
+        r32 lane_hit_t[HB_LANE_WIDTH];
+        r32 lane_normal_x[HB_LANE_WIDTH];
+        r32 lane_normal_y[HB_LANE_WIDTH];
+        r32 lane_normal_z[HB_LANE_WIDTH];
+        u32 lane_mat_index[HB_LANE_WIDTH];
+        for(u32 lane = 0;
+                lane < HB_LANE_WIDTH;
+                ++lane)
+        {
+            lane_hit_t[lane] = Flt_Max;
+            lane_normal_x[lane] = 0.0f;
+            lane_normal_y[lane] = 0.0f;
+            lane_normal_z[lane] = 0.0f;
+            lane_mat_index[lane] = 0;
+
+            if(lane_is_ray_alive[lane])
+            {
+                v3 lane_ray_origin = V3(lane_ray_origin_x[lane], lane_ray_origin_y[lane], lane_ray_origin_z[lane]) - world->voxel_world_p;
+                v3 lane_ray_dir = V3(lane_ray_dir_x[lane], lane_ray_dir_y[lane], lane_ray_dir_z[lane]);
+
+                VoxelRayHit hit = ray_intersect_with_voxel_world(world->voxel_world, world->voxel_memory, lane_ray_origin, lane_ray_dir, 
+                                                                 min_hit_distance, lane_min_hit_t[lane]);
+                if(hit.hit_t >= 0.0f)
+                {
+                    lane_hit_t[lane] = hit.hit_t;
+                    lane_normal_x[lane] = hit.hit_normal.x;
+                    lane_normal_y[lane] = hit.hit_normal.y;
+                    lane_normal_z[lane] = hit.hit_normal.z;
+                    lane_mat_index[lane] = world->voxel_material_indices[hit.color_id];
+                }
+            }
+        }
+
+        simd_f32 hit_t = simd_f32_load(lane_hit_t);
+        simd_u32 min_t_update_mask = compare_less(hit_t, min_hit_t);
+        if(!all_lanes_zero(min_t_update_mask))
+        {
+            /*
+               NOTE(joon) The hit point is pushed out of the voxel a bit(the normal always faces the side that the ray came from),
+               so that the rays that start from here are inside the empty cell, instead of the voxel itself.
+               Otherwise the rays that barely leave the face would find the same voxel again
+            */
+            simd_v3 hit_normal = simd_v3_load(lane_normal_x, lane_normal_y, lane_normal_z);
+            simd_f32 surface_offset = simd_f32_(0.001f*world->voxel_world->voxel_dim);
+
+            min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
+            next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir) + surface_offset*hit_normal);
+            next_normal = overwrite(next_normal, min_t_update_mask, hit_normal);
+            hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, simd_u32_load(lane_mat_index));
+            is_light_primitive_mask = is_light_primitive_mask & ~min_t_update_mask;
+        }
+    }
+
+    result.hit_t = min_hit_t;
+    result.hit_p = next_ray_origin;
+    result.hit_normal = next_normal;
+    result.hit_mat_index = hit_mat_index;
+    result.is_light_primitive_mask = is_light_primitive_mask;
+
+    return result;
+}
+
+// NOTE(joon) Marsaglia's method, uniform on the unit sphere. The lanes that fall outside of the unit disk try again
+internal simd_v3
+random_unit_vector(simd_random_series *series)
+{
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+    simd_f32 simd_f32_2 = simd_f32_(2.0f);
+
+    simd_f32 x = random_between_minus_1_1(series);
+    simd_f32 y = random_between_minus_1_1(series);
+    simd_f32 length_square = x*x + y*y;
+
+    simd_u32 reject_mask = compare_greater_equal(length_square, simd_f32_1);
+    while(!all_lanes_zero(reject_mask))
+    {
+        x = overwrite(x, reject_mask, random_between_minus_1_1(series));
+        y = overwrite(y, reject_mask, random_between_minus_1_1(series));
+        length_square = x*x + y*y;
+
+        reject_mask = compare_greater_equal(length_square, simd_f32_1);
+    }
+
+    simd_f32 scale = simd_f32_2*sqrt(simd_f32_1 - length_square);
+    simd_v3 result = simd_v3_(x*scale, y*scale, simd_f32_1 - simd_f32_2*length_square);
+
+    return result;
+}
+
+/*
+   NOTE(joon) sin(2*pi*t) for t between 0 & 1. The angle is folded into [-pi/2, pi/2] first,
+   where the taylor series up to x^11 is off by less than 1e-7.
+*/
+force_inline simd_f32
+sin_2pi_approx(simd_f32 t)
+{
+    simd_f32 half_pi = simd_f32_(half_pi_32);
+
+    // NOTE(joon) sin(2*pi*t) = -sin(2*pi*(t - 0.5)), which is between -pi & pi
+    simd_f32 x = simd_f32_(2.0f*pi_32)*(simd_f32_(0.5f) - t);
+    x = overwrite(x, compare_greater(x, half_pi), simd_f32_(pi_32) - x);
+    x = overwrite(x, compare_less(x, -half_pi), simd_f32_(-pi_32) - x);
+
+    simd_f32 x_square = x*x;
+    simd_f32 result = simd_f32_(-1.0f/39916800.0f);
+    result = result*x_square + simd_f32_(1.0f/362880.0f);
+    result = result*x_square + simd_f32_(-1.0f/5040.0f);
+    result = result*x_square + simd_f32_(1.0f/120.0f);
+    result = result*x_square + simd_f32_(-1.0f/6.0f);
+    result = result*x_square + simd_f32_(1.0f);
+    result = result*x;
+
+    return result;
+}
+
+// NOTE(joon) Uniform on the unit sphere, from 2 numbers between 0 & 1.
+// Unlike random_unit_vector, each sample always maps to the same vector, which keeps the stratification of the sampler
+internal simd_v3
+get_unit_vector(SimdSample2 sample)
+{
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+
+    simd_f32 z = simd_f32_1 - simd_f32_(2.0f)*sample.x;
+    simd_f32 r = sqrt(max(simd_f32_1 - z*z, simd_f32_(0.0f)));
+
+    simd_f32 cos_t = sample.y + simd_f32_(0.25f);
+    cos_t = overwrite(cos_t, compare_greater_equal(cos_t, simd_f32_1), cos_t - simd_f32_1);
+
+    simd_v3 result = simd_v3_(r*sin_2pi_approx(cos_t), r*sin_2pi_approx(sample.y), z);
+
+    return result;
+}
+
+// NOTE(joon) power heuristic with the power of 2, weight of the strategy that has pdf_a
+force_inline simd_f32
+get_mis_weight(simd_f32 pdf_a, simd_f32 pdf_b)
+{
+    simd_f32 pdf_a_square = pdf_a*pdf_a;
+    simd_f32 result = pdf_a_square / (pdf_a_square + pdf_b*pdf_b);
+
+    return result;
+}
+
+struct SimdLightSample
+{
+    simd_v3 dir;
+    // NOTE(joon) emit color / light_pdf, so that this only needs to be multiplied by the brdf * cos & the mis weight
+    simd_v3 radiance;
+    // NOTE(joon) in solid angle
+    simd_f32 light_pdf;
+
+    // NOTE(joon) the lanes where the light was not blocked, and everything else is only valid for these lanes
+    simd_u32 is_visible_mask;
+};
+
+/*
+   NOTE(joon) Next event estimation. Picks a point on one of the lights per lane and traces a shadow ray towards it.
+   The caller should weight the sample against the chance of the bounce finding the same point(see get_mis_weight),
+   as the rays that hit the lights also count them.
+   normal should be normalized & facing the side that the ray came from.
+*/
+internal SimdLightSample
+sample_direct_lighting(RaytracerWorld *world, SimdSampler *sampler, simd_v3 p, simd_v3 normal, simd_u32 is_lane_active_mask)
+{
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    SimdLightSample result = {};
+
+    // NOTE(joon) one to pick the light, and two for the point on the light
+    SimdSample2 point_sample = get_sample_2d(sampler);
+    r32 lane_u0[HB_LANE_WIDTH];
+    r32 lane_u1[HB_LANE_WIDTH];
+    r32 lane_u2[HB_LANE_WIDTH];
+    simd_f32_store(lane_u0, get_sample_1d(sampler));
+    simd_f32_store(lane_u1, point_sample.x);
+    simd_f32_store(lane_u2, point_sample.y);
+
+    u32 lane_is_active[HB_LANE_WIDTH];
+    simd_u32_store(lane_is_active, is_lane_active_mask);
+
+    // TODO(joon): gather / scatter?
+    r32 light_p_x[HB_LANE_WIDTH];
+    r32 light_p_y[HB_LANE_WIDTH];
+    r32 light_p_z[HB_LANE_WIDTH];
+    r32 light_normal_x[HB_LANE_WIDTH];
+    r32 light_normal_y[HB_LANE_WIDTH];
+    r32 light_normal_z[HB_LANE_WIDTH];
+    r32 emit_r[HB_LANE_WIDTH];
+    r32 emit_g[HB_LANE_WIDTH];
+    r32 emit_b[HB_LANE_WIDTH];
+    r32 area_pdf[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        RaytracerLightSample sample = {};
+        if(lane_is_active[lane])
+        {
+            sample = sample_raytracer_light(world, lane_u0[lane], lane_u1[lane], lane_u2[lane]);
+        }
+
+        light_p_x[lane] = sample.p.x;
+        light_p_y[lane] = sample.p.y;
+        light_p_z[lane] = sample.p.z;
+        light_normal_x[lane] = sample.normal.x;
+        light_normal_y[lane] = sample.normal.y;
+        light_normal_z[lane] = sample.normal.z;
+        emit_r[lane] = sample.emit_color.r;
+        emit_g[lane] = sample.emit_color.g;
+        emit_b[lane] = sample.emit_color.b;
+        area_pdf[lane] = sample.area_pdf;
+    }
+
+    simd_v3 to_light = simd_v3_load(light_p_x, light_p_y, light_p_z) - p;
+    simd_f32 distance_square = dot(to_light, to_light);
+    simd_f32 distance = sqrt(distance_square);
+    // NOTE(joon) NaN for the inactive lanes, which never pass the masks below
+    result.dir = to_light / distance;
+
+    simd_f32 cos = dot(normal, result.dir);
+    simd_f32 light_cos = dot(simd_v3_load(light_normal_x, light_normal_y, light_normal_z), result.dir);
+    // NOTE(joon) triangle lights emit on both sides, same as when the rays hit them
+    light_cos = max(light_cos, -light_cos);
+
+    simd_u32 shadow_ray_mask = is_lane_active_mask & compare_greater(cos, simd_f32_0) & compare_greater(light_cos, simd_f32_0);
+    if(!all_lanes_zero(shadow_ray_mask))
+    {
+        // NOTE(joon) stop a bit before the light, so that the light itself does not block the shadow ray
+        simd_f32 max_hit_t = simd_f32_(0.999f)*distance;
+        SimdRayIntersectResult hit = ray_intersect_with_raytracer_world(world, p, result.dir, shadow_ray_mask, true, max_hit_t);
+        result.is_visible_mask = shadow_ray_mask & compare_greater_equal(hit.hit_t, max_hit_t);
+
+        if(!all_lanes_zero(result.is_visible_mask))
+        {
+            result.light_pdf = overwrite(simd_f32_0, result.is_visible_mask, simd_f32_load(area_pdf)*distance_square/light_cos);
+            result.radiance = overwrite(simd_v3_(V3(0.0f, 0.0f, 0.0f)), result.is_visible_mask, 
+                                        simd_v3_load(emit_r, emit_g, emit_b) / result.light_pdf);
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) Returns the lane of the first set bit, or HB_LANE_WIDTH if there is none
+internal u32
+get_first_set_lane(simd_u32 mask)
+{
+    u32 lanes[HB_LANE_WIDTH];
+    simd_u32_store(lanes, mask);
+
+    u32 result = HB_LANE_WIDTH;
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        if(lanes[lane])
+        {
+            result = lane;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) The lanes can hit different measured materials, each of which has its own table.
+   Goes through the materials one by one, which is usually just once as the neighbouring rays mostly hit the same material.
+   Returns f(not multiplied by the cos), see get_merl_brdf_value.
+*/
+internal simd_v3
+get_measured_brdf_value(RaytracerWorld *world, simd_u32 mat_index, simd_v3 normal, simd_v3 outgoing_dir, simd_v3 incoming_dir, 
+                        simd_u32 is_lane_active_mask)
+{
+    simd_v3 result = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+
+    simd_u32 remaining_mask = is_lane_active_mask;
+    while(!all_lanes_zero(remaining_mask))
+    {
+        u32 material_index = get_lane(mat_index, get_first_set_lane(remaining_mask));
+        simd_u32 material_mask = remaining_mask & compare_equal(mat_index, simd_u32_(material_index));
+
+        MerlBrdf *brdf = world->materials[material_index].merl_brdf;
+        result = overwrite(result, material_mask, get_merl_brdf_value(brdf, normal, outgoing_dir, incoming_dir, material_mask));
+
+        remaining_mask = remaining_mask & ~material_mask;
+    }
+
+    return result;
+}
+
+// NOTE(joon) pdf of sample_measured_brdf picking the incoming direction, in solid angle. 0 for the inactive lanes
+internal simd_f32
+get_measured_brdf_pdf(RaytracerWorld *world, simd_u32 mat_index, simd_v3 normal, simd_v3 outgoing_dir, simd_v3 incoming_dir, 
+                      simd_u32 is_lane_active_mask)
+{
+    u32 lane_is_active[HB_LANE_WIDTH];
+    simd_u32_store(lane_is_active, is_lane_active_mask);
+
+    r32 pdfs[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        pdfs[lane] = 0.0f;
+        if(lane_is_active[lane])
+        {
+            MerlBrdf *brdf = world->materials[get_lane(mat_index, lane)].merl_brdf;
+            pdfs[lane] = get_merl_brdf_pdf(brdf, get_lane(normal, lane), get_lane(outgoing_dir, lane), get_lane(incoming_dir, lane));
+        }
+    }
+
+    simd_f32 result = simd_f32_load(pdfs);
+
+    return result;
+}
+
+struct SimdBrdfSample
+{
+    simd_v3 incoming_dir;
+    // NOTE(joon) in solid angle, 0 for the lanes that could not get a sample
+    simd_f32 pdf;
+};
+
+internal SimdBrdfSample
+sample_measured_brdf(RaytracerWorld *world, SimdSampler *sampler, simd_u32 mat_index, simd_v3 normal, simd_v3 outgoing_dir, 
+                     simd_u32 is_lane_active_mask)
+{
+    SimdBrdfSample result = {};
+
+    // NOTE(joon) the cells of the table, and the position inside the cell
+    SimdSample2 cell_sample = get_sample_2d(sampler);
+    SimdSample2 position_sample = get_sample_2d(sampler);
+    r32 lane_u0[HB_LANE_WIDTH];
+    r32 lane_u1[HB_LANE_WIDTH];
+    r32 lane_u2[HB_LANE_WIDTH];
+    r32 lane_u3[HB_LANE_WIDTH];
+    simd_f32_store(lane_u0, cell_sample.x);
+    simd_f32_store(lane_u1, cell_sample.y);
+    simd_f32_store(lane_u2, position_sample.x);
+    simd_f32_store(lane_u3, position_sample.y);
+
+    u32 lane_is_active[HB_LANE_WIDTH];
+    simd_u32_store(lane_is_active, is_lane_active_mask);
+
+    r32 incoming_x[HB_LANE_WIDTH];
+    r32 incoming_y[HB_LANE_WIDTH];
+    r32 incoming_z[HB_LANE_WIDTH];
+    r32 pdfs[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        MerlBrdfSample sample = {};
+        if(lane_is_active[lane])
+        {
+            MerlBrdf *brdf = world->materials[get_lane(mat_index, lane)].merl_brdf;
+            sample = sample_merl_brdf(brdf, get_lane(normal, lane), get_lane(outgoing_dir, lane), 
+                                      lane_u0[lane], lane_u1[lane], lane_u2[lane], lane_u3[lane]);
+        }
+
+        incoming_x[lane] = sample.incoming_dir.x;
+        incoming_y[lane] = sample.incoming_dir.y;
+        incoming_z[lane] = sample.incoming_dir.z;
+        pdfs[lane] = sample.pdf;
+    }
+
+    result.incoming_dir = simd_v3_load(incoming_x, incoming_y, incoming_z);
+    result.pdf = simd_f32_load(pdfs);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Dimensions of the sampler that each part of the path uses(each request to the sampler takes one).
+   Fixed per bounce, so that the same kind of sample always comes from the same dimension
+   even if the lanes took different paths or some of the requests were skipped.
+   - camera : jitter
+   - per bounce : 2 for the light(which light & where on the light), 2 for the bsdf(diffuse uses 1, measured uses 2)
+*/
+#define Raytracer_Camera_Dimension_Count 1
+#define Raytracer_Light_Dimension 0
+#define Raytracer_Bsdf_Dimension 2
+#define Raytracer_Bounce_Dimension_Count 4
+
+// NOTE(joon) should be a multiple of the widest lane width
+#define Output_Encode_Batch_Pixel_Count 64
+
+internal RaytracerOutput
+render_raytraced_image_tile_simd(RaytracerData *data)
+{
+    RaytracerOutput result = {};
+
+    // NOTE(joon): constants
+    simd_f32 simd_f32_2 = simd_f32_(2.0f);
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+    simd_f32 simd_f32_minus_1 = simd_f32_(-1.0f);
+    simd_u32 simd_u32_0 = simd_u32_(0);
+    simd_u32 simd_u32_max = simd_u32_(U32_Max);
+
+    simd_v3 simd_V30 = simd_v3_(V3(0.0f, 0.0f, 0.0f));
+
+    // TODO(joon) : completely made up number
+    simd_f32 square_root_tolerance = simd_f32_(0.00001f);
+
+    RaytracerWorld *world = data->world;
+    // NOTE(joon) triangles are only reachable through the bvh
+    assert(world->triangle_count == 0 || world->bvh.node_count);
+    u32 *pixels = data->pixels; 
+    u32 output_width = data->output_width; 
+    u32 output_height = data->output_height;
+    u32 ray_per_pixel_count = data->ray_per_pixel_count;
+
+    simd_u32 simd_output_width = simd_u32_(output_width);
+    simd_u32 simd_output_height = simd_u32_(output_height);
+    simd_u32 simd_u32_ray_per_pixel_count = simd_u32_(ray_per_pixel_count);
+    simd_f32 simd_f32_ray_per_pixel_count = simd_f32_((f32)ray_per_pixel_count);
+
+    simd_v3 film_center = simd_v3_(data->film_center); 
+    simd_f32 film_width = simd_f32_(data->film_width); 
+    simd_f32 film_height = simd_f32_(data->film_height);
+
+    simd_v3 camera_p = simd_v3_(data->camera_p);
+    simd_v3 camera_x_axis = simd_v3_(data->camera_x_axis); 
+    simd_v3 camera_y_axis = simd_v3_(data->camera_y_axis); 
+    simd_v3 camera_z_axis = simd_v3_(data->camera_z_axis);
+
+    u32 min_x = data->min_x; 
+    u32 one_past_max_x = data->one_past_max_x;
+    u32 min_y = data->min_y; 
+    u32 one_past_max_y = data->one_past_max_y;
+
+
+    // TODO(joon): These values should be more realistic. For example, when we ever have a concept of an acutal senser size, 
+    // we should use that value to calculate this!
+    simd_f32 x_per_pixel = film_width/convert_f32_from_u32(simd_output_width);
+    simd_f32 y_per_pixel = film_height/convert_f32_from_u32(simd_output_height);
+
+    simd_f32 half_film_width = film_width/simd_f32_2;
+    simd_f32 half_film_height = film_height/simd_f32_2;
+
+    // NOTE(joon) The sobol sequence of a pixel should keep going across the passes when there is an accumulation,
+    // and the pcg streams should be different per tile & per pass
+    u32 sampler_seed = data->random_seed;
+    if(data->accumulation && data->sampler_type != SamplerType_Pcg)
+    {
+        sampler_seed = data->sampler_seed;
+    }
+    SimdSampler lane_sampler = start_simd_sampler(data->sampler_type, sampler_seed, data->blue_noise_mask);
+    SimdSampler *sampler = &lane_sampler;
+
+    u32 *row = pixels + min_y*output_width + min_x;
+
+    // NOTE(joon): This is an _extremely_ hot loop. Very small performance increase/decrease can have a huge impact on the total time
+    u32 bounced_ray_count = 0;
+    for(u32 y = min_y;
+            y < one_past_max_y;
+            ++y)
+    {
+        simd_f32 film_y = simd_f32_(2.0f*((r32)y/(r32)output_height) - 1.0f);
+        u32 *pixel = row;
+
+        // NOTE(joon) the pixel colors of the row wait here, so that they can be encoded together(see encode_output_pixels)
+        r32 batch_r[Output_Encode_Batch_Pixel_Count];
+        r32 batch_g[Output_Encode_Batch_Pixel_Count];
+        r32 batch_b[Output_Encode_Batch_Pixel_Count];
+        u32 batch_pixel_count = 0;
+
+        for(u32 x = min_x;
+                x < one_past_max_x;
+                ++x)
+        {
+            simd_f32 film_x = simd_f32_(2.0f*((r32)x/(r32)output_width) - 1.0f);
+            simd_v3 result_color = simd_V30;
+
+            // NOTE(joon) sums of the first hit of each ray, only used when the features are requested
+            simd_v3 feature_albedo_sum = simd_V30;
+            simd_v3 feature_normal_sum = simd_V30;
+            simd_f32 feature_depth_sum = simd_f32_0;
+            u32 feature_ray_count = 0;
+
+            RaytracerPixelAccumulation *accumulation = 0;
+            if(data->accumulation)
+            {
+                accumulation = data->accumulation + y*output_width + x;
+            }
+
+            for(u32 ray_per_pixel_index = 0;
+                    ray_per_pixel_index < ray_per_pixel_count;
+                    ray_per_pixel_index += HB_LANE_WIDTH)
+            {
+                // NOTE(joon) adaptive sampling, only spend more rays on the pixels that are still noisy
+                if(accumulation && 
+                   is_pixel_converged(accumulation, data->min_ray_per_pixel_count, data->max_relative_error))
+                {
+                    break;
+                }
+
+                // NOTE(joon) with the accumulation, the samples of this pass come after the ones from the previous passes
+                u32 first_sample_index = accumulation ? accumulation->ray_count : ray_per_pixel_index;
+                start_simd_sampler_pixel(sampler, x, y, first_sample_index);
+
+                // NOTE(joon): These values are inside the loop because as we are casting multiple lights anyway,
+                // we can slightly 'jitter' the ray direction to get the anti-aliasing effect 
+                SimdSample2 jitter_sample = get_sample_2d(sampler);
+                simd_f32 jitter_x = x_per_pixel*jitter_sample.x;
+                simd_f32 jitter_y = y_per_pixel*jitter_sample.y;
+
+                // NOTE(joon): we multiply x and y value by half film dim(to get the position in the sensor which is center oriented) & 
+                // axis(which are defined in world coordinate, so by multiplying them, we can get the world coodinates)
+                simd_v3 film_p = film_center + (film_y + jitter_y)*half_film_height*camera_y_axis + (film_x + jitter_x)*half_film_width*camera_x_axis;
+
+                // TODO(joon) : later on, we need to make this to be random per ray per pixel!
+                simd_v3 ray_origin = camera_p;
+                simd_v3 ray_dir = film_p - camera_p;
+                simd_v3 attenuation = simd_v3_(V3(1.0f, 1.0f, 1.0f));
+
+                // NOTE(joon): ray_per_pixel_count does not need to be a multiple of the lane width,
+                // the lanes that go over the ray count are dead from the start and never contribute to the color
+                simd_u32 is_ray_alive_mask = simd_u32_max;
+                if(ray_per_pixel_count - ray_per_pixel_index < HB_LANE_WIDTH)
+                {
+                    is_ray_alive_mask = get_first_lanes_mask(ray_per_pixel_count - ray_per_pixel_index);
+                }
+                simd_u32 is_ray_valid_mask = is_ray_alive_mask;
+                result.camera_ray_count += get_non_zero_lane_count_from_all_set_bit(is_ray_valid_mask);
+                simd_v3 sample_color = simd_V30;
+
+                // NOTE(joon) the lanes where the last bounce was diffuse or measured, and the pdf of the direction that it picked.
+                // Only those can find the lights that the next event estimation also could have found
+                simd_u32 has_bsdf_pdf_mask = simd_u32_0;
+                simd_f32 bsdf_pdf = simd_f32_0;
+
+                for(u32 bounce_index = 0;
+                        bounce_index < Raytracer_Max_Bounce_Count;
+                        ++bounce_index)
+                {
+                    u32 bounce_dimension = Raytracer_Camera_Dimension_Count + bounce_index*Raytracer_Bounce_Dimension_Count;
+
+                    SimdRayIntersectResult hit = ray_intersect_with_raytracer_world(world, ray_origin, ray_dir, is_ray_alive_mask, bounce_index > 0, 
+                                                                                    simd_f32_(Flt_Max));
+                    simd_u32 hit_mat_index = hit.hit_mat_index;
+                    simd_v3 next_ray_origin = hit.hit_p;
+                    simd_v3 next_normal = hit.hit_normal;
+
+                    // TODO(joon): gatter / scatter?
+                    // NOTE(joon): gathered lane by lane, so that this works for any lane width
+                    r32 emit_r[HB_LANE_WIDTH];
+                    r32 emit_g[HB_LANE_WIDTH];
+                    r32 emit_b[HB_LANE_WIDTH];
+                    r32 reflection_r[HB_LANE_WIDTH];
+                    r32 reflection_g[HB_LANE_WIDTH];
+                    r32 reflection_b[HB_LANE_WIDTH];
+                    r32 reflectivity[HB_LANE_WIDTH];
+                    u32 has_merl_brdf[HB_LANE_WIDTH];
+                    for(u32 lane = 0;
+                            lane < HB_LANE_WIDTH;
+                            ++lane)
+                    {
+                        RaytracerMaterial *lane_hit_material = world->materials + get_lane(hit_mat_index, lane);
+
+                        emit_r[lane] = lane_hit_material->emit_color.r;
+                        emit_g[lane] = lane_hit_material->emit_color.g;
+                        emit_b[lane] = lane_hit_material->emit_color.b;
+
+                        reflection_r[lane] = lane_hit_material->reflection_color.r;
+                        reflection_g[lane] = lane_hit_material->reflection_color.g;
+                        reflection_b[lane] = lane_hit_material->reflection_color.b;
+
+                        reflectivity[lane] = lane_hit_material->reflectivity;
+                        has_merl_brdf[lane] = (lane_hit_material->merl_brdf != 0);
+                    }
+
+                    simd_v3 hit_mat_emit_color = simd_v3_load(emit_r, emit_g, emit_b);
+                    simd_v3 hit_mat_reflection_color = simd_v3_load(reflection_r, reflection_g, reflection_b);
+                    simd_f32 hit_mat_reflectivity = simd_f32_load(reflectivity);
+                    simd_u32 hit_mat_has_merl_brdf_mask = is_lane_non_zero(simd_u32_load(has_merl_brdf));
+
+                    u32 alive_lane_count = get_non_zero_lane_count_from_all_set_bit(is_ray_alive_mask);
+                    bounced_ray_count += alive_lane_count;
+                    result.bounce_lane_counts[bounce_index] += HB_LANE_WIDTH;
+                    result.bounce_alive_lane_counts[bounce_index] += alive_lane_count;
+
+                    if(data->features && bounce_index == 0)
+                    {
+                        simd_u32 is_hit_mask = is_ray_alive_mask & is_lane_non_zero(hit_mat_index);
+
+                        simd_v3 albedo = overwrite(hit_mat_emit_color, is_lane_non_zero(hit_mat_index), hit_mat_reflection_color);
+                        feature_albedo_sum = feature_albedo_sum + overwrite(simd_V30, is_ray_alive_mask, albedo);
+                        // NOTE(joon) the lanes that didn't hit anything might have a zero normal, which becomes NaN here
+                        // but it's fine as they get overwritten anyway
+                        feature_normal_sum = feature_normal_sum + overwrite(simd_V30, is_hit_mask, normalize(next_normal));
+                        feature_depth_sum = feature_depth_sum + overwrite(simd_f32_0, is_hit_mask, length(next_ray_origin - ray_origin));
+                        feature_ray_count += get_non_zero_lane_count_from_all_set_bit(is_ray_alive_mask);
+                    }
+
+                    // NOTE(joon) multiple importance sampling against the next event estimation
+                    simd_f32 emit_weight = simd_f32_1;
+                    simd_u32 mis_mask = is_ray_alive_mask & has_bsdf_pdf_mask & hit.is_light_primitive_mask;
+                    if(world->light_count && !all_lanes_zero(mis_mask))
+                    {
+                        simd_v3 to_hit = next_ray_origin - ray_origin;
+                        simd_f32 distance_square = dot(to_hit, to_hit);
+                        simd_f32 light_cos = dot(normalize(next_normal), to_hit) / sqrt(distance_square);
+                        light_cos = max(light_cos, -light_cos);
+
+                        simd_f32 light_pdf = dot(hit_mat_emit_color, simd_v3_(V3(0.2126f, 0.7152f, 0.0722f))) * 
+                                             simd_f32_(1.0f / world->total_light_power) * distance_square / light_cos;
+                        emit_weight = overwrite(emit_weight, mis_mask, get_mis_weight(bsdf_pdf, light_pdf));
+                    }
+
+                    // TODO(joon): make overwrite_plus function?
+                    sample_color = overwrite(sample_color, is_ray_alive_mask, sample_color + emit_weight*(attenuation*hit_mat_emit_color)); 
+
+                    // NOTE(joon): update if the ray is still alive or dead
+                    simd_u32 mat_mask = is_lane_non_zero(hit_mat_index);
+                    is_ray_alive_mask = is_ray_alive_mask & mat_mask;
+
+                    if(all_lanes_zero(is_ray_alive_mask))
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        next_normal = normalize(next_normal);
+                        // NOTE(joon) facing the side that the ray came from, so that both the light & the bounce stay on that side
+                        next_normal = overwrite(next_normal, compare_greater(dot(next_normal, ray_dir), simd_f32_0), -next_normal);
+
+                        // NOTE(joon) Only the fully diffuse & the measured surfaces use the next event estimation,
+                        // as there is no pdf for the lerp between the diffuse & the perfect reflection
+                        simd_u32 is_measured_mask = is_ray_alive_mask & hit_mat_has_merl_brdf_mask;
+                        simd_u32 is_diffuse_mask = is_ray_alive_mask & ~hit_mat_has_merl_brdf_mask & compare_equal(hit_mat_reflectivity, simd_f32_0);
+                        // NOTE(joon) no point of tracing the shadow rays for the surfaces that don't reflect anything(i.e the lights)
+                        simd_u32 is_reflecting_mask = compare_greater(dot(hit_mat_reflection_color, simd_v3_(V3(1.0f, 1.0f, 1.0f))), simd_f32_0);
+                        simd_u32 direct_light_mask = (is_diffuse_mask & is_reflecting_mask) | is_measured_mask;
+
+                        // NOTE(joon) the camera rays are not normalized
+                        simd_v3 outgoing_dir = -normalize(ray_dir);
+
+                        if(world->light_count && !all_lanes_zero(direct_light_mask))
+                        {
+                            set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Light_Dimension);
+                            SimdLightSample light = sample_direct_lighting(world, sampler, next_ray_origin, next_normal, direct_light_mask);
+                            if(!all_lanes_zero(light.is_visible_mask))
+                            {
+                                // NOTE(joon) brdf * cos, and the pdf of the bounce picking the same direction
+                                simd_f32 light_cos = dot(next_normal, light.dir);
+                                simd_v3 brdf_cos = (light_cos*simd_f32_(1.0f/pi_32))*hit_mat_reflection_color;
+                                simd_f32 light_bsdf_pdf = light_cos*simd_f32_(1.0f/pi_32);
+
+                                simd_u32 measured_light_mask = light.is_visible_mask & is_measured_mask;
+                                if(!all_lanes_zero(measured_light_mask))
+                                {
+                                    simd_v3 brdf = get_measured_brdf_value(world, hit_mat_index, next_normal, outgoing_dir, light.dir, measured_light_mask);
+                                    brdf_cos = overwrite(brdf_cos, measured_light_mask, light_cos*brdf);
+                                    light_bsdf_pdf = overwrite(light_bsdf_pdf, measured_light_mask,
+                                                               get_measured_brdf_pdf(world, hit_mat_index, next_normal, outgoing_dir, light.dir, measured_light_mask));
+                                }
+
+                                simd_v3 direct_light = get_mis_weight(light.light_pdf, light_bsdf_pdf)*(brdf_cos*light.radiance);
+                                sample_color = overwrite(sample_color, light.is_visible_mask, sample_color + attenuation*direct_light);
+                            }
+                        }
+
+                        attenuation = overwrite(attenuation, is_ray_alive_mask & ~is_measured_mask, attenuation*hit_mat_reflection_color);
+
+                        ray_origin = next_ray_origin;
+
+                        simd_v3 perfect_reflection = normalize(ray_dir - simd_f32_2*dot(ray_dir, next_normal)*next_normal);
+
+                        // NOTE(joon) cosine weighted, so the reflection color alone is the whole weight of the diffuse bounce
+                        set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Bsdf_Dimension);
+                        simd_v3 random_reflection = normalize(next_normal + get_unit_vector(get_sample_2d(sampler)));
+
+                        ray_dir = lerp(random_reflection, hit_mat_reflectivity, perfect_reflection);
+
+                        has_bsdf_pdf_mask = is_diffuse_mask;
+                        bsdf_pdf = dot(next_normal, ray_dir)*simd_f32_(1.0f/pi_32);
+
+                        // NOTE(joon) the measured surfaces pick the direction from their own table,
+                        // and the weight becomes f * cos / pdf instead of the reflection color
+                        if(!all_lanes_zero(is_measured_mask))
+                        {
+                            // NOTE(joon) these lanes did not use the sample of the diffuse bounce, so they can start from the same dimension
+                            set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Bsdf_Dimension);
+                            SimdBrdfSample brdf_sample = sample_measured_brdf(world, sampler, hit_mat_index, next_normal, outgoing_dir, is_measured_mask);
+                            simd_u32 is_sampled_mask = is_measured_mask & compare_greater(brdf_sample.pdf, simd_f32_0);
+
+                            simd_v3 brdf = get_measured_brdf_value(world, hit_mat_index, next_normal, outgoing_dir, brdf_sample.incoming_dir, is_sampled_mask);
+                            simd_f32 cos = dot(next_normal, brdf_sample.incoming_dir);
+                            attenuation = overwrite(attenuation, is_sampled_mask, (cos/brdf_sample.pdf)*(attenuation*brdf));
+
+                            ray_dir = overwrite(ray_dir, is_sampled_mask, brdf_sample.incoming_dir);
+                            bsdf_pdf = overwrite(bsdf_pdf, is_sampled_mask, brdf_sample.pdf);
+                            has_bsdf_pdf_mask = has_bsdf_pdf_mask | is_sampled_mask;
+
+                            // NOTE(joon) the lanes that could not get a sample are done, as they would not carry anything anyway
+                            is_ray_alive_mask = is_ray_alive_mask & ~(is_measured_mask & ~is_sampled_mask);
+                        }
+                    }
+                }
+
+                result_color = result_color + sample_color;
+
+                if(accumulation)
+                {
+                    simd_f32 luminance = overwrite(simd_f32_0, is_ray_valid_mask, dot(sample_color, simd_v3_(V3(0.2126f, 0.7152f, 0.0722f))));
+                    accumulation->luminance_sum += add_all_lanes(luminance);
+                    accumulation->luminance_square_sum += add_all_lanes(luminance*luminance);
+                    accumulation->ray_count += get_non_zero_lane_count_from_all_set_bit(is_ray_valid_mask);
+                }
+            }
+
+            v3 pixel_color = V3(0.0f, 0.0f, 0.0f);
+            if(accumulation)
+            {
+                accumulation->color_sum += V3(add_all_lanes(result_color.r), add_all_lanes(result_color.g), add_all_lanes(result_color.b));
+                if(accumulation->ray_count)
+                {
+                    pixel_color = accumulation->color_sum / (r32)accumulation->ray_count;
+                }
+
+                if(is_pixel_converged(accumulation, data->min_ray_per_pixel_count, data->max_relative_error))
+                {
+                    result.converged_pixel_count++;
+                }
+            }
+            else
+            {
+                result_color /= simd_f32_ray_per_pixel_count;
+                pixel_color = V3(add_all_lanes(result_color.r), add_all_lanes(result_color.g), add_all_lanes(result_color.b));
+            }
+
+            if(data->features)
+            {
+                RaytracerPixelFeature *feature = data->features + y*output_width + x;
+                feature->color = pixel_color;
+                if(feature_ray_count)
+                {
+                    r32 inv_feature_ray_count = 1.0f / (r32)feature_ray_count;
+                    feature->albedo = inv_feature_ray_count*V3(add_all_lanes(feature_albedo_sum.r), add_all_lanes(feature_albedo_sum.g), add_all_lanes(feature_albedo_sum.b));
+
+                    // NOTE(joon) not normalized, so that the pixels on the silhouettes end up with the shorter normals
+                    feature->normal = inv_feature_ray_count*V3(add_all_lanes(feature_normal_sum.x), add_all_lanes(feature_normal_sum.y), add_all_lanes(feature_normal_sum.z));
+                    feature->depth = inv_feature_ray_count*add_all_lanes(feature_depth_sum);
+                }
+            }
+
+            batch_r[batch_pixel_count] = pixel_color.r;
+            batch_g[batch_pixel_count] = pixel_color.g;
+            batch_b[batch_pixel_count] = pixel_color.b;
+            batch_pixel_count++;
+
+            if(batch_pixel_count == Output_Encode_Batch_Pixel_Count || x + 1 == one_past_max_x)
+            {
+                u32 batch_min_x = x + 1 - batch_pixel_count;
+                encode_output_pixels(&data->output_encoding, batch_r, batch_g, batch_b, 1.0f, batch_pixel_count, batch_min_x, y, pixel);
+                pixel += batch_pixel_count;
+                batch_pixel_count = 0;
+            }
+        }
+
+        row += output_width;
+    }
+
+    result.bounced_ray_count = bounced_ray_count;
+
+#if 0
+    // NOTE(joon): Draw tile boundary
+    {
+        u32 *row = pixels + min_y*output_width + min_x;
+        for(u32 y = min_y;
+                y < one_past_max_y;
+                ++y)
+        {
+            u32 *pixel = row;
+            for(u32 x = min_x;
+                    x < one_past_max_x;
+                    ++x)
+            {
+                if(y == min_y || y == one_past_max_y-1 || x == min_x || x == one_past_max_x - 1)
+                {
+                    *pixel = 0xffff0000;
+                }
+
+                pixel++;
+            }
+
+            row += output_width;
+        }
+    }
+#endif
 
     return result;
 }
 
-#if 0
-struct raytracer_data
+/*
+   NOTE(joon) Wavefront version of render_raytraced_image_tile_simd.
+   Instead of following the same HB_LANE_WIDTH rays until all of them die, the rays of multiple pixels are put inside a stream
+   and each bounce of the whole stream is traced at once. Only the rays that are still alive are written back to the stream,
+   so the packets are always full(except the last one) no matter how many rays have died.
+   After the first bounce, the stream is binned by the direction octant & the cell of the origin,
+   so that the rays inside the same packet at least go roughly the same way.
+   The packets that end up inside a single bin are traced together with the packet traversal like the camera rays,
+   and only the ones that straddle the bins are traced ray by ray through the wide bvh.
+*/
+#define Wavefront_Max_Ray_Count 1024
+// NOTE(joon) the origin cells are Wavefront_Origin_Cell_Dim^3 cells inside the bounds of the bvh root
+#define Wavefront_Origin_Cell_Dim 4
+#define Wavefront_Bin_Count (8*Wavefront_Origin_Cell_Dim*Wavefront_Origin_Cell_Dim*Wavefront_Origin_Cell_Dim)
+
+// NOTE(joon) padded by the lane width, so that the last packet can always load the full lanes
+#define Wavefront_Ray_Stream_Size (Wavefront_Max_Ray_Count + HB_LANE_WIDTH)
+struct WavefrontRayStream
 {
-    world *world;
-    u32 *pixels; 
-    u32 output_width; 
-    u32 output_height;
-    u32 ray_per_pixel_count;
+    r32 origin_x[Wavefront_Ray_Stream_Size];
+    r32 origin_y[Wavefront_Ray_Stream_Size];
+    r32 origin_z[Wavefront_Ray_Stream_Size];
+
+    r32 dir_x[Wavefront_Ray_Stream_Size];
+    r32 dir_y[Wavefront_Ray_Stream_Size];
+    r32 dir_z[Wavefront_Ray_Stream_Size];
 
-    v3 film_center; 
-    r32 film_width; 
-    r32 film_height;
+    r32 attenuation_r[Wavefront_Ray_Stream_Size];
+    r32 attenuation_g[Wavefront_Ray_Stream_Size];
+    r32 attenuation_b[Wavefront_Ray_Stream_Size];
 
-    v3 camera_p;
-    v3 camera_x_axis; 
-    v3 camera_y_axis; 
-    v3 camera_z_axis;
+    // NOTE(joon) which camera ray of the round this ray came from(see WavefrontCameraRays)
+    u32 camera_ray_indices[Wavefront_Ray_Stream_Size];
 
-    u32 min_x; 
-    u32 one_past_max_x;
-    u32 min_y; 
-    u32 one_past_max_y;
+    // NOTE(joon) pdf of the direction that the last bounce picked, and whether the next event estimation could also have found
+    // the same light(see has_bsdf_pdf_mask in the simd version)
+    r32 bsdf_pdfs[Wavefront_Ray_Stream_Size];
+    u32 has_bsdf_pdf_masks[Wavefront_Ray_Stream_Size];
 
-    simd_random_series series;
+    // NOTE(joon) only valid right after the sort(see sort_wavefront_ray_stream), as the compaction does not keep them
+    u32 bins[Wavefront_Ray_Stream_Size];
+
+    u32 ray_count;
 };
 
-struct raytracer_output
+/*
+   NOTE(joon) The camera rays of a round, which stay in the same order while their bounces get sorted & compacted.
+   Each one knows which pixel of the chunk it contributes to & which sample of that pixel it is.
+   All rays of the stream are on the same bounce, so the dimension of the sampler is the same for all of them.
+   The color is per ray, so that the accumulation can also get the luminance of each sample.
+*/
+struct WavefrontCameraRays
 {
-    u64 bounced_ray_count;
+    u32 pixel_indices[Wavefront_Ray_Stream_Size];
+    u32 sample_indices[Wavefront_Ray_Stream_Size];
+
+    r32 color_r[Wavefront_Max_Ray_Count];
+    r32 color_g[Wavefront_Max_Ray_Count];
+    r32 color_b[Wavefront_Max_Ray_Count];
+
+    u32 count;
 };
 
-internal raytracer_output
-render_raytraced_image_tile_simd(raytracer_data *data)
+force_inline void
+copy_wavefront_ray(WavefrontRayStream *dest, u32 dest_index, WavefrontRayStream *source, u32 source_index)
 {
-    raytracer_output result = {};
+    dest->origin_x[dest_index] = source->origin_x[source_index];
+    dest->origin_y[dest_index] = source->origin_y[source_index];
+    dest->origin_z[dest_index] = source->origin_z[source_index];
 
-    // NOTE(joon): constants
-    simd_f32 simd_f32_2 = simd_f32_(2.0f);
-    simd_f32 simd_f32_0 = simd_f32_(0.0f);
-    simd_f32 simd_f32_1 = simd_f32_(1.0f);
-    simd_f32 simd_f32_minus_1 = simd_f32_(-1.0f);
-    simd_u32 simd_u32_0 = simd_u32_(0);
-    simd_u32 simd_u32_max = simd_u32_(U32_Max);
+    dest->dir_x[dest_index] = source->dir_x[source_index];
+    dest->dir_y[dest_index] = source->dir_y[source_index];
+    dest->dir_z[dest_index] = source->dir_z[source_index];
 
-    simd_v3 simd_V30 = simd_V3(V3(0.0f, 0.0f, 0.0f));
+    dest->attenuation_r[dest_index] = source->attenuation_r[source_index];
+    dest->attenuation_g[dest_index] = source->attenuation_g[source_index];
+    dest->attenuation_b[dest_index] = source->attenuation_b[source_index];
 
-    // TODO(joon) : completely made up number
-    simd_f32 square_root_tolerance = simd_f32_(0.00001f);
+    dest->camera_ray_indices[dest_index] = source->camera_ray_indices[source_index];
 
-    world *world = data->world;
-    u32 *pixels = data->pixels; 
-    u32 output_width = data->output_width; 
-    u32 output_height = data->output_height;
-    u32 ray_per_pixel_count = data->ray_per_pixel_count;
-    assert(ray_per_pixel_count % HB_LANE_WIDTH == 0);
+    dest->bsdf_pdfs[dest_index] = source->bsdf_pdfs[source_index];
+    dest->has_bsdf_pdf_masks[dest_index] = source->has_bsdf_pdf_masks[source_index];
+}
 
-    simd_u32 simd_output_width = simd_u32_(output_width);
-    simd_u32 simd_output_height = simd_u32_(output_height);
-    simd_u32 simd_u32_ray_per_pixel_count = simd_u32_(ray_per_pixel_count);
-    simd_f32 simd_f32_ray_per_pixel_count = simd_f32_((f32)ray_per_pixel_count);
+// NOTE(joon) Each lane of the packet can be a different pixel, so the sampler is set up lane by lane(see start_simd_sampler_lanes)
+internal void
+start_wavefront_sampler_lanes(SimdSampler *sampler, u32 *camera_ray_indices, WavefrontCameraRays *camera_rays,
+                              RaytracerData *data, u32 chunk_pixel_start, u32 dimension)
+{
+    u32 tile_width = data->one_past_max_x - data->min_x;
+
+    u32 lane_x[HB_LANE_WIDTH];
+    u32 lane_y[HB_LANE_WIDTH];
+    u32 lane_sample_indices[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        // NOTE(joon) the lanes past the end of the stream can be anything, which is fine as their samples are never used
+        u32 camera_ray_index = minimum(camera_ray_indices[lane], Wavefront_Ray_Stream_Size - 1);
+        u32 tile_pixel_index = chunk_pixel_start + camera_rays->pixel_indices[camera_ray_index];
+        lane_x[lane] = data->min_x + tile_pixel_index % tile_width;
+        lane_y[lane] = data->min_y + tile_pixel_index / tile_width;
+        lane_sample_indices[lane] = camera_rays->sample_indices[camera_ray_index];
+    }
 
-    simd_v3 film_center = simd_V3(data->film_center); 
-    simd_f32 film_width = simd_f32_(data->film_width); 
-    simd_f32 film_height = simd_f32_(data->film_height);
+    start_simd_sampler_lanes(sampler, simd_u32_load(lane_x), simd_u32_load(lane_y), simd_u32_load(lane_sample_indices));
+    set_simd_sampler_dimension(sampler, dimension);
+}
 
-    simd_v3 camera_p = simd_V3(data->camera_p);
-    simd_v3 camera_x_axis = simd_V3(data->camera_x_axis); 
-    simd_v3 camera_y_axis = simd_V3(data->camera_y_axis); 
-    simd_v3 camera_z_axis = simd_V3(data->camera_z_axis);
+/*
+   NOTE(joon) Counting sort of the rays inside the source by their bin, written to the dest.
+   The bin is (direction octant, origin cell), with the octant being the most significant so that the rays
+   that go the same way end up together even when they started from the different cells.
+*/
+internal void
+sort_wavefront_ray_stream(WavefrontRayStream *dest, WavefrontRayStream *source, v3 bounds_min, v3 bounds_max)
+{
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 max_cell = simd_f32_((r32)(Wavefront_Origin_Cell_Dim - 1));
+
+    v3 bounds_dim = bounds_max - bounds_min;
+    v3 cell_per_unit = V3(bounds_dim.x > 0.0f ? Wavefront_Origin_Cell_Dim/bounds_dim.x : 0.0f,
+                          bounds_dim.y > 0.0f ? Wavefront_Origin_Cell_Dim/bounds_dim.y : 0.0f,
+                          bounds_dim.z > 0.0f ? Wavefront_Origin_Cell_Dim/bounds_dim.z : 0.0f);
+
+    u32 bins[Wavefront_Ray_Stream_Size];
+    u32 bin_offsets[Wavefront_Bin_Count] = {};
+    for(u32 ray_index = 0;
+            ray_index < source->ray_count;
+            ray_index += HB_LANE_WIDTH)
+    {
+        simd_u32 octant = (compare_less(simd_f32_load(source->dir_x + ray_index), simd_f32_0) & simd_u32_(1)) |
+                          (compare_less(simd_f32_load(source->dir_y + ray_index), simd_f32_0) & simd_u32_(2)) |
+                          (compare_less(simd_f32_load(source->dir_z + ray_index), simd_f32_0) & simd_u32_(4));
+
+        // NOTE(joon) the origins outside of the bounds are clamped to the border cells
+        simd_f32 cell_x = (simd_f32_load(source->origin_x + ray_index) - simd_f32_(bounds_min.x)) * simd_f32_(cell_per_unit.x);
+        simd_f32 cell_y = (simd_f32_load(source->origin_y + ray_index) - simd_f32_(bounds_min.y)) * simd_f32_(cell_per_unit.y);
+        simd_f32 cell_z = (simd_f32_load(source->origin_z + ray_index) - simd_f32_(bounds_min.z)) * simd_f32_(cell_per_unit.z);
+        simd_u32 cell_index_x = convert_u32_from_f32(min(max(cell_x, simd_f32_0), max_cell));
+        simd_u32 cell_index_y = convert_u32_from_f32(min(max(cell_y, simd_f32_0), max_cell));
+        simd_u32 cell_index_z = convert_u32_from_f32(min(max(cell_z, simd_f32_0), max_cell));
+
+        simd_u32 bin = (((octant*simd_u32_(Wavefront_Origin_Cell_Dim) + cell_index_z)*simd_u32_(Wavefront_Origin_Cell_Dim) + cell_index_y)*
+                        simd_u32_(Wavefront_Origin_Cell_Dim)) + cell_index_x;
+        simd_u32_store(bins + ray_index, bin);
+    }
 
-    u32 min_x = data->min_x; 
-    u32 one_past_max_x = data->one_past_max_x;
-    u32 min_y = data->min_y; 
-    u32 one_past_max_y = data->one_past_max_y;
+    for(u32 ray_index = 0;
+            ray_index < source->ray_count;
+            ++ray_index)
+    {
+        bin_offsets[bins[ray_index]]++;
+    }
 
+    u32 offset = 0;
+    for(u32 bin_index = 0;
+            bin_index < Wavefront_Bin_Count;
+            ++bin_index)
+    {
+        u32 count = bin_offsets[bin_index];
+        bin_offsets[bin_index] = offset;
+        offset += count;
+    }
 
-    // TODO(joon): These values should be more realistic. For example, when we ever have a concept of an acutal senser size, 
-    // we should use that value to calculate this!
-    simd_f32 x_per_pixel = film_width/convert_f32_from_u32(simd_output_width);
-    simd_f32 y_per_pixel = film_height/convert_f32_from_u32(simd_output_height);
+    for(u32 ray_index = 0;
+            ray_index < source->ray_count;
+            ++ray_index)
+    {
+        u32 dest_index = bin_offsets[bins[ray_index]]++;
+        copy_wavefront_ray(dest, dest_index, source, ray_index);
+        dest->bins[dest_index] = bins[ray_index];
+    }
 
-    simd_f32 half_film_width = film_width/simd_f32_2;
-    simd_f32 half_film_height = film_height/simd_f32_2;
+    dest->ray_count = source->ray_count;
+}
 
-    // TODO(joon) : completely made up number
-    simd_f32 hit_t_threshold = simd_f32_(0.0001f);
+internal RaytracerOutput
+render_raytraced_image_tile_wavefront(RaytracerData *data)
+{
+    RaytracerOutput result = {};
 
-    simd_random_series *series = &data->series;
+    simd_f32 simd_f32_0 = simd_f32_(0.0f);
+    simd_f32 simd_f32_2 = simd_f32_(2.0f);
+    simd_u32 simd_u32_max = simd_u32_(U32_Max);
 
-    u32 *row = pixels + min_y*output_width + min_x;
+    RaytracerWorld *world = data->world;
+    // NOTE(joon) triangles are only reachable through the bvh
+    assert(world->triangle_count == 0 || world->bvh.node_count);
+    u32 output_width = data->output_width; 
+    u32 output_height = data->output_height;
+    u32 ray_per_pixel_count = data->ray_per_pixel_count;
+
+    simd_v3 film_center = simd_v3_(data->film_center); 
+    simd_f32 half_film_width = simd_f32_(0.5f*data->film_width);
+    simd_f32 half_film_height = simd_f32_(0.5f*data->film_height);
+    simd_f32 x_per_pixel = simd_f32_(data->film_width/(r32)output_width);
+    simd_f32 y_per_pixel = simd_f32_(data->film_height/(r32)output_height);
+
+    simd_v3 camera_p = simd_v3_(data->camera_p);
+    simd_v3 camera_x_axis = simd_v3_(data->camera_x_axis); 
+    simd_v3 camera_y_axis = simd_v3_(data->camera_y_axis); 
+
+    // NOTE(joon) the origins of the bounced rays are always on the surface of something,
+    // and most of them will be inside the bounds of the triangles
+    v3 bounds_min = V3(0.0f, 0.0f, 0.0f);
+    v3 bounds_max = V3(0.0f, 0.0f, 0.0f);
+    if(world->bvh.node_count)
+    {
+        bounds_min = world->bvh.nodes[0].min;
+        bounds_max = world->bvh.nodes[0].max;
+    }
+
+    // NOTE(joon) The rays get sorted & mixed between the pixels, so each ray carries its own pixel & sample index.
+    // With those, each ray gets the same samples as the simd version would have given to it
+    u32 sampler_seed = data->random_seed;
+    if(data->accumulation && data->sampler_type != SamplerType_Pcg)
+    {
+        sampler_seed = data->sampler_seed;
+    }
+    SimdSampler lane_sampler = start_simd_sampler(data->sampler_type, sampler_seed, data->blue_noise_mask);
+    SimdSampler *sampler = &lane_sampler;
+
+    // NOTE(joon) ~180KB with the camera rays & the features, which is still fine for the stack of the worker threads(512KB on macos).
+    // The stream is sorted from one into the other, and compacted in place
+    WavefrontRayStream streams[2];
+    WavefrontRayStream *stream = streams + 0;
+    WavefrontRayStream *sorted_stream = streams + 1;
+    WavefrontCameraRays camera_rays;
+
+    // NOTE(joon) a chunk is a group of pixels whose rays fit inside the stream.
+    // If a single pixel has more rays than that, its rays are traced in multiple rounds.
+    // With the adaptive sampling, the pixels are checked for the convergence before each round
+    // so the rounds are as small as the batches of the simd version, and the chunks have more pixels instead
+    u32 round_ray_per_pixel_count = minimum(ray_per_pixel_count, Wavefront_Max_Ray_Count);
+    if(data->accumulation)
+    {
+        round_ray_per_pixel_count = minimum(ray_per_pixel_count, HB_LANE_WIDTH);
+    }
+    u32 tile_width = data->one_past_max_x - data->min_x;
+    u32 tile_pixel_count = tile_width * (data->one_past_max_y - data->min_y);
+    u32 max_chunk_pixel_count = Wavefront_Max_Ray_Count / round_ray_per_pixel_count;
+    if(!data->accumulation)
+    {
+        max_chunk_pixel_count = maximum(Wavefront_Max_Ray_Count / ray_per_pixel_count, 1);
+    }
+
+    // NOTE(joon) sum of the colors that each pixel of the chunk got in this call
+    r32 color_r[Wavefront_Max_Ray_Count];
+    r32 color_g[Wavefront_Max_Ray_Count];
+    r32 color_b[Wavefront_Max_Ray_Count];
+
+    // NOTE(joon) sums of the first hit of each ray, only used when the features are requested
+    v3 feature_albedo_sums[Wavefront_Max_Ray_Count];
+    v3 feature_normal_sums[Wavefront_Max_Ray_Count];
+    r32 feature_depth_sums[Wavefront_Max_Ray_Count];
+    u32 feature_ray_counts[Wavefront_Max_Ray_Count];
 
-    // NOTE(joon): This is an _extremely_ hot loop. Very small performance increase/decrease can have a huge impact on the total time
     u32 bounced_ray_count = 0;
-    for(u32 y = min_y;
-            y < one_past_max_y;
-            ++y)
+    for(u32 chunk_pixel_start = 0;
+            chunk_pixel_start < tile_pixel_count;
+            chunk_pixel_start += max_chunk_pixel_count)
     {
-        simd_f32 film_y = simd_f32_(2.0f*((r32)y/(r32)output_height) - 1.0f);
-        u32 *pixel = row;
+        u32 chunk_pixel_count = minimum(max_chunk_pixel_count, tile_pixel_count - chunk_pixel_start);
+        zero_memory(color_r, sizeof(color_r[0])*chunk_pixel_count);
+        zero_memory(color_g, sizeof(color_g[0])*chunk_pixel_count);
+        zero_memory(color_b, sizeof(color_b[0])*chunk_pixel_count);
+        if(data->features)
+        {
+            zero_memory(feature_albedo_sums, sizeof(feature_albedo_sums[0])*chunk_pixel_count);
+            zero_memory(feature_normal_sums, sizeof(feature_normal_sums[0])*chunk_pixel_count);
+            zero_memory(feature_depth_sums, sizeof(feature_depth_sums[0])*chunk_pixel_count);
+            zero_memory(feature_ray_counts, sizeof(feature_ray_counts[0])*chunk_pixel_count);
+        }
 
-        for(u32 x = min_x;
-                x < one_past_max_x;
-                ++x)
+        for(u32 round_start = 0;
+                round_start < ray_per_pixel_count;
+                round_start += round_ray_per_pixel_count)
         {
-            simd_f32 film_x = simd_f32_(2.0f*((r32)x/(r32)output_width) - 1.0f);
-            simd_v3 result_color = simd_V30;
+            u32 round_ray_count = minimum(round_ray_per_pixel_count, ray_per_pixel_count - round_start);
 
-            for(u32 ray_per_pixel_index = 0;
-                    ray_per_pixel_index < ray_per_pixel_count;
-                    ray_per_pixel_index += HB_LANE_WIDTH)
+            // NOTE(joon) the camera rays in the pixel order, skipping the pixels that have already converged
+            camera_rays.count = 0;
+            for(u32 pixel_index = 0;
+                    pixel_index < chunk_pixel_count;
+                    ++pixel_index)
             {
-                // NOTE(joon): These values are inside the loop because as we are casting multiple lights anyway,
-                // we can slightly 'jitter' the ray direction to get the anti-aliasing effect 
-                simd_f32 jitter_x = x_per_pixel*random_between_0_1(series);
-                simd_f32 jitter_y = y_per_pixel*random_between_0_1(series);
-
-                // NOTE(joon): we multiply x and y value by half film dim(to get the position in the sensor which is center oriented) & 
-                // axis(which are defined in world coordinate, so by multiplying them, we can get the world coodinates)
-                simd_v3 film_p = film_center + (film_y + jitter_y)*half_film_height*camera_y_axis + (film_x + jitter_x)*half_film_width*camera_x_axis;
-
-                // TODO(joon) : later on, we need to make this to be random per ray per pixel!
-                simd_v3 ray_origin = camera_p;
-                simd_v3 ray_dir = film_p - camera_p;
-                simd_v3 attenuation = simd_V3(V3(1.0f, 1.0f, 1.0f));
+                u32 first_sample_index = round_start;
+                if(data->accumulation)
+                {
+                    u32 tile_pixel_index = chunk_pixel_start + pixel_index;
+                    u32 x = data->min_x + tile_pixel_index % tile_width;
+                    u32 y = data->min_y + tile_pixel_index / tile_width;
+                    RaytracerPixelAccumulation *accumulation = data->accumulation + y*output_width + x;
+                    if(is_pixel_converged(accumulation, data->min_ray_per_pixel_count, data->max_relative_error))
+                    {
+                        continue;
+                    }
 
-                simd_u32 is_ray_alive_mask = simd_u32_max;
+                    // NOTE(joon) the samples of this pass come after the ones from the previous passes
+                    first_sample_index = accumulation->ray_count;
+                }
 
-                for(u32 bounce_index = 0;
-                        bounce_index < 8;
-                        ++bounce_index)
+                for(u32 sample_index = 0;
+                        sample_index < round_ray_count;
+                        ++sample_index)
                 {
-                    simd_f32 min_hit_t = simd_f32_(Flt_Max);
+                    camera_rays.pixel_indices[camera_rays.count] = pixel_index;
+                    camera_rays.sample_indices[camera_rays.count] = first_sample_index + sample_index;
+                    camera_rays.count++;
+                }
+            }
 
-                    simd_u32 hit_mat_index = simd_u32_0;
+            if(camera_rays.count == 0)
+            {
+                // NOTE(joon) every pixel of the chunk has converged
+                break;
+            }
 
-                    // NOTE(joon): Want to get rid of this value.. but sphere needs this to calculate the normal :(
-                    simd_v3 next_ray_origin = simd_V30;
-                    simd_v3 next_normal = simd_V30;
+            // NOTE(joon) the last packet loads the full lanes
+            for(u32 lane = 0;
+                    lane < HB_LANE_WIDTH;
+                    ++lane)
+            {
+                camera_rays.pixel_indices[camera_rays.count + lane] = camera_rays.pixel_indices[camera_rays.count - 1];
+                camera_rays.sample_indices[camera_rays.count + lane] = 0;
+            }
+            zero_memory(camera_rays.color_r, sizeof(camera_rays.color_r[0])*camera_rays.count);
+            zero_memory(camera_rays.color_g, sizeof(camera_rays.color_g[0])*camera_rays.count);
+            zero_memory(camera_rays.color_b, sizeof(camera_rays.color_b[0])*camera_rays.count);
+
+            stream->ray_count = camera_rays.count;
+            result.camera_ray_count += stream->ray_count;
+            for(u32 ray_index = 0;
+                    ray_index < stream->ray_count;
+                    ray_index += HB_LANE_WIDTH)
+            {
+                r32 lane_film_x[HB_LANE_WIDTH];
+                r32 lane_film_y[HB_LANE_WIDTH];
+                for(u32 lane = 0;
+                        lane < HB_LANE_WIDTH;
+                        ++lane)
+                {
+                    u32 tile_pixel_index = chunk_pixel_start + camera_rays.pixel_indices[ray_index + lane];
+                    u32 x = data->min_x + tile_pixel_index % tile_width;
+                    u32 y = data->min_y + tile_pixel_index / tile_width;
 
-                    for(u32 plane_index = 0;
-                            plane_index < world->plane_count;
-                            ++plane_index)
-                    {
-                        plane *plane = world->planes + plane_index;
-                        
-                        //simd_v3 plane_normal = normal;
-                        simd_v3 plane_normal = simd_V3(plane->normal);
-                        simd_f32 plane_d = simd_f32_(plane->d);
+                    lane_film_x[lane] = 2.0f*((r32)x/(r32)output_width) - 1.0f;
+                    lane_film_y[lane] = 2.0f*((r32)y/(r32)output_height) - 1.0f;
+                    stream->camera_ray_indices[ray_index + lane] = ray_index + lane;
+                }
 
-                        // NOTE(joon) : if the denominator is 0, it means that the ray is parallel to the plane
-                        simd_f32 denom = dot(plane_normal, ray_dir);
+                start_wavefront_sampler_lanes(sampler, stream->camera_ray_indices + ray_index, &camera_rays, data, chunk_pixel_start, 0);
+                SimdSample2 jitter_sample = get_sample_2d(sampler);
+                simd_f32 jitter_x = x_per_pixel*jitter_sample.x;
+                simd_f32 jitter_y = y_per_pixel*jitter_sample.y;
+                simd_v3 film_p = film_center + 
+                                 (simd_f32_load(lane_film_y) + jitter_y)*half_film_height*camera_y_axis + 
+                                 (simd_f32_load(lane_film_x) + jitter_x)*half_film_width*camera_x_axis;
+
+                simd_v3_store(stream->origin_x + ray_index, stream->origin_y + ray_index, stream->origin_z + ray_index, camera_p);
+                simd_v3_store(stream->dir_x + ray_index, stream->dir_y + ray_index, stream->dir_z + ray_index, film_p - camera_p);
+                simd_v3_store(stream->attenuation_r + ray_index, stream->attenuation_g + ray_index, stream->attenuation_b + ray_index, 
+                              simd_v3_(V3(1.0f, 1.0f, 1.0f)));
+                simd_f32_store(stream->bsdf_pdfs + ray_index, simd_f32_0);
+                simd_u32_store(stream->has_bsdf_pdf_masks + ray_index, simd_u32_(0));
+            }
 
-                        simd_u32 denom_mask = compare_not_equal(denom, simd_f32_0);// if denom is not 0, 
-                        
-                        if(!all_lanes_zero(denom_mask))
-                        {
-                            // TODO(joon): We might just be dividing by 0... is this safe?
-                            simd_f32 hit_t = (dot(-plane_normal, ray_origin) - plane_d)/denom;
+            for(u32 bounce_index = 0;
+                    bounce_index < Raytracer_Max_Bounce_Count && stream->ray_count;
+                    ++bounce_index)
+            {
+                u32 bounce_dimension = Raytracer_Camera_Dimension_Count + bounce_index*Raytracer_Bounce_Dimension_Count;
 
-                            // TODO(joon): denom_mask might not be necessary?
-                            simd_u32 min_t_update_mask = denom_mask & compare_greater(hit_t, hit_t_threshold) & compare_less(hit_t, min_hit_t); 
+                if(bounce_index > 0)
+                {
+                    sort_wavefront_ray_stream(sorted_stream, stream, bounds_min, bounds_max);
 
-                            if(!all_lanes_zero(min_t_update_mask))
-                            {
-                                // NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
-                                min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
-                                next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
-                                next_normal = overwrite(next_normal, min_t_update_mask, plane_normal);
+                    WavefrontRayStream *temp = stream;
+                    stream = sorted_stream;
+                    sorted_stream = temp;
+                }
 
-                                simd_u32 this_plane_mat_index = simd_u32_(plane->material_index);
-                                hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_plane_mat_index);
-                            }
-                        }
+                // NOTE(joon) The rays that are still alive are written back to the same stream.
+                // The write index never passes the packet that we are reading from, so this is safe
+                u32 alive_ray_count = 0;
+                for(u32 ray_index = 0;
+                        ray_index < stream->ray_count;
+                        ray_index += HB_LANE_WIDTH)
+                {
+                    u32 lane_count = minimum(HB_LANE_WIDTH, stream->ray_count - ray_index);
+                    simd_u32 is_ray_alive_mask = simd_u32_max;
+                    if(lane_count < HB_LANE_WIDTH)
+                    {
+                        is_ray_alive_mask = get_first_lanes_mask(lane_count);
                     }
 
-                    for(u32 sphere_index = 0;
-                            sphere_index < world->sphere_count;
-                            ++sphere_index)
+                    simd_v3 ray_origin = simd_v3_load(stream->origin_x + ray_index, stream->origin_y + ray_index, stream->origin_z + ray_index);
+                    simd_v3 ray_dir = simd_v3_load(stream->dir_x + ray_index, stream->dir_y + ray_index, stream->dir_z + ray_index);
+                    simd_v3 attenuation = simd_v3_load(stream->attenuation_r + ray_index, stream->attenuation_g + ray_index, stream->attenuation_b + ray_index);
+                    simd_f32 bsdf_pdf = simd_f32_load(stream->bsdf_pdfs + ray_index);
+                    simd_u32 has_bsdf_pdf_mask = simd_u32_load(stream->has_bsdf_pdf_masks + ray_index);
+
+                    // NOTE(joon) The compaction below overwrites this packet inside the stream, so everything else that we need
+                    // from the stream should be read before that
+                    u32 lane_camera_ray_indices[HB_LANE_WIDTH];
+                    simd_u32_store(lane_camera_ray_indices, simd_u32_load(stream->camera_ray_indices + ray_index));
+                    start_wavefront_sampler_lanes(sampler, lane_camera_ray_indices, &camera_rays, data, chunk_pixel_start, bounce_dimension);
+
+                    // NOTE(joon) The stream is sorted by the bin, so the whole packet is inside the same bin when the first & the last ray are.
+                    // Those rays start from the same cell & go to the same octant, which is coherent enough for the packet traversal
+                    b32 is_packet_coherent = (bounce_index == 0) || (stream->bins[ray_index] == stream->bins[ray_index + lane_count - 1]);
+                    SimdRayIntersectResult hit = ray_intersect_with_raytracer_world(world, ray_origin, ray_dir, is_ray_alive_mask, !is_packet_coherent,
+                                                                                    simd_f32_(Flt_Max));
+                    simd_v3 next_ray_origin = hit.hit_p;
+
+                    // NOTE(joon): gathered lane by lane, so that this works for any lane width
+                    r32 emit_r[HB_LANE_WIDTH];
+                    r32 emit_g[HB_LANE_WIDTH];
+                    r32 emit_b[HB_LANE_WIDTH];
+                    r32 reflection_r[HB_LANE_WIDTH];
+                    r32 reflection_g[HB_LANE_WIDTH];
+                    r32 reflection_b[HB_LANE_WIDTH];
+                    r32 reflectivity[HB_LANE_WIDTH];
+                    u32 has_merl_brdf[HB_LANE_WIDTH];
+                    for(u32 lane = 0;
+                            lane < HB_LANE_WIDTH;
+                            ++lane)
                     {
-                        sphere *sphere = world->spheres + sphere_index;
-
-                        simd_v3 sphere_center = simd_V3(sphere->center);
+                        RaytracerMaterial *lane_hit_material = world->materials + get_lane(hit.hit_mat_index, lane);
 
-                        simd_f32 sphere_radius_square = simd_f32_(sphere->radius * sphere->radius);
-
-                        simd_v3 rel_ray_origin = ray_origin - sphere_center;
-                        // NOTE(joon): We are using a simplified version of the solutions for the quadratic formula
-                        // which is (-b +/ sqrt(b^2 - ac))/a, where b is half of the original b
-                        simd_f32 a = dot(ray_dir, ray_dir);
-                        simd_f32 b = dot(ray_dir, rel_ray_origin);
-                        simd_f32 c = dot(rel_ray_origin, rel_ray_origin) - sphere_radius_square;
-
-                        simd_f32 root_term = b*b - a*c;
-                        simd_u32 root_term_is_positive_mask = compare_greater_equal(root_term, simd_f32_0);
-
-                        if(!all_lanes_zero(root_term_is_positive_mask))
-                        {
-                            simd_f32 sqrt_root_term = sqrt(root_term);
+                        emit_r[lane] = lane_hit_material->emit_color.r;
+                        emit_g[lane] = lane_hit_material->emit_color.g;
+                        emit_b[lane] = lane_hit_material->emit_color.b;
 
-                            simd_f32 minus_b = -b;
-                            simd_f32 num0 = (-b - sqrt_root_term);
-                            simd_f32 num1 = (-b + sqrt_root_term);
+                        reflection_r[lane] = lane_hit_material->reflection_color.r;
+                        reflection_g[lane] = lane_hit_material->reflection_color.g;
+                        reflection_b[lane] = lane_hit_material->reflection_color.b;
 
-                            simd_f32 tn = (num0)/a;
-                            simd_f32 tp = (num1)/a;
+                        reflectivity[lane] = lane_hit_material->reflectivity;
+                        has_merl_brdf[lane] = (lane_hit_material->merl_brdf != 0);
+                    }
 
-                            simd_f32 hit_t = tp;
-                            // if tn is greater than the threshold & less than tp, we should replace tp with tn 
-                            simd_u32 hit_t_overwrite_mask = compare_greater(tn, hit_t_threshold) & compare_less(tn, tp);
-                            hit_t = overwrite(hit_t, hit_t_overwrite_mask, tn);
+                    simd_v3 hit_mat_emit_color = simd_v3_load(emit_r, emit_g, emit_b);
+                    simd_v3 hit_mat_reflection_color = simd_v3_load(reflection_r, reflection_g, reflection_b);
+                    simd_f32 hit_mat_reflectivity = simd_f32_load(reflectivity);
+                    simd_u32 hit_mat_has_merl_brdf_mask = is_lane_non_zero(simd_u32_load(has_merl_brdf));
 
-                            simd_u32 min_t_update_mask = compare_greater(hit_t, hit_t_threshold) & compare_less(hit_t, min_hit_t);
-                            if(!all_lanes_zero(min_t_update_mask))
-                            {
-                                min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
-                                next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
-                                next_normal = overwrite(next_normal, min_t_update_mask, next_ray_origin - sphere_center);
+                    bounced_ray_count += lane_count;
+                    result.bounce_lane_counts[bounce_index] += HB_LANE_WIDTH;
+                    result.bounce_alive_lane_counts[bounce_index] += lane_count;
 
-                                simd_u32 this_sphere_mat_index = simd_u32_(sphere->material_index);
-                                hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_sphere_mat_index);
-                            }
+                    if(data->features && bounce_index == 0)
+                    {
+                        simd_u32 is_hit_mask = is_lane_non_zero(hit.hit_mat_index);
+                        simd_v3 albedo = overwrite(hit_mat_emit_color, is_hit_mask, hit_mat_reflection_color);
+                        // NOTE(joon) same as the simd version, the NaNs of the lanes that didn't hit anything get overwritten
+                        simd_v3 normal = overwrite(simd_v3_(V3(0.0f, 0.0f, 0.0f)), is_hit_mask, normalize(hit.hit_normal));
+                        simd_f32 depth = overwrite(simd_f32_0, is_hit_mask, length(next_ray_origin - ray_origin));
+
+                        r32 lane_albedo_r[HB_LANE_WIDTH];
+                        r32 lane_albedo_g[HB_LANE_WIDTH];
+                        r32 lane_albedo_b[HB_LANE_WIDTH];
+                        r32 lane_normal_x[HB_LANE_WIDTH];
+                        r32 lane_normal_y[HB_LANE_WIDTH];
+                        r32 lane_normal_z[HB_LANE_WIDTH];
+                        r32 lane_depth[HB_LANE_WIDTH];
+                        simd_v3_store(lane_albedo_r, lane_albedo_g, lane_albedo_b, albedo);
+                        simd_v3_store(lane_normal_x, lane_normal_y, lane_normal_z, normal);
+                        simd_f32_store(lane_depth, depth);
+
+                        // NOTE(joon) all the camera rays are alive at the first bounce
+                        for(u32 lane = 0;
+                                lane < lane_count;
+                                ++lane)
+                        {
+                            u32 pixel_index = camera_rays.pixel_indices[lane_camera_ray_indices[lane]];
+                            feature_albedo_sums[pixel_index] += V3(lane_albedo_r[lane], lane_albedo_g[lane], lane_albedo_b[lane]);
+                            feature_normal_sums[pixel_index] += V3(lane_normal_x[lane], lane_normal_y[lane], lane_normal_z[lane]);
+                            feature_depth_sums[pixel_index] += lane_depth[lane];
+                            feature_ray_counts[pixel_index]++;
                         }
                     }
 
-                    for(u32 triangle_index = 0;
-                            triangle_index < world->triangle_count;
-                            ++triangle_index)
+                    // NOTE(joon) multiple importance sampling against the next event estimation, see the simd version
+                    simd_f32 emit_weight = simd_f32_(1.0f);
+                    simd_u32 mis_mask = is_ray_alive_mask & has_bsdf_pdf_mask & hit.is_light_primitive_mask;
+                    if(world->light_count && !all_lanes_zero(mis_mask))
                     {
-                        triangle *triangle = world->triangles + triangle_index;
-
-                        /*
-                           NOTE(joon) : 
-                           Moller-Trumbore line triangle intersection argorithm
-
-                           |t| =       1           |(T x E1) * E2|
-                           |u| = -------------  x  |(ray_dir x E2) * T |
-                           |v| = (ray_dir x E2)    |(T x E1) * ray_dir |
-
-                           where T = ray_origin - v0, E1 = v1 - v0, E2 = v2 - v0,
-                           ray  = ray_origin + t * ray_dir;
-
-                           u & v = barycentric coordinates of the triangle, as a triangle can be represented in a form of 
-                           (1 - u - v)*v0 + u*v1 + v*v2;
+                        simd_v3 to_hit = next_ray_origin - ray_origin;
+                        simd_f32 distance_square = dot(to_hit, to_hit);
+                        simd_f32 light_cos = dot(normalize(hit.hit_normal), to_hit) / sqrt(distance_square);
+                        light_cos = max(light_cos, -light_cos);
+
+                        simd_f32 light_pdf = dot(hit_mat_emit_color, simd_v3_(V3(0.2126f, 0.7152f, 0.0722f))) * 
+                                             simd_f32_(1.0f / world->total_light_power) * distance_square / light_cos;
+                        emit_weight = overwrite(emit_weight, mis_mask, get_mis_weight(bsdf_pdf, light_pdf));
+                    }
 
-                           Note that there are a lot of same cross products, which we can calculate just once and reuse
-                           v0, v1, v2 can be in any order
-                           */
-                        // TODO(joon): These ones don't need to be calculated as vector, we can just duplicate the result value 
-                        // This might help to not over-populate the port that has vector arithmetic function
+                    simd_v3 sample_color = emit_weight*(attenuation*hit_mat_emit_color);
 
-                        simd_v3 v0 = simd_V3(triangle->v0);
-                        simd_v3 v1 = simd_V3(triangle->v1);
-                        simd_v3 v2 = simd_V3(triangle->v2);
-                        
-                        simd_v3 e1 = v1 - v0;
-                        simd_v3 e2 = v2 - v0;
+                    is_ray_alive_mask = is_ray_alive_mask & is_lane_non_zero(hit.hit_mat_index);
+                    if(!all_lanes_zero(is_ray_alive_mask))
+                    {
+                        simd_v3 next_normal = normalize(hit.hit_normal);
+                        next_normal = overwrite(next_normal, compare_greater(dot(next_normal, ray_dir), simd_f32_0), -next_normal);
 
-                        simd_v3 cross_ray_e2 = cross(ray_dir, e2);
+                        simd_u32 is_measured_mask = is_ray_alive_mask & hit_mat_has_merl_brdf_mask;
+                        simd_u32 is_diffuse_mask = is_ray_alive_mask & ~hit_mat_has_merl_brdf_mask & compare_equal(hit_mat_reflectivity, simd_f32_0);
+                        simd_u32 is_reflecting_mask = compare_greater(dot(hit_mat_reflection_color, simd_v3_(V3(1.0f, 1.0f, 1.0f))), simd_f32_0);
+                        simd_u32 direct_light_mask = (is_diffuse_mask & is_reflecting_mask) | is_measured_mask;
 
-                        simd_f32 det = dot(cross_ray_e2, e1);
+                        // NOTE(joon) the camera rays are not normalized
+                        simd_v3 outgoing_dir = -normalize(ray_dir);
 
-                        // if the determinant is 0, it means the ray is parallel to the triangle
-                        simd_u32 det_is_non_zero_mask = compare_not_equal(det, simd_f32_0);
-                        if(!all_lanes_zero(det_is_non_zero_mask))
+                        if(world->light_count && !all_lanes_zero(direct_light_mask))
                         {
-                            simd_v3 T = ray_origin - v0;
-                            simd_v3 a = cross(T, e1);
-
-                            simd_f32 hit_t = dot(a, e2) / det;
-                            // NOTE(joon): barycentric coordinates of u and v, the last coordinate w = (1 - u - v)
-                            simd_f32 u = dot(cross_ray_e2, T) / det;
-                            simd_f32 v = dot(a, ray_dir) / det;
-
-                            simd_u32 min_t_update_mask = compare_greater_equal(hit_t, hit_t_threshold) & 
-                                                         compare_less(hit_t, min_hit_t) &
-                                                         compare_greater_equal(u, simd_f32_0) & 
-                                                         compare_greater_equal(v, simd_f32_0) & 
-                                                         compare_less_equal(u+v, simd_f32_1);
-
-                            if(!all_lanes_zero(min_t_update_mask))
+                            set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Light_Dimension);
+                            SimdLightSample light = sample_direct_lighting(world, sampler, next_ray_origin, next_normal, direct_light_mask);
+                            if(!all_lanes_zero(light.is_visible_mask))
                             {
-                                // NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
-                                min_hit_t = overwrite(min_hit_t, min_t_update_mask, hit_t);
-                                next_ray_origin = overwrite(next_ray_origin, min_t_update_mask, ray_origin + (hit_t*ray_dir));
-                                next_normal = overwrite(next_normal, min_t_update_mask, normalize(cross(e1, e2)));
-
-                                // TODO(joon): calculate normal based on the ray dir, so that the next normal is facing the incoming ray dir
-                                // otherwise, the reflection vector will be totally busted?
-                                simd_u32 this_triangle_mat_index = simd_u32_(triangle->material_index);
-                                hit_mat_index = overwrite(hit_mat_index, min_t_update_mask, this_triangle_mat_index);
+                                simd_f32 light_cos = dot(next_normal, light.dir);
+                                simd_v3 brdf_cos = (light_cos*simd_f32_(1.0f/pi_32))*hit_mat_reflection_color;
+                                simd_f32 light_bsdf_pdf = light_cos*simd_f32_(1.0f/pi_32);
+
+                                simd_u32 measured_light_mask = light.is_visible_mask & is_measured_mask;
+                                if(!all_lanes_zero(measured_light_mask))
+                                {
+                                    simd_v3 brdf = get_measured_brdf_value(world, hit.hit_mat_index, next_normal, outgoing_dir, light.dir, measured_light_mask);
+                                    brdf_cos = overwrite(brdf_cos, measured_light_mask, light_cos*brdf);
+                                    light_bsdf_pdf = overwrite(light_bsdf_pdf, measured_light_mask,
+                                                               get_measured_brdf_pdf(world, hit.hit_mat_index, next_normal, outgoing_dir, light.dir, measured_light_mask));
+                                }
+
+                                simd_v3 direct_light = get_mis_weight(light.light_pdf, light_bsdf_pdf)*(brdf_cos*light.radiance);
+                                sample_color = overwrite(sample_color, light.is_visible_mask, sample_color + attenuation*direct_light);
                             }
                         }
-                    }
-
 
-                    // TODO(joon): gatter / scatter?
-                    material *lane_0_hit_material = world->materials + get_lane(hit_mat_index, 0);
-                    material *lane_1_hit_material = world->materials + get_lane(hit_mat_index, 1);
-                    material *lane_2_hit_material = world->materials + get_lane(hit_mat_index, 2);
-                    material *lane_3_hit_material = world->materials + get_lane(hit_mat_index, 3);
-
-                    simd_v3 hit_mat_emit_color = simd_V3(lane_0_hit_material->emit_color,
-                                                          lane_1_hit_material->emit_color, 
-                                                          lane_2_hit_material->emit_color, 
-                                                          lane_3_hit_material->emit_color);
+                        simd_v3 perfect_reflection = normalize(ray_dir - simd_f32_2*dot(ray_dir, next_normal)*next_normal);
 
-                    simd_v3 hit_mat_reflection_color = simd_V3(lane_0_hit_material->reflection_color, 
-                                                                lane_1_hit_material->reflection_color, 
-                                                                lane_2_hit_material->reflection_color, 
-                                                                lane_3_hit_material->reflection_color);
+                        set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Bsdf_Dimension);
+                        simd_v3 random_reflection = normalize(next_normal + get_unit_vector(get_sample_2d(sampler)));
 
-                    simd_f32 hit_mat_reflectivity = simd_f32_(lane_0_hit_material->reflectivity, 
-                                                              lane_1_hit_material->reflectivity, 
-                                                              lane_2_hit_material->reflectivity, 
-                                                              lane_3_hit_material->reflectivity);
+                        simd_v3 next_ray_dir = lerp(random_reflection, hit_mat_reflectivity, perfect_reflection);
+                        simd_v3 next_attenuation = attenuation*hit_mat_reflection_color;
 
-                    bounced_ray_count += get_non_zero_lane_count_from_all_set_bit(is_ray_alive_mask);
+                        simd_u32 next_has_bsdf_pdf_mask = is_diffuse_mask;
+                        simd_f32 next_bsdf_pdf = dot(next_normal, next_ray_dir)*simd_f32_(1.0f/pi_32);
 
-                    // TODO(joon): cos?
-                    // TODO(joon): make overwrite_plus function?
-                    result_color = overwrite(result_color, is_ray_alive_mask, result_color + attenuation*hit_mat_emit_color); 
+                        // NOTE(joon) same as the simd version, the measured surfaces pick the direction from their own table
+                        if(!all_lanes_zero(is_measured_mask))
+                        {
+                            set_simd_sampler_dimension(sampler, bounce_dimension + Raytracer_Bsdf_Dimension);
+                            SimdBrdfSample brdf_sample = sample_measured_brdf(world, sampler, hit.hit_mat_index, next_normal, outgoing_dir, is_measured_mask);
+                            simd_u32 is_sampled_mask = is_measured_mask & compare_greater(brdf_sample.pdf, simd_f32_0);
+
+                            simd_v3 brdf = get_measured_brdf_value(world, hit.hit_mat_index, next_normal, outgoing_dir, brdf_sample.incoming_dir, is_sampled_mask);
+                            simd_f32 cos = dot(next_normal, brdf_sample.incoming_dir);
+                            next_attenuation = overwrite(next_attenuation, is_sampled_mask, (cos/brdf_sample.pdf)*(attenuation*brdf));
+                            next_ray_dir = overwrite(next_ray_dir, is_sampled_mask, brdf_sample.incoming_dir);
+                            next_bsdf_pdf = overwrite(next_bsdf_pdf, is_sampled_mask, brdf_sample.pdf);
+                            next_has_bsdf_pdf_mask = next_has_bsdf_pdf_mask | is_sampled_mask;
+
+                            // NOTE(joon) the lanes that could not get a sample are done, as they would not carry anything anyway
+                            is_ray_alive_mask = is_ray_alive_mask & ~(is_measured_mask & ~is_sampled_mask);
+                        }
 
-                    // NOTE(joon): update if the ray is still alive or dead
-                    simd_u32 mat_mask = is_lane_non_zero(hit_mat_index);
-                    is_ray_alive_mask = is_ray_alive_mask & mat_mask;
+                        // NOTE(joon) Compaction. Every lane is written to the next slot, but the slot only advances for the live ones
+                        // so that the dead rays get overwritten by the next live one(or ignored, if they were the last ones).
+                        // This has no branches that depend on the lanes, unlike going through the live lanes one by one
+                        r32 lane_origin_x[HB_LANE_WIDTH];
+                        r32 lane_origin_y[HB_LANE_WIDTH];
+                        r32 lane_origin_z[HB_LANE_WIDTH];
+                        r32 lane_dir_x[HB_LANE_WIDTH];
+                        r32 lane_dir_y[HB_LANE_WIDTH];
+                        r32 lane_dir_z[HB_LANE_WIDTH];
+                        r32 lane_attenuation_r[HB_LANE_WIDTH];
+                        r32 lane_attenuation_g[HB_LANE_WIDTH];
+                        r32 lane_attenuation_b[HB_LANE_WIDTH];
+                        r32 lane_bsdf_pdfs[HB_LANE_WIDTH];
+                        u32 lane_has_bsdf_pdf_masks[HB_LANE_WIDTH];
+                        u32 lane_is_alive[HB_LANE_WIDTH];
+                        simd_v3_store(lane_origin_x, lane_origin_y, lane_origin_z, next_ray_origin);
+                        simd_v3_store(lane_dir_x, lane_dir_y, lane_dir_z, next_ray_dir);
+                        simd_v3_store(lane_attenuation_r, lane_attenuation_g, lane_attenuation_b, next_attenuation);
+                        simd_f32_store(lane_bsdf_pdfs, next_bsdf_pdf);
+                        simd_u32_store(lane_has_bsdf_pdf_masks, next_has_bsdf_pdf_mask);
+                        simd_u32_store(lane_is_alive, is_ray_alive_mask & simd_u32_(1));
+
+                        for(u32 lane = 0;
+                                lane < lane_count;
+                                ++lane)
+                        {
+                            stream->origin_x[alive_ray_count] = lane_origin_x[lane];
+                            stream->origin_y[alive_ray_count] = lane_origin_y[lane];
+                            stream->origin_z[alive_ray_count] = lane_origin_z[lane];
+                            stream->dir_x[alive_ray_count] = lane_dir_x[lane];
+                            stream->dir_y[alive_ray_count] = lane_dir_y[lane];
+                            stream->dir_z[alive_ray_count] = lane_dir_z[lane];
+                            stream->attenuation_r[alive_ray_count] = lane_attenuation_r[lane];
+                            stream->attenuation_g[alive_ray_count] = lane_attenuation_g[lane];
+                            stream->attenuation_b[alive_ray_count] = lane_attenuation_b[lane];
+                            stream->bsdf_pdfs[alive_ray_count] = lane_bsdf_pdfs[lane];
+                            stream->has_bsdf_pdf_masks[alive_ray_count] = lane_has_bsdf_pdf_masks[lane];
+                            stream->camera_ray_indices[alive_ray_count] = lane_camera_ray_indices[lane];
+
+                            alive_ray_count += lane_is_alive[lane];
+                        }
+                    }
 
-                    if(all_lanes_zero(is_ray_alive_mask))
+                    r32 lane_color_r[HB_LANE_WIDTH];
+                    r32 lane_color_g[HB_LANE_WIDTH];
+                    r32 lane_color_b[HB_LANE_WIDTH];
+                    simd_v3_store(lane_color_r, lane_color_g, lane_color_b, sample_color);
+                    for(u32 lane = 0;
+                            lane < lane_count;
+                            ++lane)
                     {
-                        break;
+                        u32 camera_ray_index = lane_camera_ray_indices[lane];
+                        camera_rays.color_r[camera_ray_index] += lane_color_r[lane];
+                        camera_rays.color_g[camera_ray_index] += lane_color_g[lane];
+                        camera_rays.color_b[camera_ray_index] += lane_color_b[lane];
                     }
-                    else
-                    {
-                        attenuation = overwrite(attenuation, is_ray_alive_mask, attenuation*hit_mat_reflection_color);
-
-                        ray_origin = next_ray_origin;
-
-                        next_normal = normalize(next_normal);
-                        simd_v3 perfect_reflection = normalize(ray_dir - simd_f32_2*dot(ray_dir, next_normal)*next_normal);
-
-                        simd_v3 random = simd_V3(random_between_minus_1_1(series), random_between_minus_1_1(series), random_between_minus_1_1(series));
+                }
 
-                        simd_v3 random_reflection = normalize(next_normal + random);
+                stream->ray_count = alive_ray_count;
+            }
 
-                        ray_dir = lerp(random_reflection, hit_mat_reflectivity, perfect_reflection);
+            for(u32 camera_ray_index = 0;
+                    camera_ray_index < camera_rays.count;
+                    ++camera_ray_index)
+            {
+                u32 pixel_index = camera_rays.pixel_indices[camera_ray_index];
+                color_r[pixel_index] += camera_rays.color_r[camera_ray_index];
+                color_g[pixel_index] += camera_rays.color_g[camera_ray_index];
+                color_b[pixel_index] += camera_rays.color_b[camera_ray_index];
 
-                    }
+                if(data->accumulation)
+                {
+                    u32 tile_pixel_index = chunk_pixel_start + pixel_index;
+                    u32 x = data->min_x + tile_pixel_index % tile_width;
+                    u32 y = data->min_y + tile_pixel_index / tile_width;
+                    RaytracerPixelAccumulation *accumulation = data->accumulation + y*output_width + x;
+
+                    r32 luminance = 0.2126f*camera_rays.color_r[camera_ray_index] + 
+                                    0.7152f*camera_rays.color_g[camera_ray_index] + 
+                                    0.0722f*camera_rays.color_b[camera_ray_index];
+                    accumulation->luminance_sum += luminance;
+                    accumulation->luminance_square_sum += luminance*luminance;
+                    accumulation->ray_count++;
                 }
             }
-
-            result_color /= simd_f32_ray_per_pixel_count;
-
-            f32 result_r_f32 = linear_to_srgb(clamp01(add_all_lanes(result_color.r)));
-            f32 result_g_f32 = linear_to_srgb(clamp01(add_all_lanes(result_color.g)));
-            f32 result_b_f32 = linear_to_srgb(clamp01(add_all_lanes(result_color.b)));
-
-            u32 result_r = round_r32_u32(255.0f*result_r_f32) << 16;
-            u32 result_g = round_r32_u32(255.0f*result_g_f32) << 8;
-            u32 result_b =  round_r32_u32(255.0f*result_b_f32) << 0;
-
-            u32 result_pixel_color = 0xff << 24 |
-                                    result_r |
-                                    result_g |
-                                    result_b;
-
-            *pixel++ = result_pixel_color;
         }
 
-        row += output_width;
-    }
-
-    result.bounced_ray_count = bounced_ray_count;
-
-#if 0
-    // NOTE(joon): Draw tile boundary
-    {
-        u32 *row = pixels + min_y*output_width + min_x;
-        for(u32 y = min_y;
-                y < one_past_max_y;
-                ++y)
+        // NOTE(joon) the final colors of the pixels, which are then encoded in place
+        r32 inv_ray_per_pixel_count = 1.0f / (r32)ray_per_pixel_count;
+        for(u32 pixel_index = 0;
+                pixel_index < chunk_pixel_count;
+                ++pixel_index)
         {
-            u32 *pixel = row;
-            for(u32 x = min_x;
-                    x < one_past_max_x;
-                    ++x)
+            v3 pixel_color = inv_ray_per_pixel_count*V3(color_r[pixel_index], color_g[pixel_index], color_b[pixel_index]);
+            if(data->accumulation)
             {
-                if(y == min_y || y == one_past_max_y-1 || x == min_x || x == one_past_max_x - 1)
+                u32 tile_pixel_index = chunk_pixel_start + pixel_index;
+                u32 x = data->min_x + tile_pixel_index % tile_width;
+                u32 y = data->min_y + tile_pixel_index / tile_width;
+                RaytracerPixelAccumulation *accumulation = data->accumulation + y*output_width + x;
+
+                accumulation->color_sum += V3(color_r[pixel_index], color_g[pixel_index], color_b[pixel_index]);
+                pixel_color = V3(0.0f, 0.0f, 0.0f);
+                if(accumulation->ray_count)
                 {
-                    *pixel = 0xffff0000;
+                    pixel_color = accumulation->color_sum / (r32)accumulation->ray_count;
                 }
 
-                pixel++;
+                if(is_pixel_converged(accumulation, data->min_ray_per_pixel_count, data->max_relative_error))
+                {
+                    result.converged_pixel_count++;
+                }
             }
 
-            row += output_width;
-        }
-    }
-#endif
-
-    return result;
-}
+            if(data->features)
+            {
+                u32 tile_pixel_index = chunk_pixel_start + pixel_index;
+                u32 x = data->min_x + tile_pixel_index % tile_width;
+                u32 y = data->min_y + tile_pixel_index / tile_width;
+                RaytracerPixelFeature *feature = data->features + y*output_width + x;
 
-/*
-    NOTE(joon) voxel should be axis aligned!
-    Normal plane can be expressed in : N * P = d, where N being a normal and P being any point in plane.
+                feature->color = pixel_color;
+                if(feature_ray_counts[pixel_index])
+                {
+                    r32 inv_feature_ray_count = 1.0f / (r32)feature_ray_counts[pixel_index];
+                    feature->albedo = inv_feature_ray_count*feature_albedo_sums[pixel_index];
+                    // NOTE(joon) not normalized, see the simd version
+                    feature->normal = inv_feature_ray_count*feature_normal_sums[pixel_index];
+                    feature->depth = inv_feature_ray_count*feature_depth_sums[pixel_index];
+                }
+            }
 
-    Because the planes are axis aligned, we can also simplify the typical ray - plane intersection code.
-    For example, when we solve the equation above with a ray, we get t = (d - dot(N, O)) / dot(N, V).
-    Because the planes are axis aligned, the normals should be (1, 0, 0), (0, 1, 0), (0, 0, 1).
-    So tx = (Px - Ox) / Vx;
-    So ty = (Py - Oy) / Vy;
-    So tz = (Pz - Oz) / Vz;
+            color_r[pixel_index] = pixel_color.r;
+            color_g[pixel_index] = pixel_color.g;
+            color_b[pixel_index] = pixel_color.b;
+        }
 
-    to only get the 
-*/
+        // NOTE(joon) the chunk can start & end in the middle of a row, so it's encoded one piece of a row at a time
+        for(u32 pixel_index = 0;
+                pixel_index < chunk_pixel_count;
+                )
+        {
+            u32 tile_pixel_index = chunk_pixel_start + pixel_index;
+            u32 tile_x = tile_pixel_index % tile_width;
+            u32 x = data->min_x + tile_x;
+            u32 y = data->min_y + tile_pixel_index / tile_width;
+            u32 run_pixel_count = minimum(tile_width - tile_x, chunk_pixel_count - pixel_index);
 
-internal b32
-ray_intersect_with_slab(v3 p0, v3 p1, v3 ray_origin, v3 inv_ray_dir)
-{
-    b32 result = false;
+            encode_output_pixels(&data->output_encoding, color_r + pixel_index, color_g + pixel_index, color_b + pixel_index, 
+                                 1.0f, run_pixel_count, x, y, data->pixels + y*output_width + x);
 
-    v3 t0 = hadamard((p0 - ray_origin), inv_ray_dir); // each component represents t against the slab that is aligned for each axis
-    v3 t1 = hadamard((p1 - ray_origin), inv_ray_dir); // each component represents t against the slab that is aligned for each axis
+            pixel_index += run_pixel_count;
+        }
+    }
 
-    //result = max_component(t0) <= min_component(t1);
+    result.bounced_ray_count = bounced_ray_count;
 
     return result;
 }
@@ -737,12 +3182,12 @@ struct IntersectionTestResult
 };
 
  
-internal raytracer_output
-render_raytraced_image_tile(raytracer_data *data)
+internal RaytracerOutput
+render_raytraced_image_tile(RaytracerData *data)
 {
-    raytracer_output result = {};
+    RaytracerOutput result = {};
 
-    world *world = data->world;
+    RaytracerWorld *world = data->world;
     u32 *pixels = data->pixels; 
     u32 output_width = data->output_width; 
     u32 output_height = data->output_height;
@@ -762,10 +3207,7 @@ render_raytraced_image_tile(raytracer_data *data)
     u32 min_y = data->min_y; 
     u32 one_past_max_y = data->one_past_max_y;
 
-    // TODO(joon): Get rid of rand()
-    u32 random_seed = (u32)rand();
-    // TODO(joon): Put this inside the raytracer input structure
-    random_series series = start_random_series(random_seed); 
+    RandomSeries series = start_random_series(data->random_seed); 
 
     // TODO(joon): These values should be more realistic
     // for example, when we ever have a concept of an acutal senser size, 
@@ -816,7 +3258,7 @@ render_raytraced_image_tile(raytracer_data *data)
                 v3 attenuation = V3(1, 1, 1);
 
                 for(u32 bounce_index = 0;
-                        bounce_index < 8;
+                        bounce_index < Raytracer_Max_Bounce_Count;
                         ++bounce_index)
                 {
                     r32 min_hit_t = Flt_Max;
@@ -830,7 +3272,7 @@ render_raytraced_image_tile(raytracer_data *data)
                             plane_index < world->plane_count;
                             ++plane_index)
                     {
-                        plane *plane = world->planes + plane_index;
+                        RaytracerPlane *plane = world->planes + plane_index;
 
                         RayIntersectResult intersect_result = ray_intersect_with_plane(plane->normal, plane->d, ray_origin, ray_dir);
                         
@@ -849,7 +3291,7 @@ render_raytraced_image_tile(raytracer_data *data)
                             sphere_index < world->sphere_count;
                             ++sphere_index)
                     {
-                        sphere *sphere = world->spheres + sphere_index;
+                        RaytracerSphere *sphere = world->spheres + sphere_index;
 
                         RayIntersectResult intersect_result = ray_intersect_with_sphere(sphere->center, sphere->radius, ray_origin, ray_dir);
                         
@@ -867,7 +3309,7 @@ render_raytraced_image_tile(raytracer_data *data)
                             triangle_index < world->triangle_count;
                             ++triangle_index)
                     {
-                        triangle *triangle = world->triangles + triangle_index;
+                        RaytracerTriangle *triangle = world->triangles + triangle_index;
 
                         RayIntersectResult intersect_result = ray_intersect_with_triangle(triangle->v0, triangle->v1, triangle->v2, ray_origin, ray_dir);
                         
@@ -877,14 +3319,14 @@ render_raytraced_image_tile(raytracer_data *data)
                             min_hit_t = intersect_result.hit_t;
 
                             next_ray_origin = ray_origin + intersect_result.hit_t*ray_dir;
-                            next_normal = intersect_result.next_normal;
+                            next_normal = intersect_result.hit_normal;
                         }
                     }
 #endif
                     bounced_ray_count++;
                     if(hit_mat_index)
                     {
-                        material *hit_material = world->materials + hit_mat_index;
+                        RaytracerMaterial *hit_material = world->materials + hit_mat_index;
                         // TODO(joon): cos?
                         result_color += hadamard(attenuation, hit_material->emit_color); 
                         attenuation = hadamard(attenuation, hit_material->reflection_color);
@@ -916,9 +3358,9 @@ render_raytraced_image_tile(raytracer_data *data)
             result_color.b = linear_to_srgb(result_color.b);
 #endif
 
-            u32 result_r = round_r32_u32(255.0f*result_color.r) << 16;
-            u32 result_g = round_r32_u32(255.0f*result_color.g) << 8;
-            u32 result_b =  round_r32_u32(255.0f*result_color.b) << 0;
+            u32 result_r = round_r32_to_u32(255.0f*result_color.r) << 16;
+            u32 result_g = round_r32_to_u32(255.0f*result_color.g) << 8;
+            u32 result_b =  round_r32_to_u32(255.0f*result_color.b) << 0;
 
             u32 result_pixel_color = 0xff << 24 |
                                     result_r |
@@ -961,15 +3403,3 @@ render_raytraced_image_tile(raytracer_data *data)
 
     return result;
 }
-#endif
-
-
-
-
-
-
-
-
-
-
-
@@ -0,0 +1,309 @@
+#ifndef HB_RAY_H
+#define HB_RAY_H
+
+struct VoxelWorld;
+
+struct RaytracerMaterial
+{
+    r32 reflectivity; // 0.0f being very rough like a chalk, and 1 being really relfective(like mirror)
+    v3 emit_color; // things like sky, lightbulb have this value
+    v3 reflection_color;
+
+    // NOTE(joon) Optional measured brdf(see build_merl_brdf), which replaces the reflectivity & the reflection color
+    // for the rays that bounce off this material. The reflection color is still used as the albedo for the denoiser
+    MerlBrdf *merl_brdf;
+};
+
+// TODO(joon): SIMD these!
+struct RaytracerPlane
+{
+    r32 d;
+    v3 normal;
+
+    u32 material_index;
+};
+
+struct RaytracerSphere
+{
+    v3 center;
+    r32 radius;
+
+    u32 material_index;
+};
+
+struct RaytracerTriangle
+{
+    v3 v0;
+    v3 v1;
+    v3 v2;
+
+    u32 material_index;
+};
+
+enum RaytracerLightType
+{
+    RaytracerLightType_Triangle,
+    RaytracerLightType_Sphere,
+};
+
+/*
+   NOTE(joon) Emissive triangle or sphere, see build_raytracer_light_list. 
+   The lights are picked in proportion to their power(luminance of the emit color * area) using Vose's alias table,
+   where the light at index i is picked with alias_probability, and the light at alias_index otherwise.
+*/
+struct RaytracerLight
+{
+    RaytracerLightType type;
+    u32 primitive_index;
+
+    r32 alias_probability;
+    u32 alias_index;
+};
+
+struct RaytracerWorld
+{
+    RaytracerMaterial *materials;
+    u32 material_count;
+
+    RaytracerPlane *planes;
+    u32 plane_count;
+
+    RaytracerSphere *spheres;
+    u32 sphere_count;
+
+    RaytracerTriangle *triangles;
+    u32 triangle_count;
+    // NOTE(joon) should be built with build_bvh & build_wide_bvh whenever the triangles change
+    BVH bvh;
+    WideBVH wide_bvh;
+
+    // NOTE(joon) Optional, traced as it is instead of being turned into the triangles(see ray_intersect_with_voxel_world).
+    // The voxel (0, 0, 0) starts at voxel_world_p, and each voxel gets the material of its color id.
+    // The voxels are never in the light list, even when their material is emissive
+    VoxelWorld *voxel_world;
+    u8 *voxel_memory;
+    u32 *voxel_material_indices; // 256 of them, by the color id
+    v3 voxel_world_p;
+
+    // NOTE(joon) Used for the next event estimation, and should be built again whenever the triangles, spheres or the materials change.
+    // Emissive planes & the sky(material 0) are not in here, so the rays can only find them by hitting them
+    RaytracerLight *lights;
+    u32 light_count;
+    r32 total_light_power;
+
+    u32 total_tile_count;
+    volatile u32 rendered_tile_count;
+
+    volatile u64 total_ray_count;
+    volatile u64 bounced_ray_count;
+};
+
+struct RayIntersectResult
+{
+    // NOTE(joon): instead of having a boolean value inside the struct, this value will be initialized to a negative value
+    // and when we want to check if there was a hit, we just check if hit_t >= 0.0f 
+    r32 hit_t;
+
+    v3 hit_normal;
+};
+
+struct WideBVHHit
+{
+    // NOTE(joon) same as RayIntersectResult, negative when there was no hit
+    r32 hit_t;
+    v3 hit_normal;
+
+    u32 material_index;
+    u32 triangle_index;
+};
+
+/*
+   NOTE(joon) Two level bvh for the things that only move as a whole(i.e the rigid bodies).
+   Each mesh gets its own bvh(bottom level) once, in its local space. The top level bvh is built over the world space bounds
+   of the instances, so when the instances move, only the top level has to be built again(see update_raytracer_instance_world).
+   When the ray reaches an instance, it gets transformed into the local space of the instance and goes through the mesh bvh.
+*/
+struct RaytracerMesh
+{
+    // NOTE(joon) local space
+    RaytracerTriangle *triangles;
+    u32 triangle_count;
+
+    BVH bvh;
+    WideBVH wide_bvh;
+};
+
+struct RaytracerInstance
+{
+    u32 mesh_index;
+    // NOTE(joon) Not used by the bvh, whatever the user wants to find the owner of the instance with(i.e the entity index)
+    u32 user_index;
+
+    // NOTE(joon) local to world(i.e RigidBody.transform), should only be set with set_raytracer_instance_transform
+    // so that the inverse & the bounds stay in sync
+    m4x4 transform;
+    m4x4 inv_transform;
+
+    // NOTE(joon) world space bounds of the mesh bvh
+    v3 min;
+    v3 max;
+};
+
+struct RaytracerInstanceWorld
+{
+    RaytracerMesh *meshes;
+    u32 mesh_count;
+    u32 max_mesh_count;
+
+    RaytracerInstance *instances;
+    u32 instance_count;
+    u32 max_instance_count;
+
+    // NOTE(joon) top level bvh, where the primitives are the instances.
+    // The nodes are allocated once for max_instance_count, as this gets built again every frame
+    BVH bvh;
+};
+
+struct InstanceHit
+{
+    // NOTE(joon) same as RayIntersectResult, negative when there was no hit
+    r32 hit_t;
+    // NOTE(joon) world space & normalized
+    v3 hit_normal;
+
+    u32 instance_index;
+    u32 user_index;
+    u32 material_index;
+    u32 triangle_index;
+};
+
+struct MassAggHit
+{
+    // NOTE(joon) same as RayIntersectResult, negative when there was no hit
+    r32 hit_t;
+    v3 hit_normal;
+
+    u32 face_index;
+};
+
+// NOTE(joon) running sums of the samples that a pixel got so far, across the multiple frames
+struct RaytracerPixelAccumulation
+{
+    v3 color_sum;
+
+    // NOTE(joon) luminance of each sample, for the variance estimate. 
+    // r64, as the variance is the difference of these two, which loses all of the r32 precision after a lot of passes
+    r64 luminance_sum;
+    r64 luminance_square_sum;
+
+    u32 ray_count;
+};
+
+/*
+   NOTE(joon) Guides for the denoiser, from the first hit of the rays that the pixel got in the last call.
+   albedo is the reflection color of the first hit, or the emit color for the rays that didn't hit anything(material 0),
+   and the normal & depth are 0 for those rays.
+*/
+struct RaytracerPixelFeature
+{
+    // NOTE(joon) same color as the pixel, but linear & not clamped
+    v3 color;
+
+    v3 albedo;
+    v3 normal;
+    // NOTE(joon) distance from the camera
+    r32 depth;
+};
+
+enum ToneMapType
+{
+    // NOTE(joon) just clamped to 1
+    ToneMapType_None,
+    // NOTE(joon) c/(1 + c) per channel
+    ToneMapType_Reinhard,
+    // NOTE(joon) Narkowicz's fit of the ACES filmic curve
+    ToneMapType_ACES,
+};
+
+// NOTE(joon) How the linear colors become the 8 bit sRGB pixels, see encode_output_pixels. 
+// Zeroed is the plain clamp & sRGB encode
+struct OutputEncoding
+{
+    ToneMapType tone_map_type;
+    // NOTE(joon) in stops, applied before the tone map
+    r32 exposure;
+    // NOTE(joon) 4x4 ordered dither right before the quantization, which hides the banding of the dark gradients
+    b32 use_dithering;
+};
+
+struct RaytracerData
+{
+    RaytracerWorld *world;
+    u32 *pixels; 
+    u32 output_width; 
+    u32 output_height;
+    u32 ray_per_pixel_count;
+
+    v3 film_center; 
+    r32 film_width; 
+    r32 film_height;
+
+    v3 camera_p;
+    v3 camera_x_axis; 
+    v3 camera_y_axis; 
+    v3 camera_z_axis;
+
+    u32 min_x; 
+    u32 one_past_max_x;
+    u32 min_y; 
+    u32 one_past_max_y;
+
+    // NOTE(joon): plain u32 instead of a simd series, so that this struct has the same layout
+    // no matter which lane width the kernel was compiled with
+    u32 random_seed;
+
+    // NOTE(joon) see SimdSampler. The mask is only needed for the blue noise sampler, and should be shared by all the tiles.
+    // Unlike the random_seed, sampler_seed should stay the same across the passes of the accumulation,
+    // so that the sobol sequence of each pixel keeps going instead of starting over
+    SamplerType sampler_type;
+    u32 sampler_seed;
+    BlueNoiseMask *blue_noise_mask;
+
+    // NOTE(joon) see render_raytraced_image_tile_wavefront
+    b32 use_wavefront;
+
+    // NOTE(joon) Optional, output_width*output_height of them, and should be cleared whenever the camera or the world changes.
+    // If this exists, ray_per_pixel_count becomes the budget of rays that each pixel can get per frame,
+    // and the pixels stop getting more rays once the standard error of their mean luminance falls below max_relative_error*mean.
+    // The pixel color is the mean of all the rays so far, not just the ones from this frame
+    RaytracerPixelAccumulation *accumulation;
+    r32 max_relative_error;
+    // NOTE(joon) pixels are never considered converged with less rays than this, as the variance estimate is not reliable yet
+    u32 min_ray_per_pixel_count;
+
+    // NOTE(joon) Optional, output_width*output_height of them. 
+    // The pixels that didn't get any ray in this call(i.e already converged) keep their old features, except the color
+    RaytracerPixelFeature *features;
+
+    OutputEncoding output_encoding;
+};
+
+// NOTE(joon) none of the raytracers go deeper than this
+#define Raytracer_Max_Bounce_Count 8
+
+struct RaytracerOutput
+{
+    // NOTE(joon) every ray that went through the intersection test, including the camera rays
+    u64 bounced_ray_count;
+    u64 camera_ray_count;
+
+    // NOTE(joon) For each bounce, lanes of all the packets that went through the intersection test & the ones that were actually
+    // carrying a ray. The rest were dead lanes that the simd kernels had to drag along
+    u64 bounce_lane_counts[Raytracer_Max_Bounce_Count];
+    u64 bounce_alive_lane_counts[Raytracer_Max_Bounce_Count];
+
+    // NOTE(joon) only when there was an accumulation buffer. Once all pixels have converged, the render is done
+    u32 converged_pixel_count;
+};
+
+#endif
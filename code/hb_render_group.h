@@ -8,6 +8,7 @@
 // NOTE(joon) : This forces us to copy these datas again to the actual 'usable' vertex buffer,
 // but even with more than 100000 vertices, the size of it isn't too big 
 
+struct BakedLighting;
 struct RawMesh
 {
     v3 *positions;
@@ -27,6 +28,9 @@ struct RawMesh
 
     u32 *texcoord_indices;
     u32 texcoord_index_count;
+
+    // NOTE(joon) Optional, one per position. See bake_mesh_lighting
+    BakedLighting *baked_lighting;
 };
 
 struct Camera
@@ -50,6 +54,7 @@ enum RenderEntryType
     RenderEntryType_Line,
     RenderEntryType_Cube,
     RenderEntryType_Sphere,
+    RenderEntryType_Text,
 };
 
 // TODO(joon) Do we have enough reason to keep this header?
@@ -99,6 +104,49 @@ struct RenderEntrySphere
     v3 color;
 };
 
+// NOTE(joon) One per glyph, and the backend draws all of them as instanced quads in screen space.
+// Kept small on purpose, as the profiler overlays can easily push thousands of glyphs every frame
+struct TextGlyphInstance
+{
+    // NOTE(joon) top left corner of the quad, in pixels from the top left corner of the screen
+    i16 x;
+    i16 y;
+
+    // NOTE(joon) in texels, the quad has the same size as the glyph in the atlas
+    u16 atlas_x;
+    u16 atlas_y;
+    u16 width;
+    u16 height;
+
+    u32 color; // RGBA8, 0xAABBGGRR
+};
+
+struct font_info;
+
+// NOTE(joon) followed by TextGlyphInstance[glyph_count] and then u16 glyph_ids[glyph_count],
+// use get_render_entry_text_size to skip the whole entry
+struct RenderEntryText
+{
+    RenderEntryHeader header;
+
+    u32 glyph_count;
+
+    // NOTE(joon) only used by the game code, to put the glyphs back into the atlas 
+    // when the atlas was cleared later in the same frame
+    font_info *font;
+    u32 pixel_size;
+};
+
+internal inline u32
+get_render_entry_text_size(u32 glyph_count)
+{
+    u32 result = sizeof(RenderEntryText) + (sizeof(TextGlyphInstance) + sizeof(u16))*glyph_count;
+    // NOTE(joon) keep the next entry aligned
+    result = (result + 7) & ~7u;
+
+    return result;
+}
+
 #if 0
 struct RenderEntryParticleFaces
 {
@@ -113,6 +161,11 @@ struct RenderGroup
 {
     // NOTE(joon) provided by the platform layer
     PlatformRenderPushBuffer *render_push_buffer;
+
+    // NOTE(joon) offsets of the text entries that were pushed in this frame, see push_text
+    u32 text_entry_offsets[256];
+    u32 text_entry_count;
+    u32 text_atlas_clear_count;
 };
 
 // TODO(joon) move the shader related structs(i.e uniform) into seperate file? (hb_shader.h)
@@ -0,0 +1,431 @@
+internal void
+toggle_blue_noise_pixel(r32 *energies, u32 *is_set, r32 *gaussian, u32 pixel_index)
+{
+    u32 dim = Blue_Noise_Mask_Dim;
+    u32 pixel_x = pixel_index & (dim - 1);
+    u32 pixel_y = pixel_index >> Blue_Noise_Mask_Dim_Log2;
+
+    r32 sign = is_set[pixel_index] ? -1.0f : 1.0f;
+    is_set[pixel_index] = !is_set[pixel_index];
+
+    for(u32 y = 0;
+            y < dim;
+            ++y)
+    {
+        r32 *row = gaussian + ((y - pixel_y) & (dim - 1))*dim;
+        for(u32 x = 0;
+                x < dim;
+                ++x)
+        {
+            energies[y*dim + x] += sign*row[(x - pixel_x) & (dim - 1)];
+        }
+    }
+}
+
+// NOTE(joon) tightest cluster = the set pixel with the most energy, largest void = the empty pixel with the least energy
+internal u32
+find_blue_noise_pixel(r32 *energies, u32 *is_set, b32 find_tightest_cluster)
+{
+    u32 result = 0;
+    r32 best_energy = find_tightest_cluster ? -Flt_Max : Flt_Max;
+    for(u32 pixel_index = 0;
+            pixel_index < Blue_Noise_Mask_Dim*Blue_Noise_Mask_Dim;
+            ++pixel_index)
+    {
+        if(find_tightest_cluster)
+        {
+            if(is_set[pixel_index] && energies[pixel_index] > best_energy)
+            {
+                best_energy = energies[pixel_index];
+                result = pixel_index;
+            }
+        }
+        else
+        {
+            if(!is_set[pixel_index] && energies[pixel_index] < best_energy)
+            {
+                best_energy = energies[pixel_index];
+                result = pixel_index;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Void and cluster(Ulichney 1993). Starts from a few random pixels, moves them from the tightest cluster
+   to the largest void until they are evenly spread, and then ranks every pixel by the order that it would be removed
+   or inserted while keeping the pattern even. How tight each pixel is comes from a gaussian that wraps around the mask,
+   so that the mask can be tiled.
+   This is slow-ish(a few million adds), so the mask should be built once and shared.
+*/
+internal void
+build_blue_noise_mask(BlueNoiseMask *mask, MemoryArena *transient_arena, u32 seed)
+{
+    u32 dim = Blue_Noise_Mask_Dim;
+    u32 pixel_count = dim*dim;
+
+    TempMemory mask_memory = start_temp_memory(transient_arena, (4*sizeof(r32) + 3*sizeof(u32))*pixel_count + 1, false);
+    r32 *gaussian = push_array(&mask_memory, r32, pixel_count);
+    r32 *energies = push_array(&mask_memory, r32, pixel_count);
+    r32 *prototype_energies = push_array(&mask_memory, r32, pixel_count);
+    u32 *is_set = push_array(&mask_memory, u32, pixel_count);
+    u32 *prototype_is_set = push_array(&mask_memory, u32, pixel_count);
+    u32 *ranks = push_array(&mask_memory, u32, pixel_count);
+
+    // NOTE(joon) indexed with the offset between the pixels, wrapped around
+    r32 sigma = 1.5f;
+    for(u32 y = 0;
+            y < dim;
+            ++y)
+    {
+        for(u32 x = 0;
+                x < dim;
+                ++x)
+        {
+            r32 dx = (r32)minimum(x, dim - x);
+            r32 dy = (r32)minimum(y, dim - y);
+            gaussian[y*dim + x] = expf(-(dx*dx + dy*dy) / (2.0f*sigma*sigma));
+        }
+    }
+
+    zero_memory(energies, sizeof(r32)*pixel_count);
+    zero_memory(is_set, sizeof(u32)*pixel_count);
+
+    // NOTE(joon) about 10% of the pixels to start with
+    Pcg32 pcg = start_pcg32(seed, 0);
+    u32 set_count = 0;
+    while(set_count < pixel_count / 10)
+    {
+        u32 pixel_index = random_u32(&pcg) % pixel_count;
+        if(!is_set[pixel_index])
+        {
+            toggle_blue_noise_pixel(energies, is_set, gaussian, pixel_index);
+            set_count++;
+        }
+    }
+
+    while(1)
+    {
+        u32 cluster_index = find_blue_noise_pixel(energies, is_set, true);
+        toggle_blue_noise_pixel(energies, is_set, gaussian, cluster_index);
+
+        u32 void_index = find_blue_noise_pixel(energies, is_set, false);
+        toggle_blue_noise_pixel(energies, is_set, gaussian, void_index);
+
+        if(void_index == cluster_index)
+        {
+            break;
+        }
+    }
+
+    memcpy(prototype_energies, energies, sizeof(r32)*pixel_count);
+    memcpy(prototype_is_set, is_set, sizeof(u32)*pixel_count);
+
+    // NOTE(joon) the pixels of the prototype, by removing the tightest cluster one by one
+    for(u32 rank = set_count;
+            rank > 0;
+            --rank)
+    {
+        u32 cluster_index = find_blue_noise_pixel(energies, is_set, true);
+        toggle_blue_noise_pixel(energies, is_set, gaussian, cluster_index);
+        ranks[cluster_index] = rank - 1;
+    }
+
+    // NOTE(joon) and the rest, by filling the largest void one by one
+    memcpy(energies, prototype_energies, sizeof(r32)*pixel_count);
+    memcpy(is_set, prototype_is_set, sizeof(u32)*pixel_count);
+    for(u32 rank = set_count;
+            rank < pixel_count;
+            ++rank)
+    {
+        u32 void_index = find_blue_noise_pixel(energies, is_set, false);
+        toggle_blue_noise_pixel(energies, is_set, gaussian, void_index);
+        ranks[void_index] = rank;
+    }
+
+    for(u32 pixel_index = 0;
+            pixel_index < pixel_count;
+            ++pixel_index)
+    {
+        mask->values[pixel_index] = (ranks[pixel_index] + 0.5f) / pixel_count;
+    }
+
+    end_temp_memory(&mask_memory);
+}
+
+force_inline simd_u32
+reverse_bits(simd_u32 x)
+{
+    simd_u32 mask_1 = simd_u32_(0x55555555);
+    simd_u32 mask_2 = simd_u32_(0x33333333);
+    simd_u32 mask_4 = simd_u32_(0x0f0f0f0f);
+    simd_u32 mask_8 = simd_u32_(0x00ff00ff);
+
+    x = ((x >> 1) & mask_1) | ((x & mask_1) << 1);
+    x = ((x >> 2) & mask_2) | ((x & mask_2) << 2);
+    x = ((x >> 4) & mask_4) | ((x & mask_4) << 4);
+    x = ((x >> 8) & mask_8) | ((x & mask_8) << 8);
+    x = (x >> 16) | (x << 16);
+
+    return x;
+}
+
+// NOTE(joon) Each bit only depends on itself & the bits below it, which is what the Owen scrambling needs
+// once the bits are reversed(Laine & Karras 2011, with the constants from Burley 2020)
+force_inline simd_u32
+laine_karras_permutation(simd_u32 x, simd_u32 seed)
+{
+    x = x + seed;
+    x = x ^ (x*simd_u32_(0x6c50b47c));
+    x = x ^ (x*simd_u32_(0xb82f1e52));
+    x = x ^ (x*simd_u32_(0xc7afe638));
+    x = x ^ (x*simd_u32_(0x8d22f6e6));
+
+    return x;
+}
+
+force_inline simd_u32
+nested_uniform_scramble(simd_u32 x, simd_u32 seed)
+{
+    x = reverse_bits(x);
+    x = laine_karras_permutation(x, seed);
+    x = reverse_bits(x);
+
+    return x;
+}
+
+// NOTE(joon) Second dimension of the sobol sequence(the first one is just the reversed bits of the index).
+// Goes through the bits of the index until all lanes run out, so this is faster for the smaller indices
+force_inline simd_u32
+get_sobol_second_dimension(simd_u32 index)
+{
+    simd_u32 simd_u32_1 = simd_u32_(1);
+    simd_u32 result = simd_u32_(0);
+
+    u32 direction = 1u << 31;
+    while(!all_lanes_zero(index))
+    {
+        result = result ^ (simd_u32_(direction) & is_lane_non_zero(index & simd_u32_1));
+
+        index = index >> 1;
+        direction ^= direction >> 1;
+    }
+
+    return result;
+}
+
+// NOTE(joon) [0, 1), only using the top 24 bits so that the result never rounds up to 1
+force_inline simd_f32
+convert_unit_f32_from_u32(simd_u32 value)
+{
+    simd_f32 result = convert_f32_from_u32(value >> 8)*simd_f32_(1.0f / 16777216.0f);
+
+    return result;
+}
+
+// NOTE(joon) boost::hash_combine, with both of them going through the hash first
+force_inline u32
+combine_hashes(u32 a, u32 b)
+{
+    u32 result = hash_u32(a ^ (hash_u32(b) + 0x9e3779b9 + (a << 6) + (a >> 2)));
+
+    return result;
+}
+
+// NOTE(joon) simd version of the two above, for when the lanes are not in the same pixel
+force_inline simd_u32
+hash_u32(simd_u32 value)
+{
+    value = value ^ (value >> 16);
+    value = value*simd_u32_(0x85ebca6b);
+    value = value ^ (value >> 13);
+    value = value*simd_u32_(0xc2b2ae35);
+    value = value ^ (value >> 16);
+
+    return value;
+}
+
+force_inline simd_u32
+combine_hashes(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = hash_u32(a ^ (hash_u32(b) + simd_u32_(0x9e3779b9) + (a << 6) + (a >> 2)));
+
+    return result;
+}
+
+internal SimdSampler
+start_simd_sampler(SamplerType type, u32 seed, BlueNoiseMask *blue_noise_mask)
+{
+    assert(type != SamplerType_BlueNoiseSobol || blue_noise_mask);
+
+    SimdSampler result = {};
+    result.type = type;
+    result.seed = seed;
+    result.blue_noise_mask = blue_noise_mask;
+
+    u32 pcg_states[HB_LANE_WIDTH];
+    u32 pcg_increments[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        pcg_states[lane] = combine_hashes(seed, 2*lane);
+        pcg_increments[lane] = (combine_hashes(seed, 2*lane + 1) << 1) | 1;
+    }
+    result.pcg_state = simd_u32_load(pcg_states);
+    result.pcg_increment = simd_u32_load(pcg_increments);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Same as start_simd_sampler_pixel, but each lane can be a sample of a different pixel.
+   The wavefront raytracer uses this, as the rays of the different pixels get mixed inside the packets.
+   The lanes get exactly the same samples as they would have gotten from start_simd_sampler_pixel with the same pixel & sample index.
+*/
+internal void
+start_simd_sampler_lanes(SimdSampler *sampler, simd_u32 pixel_xs, simd_u32 pixel_ys, simd_u32 sample_indices)
+{
+    sampler->sample_indices = sample_indices;
+    sampler->pixel_xs = pixel_xs;
+    sampler->pixel_ys = pixel_ys;
+    sampler->dimension = 0;
+
+    if(sampler->type == SamplerType_Sobol)
+    {
+        sampler->pixel_seeds = combine_hashes(simd_u32_(sampler->seed), combine_hashes(pixel_xs, pixel_ys));
+    }
+    else
+    {
+        sampler->pixel_seeds = simd_u32_(sampler->seed);
+    }
+}
+
+/*
+   NOTE(joon) Should be called whenever the lanes start on a new set of samples.
+   first_sample_index is the index of the sample of the first lane inside the pixel, and the rest of the lanes get the ones after it.
+   It should keep going up across the calls for the same pixel, as the sobol sequence only gets better with more samples.
+*/
+internal void
+start_simd_sampler_pixel(SimdSampler *sampler, u32 pixel_x, u32 pixel_y, u32 first_sample_index)
+{
+    u32 lane_indices[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        lane_indices[lane] = first_sample_index + lane;
+    }
+
+    start_simd_sampler_lanes(sampler, simd_u32_(pixel_x), simd_u32_(pixel_y), simd_u32_load(lane_indices));
+}
+
+// NOTE(joon) so that the same kind of request always gets the same dimension, even if some of the requests were skipped
+internal void
+set_simd_sampler_dimension(SimdSampler *sampler, u32 dimension)
+{
+    sampler->dimension = dimension;
+}
+
+force_inline simd_u32
+get_next_pcg_u32(SimdSampler *sampler)
+{
+    simd_u32 state = sampler->pcg_state;
+    sampler->pcg_state = state*simd_u32_(747796405u) + sampler->pcg_increment;
+
+    simd_u32 word = ((state >> ((state >> 28) + simd_u32_(4))) ^ state)*simd_u32_(277803737u);
+    simd_u32 result = (word >> 22) ^ word;
+
+    return result;
+}
+
+// NOTE(joon) Cranley-Patterson rotation, where the whole sequence of the pixel gets shifted by the value of the mask.
+// Each dimension & each component looks up the mask at a different offset
+internal simd_f32
+rotate_by_blue_noise(SimdSampler *sampler, simd_f32 value, u32 offset)
+{
+    simd_u32 dim_mask = simd_u32_(Blue_Noise_Mask_Dim - 1);
+    simd_u32 mask_indices = (((sampler->pixel_ys + simd_u32_(offset >> 16)) & dim_mask) << Blue_Noise_Mask_Dim_Log2) | 
+                            ((sampler->pixel_xs + simd_u32_(offset)) & dim_mask);
+
+    // TODO(joon): gather?
+    r32 mask_values[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
+    {
+        mask_values[lane] = sampler->blue_noise_mask->values[get_lane(mask_indices, lane)];
+    }
+
+    simd_f32 simd_f32_1 = simd_f32_(1.0f);
+    simd_f32 result = value + simd_f32_load(mask_values);
+    result = overwrite(result, compare_greater_equal(result, simd_f32_1), result - simd_f32_1);
+
+    return result;
+}
+
+internal SimdSample2
+get_sample_2d(SimdSampler *sampler)
+{
+    SimdSample2 result = {};
+
+    if(sampler->type == SamplerType_Pcg)
+    {
+        result.x = convert_unit_f32_from_u32(get_next_pcg_u32(sampler));
+        result.y = convert_unit_f32_from_u32(get_next_pcg_u32(sampler));
+    }
+    else
+    {
+        simd_u32 dimension_seed = combine_hashes(sampler->pixel_seeds, simd_u32_(sampler->dimension));
+
+        // NOTE(joon) Shuffles the order of the samples, so that the dimensions don't get correlated with each other.
+        // The first dimension being the reversed bits of the index, its scramble is just the permutation
+        simd_u32 index = nested_uniform_scramble(sampler->sample_indices, dimension_seed);
+        simd_u32 x = reverse_bits(laine_karras_permutation(index, combine_hashes(dimension_seed, simd_u32_(1))));
+        simd_u32 y = nested_uniform_scramble(get_sobol_second_dimension(index), combine_hashes(dimension_seed, simd_u32_(2)));
+
+        result.x = convert_unit_f32_from_u32(x);
+        result.y = convert_unit_f32_from_u32(y);
+
+        if(sampler->type == SamplerType_BlueNoiseSobol)
+        {
+            u32 offset = combine_hashes(sampler->seed, sampler->dimension);
+            result.x = rotate_by_blue_noise(sampler, result.x, offset);
+            result.y = rotate_by_blue_noise(sampler, result.y, hash_u32(offset));
+        }
+    }
+
+    sampler->dimension++;
+
+    return result;
+}
+
+// NOTE(joon) same as the first component of get_sample_2d
+internal simd_f32
+get_sample_1d(SimdSampler *sampler)
+{
+    simd_f32 result = {};
+
+    if(sampler->type == SamplerType_Pcg)
+    {
+        result = convert_unit_f32_from_u32(get_next_pcg_u32(sampler));
+    }
+    else
+    {
+        simd_u32 dimension_seed = combine_hashes(sampler->pixel_seeds, simd_u32_(sampler->dimension));
+
+        simd_u32 index = nested_uniform_scramble(sampler->sample_indices, dimension_seed);
+        result = convert_unit_f32_from_u32(reverse_bits(laine_karras_permutation(index, combine_hashes(dimension_seed, simd_u32_(1)))));
+
+        if(sampler->type == SamplerType_BlueNoiseSobol)
+        {
+            result = rotate_by_blue_noise(sampler, result, combine_hashes(sampler->seed, sampler->dimension));
+        }
+    }
+
+    sampler->dimension++;
+
+    return result;
+}
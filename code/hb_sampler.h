@@ -0,0 +1,58 @@
+#ifndef HB_SAMPLER_H
+#define HB_SAMPLER_H
+
+/*
+    NOTE(joon) Where the simd raytracer gets its random numbers from, each lane being a different sample of the same pixel.
+    - Sobol : 2D Sobol sequence with the hash based Owen scrambling(Burley 2020). Every request(see get_sample_2d) uses the
+              first 2 dimensions of the sequence with its own scramble, which keeps each pair well stratified
+              without needing the higher dimensions that are not as good. Each pixel gets its own scramble.
+    - BlueNoiseSobol : Same as the Sobol, but all pixels share the scramble and get shifted by the blue noise mask instead,
+              so that the error of the neighbouring pixels is as different as possible. Looks much better with a few samples
+              per pixel, and the denoiser also likes it more.
+    - Pcg : Plain random numbers with a pcg stream per lane. Mostly to compare against.
+*/
+enum SamplerType
+{
+    SamplerType_Sobol,
+    SamplerType_BlueNoiseSobol,
+    SamplerType_Pcg,
+};
+
+#define Blue_Noise_Mask_Dim_Log2 6
+#define Blue_Noise_Mask_Dim (1 << Blue_Noise_Mask_Dim_Log2)
+
+// NOTE(joon) Tiled over the image, each value is between 0 & 1 with the same number of pixels for each value.
+// See build_blue_noise_mask
+struct BlueNoiseMask
+{
+    r32 values[Blue_Noise_Mask_Dim*Blue_Noise_Mask_Dim];
+};
+
+struct SimdSampler
+{
+    SamplerType type;
+    BlueNoiseMask *blue_noise_mask;
+    u32 seed;
+
+    // NOTE(joon) Pcg. 32 bit state per lane(pcg-rxs-m-xs), as the simd lanes don't have the 64 bit multiply.
+    // Each lane has its own stream
+    simd_u32 pcg_state;
+    simd_u32 pcg_increment;
+
+    // NOTE(joon) Sobol, set per pixel(or per lane, see start_simd_sampler_lanes). Index of each lane inside the sequence of its pixel
+    simd_u32 sample_indices;
+    simd_u32 pixel_seeds;
+    simd_u32 pixel_xs;
+    simd_u32 pixel_ys;
+
+    // NOTE(joon) each request uses a new one
+    u32 dimension;
+};
+
+struct SimdSample2
+{
+    simd_f32 x;
+    simd_f32 y;
+};
+
+#endif
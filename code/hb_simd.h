@@ -7,381 +7,63 @@
 
 // TODO(joon): Make seperate types for each lane with different size, or a safegurad that we can insert inside the function that tells 
 // that a certain function only works with specific size of lane
-#define HB_LANE_WIDTH 4 // NOTE(joon): Should be 1/4 for ARM, 1/4/8 for x86/64
+// NOTE(joon): Should be 1/4 for ARM, 1/4/8/16 for x86/64. Can be overriden from the command line(i.e -D HB_LANE_WIDTH=8),
+// and the code that uses this layer should never assume a specific lane width
+#ifndef HB_LANE_WIDTH
+#define HB_LANE_WIDTH 4
+#endif
+
+#if HB_ARM && HB_LANE_WIDTH > 4
+// TODO(joon): M1 pro does not support more that 128bit lane... 
+#error "ARM only supports up to 4 lanes"
+#endif
 
-#if HB_ARM
 //NOTE(joon): Gets rid of bl instructions
+#if HB_MSVC
+#define force_inline static __forceinline
+#else
 #define force_inline static inline __attribute__((always_inline))
+#endif
 
 #if HB_LANE_WIDTH == 4
+// NOTE(joon): NEON for ARM, SSE4.1 for x64
 #include "hb_simd_4x.h"
 
 #elif HB_LANE_WIDTH == 8
+// NOTE(joon): AVX2
+#include "hb_simd_8x.h"
 
-// TODO(joon): M1 pro does not support more that 128bit lane... 
-//#include "hb_simd_8x.h"
-#elif HB_LANE_WIDTH == 1
-
-typedef v3 simd_v3;
-typedef r32 simd_f32;
-typedef r32 simd_r32;
-typedef u32 simd_u32;
-typedef i32 simd_i32;
-
-#define simd_random_series random_series
-
-//////////////////// simd_u32 //////////////////// 
-force_inline simd_u32
-simd_u32_(u32 value)
-{
-    return value;
-}
-
-force_inline simd_u32
-simd_u32_load(u32 *ptr)
-{
-    simd_u32 result = *ptr;
-    return result;
-}
-
-force_inline u32
-get_lane(simd_u32 a, u32 lane)
-{
-    return a;
-}
-
-force_inline simd_f32
-convert_f32_from_u32(simd_u32 a)
-{
-    // TODO(joon): This might have potential sign bug!!!
-    return (simd_f32)a;
-}
-
-force_inline simd_u32
-compare_not_equal(simd_u32 a, simd_u32 b)
-{
-    simd_u32 result = 0;
-    if(a != b)
-    {
-        result = 0xffffffff;
-    }
-
-    return result;
-}
-
-force_inline simd_u32
-overwrite(simd_u32 dest, simd_u32 mask, simd_u32 source)
-{
-    simd_u32 result = {};
-
-    mask = (mask == 0) ? 0 : 0xffffffff;
-    result = (dest & (~mask)) | (source & mask);
-
-    return result;
-}
-
-force_inline simd_u32
-is_lane_non_zero(simd_u32 a)
-{
-    simd_u32 result = 0;
-
-    if(a != 0)
-    {
-        result = 0xffffffff;
-    }
-
-    return result;
-}
-
-force_inline u32
-get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
-{
-    u32 result = 0;
-
-    if(a != 0)
-    {
-        result = 1;
-    }
-
-    return result;
-}
-
-force_inline u32
-get_non_zero_lane_count(simd_u32 a)
-{
-    u32 result = 0;
-
-    if(a != 0)
-    {
-        result = 1;
-    }
-
-    return result;
-}
-
-force_inline b32
-all_lanes_zero(simd_u32 a)
-{
-    b32 result = false;
-
-    if(a == 0)
-    {
-        result = true;
-    }
-
-    return result;
-}
-
-//////////////////// simd_f32 //////////////////// 
-
-force_inline simd_f32
-simd_f32_(f32 value)
-{
-    return value;
-}
-
-force_inline simd_f32
-simd_f32_(f32 value0, f32 value1, f32 value2, f32 value3)
-{
-    return value0;
-}
-
-force_inline simd_f32
-simd_f32_load(f32 *ptr)
-{
-    simd_f32 result = *ptr;
-    return result;
-}
-
-force_inline f32
-get_lane(simd_f32 a, u32 lane)
-{
-    return a;
-}
-
-force_inline simd_u32
-compare_equal(simd_f32 a, simd_f32 b)
-{
-    simd_u32 result = 0;
-
-    // TODO(joon): This is a totally made up number
-    f32 epsilon = 0.00001f;
-    f32 diff = a-b;
-
-    if(diff > -epsilon && diff < epsilon)
-    {
-        result = 0xffffffff;
-    }
-
-    return result;
-}
-
-force_inline simd_u32
-compare_not_equal(simd_f32 a, simd_f32 b)
-{
-    simd_u32 result = 0;
-
-    result = (compare_equal(a, b) == 0) ? 0xffffffff : 0;
-
-    return result;
-}
-
-force_inline simd_u32
-compare_greater(simd_f32 a, simd_f32 b)
-{
-    simd_u32 result = 0;
-
-    if(a > b)
-    {
-        result = 0xffffffff;
-    }
-
-    return result;
-}
-
-// TODO(joon): Also add epsilon?
-force_inline simd_u32
-compare_greater_equal(simd_f32 a, simd_f32 b)
-{
-    simd_u32 result = 0;
-
-    if(a > b || compare_equal(a, b))
-    {
-        result = 0xffffffff;
-    }
+#elif HB_LANE_WIDTH == 16
+// NOTE(joon): AVX-512F
+#include "hb_simd_16x.h"
 
-    return result;
-}
+#elif HB_LANE_WIDTH == 1
+// NOTE(joon): Plain C, mostly for checking the other ones(see hb_simd_test.cpp)
+#include "hb_simd_1x.h"
 
-force_inline simd_u32
-compare_less(simd_f32 a, simd_f32 b)
-{
-    simd_u32 result = 0;
-    if(a < b)
-    {
-        result = 0xffffffff;
-    }
+#endif
 
-    return result;
-}
+///////////// codes that are common across different simd lane size should come here
 
+// NOTE(joon): Sets the first 'count' lanes, and clears the rest.
+// Used to mask out the lanes for the tail of a loop that is not a multiple of the lane width
 force_inline simd_u32
-compare_less_equal(simd_f32 a, simd_f32 b)
+get_first_lanes_mask(u32 count)
 {
-    simd_u32 result = 0;
-    if(a <= b)
+    u32 lanes[HB_LANE_WIDTH];
+    for(u32 lane = 0;
+            lane < HB_LANE_WIDTH;
+            ++lane)
     {
-        result = 0xffffffff;
+        lanes[lane] = (lane < count) ? 0xffffffff : 0;
     }
 
-    return result;
-}
-
-force_inline simd_f32
-overwrite(simd_f32 dest, simd_u32 mask, simd_f32 source)
-{
-    simd_f32 result = {};
-
-    mask = (mask == 0) ? 0 : 0xffffffff;
-
-    // TODO(joon): This is also prone to bug
-    simd_u32 result_u32 = (((*(simd_u32 *)&dest) & (~mask)) | ((*(simd_u32 *)&source) & mask));
-    result = *(simd_f32 *)&result_u32;
-
-    return result;
-}
-
-force_inline simd_f32
-add_all_lanes(simd_f32 a)
-{
-    return a;
-}
-
-//////////////////// simd_v3 //////////////////// 
-
-force_inline simd_v3
-simd_v3_()
-{
-    simd_v3 result = {};
-    return result;
-}
-
-force_inline simd_v3
-simd_v3_(v3 value)
-{
-    return value;
-}
-
-force_inline simd_v3
-simd_v3_(v3 value0, v3 value1, v3 value2, v3 value3)
-{
-    simd_v3 result = value0;
-
-    return result;
-}
-
-force_inline simd_v3
-simd_v3_(simd_f32 value0, simd_f32 value1, simd_f32 value2)
-{
-    simd_v3 result = {};
-
-    result.x = value0;
-    result.y = value1;
-    result.z = value2;
-
-    return result;
-}
-
-force_inline simd_v3
-operator*(simd_v3 a, simd_v3 b)
-{
-    simd_v3 result = {};
-
-    result.x = a.x * b.x;
-    result.y = a.y * b.y;
-    result.z = a.z * b.z;
-
-    return result;
-}
-
-force_inline simd_v3
-operator/(simd_v3 a, simd_v3 b)
-{
-    simd_v3 result = {};
-
-    result.x = a.x / b.x;
-    result.y = a.y / b.y;
-    result.z = a.z / b.z;
-
-    return result;
-}
-
-force_inline simd_v3
-min(simd_v3 a, simd_v3 b)
-{
-    simd_v3 result = {};
-    result.x = minimum(a.x, b.x);
-    result.y = minimum(a.y, b.y);
-    result.z = minimum(a.z, b.z);
-
-    return result;
-}
-
-force_inline simd_v3
-max(simd_v3 a, simd_v3 b)
-{
-    simd_v3 result = {};
-
-    result.x = maximum(a.x, b.x);
-    result.y = maximum(a.y, b.y);
-    result.z = maximum(a.z, b.z);
-
-    return result;
-}
-
-force_inline simd_f32
-min_component(simd_v3 a)
-{
-    simd_f32 result = minimum(minimum(a.x, a.y), a.z);
-
-    return result;
-}
-
-force_inline simd_f32
-max_component(simd_v3 a)
-{
-    simd_f32 result = maximum(maximum(a.x, a.y), a.z);
-
-    return result;
-}
-
-force_inline simd_v3
-overwrite(simd_v3 dest, simd_u32 mask, simd_v3 source)
-{
-    simd_v3 result = {};
-
-    mask = (mask == 0) ? 0 : 0xffffffff;
-
-    result.x = overwrite(dest.x, mask, source.x);
-    result.y = overwrite(dest.y, mask, source.y);
-    result.z = overwrite(dest.z, mask, source.z);
+    simd_u32 result = simd_u32_load(lanes);
 
     return result;
 }
 
-force_inline simd_random_series
-start_random_series(u32 seed0, u32 seed1, u32 seed2, u32 seed3)
-{
-    simd_random_series result = {};
-    result.next_random = simd_u32_(seed0);
-
-    return result;
-}
-
-#endif
-
-///////////// codes that are common across different simd lane size should come here
-
+#if HB_ARM
 
 // TODO(joon) : lane vs non-lane ARM SIMD
 // TODO(joon) : load simd aligned vs unaligned
@@ -0,0 +1,1098 @@
+#if HB_X64
+
+// NOTE(joon): AVX-512 version of hb_simd_4x.h, 512 bit wide lanes. Only uses AVX512F, so needs -mavx512f.
+// AVX-512 comparisons write to the mask registers instead of the vector lanes,
+// so they are expanded back to all 1 or 0 lanes to keep the API the same as the other versions
+#include <immintrin.h>
+
+struct simd_f32
+{
+    __m512 v;
+};
+
+struct simd_u32
+{
+    __m512i v;
+};
+
+struct simd_i32
+{
+    __m512i v;
+};
+
+struct simd_v3
+{
+    union
+    {
+        struct
+        {
+            __m512 x;
+            __m512 y;
+            __m512 z;
+        };
+
+        struct
+        {
+            __m512 r;
+            __m512 g;
+            __m512 b;
+        };
+        __m512 e[3];
+    };
+};
+
+struct simd_v3i
+{
+    __m512i x;
+    __m512i y;
+    __m512i z;
+};
+
+struct simd_v3u
+{
+    __m512i x;
+    __m512i y;
+    __m512i z;
+};
+
+force_inline __m512i
+expand_mask(__mmask16 mask)
+{
+    __m512i result = _mm512_maskz_mov_epi32(mask, _mm512_set1_epi32(-1));
+
+    return result;
+}
+
+// NOTE(joon): bitwise version of 'mask ? a : b', which is the same as the bit select in ARM
+force_inline __m512i
+bit_select(__m512i mask, __m512i a, __m512i b)
+{
+    __m512i result = _mm512_ternarylogic_epi32(mask, a, b, 0xca);
+
+    return result;
+}
+
+force_inline u32
+add_all_lanes(__m512i a)
+{
+    u32 result = (u32)_mm512_reduce_add_epi32(a);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(__m512 a)
+{
+    // NOTE(joon): Not _mm512_reduce_add_ps, which adds the halves first. 
+    // Same order as the 8x version, so that the result is bit exact with the narrower widths
+    __m512 sum = _mm512_add_ps(a, _mm512_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm512_add_ps(sum, _mm512_permute_ps(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    __m128 low = _mm_add_ss(_mm512_castps512_ps128(sum), _mm512_extractf32x4_ps(sum, 1));
+    __m128 high = _mm_add_ss(_mm512_extractf32x4_ps(sum, 2), _mm512_extractf32x4_ps(sum, 3));
+    f32 result = _mm_cvtss_f32(_mm_add_ss(low, high));
+
+    return result;
+}
+
+//////////////////// simd_u32 ////////////////////
+
+force_inline simd_u32
+simd_u32_(u32 dup)
+{
+    simd_u32 result = {};
+
+    result.v = _mm512_set1_epi32((i32)dup);
+
+    return result;
+}
+
+force_inline simd_u32
+simd_u32_load(u32 *ptr)
+{
+    simd_u32 result = {};
+    result.v = _mm512_loadu_si512(ptr);
+
+    return result;
+}
+
+// NOTE(joon): reading the lane through a casted pointer breaks the strict aliasing rule
+force_inline u32
+get_lane(simd_u32 a, u32 lane)
+{
+    u32 lanes[16];
+    _mm512_storeu_si512(lanes, a.v);
+
+    return lanes[lane];
+}
+
+force_inline void
+simd_u32_store(u32 *ptr, simd_u32 a)
+{
+    _mm512_storeu_si512(ptr, a.v);
+}
+
+// unary not opeartor
+force_inline simd_u32
+operator~(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = _mm512_xor_si512(a.v, _mm512_set1_epi32(-1));
+
+    return result;
+}
+
+force_inline simd_u32
+operator+(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_add_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator-(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_sub_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator*(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_mullo_epi32(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): Shifting by 32 or more clears the lanes, which is the same as the other versions
+force_inline simd_u32
+operator<<(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm512_sll_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+// NOTE(joon): logical shift, does not keep the sign bit
+force_inline simd_u32
+operator>>(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm512_srl_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+force_inline simd_u32
+operator|(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_or_si512(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator^(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_xor_si512(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): each lane gets shifted by the amount in the same lane, which should be less than 32
+force_inline simd_u32
+operator>>(simd_u32 a, simd_u32 shift_amounts)
+{
+    simd_u32 result = {};
+
+    result.v = _mm512_srlv_epi32(a.v, shift_amounts.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator&(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm512_and_si512(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): AVX-512 finally has the unsigned comparisons
+force_inline simd_u32
+compare_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmpeq_epu32_mask(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmpge_epu32_mask(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmpgt_epu32_mask(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmple_epu32_mask(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmplt_epu32_mask(a.v, b.v));
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_u32
+overwrite(simd_u32 dest, simd_u32 mask, simd_u32 source)
+{
+    simd_u32 result = {};
+
+    result.v = bit_select(mask.v, source.v, dest.v);
+
+    return result;
+}
+
+// NOTE(joon): Fills the mask lane with 1 if the lane has non-zero value
+// if not, fills with 0
+force_inline simd_u32
+is_lane_non_zero(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_test_epi32_mask(a.v, a.v));
+
+    return result;
+}
+
+force_inline u32
+add_all_lanes(simd_u32 a)
+{
+    u32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+// NOTE(joon): This only works if the lane is all 1 or 0
+force_inline u32
+get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
+{
+    u32 result = __builtin_popcount((u32)_mm512_test_epi32_mask(a.v, _mm512_set1_epi32((i32)0x80000000)));
+
+    return result;
+}
+
+force_inline u32
+get_non_zero_lane_count(simd_u32 a)
+{
+    u32 result = __builtin_popcount((u32)_mm512_test_epi32_mask(a.v, a.v));
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_u32 a)
+{
+    b32 result = (_mm512_test_epi32_mask(a.v, a.v) == 0);
+
+    return result;
+}
+
+//////////////////// simd_f32 ////////////////////
+
+force_inline simd_f32
+simd_f32_(r32 dup)
+{
+    simd_f32 result = {};
+    result.v = _mm512_set1_ps(dup);
+
+    return result;
+}
+
+force_inline simd_f32
+simd_f32_load(r32 *ptr)
+{
+    simd_f32 result = {};
+    result.v = _mm512_loadu_ps(ptr);
+
+    return result;
+}
+
+// NOTE(joon): Loads 'count' values and zeroes the rest of the lanes, so that we never read past the end of an array 
+// that is shorter than the lane width. The masked out lanes are never touched, so this does not fault either
+force_inline simd_f32
+simd_f32_load_first_lanes(r32 *ptr, u32 count)
+{
+    simd_f32 result = {};
+
+    __mmask16 mask = (__mmask16)((1u << count) - 1);
+    result.v = _mm512_maskz_loadu_ps(mask, ptr);
+
+    return result;
+}
+
+force_inline r32
+get_lane(simd_f32 a, u32 lane)
+{
+    r32 lanes[16];
+    _mm512_storeu_ps(lanes, a.v);
+
+    return lanes[lane];
+}
+
+// NOTE(joon): lane i = base[lane i of indices]. All lanes are loaded,
+// so the indices of the lanes that are not used should still point inside the array(i.e 0)
+force_inline simd_f32
+gather(r32 *base, simd_u32 indices)
+{
+    simd_f32 result = {};
+    result.v = _mm512_i32gather_ps(indices.v, base, sizeof(r32));
+
+    return result;
+}
+
+force_inline void
+simd_f32_store(r32 *ptr, simd_f32 a)
+{
+    _mm512_storeu_ps(ptr, a.v);
+}
+
+force_inline simd_f32
+operator+(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm512_add_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm512_sub_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a)
+{
+    // NOTE(joon): xor_ps is AVX512DQ, so flip the sign bit as an integer
+    a.v = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32((i32)0x80000000)));
+
+    return a;
+}
+
+force_inline simd_f32
+operator*(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm512_mul_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator/(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_div_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32 &
+operator+=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm512_add_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator-=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm512_sub_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator/=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm512_div_ps(a.v, b.v);
+
+    return a;
+}
+
+// NOTE(joon): cvttps_epu32 returns U32_Max for the values that are out of range,
+// so we only need to get rid of the negative values & NaN to match the ARM version
+force_inline simd_u32
+convert_u32_from_f32(simd_f32 value)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): max_ps returns the second operand if any of them is NaN
+    __m512 positive = _mm512_max_ps(value.v, _mm512_setzero_ps());
+    result.v = _mm512_cvttps_epu32(positive);
+
+    return result;
+}
+
+force_inline simd_f32
+convert_f32_from_u32(simd_u32 value)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_cvtepu32_ps(value.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a.v), mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator&(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a.v), mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a.v), _mm512_castps_si512(b.v)));
+
+    return result;
+}
+
+force_inline simd_f32
+sqrt(simd_f32 a)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_sqrt_ps(a.v);
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_f32
+overwrite(simd_f32 dest, simd_u32 mask, simd_f32 source)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_castsi512_ps(bit_select(mask.v, _mm512_castps_si512(source.v), _mm512_castps_si512(dest.v)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+force_inline simd_f32
+lerp(simd_f32 min, simd_f32 t, simd_f32 max)
+{
+    return min + t*(max-min);
+}
+
+force_inline simd_f32
+min(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_min_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+min_component(simd_f32 a)
+{
+    f32 result = _mm512_reduce_min_ps(a.v);
+
+    return result;
+}
+
+force_inline f32
+max_component(simd_f32 a)
+{
+    f32 result = _mm512_reduce_max_ps(a.v);
+
+    return result;
+}
+
+force_inline simd_f32
+max(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm512_max_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(simd_f32 a)
+{
+    f32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_f32 a)
+{
+    // NOTE(joon): -0.0f also counts as zero
+    b32 result = (_mm512_cmp_ps_mask(a.v, _mm512_setzero_ps(), _CMP_EQ_OQ) == 0xffff);
+
+    return result;
+}
+
+//////////////////// simd_v3 ////////////////////
+
+force_inline simd_v3
+simd_v3_(v3 dup)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_set1_ps(dup.x);
+    result.y = _mm512_set1_ps(dup.y);
+    result.z = _mm512_set1_ps(dup.z);
+
+    return result;
+}
+
+force_inline simd_v3
+simd_v3_(simd_f32 value0, simd_f32 value1, simd_f32 value2)
+{
+    simd_v3 result = {};
+
+    result.x = value0.v;
+    result.y = value1.v;
+    result.z = value2.v;
+
+    return result;
+}
+
+// NOTE(joon): This is a much more preferred version of loading in the data
+force_inline simd_v3
+simd_v3_load(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_loadu_ps(array_of_x);
+    result.y = _mm512_loadu_ps(array_of_y);
+    result.z = _mm512_loadu_ps(array_of_z);
+
+    return result;
+}
+
+// NOTE(joon): Mostly used for scattering the result lane by lane
+force_inline v3
+get_lane(simd_v3 a, u32 lane)
+{
+    r32 lanes_x[16];
+    r32 lanes_y[16];
+    r32 lanes_z[16];
+    _mm512_storeu_ps(lanes_x, a.x);
+    _mm512_storeu_ps(lanes_y, a.y);
+    _mm512_storeu_ps(lanes_z, a.z);
+
+    v3 result = {};
+    result.x = lanes_x[lane];
+    result.y = lanes_y[lane];
+    result.z = lanes_z[lane];
+
+    return result;
+}
+
+// NOTE(joon): Opposite of simd_v3_load, used for scattering the whole vector at once
+force_inline void
+simd_v3_store(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z, simd_v3 a)
+{
+    _mm512_storeu_ps(array_of_x, a.x);
+    _mm512_storeu_ps(array_of_y, a.y);
+    _mm512_storeu_ps(array_of_z, a.z);
+}
+
+force_inline simd_v3
+operator+(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_add_ps(a.x, b.x);
+    result.y = _mm512_add_ps(a.y, b.y);
+    result.z = _mm512_add_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+    result.x = _mm512_sub_ps(a.x, b.x);
+    result.y = _mm512_sub_ps(a.y, b.y);
+    result.z = _mm512_sub_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_mul_ps(a.x, b.x);
+    result.y = _mm512_mul_ps(a.y, b.y);
+    result.z = _mm512_mul_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_f32 value, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_mul_ps(value.v, b.x);
+    result.y = _mm512_mul_ps(value.v, b.y);
+    result.z = _mm512_mul_ps(value.v, b.z);
+
+    return result;
+}
+
+force_inline simd_v3 &
+operator*=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm512_mul_ps(v.x, value.v);
+    v.y = _mm512_mul_ps(v.y, value.v);
+    v.z = _mm512_mul_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator/=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm512_div_ps(v.x, value.v);
+    v.y = _mm512_div_ps(v.y, value.v);
+    v.z = _mm512_div_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator+=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm512_add_ps(v.x, value.v);
+    v.y = _mm512_add_ps(v.y, value.v);
+    v.z = _mm512_add_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_div_ps(a.x, b.x);
+    result.y = _mm512_div_ps(a.y, b.y);
+    result.z = _mm512_div_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_f32 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_div_ps(a.x, b.v);
+    result.y = _mm512_div_ps(a.y, b.v);
+    result.z = _mm512_div_ps(a.z, b.v);
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a)
+{
+    simd_f32 x = {a.x};
+    simd_f32 y = {a.y};
+    simd_f32 z = {a.z};
+
+    a.x = (-x).v;
+    a.y = (-y).v;
+    a.z = (-z).v;
+
+    return a;
+}
+
+force_inline simd_v3
+overwrite(simd_v3 dest, simd_u32 mask, simd_v3 source)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_castsi512_ps(bit_select(mask.v, _mm512_castps_si512(source.x), _mm512_castps_si512(dest.x)));
+    result.y = _mm512_castsi512_ps(bit_select(mask.v, _mm512_castps_si512(source.y), _mm512_castps_si512(dest.y)));
+    result.z = _mm512_castsi512_ps(bit_select(mask.v, _mm512_castps_si512(source.z), _mm512_castps_si512(dest.z)));
+
+    return result;
+}
+
+force_inline simd_v3
+lerp(simd_v3 min, simd_f32 t, simd_v3 max)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_add_ps(min.x, _mm512_mul_ps(t.v, _mm512_sub_ps(max.x, min.x)));
+    result.y = _mm512_add_ps(min.y, _mm512_mul_ps(t.v, _mm512_sub_ps(max.y, min.y)));
+    result.z = _mm512_add_ps(min.z, _mm512_mul_ps(t.v, _mm512_sub_ps(max.z, min.z)));
+
+    return result;
+}
+
+force_inline simd_f32
+dot(simd_v3 a, simd_v3 b)
+{
+    simd_v3 hadamard = a*b;
+
+    simd_f32 result = {};
+
+    result.v = _mm512_add_ps(_mm512_add_ps(hadamard.x, hadamard.y), hadamard.z);
+
+    return result;
+}
+
+force_inline simd_f32
+length_square(simd_v3 a)
+{
+    return dot(a, a);
+}
+
+force_inline simd_f32
+length(simd_v3 a)
+{
+    simd_f32 result = sqrt(length_square(a));
+
+    return result;
+}
+
+force_inline simd_v3
+normalize(simd_v3 a)
+{
+    simd_v3 result = a / length(a);
+
+    return result;
+}
+
+force_inline simd_v3
+cross(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_sub_ps(_mm512_mul_ps(a.y, b.z), _mm512_mul_ps(b.y, a.z));
+    result.y = _mm512_sub_ps(_mm512_mul_ps(b.x, a.z), _mm512_mul_ps(a.x, b.z));
+    result.z = _mm512_sub_ps(_mm512_mul_ps(a.x, b.y), _mm512_mul_ps(b.x, a.y));
+
+    return result;
+}
+
+force_inline simd_v3
+min(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_min_ps(a.x, b.x);
+    result.y = _mm512_min_ps(a.y, b.y);
+    result.z = _mm512_min_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+max(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm512_max_ps(a.x, b.x);
+    result.y = _mm512_max_ps(a.y, b.y);
+    result.z = _mm512_max_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_f32
+min_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm512_min_ps(_mm512_min_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline simd_f32
+max_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm512_max_ps(_mm512_max_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline v3
+add_all_lanes(simd_v3 a)
+{
+    v3 result = {};
+
+    result.x = add_all_lanes(a.x);
+    result.y = add_all_lanes(a.y);
+    result.z = add_all_lanes(a.z);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.x, b.x, _CMP_EQ_OQ) &
+                           _mm512_cmp_ps_mask(a.y, b.y, _CMP_EQ_OQ) &
+                           _mm512_cmp_ps_mask(a.z, b.z, _CMP_EQ_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.x, b.x, _CMP_GE_OQ) &
+                           _mm512_cmp_ps_mask(a.y, b.y, _CMP_GE_OQ) &
+                           _mm512_cmp_ps_mask(a.z, b.z, _CMP_GE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.x, b.x, _CMP_GT_OQ) &
+                           _mm512_cmp_ps_mask(a.y, b.y, _CMP_GT_OQ) &
+                           _mm512_cmp_ps_mask(a.z, b.z, _CMP_GT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.x, b.x, _CMP_LE_OQ) &
+                           _mm512_cmp_ps_mask(a.y, b.y, _CMP_LE_OQ) &
+                           _mm512_cmp_ps_mask(a.z, b.z, _CMP_LE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = expand_mask(_mm512_cmp_ps_mask(a.x, b.x, _CMP_LT_OQ) &
+                           _mm512_cmp_ps_mask(a.y, b.y, _CMP_LT_OQ) &
+                           _mm512_cmp_ps_mask(a.z, b.z, _CMP_LT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+//////////////////// random_series ////////////////////
+
+struct simd_random_series
+{
+    simd_u32 next_random;
+};
+
+force_inline void
+xor_shift_32(simd_u32 *next_random)
+{
+    simd_u32 x = *next_random;
+
+    x.v = _mm512_xor_si512(x.v, _mm512_slli_epi32(x.v, 13));
+    x.v = _mm512_xor_si512(x.v, _mm512_srli_epi32(x.v, 17));
+    x.v = _mm512_xor_si512(x.v, _mm512_srli_epi32(x.v, 5));
+
+    *next_random = x;
+}
+
+force_inline simd_random_series
+start_random_series(simd_u32 seed)
+{
+    simd_random_series result = {};
+    result.next_random = seed;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between_0_1(simd_random_series *series)
+{
+    xor_shift_32(&series->next_random);
+
+    simd_f32 max = simd_f32_((r32)U32_Max);
+
+    simd_f32 result = convert_f32_from_u32(series->next_random)/max;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between(simd_random_series *series, r32 min, r32 max)
+{
+    simd_f32 simd_min = simd_f32_(min);
+    simd_f32 simd_t = simd_f32_(max-min);
+
+    return simd_min + simd_t*random_between_0_1(series);
+}
+
+force_inline simd_f32
+random_between_minus_1_1(simd_random_series *series)
+{
+    simd_f32 simd_2 = simd_f32_(2.0f);
+    simd_f32 simd_1 = simd_f32_(1.0f);
+
+    simd_f32 result = (simd_2*random_between_0_1(series)) - simd_1;
+    return result;
+}
+
+#endif // #if HB_X64
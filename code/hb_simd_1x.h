@@ -0,0 +1,1086 @@
+// NOTE(joon): Scalar version of hb_simd_4x.h, which means only one lane.
+// Plain C, so it works on any platform, and the functions should behave exactly the same as the 4x version lane by lane
+// (see hb_simd_test.cpp). Mostly useful for checking the wider versions & debugging the simd code one lane at a time
+
+struct simd_f32
+{
+    r32 v;
+};
+
+struct simd_u32
+{
+    u32 v;
+};
+
+struct simd_i32
+{
+    i32 v;
+};
+
+struct simd_v3
+{
+    union
+    {
+        struct
+        {
+            r32 x;
+            r32 y;
+            r32 z;
+        };
+
+        struct
+        {
+            r32 r;
+            r32 g;
+            r32 b;
+        };
+        r32 e[3];
+    };
+};
+
+struct simd_v3i
+{
+    i32 x;
+    i32 y;
+    i32 z;
+};
+
+struct simd_v3u
+{
+    u32 x;
+    u32 y;
+    u32 z;
+};
+
+// NOTE(joon): the masks are bitwise, so the floats need to be treated as bits sometimes
+union SimdLaneBits
+{
+    r32 f;
+    u32 u;
+};
+
+force_inline u32
+get_bits(r32 a)
+{
+    SimdLaneBits bits = {};
+    bits.f = a;
+
+    return bits.u;
+}
+
+force_inline r32
+get_r32_from_bits(u32 a)
+{
+    SimdLaneBits bits = {};
+    bits.u = a;
+
+    return bits.f;
+}
+
+// NOTE(joon): same as the bit select in ARM, mask ? source : dest bit by bit
+force_inline u32
+bit_select(u32 mask, u32 source, u32 dest)
+{
+    u32 result = (dest & ~mask) | (source & mask);
+
+    return result;
+}
+
+// NOTE(joon): same as the ones that take the raw __m128(i) in the 4x version, for the raw lanes of simd_v3
+force_inline u32
+add_all_lanes(u32 a)
+{
+    return a;
+}
+
+force_inline f32
+add_all_lanes(r32 a)
+{
+    return a;
+}
+
+// NOTE(joon): The sse min/max return the second operand if any of them is NaN
+force_inline r32
+min_lane(r32 a, r32 b)
+{
+    r32 result = (a < b) ? a : b;
+
+    return result;
+}
+
+force_inline r32
+max_lane(r32 a, r32 b)
+{
+    r32 result = (a > b) ? a : b;
+
+    return result;
+}
+
+//////////////////// simd_u32 ////////////////////
+
+force_inline simd_u32
+simd_u32_(u32 dup)
+{
+    simd_u32 result = {};
+
+    result.v = dup;
+
+    return result;
+}
+
+force_inline simd_u32
+simd_u32_load(u32 *ptr)
+{
+    simd_u32 result = {};
+    result.v = *ptr;
+
+    return result;
+}
+
+force_inline u32
+get_lane(simd_u32 a, u32 lane)
+{
+    return a.v;
+}
+
+force_inline void
+simd_u32_store(u32 *ptr, simd_u32 a)
+{
+    *ptr = a.v;
+}
+
+// unary not opeartor
+force_inline simd_u32
+operator~(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = ~a.v;
+
+    return result;
+}
+
+force_inline simd_u32
+operator+(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v + b.v;
+
+    return result;
+}
+
+force_inline simd_u32
+operator-(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v - b.v;
+
+    return result;
+}
+
+force_inline simd_u32
+operator*(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v * b.v;
+
+    return result;
+}
+
+// NOTE(joon): Shifting by 32 or more clears the lane, same as the 4x version.
+// This is undefined in C, so it needs to be handled seperately
+force_inline simd_u32
+operator<<(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = (shift_amount < 32) ? (a.v << shift_amount) : 0;
+
+    return result;
+}
+
+// NOTE(joon): logical shift, does not keep the sign bit
+force_inline simd_u32
+operator>>(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = (shift_amount < 32) ? (a.v >> shift_amount) : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+operator|(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v | b.v;
+
+    return result;
+}
+
+force_inline simd_u32
+operator^(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v ^ b.v;
+
+    return result;
+}
+
+// NOTE(joon): each lane gets shifted by the amount in the same lane, which should be less than 32
+force_inline simd_u32
+operator>>(simd_u32 a, simd_u32 shift_amounts)
+{
+    simd_u32 result = {};
+
+    result.v = a.v >> shift_amounts.v;
+
+    return result;
+}
+
+force_inline simd_u32
+operator&(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = a.v & b.v;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v == b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v >= b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v > b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v <= b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v < b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+// NOTE(joon): bitwise, so the mask does not have to be all 1 or 0
+force_inline simd_u32
+overwrite(simd_u32 dest, simd_u32 mask, simd_u32 source)
+{
+    simd_u32 result = {};
+
+    result.v = bit_select(mask.v, source.v, dest.v);
+
+    return result;
+}
+
+// NOTE(joon): Fills the mask lane with 1 if the lane has non-zero value
+// if not, fills with 0
+force_inline simd_u32
+is_lane_non_zero(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v != 0) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline u32
+add_all_lanes(simd_u32 a)
+{
+    return a.v;
+}
+
+// NOTE(joon): This only works if the lane is all 1 or 0. Same as the 4x version, only looks at the top bit
+force_inline u32
+get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
+{
+    u32 result = (a.v >> 31);
+
+    return result;
+}
+
+force_inline u32
+get_non_zero_lane_count(simd_u32 a)
+{
+    u32 result = (a.v != 0) ? 1 : 0;
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_u32 a)
+{
+    b32 result = (a.v == 0);
+
+    return result;
+}
+
+//////////////////// simd_f32 ////////////////////
+
+force_inline simd_f32
+simd_f32_(r32 dup)
+{
+    simd_f32 result = {};
+    result.v = dup;
+
+    return result;
+}
+
+force_inline simd_f32
+simd_f32_load(r32 *ptr)
+{
+    simd_f32 result = {};
+    result.v = *ptr;
+
+    return result;
+}
+
+// NOTE(joon): Loads 'count' values and zeroes the rest of the lanes, so that we never read past the end of an array
+// that is shorter than the lane width
+force_inline simd_f32
+simd_f32_load_first_lanes(r32 *ptr, u32 count)
+{
+    simd_f32 result = {};
+    if(count != 0)
+    {
+        result.v = *ptr;
+    }
+
+    return result;
+}
+
+force_inline r32
+get_lane(simd_f32 a, u32 lane)
+{
+    return a.v;
+}
+
+// NOTE(joon): lane i = base[lane i of indices]
+force_inline simd_f32
+gather(r32 *base, simd_u32 indices)
+{
+    simd_f32 result = {};
+    result.v = base[indices.v];
+
+    return result;
+}
+
+force_inline void
+simd_f32_store(r32 *ptr, simd_f32 a)
+{
+    *ptr = a.v;
+}
+
+force_inline simd_f32
+operator+(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = a.v + b.v;
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = a.v - b.v;
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a)
+{
+    // NOTE(joon): same as multiplying by -1, but only flips the sign bit
+    a.v = get_r32_from_bits(get_bits(a.v) ^ 0x80000000);
+
+    return a;
+}
+
+force_inline simd_f32
+operator*(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = a.v * b.v;
+
+    return result;
+}
+
+force_inline simd_f32
+operator/(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = a.v / b.v;
+
+    return result;
+}
+
+force_inline simd_f32 &
+operator+=(simd_f32 &a, simd_f32 b)
+{
+    a.v += b.v;
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator-=(simd_f32 &a, simd_f32 b)
+{
+    a.v -= b.v;
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator/=(simd_f32 &a, simd_f32 b)
+{
+    a.v /= b.v;
+
+    return a;
+}
+
+// NOTE(joon): same as vcvtq_u32_f32 - rounds towards zero, negative values & NaN become 0,
+// and values that are too big saturate to U32_Max. Casting these in C is undefined, so they are handled first
+force_inline simd_u32
+convert_u32_from_f32(simd_f32 value)
+{
+    simd_u32 result = {};
+
+    if(value.v >= 4294967296.0f)
+    {
+        result.v = 0xffffffff;
+    }
+    else if(value.v > 0.0f)
+    {
+        result.v = (u32)value.v;
+    }
+
+    return result;
+}
+
+// NOTE(joon): u32 -> f32 only rounds once, same as vcvtq_f32_u32
+force_inline simd_f32
+convert_f32_from_u32(simd_u32 value)
+{
+    simd_f32 result = {};
+
+    result.v = (r32)value.v;
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = get_r32_from_bits(get_bits(a.v) | mask.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator&(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = get_r32_from_bits(get_bits(a.v) & mask.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = get_r32_from_bits(get_bits(a.v) | get_bits(b.v));
+
+    return result;
+}
+
+force_inline simd_f32
+sqrt(simd_f32 a)
+{
+    simd_f32 result = {};
+
+    result.v = sqrtf(a.v);
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_f32
+overwrite(simd_f32 dest, simd_u32 mask, simd_f32 source)
+{
+    simd_f32 result = {};
+
+    result.v = get_r32_from_bits(bit_select(mask.v, get_bits(source.v), get_bits(dest.v)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v == b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v >= b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v > b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v <= b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.v < b.v) ? 0xffffffff : 0;
+
+    return result;
+}
+
+// NOTE(joon): NaN is not equal to anything, so this is true for NaN
+force_inline simd_u32
+compare_not_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+force_inline simd_f32
+lerp(simd_f32 min, simd_f32 t, simd_f32 max)
+{
+    return min + t*(max-min);
+}
+
+force_inline simd_f32
+min(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = min_lane(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+min_component(simd_f32 a)
+{
+    return a.v;
+}
+
+force_inline f32
+max_component(simd_f32 a)
+{
+    return a.v;
+}
+
+force_inline simd_f32
+max(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = max_lane(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(simd_f32 a)
+{
+    return a.v;
+}
+
+force_inline b32
+all_lanes_zero(simd_f32 a)
+{
+    // NOTE(joon): -0.0f also counts as zero
+    b32 result = (a.v == 0.0f);
+
+    return result;
+}
+
+//////////////////// simd_v3 ////////////////////
+
+force_inline simd_v3
+simd_v3_(v3 dup)
+{
+    simd_v3 result = {};
+
+    result.x = dup.x;
+    result.y = dup.y;
+    result.z = dup.z;
+
+    return result;
+}
+
+force_inline simd_v3
+simd_v3_(simd_f32 value0, simd_f32 value1, simd_f32 value2)
+{
+    simd_v3 result = {};
+
+    result.x = value0.v;
+    result.y = value1.v;
+    result.z = value2.v;
+
+    return result;
+}
+
+force_inline simd_v3
+simd_v3_load(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z)
+{
+    simd_v3 result = {};
+
+    result.x = *array_of_x;
+    result.y = *array_of_y;
+    result.z = *array_of_z;
+
+    return result;
+}
+
+force_inline v3
+get_lane(simd_v3 a, u32 lane)
+{
+    v3 result = {};
+    result.x = a.x;
+    result.y = a.y;
+    result.z = a.z;
+
+    return result;
+}
+
+force_inline void
+simd_v3_store(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z, simd_v3 a)
+{
+    *array_of_x = a.x;
+    *array_of_y = a.y;
+    *array_of_z = a.z;
+}
+
+force_inline simd_v3
+operator+(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = a.x + b.x;
+    result.y = a.y + b.y;
+    result.z = a.z + b.z;
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+    result.x = a.x - b.x;
+    result.y = a.y - b.y;
+    result.z = a.z - b.z;
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = a.x * b.x;
+    result.y = a.y * b.y;
+    result.z = a.z * b.z;
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_f32 value, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = value.v * b.x;
+    result.y = value.v * b.y;
+    result.z = value.v * b.z;
+
+    return result;
+}
+
+force_inline simd_v3 &
+operator*=(simd_v3 &v, simd_f32 value)
+{
+    v.x *= value.v;
+    v.y *= value.v;
+    v.z *= value.v;
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator/=(simd_v3 &v, simd_f32 value)
+{
+    v.x /= value.v;
+    v.y /= value.v;
+    v.z /= value.v;
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator+=(simd_v3 &v, simd_f32 value)
+{
+    v.x += value.v;
+    v.y += value.v;
+    v.z += value.v;
+
+    return v;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = a.x / b.x;
+    result.y = a.y / b.y;
+    result.z = a.z / b.z;
+
+    return result;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_f32 b)
+{
+    simd_v3 result = {};
+
+    result.x = a.x / b.v;
+    result.y = a.y / b.v;
+    result.z = a.z / b.v;
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a)
+{
+    a.x = get_r32_from_bits(get_bits(a.x) ^ 0x80000000);
+    a.y = get_r32_from_bits(get_bits(a.y) ^ 0x80000000);
+    a.z = get_r32_from_bits(get_bits(a.z) ^ 0x80000000);
+
+    return a;
+}
+
+force_inline simd_v3
+overwrite(simd_v3 dest, simd_u32 mask, simd_v3 source)
+{
+    simd_v3 result = {};
+
+    result.x = get_r32_from_bits(bit_select(mask.v, get_bits(source.x), get_bits(dest.x)));
+    result.y = get_r32_from_bits(bit_select(mask.v, get_bits(source.y), get_bits(dest.y)));
+    result.z = get_r32_from_bits(bit_select(mask.v, get_bits(source.z), get_bits(dest.z)));
+
+    return result;
+}
+
+force_inline simd_v3
+lerp(simd_v3 min, simd_f32 t, simd_v3 max)
+{
+    simd_v3 result = {};
+
+    result.x = min.x + t.v*(max.x - min.x);
+    result.y = min.y + t.v*(max.y - min.y);
+    result.z = min.z + t.v*(max.z - min.z);
+
+    return result;
+}
+
+force_inline simd_f32
+dot(simd_v3 a, simd_v3 b)
+{
+    simd_v3 hadamard = a*b;
+
+    simd_f32 result = {};
+
+    result.v = (hadamard.x + hadamard.y) + hadamard.z;
+
+    return result;
+}
+
+force_inline simd_f32
+length_square(simd_v3 a)
+{
+    return dot(a, a);
+}
+
+force_inline simd_f32
+length(simd_v3 a)
+{
+    simd_f32 result = sqrt(length_square(a));
+
+    return result;
+}
+
+force_inline simd_v3
+normalize(simd_v3 a)
+{
+    simd_v3 result = a / length(a);
+
+    return result;
+}
+
+force_inline simd_v3
+cross(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = a.y*b.z - b.y*a.z;
+    result.y = b.x*a.z - a.x*b.z;
+    result.z = a.x*b.y - b.x*a.y;
+
+    return result;
+}
+
+force_inline simd_v3
+min(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = min_lane(a.x, b.x);
+    result.y = min_lane(a.y, b.y);
+    result.z = min_lane(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+max(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = max_lane(a.x, b.x);
+    result.y = max_lane(a.y, b.y);
+    result.z = max_lane(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_f32
+min_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = min_lane(min_lane(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline simd_f32
+max_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = max_lane(max_lane(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline v3
+add_all_lanes(simd_v3 a)
+{
+    v3 result = {};
+
+    result.x = a.x;
+    result.y = a.y;
+    result.z = a.z;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.x == b.x && a.y == b.y && a.z == b.z) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.x >= b.x && a.y >= b.y && a.z >= b.z) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.x > b.x && a.y > b.y && a.z > b.z) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.x <= b.x && a.y <= b.y && a.z <= b.z) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = (a.x < b.x && a.y < b.y && a.z < b.z) ? 0xffffffff : 0;
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+//////////////////// random_series ////////////////////
+
+struct simd_random_series
+{
+    simd_u32 next_random;
+};
+
+force_inline void
+xor_shift_32(simd_u32 *next_random)
+{
+    simd_u32 x = *next_random;
+
+    x.v ^= (x.v << 13);
+    x.v ^= (x.v >> 17);
+    x.v ^= (x.v >> 5);
+
+    *next_random = x;
+}
+
+// NOTE(joon): lane width independent version
+force_inline simd_random_series
+start_random_series(simd_u32 seed)
+{
+    simd_random_series result = {};
+    result.next_random = seed;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between_0_1(simd_random_series *series)
+{
+    xor_shift_32(&series->next_random);
+
+    simd_f32 max = simd_f32_((r32)U32_Max);
+
+    simd_f32 result = convert_f32_from_u32(series->next_random)/max;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between(simd_random_series *series, r32 min, r32 max)
+{
+    simd_f32 simd_min = simd_f32_(min);
+    simd_f32 simd_t = simd_f32_(max-min);
+
+    return simd_min + simd_t*random_between_0_1(series);
+}
+
+force_inline simd_f32
+random_between_minus_1_1(simd_random_series *series)
+{
+    simd_f32 simd_2 = simd_f32_(2.0f);
+    simd_f32 simd_1 = simd_f32_(1.0f);
+
+    simd_f32 result = (simd_2*random_between_0_1(series)) - simd_1;
+    return result;
+}
@@ -109,6 +109,12 @@ get_lane(simd_u32 a, u32 lane)
     return (((u32 *)&a)[lane]);
 }
 
+force_inline void
+simd_u32_store(u32 *ptr, simd_u32 a)
+{
+    vst1q_u32(ptr, a.v);
+}
+
 // unary not opeartor
 force_inline simd_u32
 operator~(simd_u32 a)
@@ -196,6 +202,27 @@ operator|(simd_u32 a, simd_u32 b)
     return result;
 }
 
+force_inline simd_u32
+operator^(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = veorq_u32(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): each lane gets shifted by the amount in the same lane, which should be less than 32
+force_inline simd_u32
+operator>>(simd_u32 a, simd_u32 shift_amounts)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): shifting left by a negative amount shifts right
+    result.v = vshlq_u32(a.v, vnegq_s32(vreinterpretq_s32_u32(shift_amounts.v)));
+
+    return result;
+}
+
 force_inline simd_u32
 operator&(simd_u32 a, simd_u32 b)
 {
@@ -307,14 +334,13 @@ get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
 
 // TODO(joon): Should be a magic intrinsic function
 // that does this for me
-// TODO(joon): This routine is not tested yet
 force_inline u32
 get_non_zero_lane_count(simd_u32 a)
 {
     u32 result = 0;
 
-    simd_u32 simd_u32_0 = simd_u32_(0);
-    result = add_all_lanes(~compare_equal(a, simd_u32_0))/8;
+    // NOTE(joon) adding up the raw masks overflows, so turn each non zero lane into 1 first
+    result = add_all_lanes(is_lane_non_zero(a) & simd_u32_(1));
 
     return result;
 }
@@ -322,7 +348,8 @@ get_non_zero_lane_count(simd_u32 a)
 force_inline b32
 all_lanes_zero(simd_u32 a)
 {
-    b32 result = !(add_all_lanes(a));
+    // NOTE(joon) adding up the lanes does not work here, as the lanes can sum up to 0 by overflowing
+    b32 result = !(vmaxvq_u32(a.v));
 
     return result;
 }
@@ -357,12 +384,65 @@ simd_f32_load(r32 *ptr)
     return result;
 }
 
+// NOTE(joon): Loads 'count' values and zeroes the rest of the lanes, so that we never read past the end of an array 
+// that is shorter than the lane width
+force_inline simd_f32
+simd_f32_load_first_lanes(r32 *ptr, u32 count)
+{
+    simd_f32 result = {};
+    if(count == 4)
+    {
+        result = simd_f32_load(ptr);
+    }
+    else
+    {
+        r32 lanes[4] = {};
+        for(u32 lane = 0;
+                lane < count;
+                ++lane)
+        {
+            lanes[lane] = ptr[lane];
+        }
+
+        result = simd_f32_load(lanes);
+    }
+
+    return result;
+}
+
 force_inline r32
 get_lane(simd_f32 a, u32 lane)
 {
     return (((r32 *)&a)[lane]);
 }
 
+// NOTE(joon): lane i = base[lane i of indices]. There is no gather instruction, so this is done lane by lane.
+// All lanes are loaded, so the indices of the lanes that are not used should still point inside the array(i.e 0)
+force_inline simd_f32
+gather(r32 *base, simd_u32 indices)
+{
+    u32 lane_indices[4];
+    simd_u32_store(lane_indices, indices);
+
+    r32 lanes[4];
+    for(u32 lane = 0;
+            lane < 4;
+            ++lane)
+    {
+        lanes[lane] = base[lane_indices[lane]];
+    }
+
+    simd_f32 result = simd_f32_load(lanes);
+
+    return result;
+}
+
+force_inline void
+simd_f32_store(r32 *ptr, simd_f32 a)
+{
+    vst1q_f32(ptr, a.v);
+}
+
 force_inline simd_f32
 operator+(simd_f32 a, simd_f32 b)
 {
@@ -639,7 +719,8 @@ add_all_lanes(simd_f32 a)
 force_inline b32
 all_lanes_zero(simd_f32 a)
 {
-    b32 result = !(add_all_lanes(a));
+    // NOTE(joon) same as the u32 version, 1 + -1 should not count as all lanes being zero
+    b32 result = !(vmaxvq_f32(vabsq_f32(a.v)));
 
     return result;
 }
@@ -705,6 +786,34 @@ simd_v3_load(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z)
     return result;
 }
 
+// NOTE(joon): Mostly used for scattering the result lane by lane
+force_inline v3
+get_lane(simd_v3 a, u32 lane)
+{
+    r32 lanes_x[4];
+    r32 lanes_y[4];
+    r32 lanes_z[4];
+    vst1q_f32(lanes_x, a.x);
+    vst1q_f32(lanes_y, a.y);
+    vst1q_f32(lanes_z, a.z);
+
+    v3 result = {};
+    result.x = lanes_x[lane];
+    result.y = lanes_y[lane];
+    result.z = lanes_z[lane];
+
+    return result;
+}
+
+// NOTE(joon): Opposite of simd_v3_load, used for scattering the whole vector at once
+force_inline void
+simd_v3_store(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z, simd_v3 a)
+{
+    vst1q_f32(array_of_x, a.x);
+    vst1q_f32(array_of_y, a.y);
+    vst1q_f32(array_of_z, a.z);
+}
+
 force_inline simd_v3
 operator+(simd_v3 a, simd_v3 b)
 {
@@ -1038,6 +1147,1203 @@ start_random_series(u32 seed0, u32 seed1, u32 seed2, u32 seed3)
     return result;
 }
 
+// NOTE(joon): lane width independent version
+force_inline simd_random_series
+start_random_series(simd_u32 seed)
+{
+    simd_random_series result = {};
+    result.next_random = seed;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between_0_1(simd_random_series *series)
+{
+    xor_shift_32(&series->next_random);
+
+    simd_f32 max = simd_f32_((r32)U32_Max);
+
+    simd_f32 result = convert_f32_from_u32(series->next_random)/max;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between(simd_random_series *series, r32 min, r32 max)
+{
+    simd_f32 simd_min = simd_f32_(min);
+    simd_f32 simd_t = simd_f32_(max-min);
+
+    return simd_min + simd_t*random_between_0_1(series);
+}
+
+force_inline simd_f32
+random_between_minus_1_1(simd_random_series *series)
+{
+    simd_f32 simd_2 = simd_f32_(2.0f);
+    simd_f32 simd_1 = simd_f32_(1.0f);
+
+    simd_f32 result = (simd_2*random_between_0_1(series)) - simd_1;
+    return result;
+}
+
+#elif HB_X64
+
+// NOTE(joon): SSE4.1 version of everything above, and should behave exactly the same lane by lane.
+// Needs -msse4.1(or anything newer), as the force_inlined functions cannot be inlined without it
+#include <smmintrin.h>
+
+struct simd_f32
+{
+    __m128 v;
+};
+
+struct simd_u32
+{
+    __m128i v;
+};
+
+struct simd_i32
+{
+    __m128i v;
+};
+
+struct simd_v3
+{
+    union
+    {
+        struct
+        {
+            __m128 x;
+            __m128 y;
+            __m128 z;
+        };
+
+        struct
+        {
+            __m128 r;
+            __m128 g;
+            __m128 b;
+        };
+        __m128 e[3];
+    };
+};
+
+struct simd_v3i
+{
+    __m128i x;
+    __m128i y;
+    __m128i z;
+};
+
+struct simd_v3u
+{
+    __m128i x;
+    __m128i y;
+    __m128i z;
+};
+
+force_inline u32
+add_all_lanes(__m128i a)
+{
+    // NOTE(joon): (0+2, 1+3, ...) and then (0+2+1+3, ...)
+    __m128i sum = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    u32 result = (u32)_mm_cvtsi128_si32(sum);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(__m128 a)
+{
+    // NOTE(joon): vaddvq_f32 adds the pairs first((0+1) + (2+3)), 
+    // so follow the same order to get the bit exact result
+    __m128 sum = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_add_ss(sum, _mm_movehl_ps(sum, sum));
+
+    f32 result = _mm_cvtss_f32(sum);
+
+    return result;
+}
+
+// NOTE(joon): SSE only has signed integer comparisons,
+// so flip the sign bit of both sides to compare them as unsigned
+force_inline __m128i
+flip_sign_bit(__m128i a)
+{
+    __m128i result = _mm_xor_si128(a, _mm_set1_epi32((i32)0x80000000));
+
+    return result;
+}
+
+//////////////////// simd_u32 ////////////////////
+
+force_inline simd_u32
+simd_u32_(u32 dup)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_set1_epi32((i32)dup);
+
+    return result;
+}
+
+force_inline simd_u32
+simd_u32_(u32 value0, u32 value1, u32 value2, u32 value3)
+{
+    simd_u32 result = {};
+    
+    // NOTE(joon): _mm_set_epi32 takes the values in reverse order
+    result.v = _mm_setr_epi32((i32)value0, (i32)value1, (i32)value2, (i32)value3);
+
+    return result;
+}
+
+force_inline simd_u32
+simd_u32_load(u32 *ptr)
+{
+    simd_u32 result = {};
+    result.v = _mm_loadu_si128((__m128i *)ptr);
+
+    return result;
+}
+
+// NOTE(joon): reading the lane through a casted pointer breaks the strict aliasing rule,
+// and gcc happily optimizes the read away
+force_inline u32
+get_lane(simd_u32 a, u32 lane)
+{
+    u32 lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, a.v);
+
+    return lanes[lane];
+}
+
+force_inline void
+simd_u32_store(u32 *ptr, simd_u32 a)
+{
+    _mm_storeu_si128((__m128i *)ptr, a.v);
+}
+
+// unary not opeartor
+force_inline simd_u32
+operator~(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_xor_si128(a.v, _mm_set1_epi32(-1));
+
+    return result;
+}
+
+force_inline simd_u32
+operator+(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm_add_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator-(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm_sub_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator*(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    // NOTE(joon): low 32 bits of the product, which is the same for both signed and unsigned
+    result.v = _mm_mullo_epi32(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): Unlike ARM, intel has a shift instruction that takes the shift amount from a register.
+// Shifting by 32 or more clears the lanes, which is the same as the ARM version
+force_inline simd_u32
+operator<<(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_sll_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+// NOTE(joon): logical shift, does not keep the sign bit
+force_inline simd_u32
+operator>>(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_srl_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+force_inline simd_u32
+operator|(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm_or_si128(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator^(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm_xor_si128(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): each lane gets shifted by the amount in the same lane, which should be less than 32
+force_inline simd_u32
+operator>>(simd_u32 a, simd_u32 shift_amounts)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): SSE does not have a per lane shift, which came with AVX2
+    u32 lanes[4];
+    u32 lane_shift_amounts[4];
+    simd_u32_store(lanes, a);
+    simd_u32_store(lane_shift_amounts, shift_amounts);
+    for(u32 lane = 0;
+            lane < 4;
+            ++lane)
+    {
+        lanes[lane] >>= lane_shift_amounts[lane];
+    }
+    result = simd_u32_load(lanes);
+
+    return result;
+}
+
+force_inline simd_u32
+operator&(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm_and_si128(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_cmpeq_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): a >= b if max(a, b) == a
+    result.v = _mm_cmpeq_epi32(_mm_max_epu32(a.v, b.v), a.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_cmpgt_epi32(flip_sign_bit(a.v), flip_sign_bit(b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_cmpeq_epi32(_mm_min_epu32(a.v, b.v), a.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_cmplt_epi32(flip_sign_bit(a.v), flip_sign_bit(b.v));
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_u32
+overwrite(simd_u32 dest, simd_u32 mask, simd_u32 source)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_or_si128(_mm_andnot_si128(mask.v, dest.v), _mm_and_si128(mask.v, source.v));
+
+    return result;
+}
+
+// NOTE(joon): Fills the mask lane with 1 if the lane has non-zero value
+// if not, fills with 0
+force_inline simd_u32
+is_lane_non_zero(simd_u32 a)
+{
+    simd_u32 result = {};
+    
+    simd_u32 simd_u32_0 = simd_u32_(0);
+    result = ~compare_equal(a, simd_u32_0);
+
+    return result;
+}
+
+force_inline u32
+add_all_lanes(simd_u32 a)
+{
+    u32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+// NOTE(joon): This only works if the lane is all 1 or 0
+force_inline u32
+get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
+{
+    // NOTE(joon): one bit per lane, from the sign bits. popcnt is not part of SSE4.1, so just add them up
+    u32 mask = (u32)_mm_movemask_ps(_mm_castsi128_ps(a.v));
+    u32 result = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+
+    return result;
+}
+
+force_inline u32
+get_non_zero_lane_count(simd_u32 a)
+{
+    u32 result = get_non_zero_lane_count_from_all_set_bit(is_lane_non_zero(a));
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_u32 a)
+{
+    b32 result = _mm_testz_si128(a.v, a.v);
+
+    return result;
+}
+
+//////////////////// simd_f32 //////////////////// 
+
+force_inline simd_f32
+simd_f32_(r32 dup)
+{
+    simd_f32 result = {};
+    result.v = _mm_set1_ps(dup);
+
+    return result;
+}
+
+force_inline simd_f32
+simd_f32_(r32 value0, r32 value1, r32 value2, r32 value3)
+{
+    // TODO(joon): I assume that instead of using this path, it's much better to structure some kind of SOA
+    simd_f32 result = {};
+    result.v = _mm_setr_ps(value0, value1, value2, value3);
+
+    return result;
+}
+
+force_inline simd_f32
+simd_f32_load(r32 *ptr)
+{
+    simd_f32 result = {};
+    result.v = _mm_loadu_ps(ptr);
+
+    return result;
+}
+
+// NOTE(joon): Loads 'count' values and zeroes the rest of the lanes, so that we never read past the end of an array 
+// that is shorter than the lane width
+force_inline simd_f32
+simd_f32_load_first_lanes(r32 *ptr, u32 count)
+{
+    simd_f32 result = {};
+    if(count == 4)
+    {
+        result = simd_f32_load(ptr);
+    }
+    else
+    {
+        r32 lanes[4] = {};
+        for(u32 lane = 0;
+                lane < count;
+                ++lane)
+        {
+            lanes[lane] = ptr[lane];
+        }
+
+        result = simd_f32_load(lanes);
+    }
+
+    return result;
+}
+
+force_inline r32
+get_lane(simd_f32 a, u32 lane)
+{
+    r32 lanes[4];
+    _mm_storeu_ps(lanes, a.v);
+
+    return lanes[lane];
+}
+
+// NOTE(joon): lane i = base[lane i of indices]. There is no gather instruction, so this is done lane by lane.
+// All lanes are loaded, so the indices of the lanes that are not used should still point inside the array(i.e 0)
+force_inline simd_f32
+gather(r32 *base, simd_u32 indices)
+{
+    u32 lane_indices[4];
+    simd_u32_store(lane_indices, indices);
+
+    r32 lanes[4];
+    for(u32 lane = 0;
+            lane < 4;
+            ++lane)
+    {
+        lanes[lane] = base[lane_indices[lane]];
+    }
+
+    simd_f32 result = simd_f32_load(lanes);
+
+    return result;
+}
+
+force_inline void
+simd_f32_store(r32 *ptr, simd_f32 a)
+{
+    _mm_storeu_ps(ptr, a.v);
+}
+
+force_inline simd_f32
+operator+(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm_add_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm_sub_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a)
+{
+    // NOTE(joon): same as multiplying by -1, but only flips the sign bit
+    a.v = _mm_xor_ps(a.v, _mm_set1_ps(-0.0f));
+
+    return a;
+}
+
+force_inline simd_f32
+operator*(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm_mul_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator/(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_div_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32 &
+operator+=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm_add_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator-=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm_sub_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator/=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm_div_ps(a.v, b.v);
+
+    return a;
+}
+
+// NOTE(joon): SSE only has the signed conversion, so this mimics vcvtq_u32_f32 -
+// rounds towards zero, negative values & NaN become 0, and values that are too big saturate to U32_Max
+force_inline simd_u32
+convert_u32_from_f32(simd_f32 value)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): max_ps returns the second operand if any of them is NaN
+    __m128 positive = _mm_max_ps(value.v, _mm_setzero_ps());
+
+    __m128 two_pow_31 = _mm_set1_ps(2147483648.0f);
+    __m128 high_mask = _mm_cmpge_ps(positive, two_pow_31);
+    __m128 overflow_mask = _mm_cmpge_ps(positive, _mm_set1_ps(4294967296.0f));
+
+    // NOTE(joon): values that are bigger than 2^31 are converted after subtracting 2^31,
+    // and then get the top bit back
+    __m128i low = _mm_cvttps_epi32(_mm_sub_ps(positive, _mm_and_ps(high_mask, two_pow_31)));
+    result.v = _mm_xor_si128(low, _mm_slli_epi32(_mm_castps_si128(high_mask), 31));
+    result.v = _mm_or_si128(result.v, _mm_castps_si128(overflow_mask));
+
+    return result;
+}
+
+// NOTE(joon): SSE only has the signed conversion, so convert high & low 16 bits seperately.
+// Both halves and the scaled high half are exact in f32, so the final add is the only rounding, same as vcvtq_f32_u32
+force_inline simd_f32
+convert_f32_from_u32(simd_u32 value)
+{
+    simd_f32 result = {};
+
+    __m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(value.v, 16));
+    __m128 low = _mm_cvtepi32_ps(_mm_and_si128(value.v, _mm_set1_epi32(0xffff)));
+
+    result.v = _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.0f)), low);
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_or_ps(a.v, _mm_castsi128_ps(mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator&(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_and_ps(a.v, _mm_castsi128_ps(mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    
+    result.v = _mm_or_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+sqrt(simd_f32 a)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_sqrt_ps(a.v);
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_f32
+overwrite(simd_f32 dest, simd_u32 mask, simd_f32 source)
+{
+    simd_f32 result = {};
+
+    // NOTE(joon): not using blendv, as it only looks at the top bit of each lane while the ARM version is a bitwise select
+    __m128 mask_f32 = _mm_castsi128_ps(mask.v);
+    result.v = _mm_or_ps(_mm_andnot_ps(mask_f32, dest.v), _mm_and_ps(mask_f32, source.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_cmpeq_ps(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_cmpge_ps(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_cmpgt_ps(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_cmple_ps(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_cmplt_ps(a.v, b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+force_inline simd_f32
+lerp(simd_f32 min, simd_f32 t, simd_f32 max)
+{
+    return min + t*(max-min);
+}
+
+force_inline simd_f32
+min(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_min_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+min_component(simd_f32 a)
+{
+    __m128 m = _mm_min_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_min_ss(m, _mm_movehl_ps(m, m));
+
+    f32 result = _mm_cvtss_f32(m);
+
+    return result;
+}
+
+force_inline f32
+max_component(simd_f32 a)
+{
+    __m128 m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_max_ss(m, _mm_movehl_ps(m, m));
+
+    f32 result = _mm_cvtss_f32(m);
+
+    return result;
+}
+
+force_inline simd_f32
+max(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm_max_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(simd_f32 a)
+{
+    f32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_f32 a)
+{
+    // NOTE(joon): -0.0f also counts as zero
+    b32 result = (_mm_movemask_ps(_mm_cmpeq_ps(a.v, _mm_setzero_ps())) == 0xf);
+
+    return result;
+}
+
+//////////////////// simd_v3 ////////////////////
+
+force_inline simd_v3
+simd_v3_(v3 dup)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_set1_ps(dup.x);
+    result.y = _mm_set1_ps(dup.y);
+    result.z = _mm_set1_ps(dup.z);
+
+    return result;
+}
+
+// NOTE(joon): This path is most likely for the initial steps of opitimization, consider using the SOA version instead!
+force_inline simd_v3
+simd_v3_(v3 value0, v3 value1, v3 value2, v3 value3)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_setr_ps(value0.x, value1.x, value2.x, value3.x);
+    result.y = _mm_setr_ps(value0.y, value1.y, value2.y, value3.y);
+    result.z = _mm_setr_ps(value0.z, value1.z, value2.z, value3.z);
+
+    return result;
+}
+
+force_inline simd_v3
+simd_v3_(simd_f32 value0, simd_f32 value1, simd_f32 value2)
+{
+    simd_v3 result = {};
+
+    result.x = value0.v;    
+    result.y = value1.v;
+    result.z = value2.v;
+
+    return result;
+}
+
+// NOTE(joon): This is a much more preferred version of loading in the data
+force_inline simd_v3
+simd_v3_load(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_loadu_ps(array_of_x);
+    result.y = _mm_loadu_ps(array_of_y);
+    result.z = _mm_loadu_ps(array_of_z);
+
+    return result;
+}
+
+// NOTE(joon): Mostly used for scattering the result lane by lane
+force_inline v3
+get_lane(simd_v3 a, u32 lane)
+{
+    r32 lanes_x[4];
+    r32 lanes_y[4];
+    r32 lanes_z[4];
+    _mm_storeu_ps(lanes_x, a.x);
+    _mm_storeu_ps(lanes_y, a.y);
+    _mm_storeu_ps(lanes_z, a.z);
+
+    v3 result = {};
+    result.x = lanes_x[lane];
+    result.y = lanes_y[lane];
+    result.z = lanes_z[lane];
+
+    return result;
+}
+
+// NOTE(joon): Opposite of simd_v3_load, used for scattering the whole vector at once
+force_inline void
+simd_v3_store(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z, simd_v3 a)
+{
+    _mm_storeu_ps(array_of_x, a.x);
+    _mm_storeu_ps(array_of_y, a.y);
+    _mm_storeu_ps(array_of_z, a.z);
+}
+
+force_inline simd_v3
+operator+(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_add_ps(a.x, b.x);
+    result.y = _mm_add_ps(a.y, b.y);
+    result.z = _mm_add_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+    result.x = _mm_sub_ps(a.x, b.x);
+    result.y = _mm_sub_ps(a.y, b.y);
+    result.z = _mm_sub_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_mul_ps(a.x, b.x);
+    result.y = _mm_mul_ps(a.y, b.y);
+    result.z = _mm_mul_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_f32 value, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_mul_ps(value.v, b.x);
+    result.y = _mm_mul_ps(value.v, b.y);
+    result.z = _mm_mul_ps(value.v, b.z);
+
+    return result;
+}
+
+force_inline simd_v3 &
+operator*=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm_mul_ps(v.x, value.v);
+    v.y = _mm_mul_ps(v.y, value.v);
+    v.z = _mm_mul_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator/=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm_div_ps(v.x, value.v);
+    v.y = _mm_div_ps(v.y, value.v);
+    v.z = _mm_div_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator+=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm_add_ps(v.x, value.v);
+    v.y = _mm_add_ps(v.y, value.v);
+    v.z = _mm_add_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_div_ps(a.x, b.x);
+    result.y = _mm_div_ps(a.y, b.y);
+    result.z = _mm_div_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_f32 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_div_ps(a.x, b.v);
+    result.y = _mm_div_ps(a.y, b.v);
+    result.z = _mm_div_ps(a.z, b.v);
+
+    return result;
+}
+
+force_inline simd_v3 
+operator-(simd_v3 a)
+{
+    __m128 sign_bit = _mm_set1_ps(-0.0f);
+
+    a.x = _mm_xor_ps(a.x, sign_bit);
+    a.y = _mm_xor_ps(a.y, sign_bit);
+    a.z = _mm_xor_ps(a.z, sign_bit);
+
+    return a;
+}
+
+force_inline simd_v3
+overwrite(simd_v3 dest, simd_u32 mask, simd_v3 source)
+{
+    simd_v3 result = {};
+
+    __m128 mask_f32 = _mm_castsi128_ps(mask.v);
+
+    result.x = _mm_or_ps(_mm_andnot_ps(mask_f32, dest.x), _mm_and_ps(mask_f32, source.x));
+    result.y = _mm_or_ps(_mm_andnot_ps(mask_f32, dest.y), _mm_and_ps(mask_f32, source.y));
+    result.z = _mm_or_ps(_mm_andnot_ps(mask_f32, dest.z), _mm_and_ps(mask_f32, source.z));
+
+    return result;
+}
+
+force_inline simd_v3
+lerp(simd_v3 min, simd_f32 t, simd_v3 max)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_add_ps(min.x, _mm_mul_ps(t.v, _mm_sub_ps(max.x, min.x)));
+    result.y = _mm_add_ps(min.y, _mm_mul_ps(t.v, _mm_sub_ps(max.y, min.y)));
+    result.z = _mm_add_ps(min.z, _mm_mul_ps(t.v, _mm_sub_ps(max.z, min.z)));
+
+    return result;
+}
+
+force_inline simd_f32
+dot(simd_v3 a, simd_v3 b)
+{
+    simd_v3 hadamard = a*b;
+
+    simd_f32 result = {};
+
+    result.v = _mm_add_ps(_mm_add_ps(hadamard.x, hadamard.y), hadamard.z);
+
+    return result;
+}
+
+force_inline simd_f32
+length_square(simd_v3 a)
+{
+    return dot(a, a);
+}
+
+force_inline simd_f32
+length(simd_v3 a)
+{
+    simd_f32 result = sqrt(length_square(a));
+
+    return result;
+}
+
+force_inline simd_v3
+normalize(simd_v3 a)
+{
+    simd_v3 result = a / length(a);
+
+    return result;
+}
+
+force_inline simd_v3
+cross(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(b.y, a.z));
+    result.y = _mm_sub_ps(_mm_mul_ps(b.x, a.z), _mm_mul_ps(a.x, b.z));
+    result.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(b.x, a.y));
+
+    return result;
+}
+
+force_inline simd_v3
+min(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_min_ps(a.x, b.x);
+    result.y = _mm_min_ps(a.y, b.y);
+    result.z = _mm_min_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+max(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm_max_ps(a.x, b.x);
+    result.y = _mm_max_ps(a.y, b.y);
+    result.z = _mm_max_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_f32
+min_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm_min_ps(_mm_min_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline simd_f32
+max_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm_max_ps(_mm_max_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline v3
+add_all_lanes(simd_v3 a)
+{
+    v3 result = {};
+
+    result.x = add_all_lanes(a.x);
+    result.y = add_all_lanes(a.y);
+    result.z = add_all_lanes(a.z);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(a.x, b.x), _mm_cmpeq_ps(a.y, b.y)), _mm_cmpeq_ps(a.z, b.z)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(a.x, b.x), _mm_cmpge_ps(a.y, b.y)), _mm_cmpge_ps(a.z, b.z)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(a.x, b.x), _mm_cmpgt_ps(a.y, b.y)), _mm_cmpgt_ps(a.z, b.z)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_and_ps(_mm_and_ps(_mm_cmple_ps(a.x, b.x), _mm_cmple_ps(a.y, b.y)), _mm_cmple_ps(a.z, b.z)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm_castps_si128(_mm_and_ps(_mm_and_ps(_mm_cmplt_ps(a.x, b.x), _mm_cmplt_ps(a.y, b.y)), _mm_cmplt_ps(a.z, b.z)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+//////////////////// random_series //////////////////// 
+
+struct simd_random_series
+{
+    simd_u32 next_random;
+};
+
+force_inline void
+xor_shift_32(simd_u32 *next_random)
+{
+    simd_u32 x = *next_random;
+
+    x.v = _mm_xor_si128(x.v, _mm_slli_epi32(x.v, 13));
+    x.v = _mm_xor_si128(x.v, _mm_srli_epi32(x.v, 17));
+    x.v = _mm_xor_si128(x.v, _mm_srli_epi32(x.v, 5));
+
+    *next_random = x;
+}
+
+force_inline simd_random_series
+start_random_series(u32 seed0, u32 seed1, u32 seed2, u32 seed3)
+{
+    simd_random_series result = {};
+    result.next_random = simd_u32_(seed0, seed1, seed2, seed3);
+
+    return result;
+}
+
+// NOTE(joon): lane width independent version
+force_inline simd_random_series
+start_random_series(simd_u32 seed)
+{
+    simd_random_series result = {};
+    result.next_random = seed;
+
+    return result;
+}
+
 force_inline simd_f32
 random_between_0_1(simd_random_series *series)
 {
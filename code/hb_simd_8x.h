@@ -0,0 +1,1109 @@
+#if HB_X64
+
+// NOTE(joon): AVX2 version of hb_simd_4x.h, which means 256 bit wide lanes.
+// Needs -mavx2, and the functions should behave exactly the same as the 4x version lane by lane
+#include <immintrin.h>
+
+struct simd_f32
+{
+    __m256 v;
+};
+
+struct simd_u32
+{
+    __m256i v;
+};
+
+struct simd_i32
+{
+    __m256i v;
+};
+
+struct simd_v3
+{
+    union
+    {
+        struct
+        {
+            __m256 x;
+            __m256 y;
+            __m256 z;
+        };
+
+        struct
+        {
+            __m256 r;
+            __m256 g;
+            __m256 b;
+        };
+        __m256 e[3];
+    };
+};
+
+struct simd_v3i
+{
+    __m256i x;
+    __m256i y;
+    __m256i z;
+};
+
+struct simd_v3u
+{
+    __m256i x;
+    __m256i y;
+    __m256i z;
+};
+
+force_inline u32
+add_all_lanes(__m256i a)
+{
+    // NOTE(joon): add the high & low 128 bit halves first, and then the same as the 4x version
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    u32 result = (u32)_mm_cvtsi128_si32(sum);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(__m256 a)
+{
+    // NOTE(joon): Same order as the 4x version((0+1) + (2+3)) inside each 128 bit half, and then the two halves,
+    // so that the result is bit exact with the narrower widths that add the vectors the same way
+    __m256 sum = _mm256_add_ps(a, _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm256_add_ps(sum, _mm256_permute_ps(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    f32 result = _mm_cvtss_f32(_mm_add_ss(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+
+    return result;
+}
+
+// NOTE(joon): AVX2 only has signed integer comparisons,
+// so flip the sign bit of both sides to compare them as unsigned
+force_inline __m256i
+flip_sign_bit(__m256i a)
+{
+    __m256i result = _mm256_xor_si256(a, _mm256_set1_epi32((i32)0x80000000));
+
+    return result;
+}
+
+//////////////////// simd_u32 ////////////////////
+
+force_inline simd_u32
+simd_u32_(u32 dup)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_set1_epi32((i32)dup);
+
+    return result;
+}
+
+force_inline simd_u32
+simd_u32_load(u32 *ptr)
+{
+    simd_u32 result = {};
+    result.v = _mm256_loadu_si256((__m256i *)ptr);
+
+    return result;
+}
+
+// NOTE(joon): reading the lane through a casted pointer breaks the strict aliasing rule
+force_inline u32
+get_lane(simd_u32 a, u32 lane)
+{
+    u32 lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, a.v);
+
+    return lanes[lane];
+}
+
+force_inline void
+simd_u32_store(u32 *ptr, simd_u32 a)
+{
+    _mm256_storeu_si256((__m256i *)ptr, a.v);
+}
+
+// unary not opeartor
+force_inline simd_u32
+operator~(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_xor_si256(a.v, _mm256_set1_epi32(-1));
+
+    return result;
+}
+
+force_inline simd_u32
+operator+(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_add_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator-(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_sub_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator*(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_mullo_epi32(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): Shifting by 32 or more clears the lanes, which is the same as the other versions
+force_inline simd_u32
+operator<<(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_sll_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+// NOTE(joon): logical shift, does not keep the sign bit
+force_inline simd_u32
+operator>>(simd_u32 a, u32 shift_amount)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_srl_epi32(a.v, _mm_cvtsi32_si128((i32)shift_amount));
+
+    return result;
+}
+
+force_inline simd_u32
+operator|(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_or_si256(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator^(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_xor_si256(a.v, b.v);
+
+    return result;
+}
+
+// NOTE(joon): each lane gets shifted by the amount in the same lane, which should be less than 32
+force_inline simd_u32
+operator>>(simd_u32 a, simd_u32 shift_amounts)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_srlv_epi32(a.v, shift_amounts.v);
+
+    return result;
+}
+
+force_inline simd_u32
+operator&(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+    result.v = _mm256_and_si256(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_cmpeq_epi32(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): a >= b if max(a, b) == a
+    result.v = _mm256_cmpeq_epi32(_mm256_max_epu32(a.v, b.v), a.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_cmpgt_epi32(flip_sign_bit(a.v), flip_sign_bit(b.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_cmpeq_epi32(_mm256_min_epu32(a.v, b.v), a.v);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_u32 a, simd_u32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_cmpgt_epi32(flip_sign_bit(b.v), flip_sign_bit(a.v));
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_u32
+overwrite(simd_u32 dest, simd_u32 mask, simd_u32 source)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_or_si256(_mm256_andnot_si256(mask.v, dest.v), _mm256_and_si256(mask.v, source.v));
+
+    return result;
+}
+
+// NOTE(joon): Fills the mask lane with 1 if the lane has non-zero value
+// if not, fills with 0
+force_inline simd_u32
+is_lane_non_zero(simd_u32 a)
+{
+    simd_u32 result = {};
+
+    simd_u32 simd_u32_0 = simd_u32_(0);
+    result = ~compare_equal(a, simd_u32_0);
+
+    return result;
+}
+
+force_inline u32
+add_all_lanes(simd_u32 a)
+{
+    u32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+// NOTE(joon): This only works if the lane is all 1 or 0
+force_inline u32
+get_non_zero_lane_count_from_all_set_bit(simd_u32 a)
+{
+    // NOTE(joon): one bit per lane, from the sign bits
+    u32 result = __builtin_popcount((u32)_mm256_movemask_ps(_mm256_castsi256_ps(a.v)));
+
+    return result;
+}
+
+force_inline u32
+get_non_zero_lane_count(simd_u32 a)
+{
+    u32 result = get_non_zero_lane_count_from_all_set_bit(is_lane_non_zero(a));
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_u32 a)
+{
+    b32 result = _mm256_testz_si256(a.v, a.v);
+
+    return result;
+}
+
+//////////////////// simd_f32 ////////////////////
+
+force_inline simd_f32
+simd_f32_(r32 dup)
+{
+    simd_f32 result = {};
+    result.v = _mm256_set1_ps(dup);
+
+    return result;
+}
+
+force_inline simd_f32
+simd_f32_load(r32 *ptr)
+{
+    simd_f32 result = {};
+    result.v = _mm256_loadu_ps(ptr);
+
+    return result;
+}
+
+// NOTE(joon): Loads 'count' values and zeroes the rest of the lanes, so that we never read past the end of an array 
+// that is shorter than the lane width. The masked out lanes are never touched, so this does not fault either
+force_inline simd_f32
+simd_f32_load_first_lanes(r32 *ptr, u32 count)
+{
+    simd_f32 result = {};
+
+    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((i32)count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    result.v = _mm256_maskload_ps(ptr, mask);
+
+    return result;
+}
+
+force_inline r32
+get_lane(simd_f32 a, u32 lane)
+{
+    r32 lanes[8];
+    _mm256_storeu_ps(lanes, a.v);
+
+    return lanes[lane];
+}
+
+// NOTE(joon): lane i = base[lane i of indices]. All lanes are loaded,
+// so the indices of the lanes that are not used should still point inside the array(i.e 0)
+force_inline simd_f32
+gather(r32 *base, simd_u32 indices)
+{
+    simd_f32 result = {};
+    result.v = _mm256_i32gather_ps(base, indices.v, sizeof(r32));
+
+    return result;
+}
+
+force_inline void
+simd_f32_store(r32 *ptr, simd_f32 a)
+{
+    _mm256_storeu_ps(ptr, a.v);
+}
+
+force_inline simd_f32
+operator+(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm256_add_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm256_sub_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator-(simd_f32 a)
+{
+    a.v = _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f));
+
+    return a;
+}
+
+force_inline simd_f32
+operator*(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+    result.v = _mm256_mul_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+operator/(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_div_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32 &
+operator+=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm256_add_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator-=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm256_sub_ps(a.v, b.v);
+
+    return a;
+}
+
+force_inline simd_f32 &
+operator/=(simd_f32 &a, simd_f32 b)
+{
+    a.v = _mm256_div_ps(a.v, b.v);
+
+    return a;
+}
+
+// NOTE(joon): same as the SSE version - rounds towards zero, negative values & NaN become 0,
+// and values that are too big saturate to U32_Max
+force_inline simd_u32
+convert_u32_from_f32(simd_f32 value)
+{
+    simd_u32 result = {};
+
+    // NOTE(joon): max_ps returns the second operand if any of them is NaN
+    __m256 positive = _mm256_max_ps(value.v, _mm256_setzero_ps());
+
+    __m256 two_pow_31 = _mm256_set1_ps(2147483648.0f);
+    __m256 high_mask = _mm256_cmp_ps(positive, two_pow_31, _CMP_GE_OQ);
+    __m256 overflow_mask = _mm256_cmp_ps(positive, _mm256_set1_ps(4294967296.0f), _CMP_GE_OQ);
+
+    __m256i low = _mm256_cvttps_epi32(_mm256_sub_ps(positive, _mm256_and_ps(high_mask, two_pow_31)));
+    result.v = _mm256_xor_si256(low, _mm256_slli_epi32(_mm256_castps_si256(high_mask), 31));
+    result.v = _mm256_or_si256(result.v, _mm256_castps_si256(overflow_mask));
+
+    return result;
+}
+
+// NOTE(joon): same as the SSE version, convert high & low 16 bits seperately
+force_inline simd_f32
+convert_f32_from_u32(simd_u32 value)
+{
+    simd_f32 result = {};
+
+    __m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(value.v, 16));
+    __m256 low = _mm256_cvtepi32_ps(_mm256_and_si256(value.v, _mm256_set1_epi32(0xffff)));
+
+    result.v = _mm256_add_ps(_mm256_mul_ps(high, _mm256_set1_ps(65536.0f)), low);
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_or_ps(a.v, _mm256_castsi256_ps(mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator&(simd_f32 a, simd_u32 mask)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_and_ps(a.v, _mm256_castsi256_ps(mask.v));
+
+    return result;
+}
+
+force_inline simd_f32
+operator|(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_or_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline simd_f32
+sqrt(simd_f32 a)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_sqrt_ps(a.v);
+
+    return result;
+}
+
+// NOTE(joon): clear the values that will be overwritten by the new value, or them to overwrite
+force_inline simd_f32
+overwrite(simd_f32 dest, simd_u32 mask, simd_f32 source)
+{
+    simd_f32 result = {};
+
+    __m256 mask_f32 = _mm256_castsi256_ps(mask.v);
+    result.v = _mm256_or_ps(_mm256_andnot_ps(mask_f32, dest.v), _mm256_and_ps(mask_f32, source.v));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_f32 a, simd_f32 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+force_inline simd_f32
+lerp(simd_f32 min, simd_f32 t, simd_f32 max)
+{
+    return min + t*(max-min);
+}
+
+force_inline simd_f32
+min(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_min_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+min_component(simd_f32 a)
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_min_ss(m, _mm_movehl_ps(m, m));
+
+    f32 result = _mm_cvtss_f32(m);
+
+    return result;
+}
+
+force_inline f32
+max_component(simd_f32 a)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_max_ss(m, _mm_movehl_ps(m, m));
+
+    f32 result = _mm_cvtss_f32(m);
+
+    return result;
+}
+
+force_inline simd_f32
+max(simd_f32 a, simd_f32 b)
+{
+    simd_f32 result = {};
+
+    result.v = _mm256_max_ps(a.v, b.v);
+
+    return result;
+}
+
+force_inline f32
+add_all_lanes(simd_f32 a)
+{
+    f32 result = add_all_lanes(a.v);
+
+    return result;
+}
+
+force_inline b32
+all_lanes_zero(simd_f32 a)
+{
+    // NOTE(joon): -0.0f also counts as zero
+    b32 result = (_mm256_movemask_ps(_mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_EQ_OQ)) == 0xff);
+
+    return result;
+}
+
+//////////////////// simd_v3 ////////////////////
+
+force_inline simd_v3
+simd_v3_(v3 dup)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_set1_ps(dup.x);
+    result.y = _mm256_set1_ps(dup.y);
+    result.z = _mm256_set1_ps(dup.z);
+
+    return result;
+}
+
+force_inline simd_v3
+simd_v3_(simd_f32 value0, simd_f32 value1, simd_f32 value2)
+{
+    simd_v3 result = {};
+
+    result.x = value0.v;
+    result.y = value1.v;
+    result.z = value2.v;
+
+    return result;
+}
+
+// NOTE(joon): This is a much more preferred version of loading in the data
+force_inline simd_v3
+simd_v3_load(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_loadu_ps(array_of_x);
+    result.y = _mm256_loadu_ps(array_of_y);
+    result.z = _mm256_loadu_ps(array_of_z);
+
+    return result;
+}
+
+// NOTE(joon): Mostly used for scattering the result lane by lane
+force_inline v3
+get_lane(simd_v3 a, u32 lane)
+{
+    r32 lanes_x[8];
+    r32 lanes_y[8];
+    r32 lanes_z[8];
+    _mm256_storeu_ps(lanes_x, a.x);
+    _mm256_storeu_ps(lanes_y, a.y);
+    _mm256_storeu_ps(lanes_z, a.z);
+
+    v3 result = {};
+    result.x = lanes_x[lane];
+    result.y = lanes_y[lane];
+    result.z = lanes_z[lane];
+
+    return result;
+}
+
+// NOTE(joon): Opposite of simd_v3_load, used for scattering the whole vector at once
+force_inline void
+simd_v3_store(r32 *array_of_x, r32 *array_of_y, r32 *array_of_z, simd_v3 a)
+{
+    _mm256_storeu_ps(array_of_x, a.x);
+    _mm256_storeu_ps(array_of_y, a.y);
+    _mm256_storeu_ps(array_of_z, a.z);
+}
+
+force_inline simd_v3
+operator+(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_add_ps(a.x, b.x);
+    result.y = _mm256_add_ps(a.y, b.y);
+    result.z = _mm256_add_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+    result.x = _mm256_sub_ps(a.x, b.x);
+    result.y = _mm256_sub_ps(a.y, b.y);
+    result.z = _mm256_sub_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_mul_ps(a.x, b.x);
+    result.y = _mm256_mul_ps(a.y, b.y);
+    result.z = _mm256_mul_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator*(simd_f32 value, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_mul_ps(value.v, b.x);
+    result.y = _mm256_mul_ps(value.v, b.y);
+    result.z = _mm256_mul_ps(value.v, b.z);
+
+    return result;
+}
+
+force_inline simd_v3 &
+operator*=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm256_mul_ps(v.x, value.v);
+    v.y = _mm256_mul_ps(v.y, value.v);
+    v.z = _mm256_mul_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator/=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm256_div_ps(v.x, value.v);
+    v.y = _mm256_div_ps(v.y, value.v);
+    v.z = _mm256_div_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3 &
+operator+=(simd_v3 &v, simd_f32 value)
+{
+    v.x = _mm256_add_ps(v.x, value.v);
+    v.y = _mm256_add_ps(v.y, value.v);
+    v.z = _mm256_add_ps(v.z, value.v);
+
+    return v;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_div_ps(a.x, b.x);
+    result.y = _mm256_div_ps(a.y, b.y);
+    result.z = _mm256_div_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+operator/(simd_v3 a, simd_f32 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_div_ps(a.x, b.v);
+    result.y = _mm256_div_ps(a.y, b.v);
+    result.z = _mm256_div_ps(a.z, b.v);
+
+    return result;
+}
+
+force_inline simd_v3
+operator-(simd_v3 a)
+{
+    __m256 sign_bit = _mm256_set1_ps(-0.0f);
+
+    a.x = _mm256_xor_ps(a.x, sign_bit);
+    a.y = _mm256_xor_ps(a.y, sign_bit);
+    a.z = _mm256_xor_ps(a.z, sign_bit);
+
+    return a;
+}
+
+force_inline simd_v3
+overwrite(simd_v3 dest, simd_u32 mask, simd_v3 source)
+{
+    simd_v3 result = {};
+
+    __m256 mask_f32 = _mm256_castsi256_ps(mask.v);
+
+    result.x = _mm256_or_ps(_mm256_andnot_ps(mask_f32, dest.x), _mm256_and_ps(mask_f32, source.x));
+    result.y = _mm256_or_ps(_mm256_andnot_ps(mask_f32, dest.y), _mm256_and_ps(mask_f32, source.y));
+    result.z = _mm256_or_ps(_mm256_andnot_ps(mask_f32, dest.z), _mm256_and_ps(mask_f32, source.z));
+
+    return result;
+}
+
+force_inline simd_v3
+lerp(simd_v3 min, simd_f32 t, simd_v3 max)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_add_ps(min.x, _mm256_mul_ps(t.v, _mm256_sub_ps(max.x, min.x)));
+    result.y = _mm256_add_ps(min.y, _mm256_mul_ps(t.v, _mm256_sub_ps(max.y, min.y)));
+    result.z = _mm256_add_ps(min.z, _mm256_mul_ps(t.v, _mm256_sub_ps(max.z, min.z)));
+
+    return result;
+}
+
+force_inline simd_f32
+dot(simd_v3 a, simd_v3 b)
+{
+    simd_v3 hadamard = a*b;
+
+    simd_f32 result = {};
+
+    result.v = _mm256_add_ps(_mm256_add_ps(hadamard.x, hadamard.y), hadamard.z);
+
+    return result;
+}
+
+force_inline simd_f32
+length_square(simd_v3 a)
+{
+    return dot(a, a);
+}
+
+force_inline simd_f32
+length(simd_v3 a)
+{
+    simd_f32 result = sqrt(length_square(a));
+
+    return result;
+}
+
+force_inline simd_v3
+normalize(simd_v3 a)
+{
+    simd_v3 result = a / length(a);
+
+    return result;
+}
+
+force_inline simd_v3
+cross(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(b.y, a.z));
+    result.y = _mm256_sub_ps(_mm256_mul_ps(b.x, a.z), _mm256_mul_ps(a.x, b.z));
+    result.z = _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(b.x, a.y));
+
+    return result;
+}
+
+force_inline simd_v3
+min(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_min_ps(a.x, b.x);
+    result.y = _mm256_min_ps(a.y, b.y);
+    result.z = _mm256_min_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_v3
+max(simd_v3 a, simd_v3 b)
+{
+    simd_v3 result = {};
+
+    result.x = _mm256_max_ps(a.x, b.x);
+    result.y = _mm256_max_ps(a.y, b.y);
+    result.z = _mm256_max_ps(a.z, b.z);
+
+    return result;
+}
+
+force_inline simd_f32
+min_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm256_min_ps(_mm256_min_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline simd_f32
+max_component(simd_v3 a)
+{
+    simd_f32 result = {};
+    result.v = _mm256_max_ps(_mm256_max_ps(a.x, a.y), a.z);
+
+    return result;
+}
+
+force_inline v3
+add_all_lanes(simd_v3 a)
+{
+    v3 result = {};
+
+    result.x = add_all_lanes(a.x);
+    result.y = add_all_lanes(a.y);
+    result.z = add_all_lanes(a.z);
+
+    return result;
+}
+
+force_inline simd_u32
+compare_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a.x, b.x, _CMP_EQ_OQ), _mm256_cmp_ps(a.y, b.y, _CMP_EQ_OQ)),
+                                                _mm256_cmp_ps(a.z, b.z, _CMP_EQ_OQ)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a.x, b.x, _CMP_GE_OQ), _mm256_cmp_ps(a.y, b.y, _CMP_GE_OQ)),
+                                                _mm256_cmp_ps(a.z, b.z, _CMP_GE_OQ)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_greater(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a.x, b.x, _CMP_GT_OQ), _mm256_cmp_ps(a.y, b.y, _CMP_GT_OQ)),
+                                                _mm256_cmp_ps(a.z, b.z, _CMP_GT_OQ)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a.x, b.x, _CMP_LE_OQ), _mm256_cmp_ps(a.y, b.y, _CMP_LE_OQ)),
+                                                _mm256_cmp_ps(a.z, b.z, _CMP_LE_OQ)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_less(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result.v = _mm256_castps_si256(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a.x, b.x, _CMP_LT_OQ), _mm256_cmp_ps(a.y, b.y, _CMP_LT_OQ)),
+                                                _mm256_cmp_ps(a.z, b.z, _CMP_LT_OQ)));
+
+    return result;
+}
+
+force_inline simd_u32
+compare_not_equal(simd_v3 a, simd_v3 b)
+{
+    simd_u32 result = {};
+
+    result = ~compare_equal(a, b);
+
+    return result;
+}
+
+//////////////////// random_series ////////////////////
+
+struct simd_random_series
+{
+    simd_u32 next_random;
+};
+
+force_inline void
+xor_shift_32(simd_u32 *next_random)
+{
+    simd_u32 x = *next_random;
+
+    x.v = _mm256_xor_si256(x.v, _mm256_slli_epi32(x.v, 13));
+    x.v = _mm256_xor_si256(x.v, _mm256_srli_epi32(x.v, 17));
+    x.v = _mm256_xor_si256(x.v, _mm256_srli_epi32(x.v, 5));
+
+    *next_random = x;
+}
+
+force_inline simd_random_series
+start_random_series(simd_u32 seed)
+{
+    simd_random_series result = {};
+    result.next_random = seed;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between_0_1(simd_random_series *series)
+{
+    xor_shift_32(&series->next_random);
+
+    simd_f32 max = simd_f32_((r32)U32_Max);
+
+    simd_f32 result = convert_f32_from_u32(series->next_random)/max;
+
+    return result;
+}
+
+force_inline simd_f32
+random_between(simd_random_series *series, r32 min, r32 max)
+{
+    simd_f32 simd_min = simd_f32_(min);
+    simd_f32 simd_t = simd_f32_(max-min);
+
+    return simd_min + simd_t*random_between_0_1(series);
+}
+
+force_inline simd_f32
+random_between_minus_1_1(simd_random_series *series)
+{
+    simd_f32 simd_2 = simd_f32_(2.0f);
+    simd_f32 simd_1 = simd_f32_(1.0f);
+
+    simd_f32 result = (simd_2*random_between_0_1(series)) - simd_1;
+    return result;
+}
+
+#endif // #if HB_X64
@@ -0,0 +1,550 @@
+/*
+    NOTE(joon) Checks that the simd layer gives the same result lane by lane, no matter how many lanes there are.
+    Like hb_kernel_isa.cpp, this is not a part of the unity build, and gets compiled multiple times(see simd_test in the makefile) :
+    - once per lane width(1, 4 which is NEON on ARM & SSE4.1 on x64, 8 which is AVX2 and 16 which is AVX-512),
+      which runs every operation over the same inputs and writes out the results(see run_simd_test)
+    - once with HB_SIMD_TEST_MAIN, which makes the inputs, runs all of them and compares the wider results against the 1x(scalar) ones.
+      The widths that this cpu can't run are skipped. Returns non-zero if anything did not match
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hb_types.h"
+#include "hb_simd.h"
+#include "hb_intrinsic.h"
+
+// NOTE(joon) this does not need anything else from hb_platform.h
+#define internal static
+
+#define simd_test_name__(name, lane_width) name##_##lane_width
+#define simd_test_name_(name, lane_width) simd_test_name__(name, lane_width)
+#define simd_test_name(name) simd_test_name_(name, HB_LANE_WIDTH)
+
+// NOTE(joon) The operations that go across the lanes(i.e add_all_lanes) work on this many values at once,
+// so the narrower version goes through multiple vectors & combines them the same way the wider version does
+#define Simd_Test_Group_Lane_Count 16
+#define Simd_Test_Random_Step_Count 8
+
+enum SimdTestOp
+{
+    // NOTE(joon) u32 results, which should be exactly the same
+    SimdTestOp_AddU32,
+    SimdTestOp_SubU32,
+    SimdTestOp_MulU32,
+    SimdTestOp_ShiftLeftU32,
+    SimdTestOp_ShiftLeftOverflowU32,
+    SimdTestOp_ShiftRightU32,
+    SimdTestOp_ShiftRightOverflowU32,
+    SimdTestOp_ShiftRightPerLaneU32,
+    SimdTestOp_AndU32,
+    SimdTestOp_OrU32,
+    SimdTestOp_XorU32,
+    SimdTestOp_NotU32,
+    SimdTestOp_CompareEqualU32,
+    SimdTestOp_CompareGreaterEqualU32,
+    SimdTestOp_CompareGreaterU32,
+    SimdTestOp_CompareLessEqualU32,
+    SimdTestOp_CompareLessU32,
+    SimdTestOp_OverwriteU32,
+    SimdTestOp_IsLaneNonZero,
+    SimdTestOp_CompareEqualF32,
+    SimdTestOp_CompareNotEqualF32,
+    SimdTestOp_CompareGreaterEqualF32,
+    SimdTestOp_CompareGreaterF32,
+    SimdTestOp_CompareLessEqualF32,
+    SimdTestOp_CompareLessF32,
+    SimdTestOp_CompareLessV3,
+    SimdTestOp_CompareEqualV3,
+    SimdTestOp_ConvertU32FromF32,
+    SimdTestOp_FirstLanesMask,
+    SimdTestOp_AddAllLanesU32,
+    SimdTestOp_NonZeroLaneCount,
+    SimdTestOp_NonZeroLaneCountFromAllSetBit,
+    SimdTestOp_AllLanesZeroU32,
+    SimdTestOp_AllLanesZeroF32,
+
+    // NOTE(joon) r32 results, where all NaNs are the same
+    SimdTestOp_FirstR32,
+    SimdTestOp_AddF32 = SimdTestOp_FirstR32,
+    SimdTestOp_SubF32,
+    SimdTestOp_MulF32,
+    SimdTestOp_DivF32,
+    SimdTestOp_NegateF32,
+    SimdTestOp_SqrtF32,
+    SimdTestOp_MinF32,
+    SimdTestOp_MaxF32,
+    SimdTestOp_LerpF32,
+    SimdTestOp_AndMaskF32,
+    SimdTestOp_OrMaskF32,
+    SimdTestOp_OverwriteF32,
+    SimdTestOp_ConvertF32FromU32,
+    SimdTestOp_DotV3,
+    SimdTestOp_CrossV3X,
+    SimdTestOp_CrossV3Y,
+    SimdTestOp_CrossV3Z,
+    SimdTestOp_OverwriteV3X,
+    SimdTestOp_OverwriteV3Y,
+    SimdTestOp_OverwriteV3Z,
+    SimdTestOp_MinComponentV3,
+    SimdTestOp_AddAllLanesF32,
+    SimdTestOp_RandomBetween01,
+    SimdTestOp_RandomBetweenMinus11,
+
+    SimdTestOp_Count,
+};
+
+struct SimdTestData
+{
+    // NOTE(joon) multiple of Simd_Test_Group_Lane_Count
+    u32 count;
+
+    u32 *u32_a;
+    u32 *u32_b;
+    // NOTE(joon) includes NaN, infinity, -0, denormals & the values that don't fit in u32
+    r32 *f32_a;
+    r32 *f32_b;
+    // NOTE(joon) min & max give back different NaNs(or -0 & 0) on different platforms,
+    // so they get these instead, which are never NaN nor equal to each other
+    r32 *min_max_a;
+    r32 *min_max_b;
+    // NOTE(joon) 0, all set, or random bits(the masks are bitwise)
+    u32 *masks;
+    u32 *seeds;
+
+    // NOTE(joon) count*Simd_Test_Random_Step_Count values per op.
+    // The ones that go across the lanes only have one value per group
+    u32 *results[SimdTestOp_Count];
+};
+
+#define SIMD_TEST_RUN(name) void (name)(SimdTestData *data)
+typedef SIMD_TEST_RUN(simd_test_run);
+SIMD_TEST_RUN(run_simd_test_1);
+SIMD_TEST_RUN(run_simd_test_4);
+#if HB_X64
+SIMD_TEST_RUN(run_simd_test_8);
+SIMD_TEST_RUN(run_simd_test_16);
+#endif
+
+#if HB_SIMD_TEST_MAIN
+
+internal u32
+xor_shift_32(u32 *state)
+{
+    u32 x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x >> 5;
+
+    *state = x;
+
+    return x;
+}
+
+internal r32
+get_r32_from_u32_bits(u32 bits)
+{
+    r32 result;
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+internal r32
+get_random_test_r32(u32 *state)
+{
+    r32 result = 0.0f;
+
+    u32 special_values[] =
+    {
+        0x00000000, 0x80000000, // 0, -0
+        0x7fc00000, 0xffc00000, 0x7f800001, // NaNs
+        0x7f800000, 0xff800000, // infinity
+        0x00000001, 0x807fffff, // denormals
+        0x3f800000, 0xbf800000, 0x3f000000, // 1, -1, 0.5
+        0x4f000000, 0x4f7fffff, 0x4f800000, 0x4f800001, // 2^31, biggest f32 less than 2^32, 2^32, bigger than 2^32
+    };
+
+    u32 random = xor_shift_32(state);
+    switch(random % 4)
+    {
+        case 0:
+        {
+            result = get_r32_from_u32_bits(special_values[xor_shift_32(state) % (sizeof(special_values)/sizeof(special_values[0]))]);
+        }break;
+
+        case 1:
+        {
+            // NOTE(joon) any bit pattern
+            result = get_r32_from_u32_bits(xor_shift_32(state));
+        }break;
+
+        default:
+        {
+            // NOTE(joon) the range where most of the values are, including the ones that become u32
+            result = ((r32)(xor_shift_32(state) & 0xffffff) / (r32)0xffffff)*8192.0f - 4096.0f;
+            if(random & 64)
+            {
+                result *= 1048576.0f;
+            }
+        }break;
+    }
+
+    return result;
+}
+
+internal u32
+get_random_test_u32(u32 *state)
+{
+    u32 result = 0;
+
+    u32 special_values[] = {0, 1, 2, 31, 32, 0x7fffffff, 0x80000000, 0x80000001, 0xfffffffe, 0xffffffff};
+
+    if(xor_shift_32(state) % 4 == 0)
+    {
+        result = special_values[xor_shift_32(state) % (sizeof(special_values)/sizeof(special_values[0]))];
+    }
+    else
+    {
+        result = xor_shift_32(state);
+    }
+
+    return result;
+}
+
+internal SimdTestData
+allocate_simd_test_data(SimdTestData *inputs)
+{
+    SimdTestData result = *inputs;
+
+    for(u32 op = 0;
+            op < SimdTestOp_Count;
+            ++op)
+    {
+        result.results[op] = (u32 *)calloc(result.count*Simd_Test_Random_Step_Count, sizeof(u32));
+    }
+
+    return result;
+}
+
+int
+main(int argc, char **argv)
+{
+    SimdTestData inputs = {};
+    inputs.count = 1 << 16;
+
+    u32 count = inputs.count;
+    inputs.u32_a = (u32 *)malloc(sizeof(u32)*count);
+    inputs.u32_b = (u32 *)malloc(sizeof(u32)*count);
+    inputs.f32_a = (r32 *)malloc(sizeof(r32)*count);
+    inputs.f32_b = (r32 *)malloc(sizeof(r32)*count);
+    inputs.min_max_a = (r32 *)malloc(sizeof(r32)*count);
+    inputs.min_max_b = (r32 *)malloc(sizeof(r32)*count);
+    inputs.masks = (u32 *)malloc(sizeof(u32)*count);
+    inputs.seeds = (u32 *)malloc(sizeof(u32)*count);
+
+    u32 state = 0x12345678;
+    for(u32 index = 0;
+            index < count;
+            ++index)
+    {
+        inputs.u32_a[index] = get_random_test_u32(&state);
+        inputs.u32_b[index] = get_random_test_u32(&state);
+        // NOTE(joon) so that the equal compares are not always false
+        if(xor_shift_32(&state) % 8 == 0)
+        {
+            inputs.u32_b[index] = inputs.u32_a[index];
+        }
+
+        inputs.f32_a[index] = get_random_test_r32(&state);
+        inputs.f32_b[index] = get_random_test_r32(&state);
+        if(xor_shift_32(&state) % 8 == 0)
+        {
+            inputs.f32_b[index] = inputs.f32_a[index];
+        }
+
+        do
+        {
+            inputs.min_max_a[index] = get_random_test_r32(&state);
+            inputs.min_max_b[index] = get_random_test_r32(&state);
+        }
+        while(isnan(inputs.min_max_a[index]) || isnan(inputs.min_max_b[index]) ||
+              inputs.min_max_a[index] == inputs.min_max_b[index]);
+
+        switch(xor_shift_32(&state) % 4)
+        {
+            case 0:
+            case 1:
+            {
+                inputs.masks[index] = 0;
+            }break;
+
+            case 2:
+            {
+                inputs.masks[index] = 0xffffffff;
+            }break;
+
+            case 3:
+            {
+                inputs.masks[index] = xor_shift_32(&state);
+            }break;
+        }
+
+        // NOTE(joon) xorshift gets stuck at 0
+        inputs.seeds[index] = xor_shift_32(&state) | 1;
+    }
+
+    SimdTestData scalar_data = allocate_simd_test_data(&inputs);
+    run_simd_test_1(&scalar_data);
+
+    struct SimdTestWidth
+    {
+        u32 lane_width;
+        CpuFeatureLevel required_level;
+        simd_test_run *run;
+    };
+    SimdTestWidth widths[] = 
+    {
+#if HB_ARM
+        {4, CpuFeatureLevel_NEON, run_simd_test_4},
+#else
+        {4, CpuFeatureLevel_SSE41, run_simd_test_4},
+        {8, CpuFeatureLevel_AVX2, run_simd_test_8},
+        {16, CpuFeatureLevel_AVX512, run_simd_test_16},
+#endif
+    };
+
+    CpuFeatureLevel cpu_feature_level = get_cpu_feature_level();
+    SimdTestData simd_data = allocate_simd_test_data(&inputs);
+
+    u32 total_mismatch_count = 0;
+    for(u32 width_index = 0;
+            width_index < sizeof(widths)/sizeof(widths[0]);
+            ++width_index)
+    {
+        SimdTestWidth *width = widths + width_index;
+        if(cpu_feature_level < width->required_level)
+        {
+            printf("simd test : skipping %ux, not supported by this cpu\n", width->lane_width);
+            continue;
+        }
+
+        for(u32 op = 0;
+                op < SimdTestOp_Count;
+                ++op)
+        {
+            memset(simd_data.results[op], 0, sizeof(u32)*count*Simd_Test_Random_Step_Count);
+        }
+        width->run(&simd_data);
+
+        u32 width_mismatch_count = 0;
+        for(u32 op = 0;
+                op < SimdTestOp_Count;
+                ++op)
+        {
+            u32 mismatch_count = 0;
+            for(u32 index = 0;
+                    index < count*Simd_Test_Random_Step_Count;
+                    ++index)
+            {
+                u32 expected = scalar_data.results[op][index];
+                u32 got = simd_data.results[op][index];
+
+                b32 is_match = (expected == got);
+                if(!is_match && op >= SimdTestOp_FirstR32)
+                {
+                    is_match = isnan(get_r32_from_u32_bits(expected)) && isnan(get_r32_from_u32_bits(got));
+                }
+
+                if(!is_match)
+                {
+                    if(mismatch_count == 0)
+                    {
+                        printf("%ux op %u : index %u, expected 0x%08x(%g) but got 0x%08x(%g)\n", width->lane_width, op, index,
+                                expected, get_r32_from_u32_bits(expected), got, get_r32_from_u32_bits(got));
+                    }
+                    mismatch_count++;
+                }
+            }
+
+            width_mismatch_count += mismatch_count;
+        }
+
+        printf("simd test %ux : %u ops, %u values each, %u mismatches\n", width->lane_width, (u32)SimdTestOp_Count, count, width_mismatch_count);
+        total_mismatch_count += width_mismatch_count;
+    }
+
+    int result = (total_mismatch_count == 0) ? 0 : 1;
+
+    return result;
+}
+
+#else
+
+#if HB_LANE_WIDTH > Simd_Test_Group_Lane_Count
+#error "the lane width should not be bigger than Simd_Test_Group_Lane_Count"
+#endif
+
+#define store_u32_result(op, value) simd_u32_store(data->results[op] + index, value)
+
+internal void
+store_r32_result(SimdTestData *data, u32 op, u32 index, simd_f32 value)
+{
+    r32 lanes[HB_LANE_WIDTH];
+    simd_f32_store(lanes, value);
+    memcpy(data->results[op] + index, lanes, sizeof(lanes));
+}
+
+SIMD_TEST_RUN(simd_test_name(run_simd_test))
+{
+    for(u32 index = 0;
+            index < data->count;
+            index += HB_LANE_WIDTH)
+    {
+        simd_u32 ua = simd_u32_load(data->u32_a + index);
+        simd_u32 ub = simd_u32_load(data->u32_b + index);
+        simd_f32 fa = simd_f32_load(data->f32_a + index);
+        simd_f32 fb = simd_f32_load(data->f32_b + index);
+        simd_u32 mask = simd_u32_load(data->masks + index);
+
+        store_u32_result(SimdTestOp_AddU32, ua + ub);
+        store_u32_result(SimdTestOp_SubU32, ua - ub);
+        store_u32_result(SimdTestOp_MulU32, ua * ub);
+        store_u32_result(SimdTestOp_ShiftLeftU32, ua << 13);
+        store_u32_result(SimdTestOp_ShiftLeftOverflowU32, ua << 32);
+        store_u32_result(SimdTestOp_ShiftRightU32, ua >> 17);
+        store_u32_result(SimdTestOp_ShiftRightOverflowU32, ua >> 33);
+        store_u32_result(SimdTestOp_ShiftRightPerLaneU32, ua >> (ub & simd_u32_(31)));
+        store_u32_result(SimdTestOp_AndU32, ua & ub);
+        store_u32_result(SimdTestOp_OrU32, ua | ub);
+        store_u32_result(SimdTestOp_XorU32, ua ^ ub);
+        store_u32_result(SimdTestOp_NotU32, ~ua);
+        store_u32_result(SimdTestOp_CompareEqualU32, compare_equal(ua, ub));
+        store_u32_result(SimdTestOp_CompareGreaterEqualU32, compare_greater_equal(ua, ub));
+        store_u32_result(SimdTestOp_CompareGreaterU32, compare_greater(ua, ub));
+        store_u32_result(SimdTestOp_CompareLessEqualU32, compare_less_equal(ua, ub));
+        store_u32_result(SimdTestOp_CompareLessU32, compare_less(ua, ub));
+        store_u32_result(SimdTestOp_OverwriteU32, overwrite(ua, mask, ub));
+        store_u32_result(SimdTestOp_IsLaneNonZero, is_lane_non_zero(mask));
+
+        store_u32_result(SimdTestOp_CompareEqualF32, compare_equal(fa, fb));
+        store_u32_result(SimdTestOp_CompareNotEqualF32, compare_not_equal(fa, fb));
+        store_u32_result(SimdTestOp_CompareGreaterEqualF32, compare_greater_equal(fa, fb));
+        store_u32_result(SimdTestOp_CompareGreaterF32, compare_greater(fa, fb));
+        store_u32_result(SimdTestOp_CompareLessEqualF32, compare_less_equal(fa, fb));
+        store_u32_result(SimdTestOp_CompareLessF32, compare_less(fa, fb));
+        store_u32_result(SimdTestOp_ConvertU32FromF32, convert_u32_from_f32(fa));
+
+        store_r32_result(data, SimdTestOp_AddF32, index, fa + fb);
+        store_r32_result(data, SimdTestOp_SubF32, index, fa - fb);
+        store_r32_result(data, SimdTestOp_MulF32, index, fa * fb);
+        store_r32_result(data, SimdTestOp_DivF32, index, fa / fb);
+        store_r32_result(data, SimdTestOp_NegateF32, index, -fa);
+        store_r32_result(data, SimdTestOp_SqrtF32, index, sqrt(fa));
+        store_r32_result(data, SimdTestOp_LerpF32, index, lerp(fa, simd_f32_(0.25f), fb));
+        store_r32_result(data, SimdTestOp_AndMaskF32, index, fa & mask);
+        store_r32_result(data, SimdTestOp_OrMaskF32, index, fa | mask);
+        store_r32_result(data, SimdTestOp_OverwriteF32, index, overwrite(fa, mask, fb));
+        store_r32_result(data, SimdTestOp_ConvertF32FromU32, index, convert_f32_from_u32(ua));
+
+        simd_f32 min_max_a = simd_f32_load(data->min_max_a + index);
+        simd_f32 min_max_b = simd_f32_load(data->min_max_b + index);
+        store_r32_result(data, SimdTestOp_MinF32, index, min(min_max_a, min_max_b));
+        store_r32_result(data, SimdTestOp_MaxF32, index, max(min_max_a, min_max_b));
+
+        simd_v3 va = simd_v3_(fa, fb, min_max_a);
+        simd_v3 vb = simd_v3_(min_max_b, fa, fb);
+        r32 cross_x[HB_LANE_WIDTH];
+        r32 cross_y[HB_LANE_WIDTH];
+        r32 cross_z[HB_LANE_WIDTH];
+        simd_v3_store(cross_x, cross_y, cross_z, cross(va, vb));
+        simd_v3 overwritten = overwrite(va, mask, vb);
+        r32 overwritten_x[HB_LANE_WIDTH];
+        r32 overwritten_y[HB_LANE_WIDTH];
+        r32 overwritten_z[HB_LANE_WIDTH];
+        simd_v3_store(overwritten_x, overwritten_y, overwritten_z, overwritten);
+        store_r32_result(data, SimdTestOp_DotV3, index, dot(va, vb));
+        store_r32_result(data, SimdTestOp_CrossV3X, index, simd_f32_load(cross_x));
+        store_r32_result(data, SimdTestOp_CrossV3Y, index, simd_f32_load(cross_y));
+        store_r32_result(data, SimdTestOp_CrossV3Z, index, simd_f32_load(cross_z));
+        store_r32_result(data, SimdTestOp_OverwriteV3X, index, simd_f32_load(overwritten_x));
+        store_r32_result(data, SimdTestOp_OverwriteV3Y, index, simd_f32_load(overwritten_y));
+        store_r32_result(data, SimdTestOp_OverwriteV3Z, index, simd_f32_load(overwritten_z));
+        store_r32_result(data, SimdTestOp_MinComponentV3, index,
+                         min_component(simd_v3_(min_max_a, min_max_b, min_max_a + min_max_b)));
+        store_u32_result(SimdTestOp_CompareLessV3, compare_less(va, vb));
+        store_u32_result(SimdTestOp_CompareEqualV3, compare_equal(va, overwritten));
+
+        // NOTE(joon) each lane gets its own seed, so the lane i of the wider version should be the same as the scalar one with that seed
+        simd_random_series series = start_random_series(simd_u32_load(data->seeds + index));
+        simd_random_series series_minus_1_1 = start_random_series(simd_u32_load(data->seeds + index) ^ simd_u32_(0xa5a5a5a5));
+        for(u32 step = 0;
+                step < Simd_Test_Random_Step_Count;
+                ++step)
+        {
+            store_r32_result(data, SimdTestOp_RandomBetween01, step*data->count + index, random_between_0_1(&series));
+            store_r32_result(data, SimdTestOp_RandomBetweenMinus11, step*data->count + index, random_between_minus_1_1(&series_minus_1_1));
+        }
+    }
+
+    u32 vector_count = Simd_Test_Group_Lane_Count / HB_LANE_WIDTH;
+    for(u32 group_index = 0;
+            group_index < data->count / Simd_Test_Group_Lane_Count;
+            ++group_index)
+    {
+        u32 first_lane_count = group_index % (Simd_Test_Group_Lane_Count + 1);
+
+        r32 partial_sums[Simd_Test_Group_Lane_Count];
+        u32 u32_sum = 0;
+        u32 non_zero_lane_count = 0;
+        u32 non_zero_lane_count_from_all_set_bit = 0;
+        b32 all_lanes_zero_u32 = true;
+        b32 all_lanes_zero_f32 = true;
+        for(u32 vector_index = 0;
+                vector_index < vector_count;
+                ++vector_index)
+        {
+            u32 index = group_index*Simd_Test_Group_Lane_Count + vector_index*HB_LANE_WIDTH;
+
+            simd_u32 ua = simd_u32_load(data->u32_a + index);
+            simd_u32 ub = simd_u32_load(data->u32_b + index);
+            simd_f32 fa = simd_f32_load(data->f32_a + index);
+            simd_u32 mask = simd_u32_load(data->masks + index);
+
+            partial_sums[vector_index] = add_all_lanes(fa);
+            u32_sum += add_all_lanes(ua);
+            non_zero_lane_count += get_non_zero_lane_count(mask);
+            non_zero_lane_count_from_all_set_bit += get_non_zero_lane_count_from_all_set_bit(compare_less(ua, ub));
+            all_lanes_zero_u32 &= all_lanes_zero(mask);
+            // NOTE(joon) 0 or -0 where the mask is 0, which should both count as zero
+            all_lanes_zero_f32 &= all_lanes_zero(overwrite(fa & simd_u32_(0x80000000), is_lane_non_zero(mask), fa));
+
+            u32 lane_count = (first_lane_count > vector_index*HB_LANE_WIDTH) ? (first_lane_count - vector_index*HB_LANE_WIDTH) : 0;
+            store_u32_result(SimdTestOp_FirstLanesMask, get_first_lanes_mask(lane_count));
+        }
+
+        // NOTE(joon) add_all_lanes adds the pairs first((0+1) + (2+3)), so the partial sums are added the same way
+        for(u32 partial_sum_count = vector_count;
+                partial_sum_count > 1;
+                partial_sum_count /= 2)
+        {
+            for(u32 pair_index = 0;
+                    pair_index < partial_sum_count/2;
+                    ++pair_index)
+            {
+                partial_sums[pair_index] = partial_sums[2*pair_index] + partial_sums[2*pair_index + 1];
+            }
+        }
+
+        memcpy(data->results[SimdTestOp_AddAllLanesF32] + group_index, partial_sums, sizeof(r32));
+        data->results[SimdTestOp_AddAllLanesU32][group_index] = u32_sum;
+        data->results[SimdTestOp_NonZeroLaneCount][group_index] = non_zero_lane_count;
+        data->results[SimdTestOp_NonZeroLaneCountFromAllSetBit][group_index] = non_zero_lane_count_from_all_set_bit;
+        data->results[SimdTestOp_AllLanesZeroU32][group_index] = all_lanes_zero_u32 ? 1 : 0;
+        data->results[SimdTestOp_AllLanesZeroF32][group_index] = all_lanes_zero_f32 ? 1 : 0;
+    }
+}
+
+#endif
@@ -675,31 +675,8 @@ move_mass_agg_entity(GameState *game_state, Entity *entity, f32 dt_per_frame, b3
 {
     MassAgg *mass_agg = &entity->mass_agg;
 
-    for(u32 connection_index = 0;
-            connection_index < mass_agg->connection_count;
-            ++connection_index)
-    {
-        PiecewiseMassParticleConnection *connection = mass_agg->connections + connection_index;
-
-        MassParticle *particle_0 = mass_agg->particles + connection->ID_0;
-        MassParticle *particle_1 = mass_agg->particles + connection->ID_1;
-        v3 delta = particle_1->p - particle_0->p;
-        f32 delta_length = length(delta);
-        f32 length_diff = delta_length - connection->rest_length;
-
-        // TODO(joon) We do change both of the connected particles' positions, 
-        // but this all happens sequentially.. can we do something better?
-        if(abs(length_diff) > 0.0f)
-        {
-            v3 elastic_force = mass_agg->elastic_value * length_diff * (delta/delta_length); 
-            if(length(elastic_force) >= 10.0f)
-            {
-                int breakhere = 0;
-            }
-            particle_0->this_frame_force += elastic_force; 
-            particle_1->this_frame_force -= elastic_force;
-        }
-    }
+    // NOTE(joon) elastic forces between the connected particles
+    hot_kernels.accumulate_spring_forces(mass_agg);
 
     // NOTE(joon) first, apply gravity to start collision
     for(u32 particle_index = 0;
@@ -0,0 +1,1083 @@
+#include "hb_texture.h"
+
+/*
+   NOTE(joon) Mip generation is done in linear space(sRGB -> linear -> filter -> sRGB),
+   as filtering the sRGB values directly makes the smaller mips look darker than they should be.
+   Alpha is already linear, so it's filtered as it is.
+
+   To make the filtering SIMD friendly, each level is stored as 4 seperate f32 planes(r, g, b, a),
+   and the 2D filter is done with two 1D passes. Each pass filters along the y axis and writes the result transposed,
+   so that the lanes are always going across x where the source texels are continuous in memory.
+
+   After the second pass, the image is back to the original orientation.
+*/
+
+global b32 is_srgb_to_linear_table_initialized;
+global f32 srgb_to_linear_table[256];
+
+internal f32
+srgb_to_linear(f32 srgb_value)
+{
+    f32 result = 0.0f;
+
+    if(srgb_value <= 0.04045f)
+    {
+        result = srgb_value / 12.92f;
+    }
+    else
+    {
+        result = powf((srgb_value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    return result;
+}
+
+internal void
+initialize_srgb_to_linear_table(void)
+{
+    if(!is_srgb_to_linear_table_initialized)
+    {
+        for(u32 i = 0;
+                i < array_count(srgb_to_linear_table);
+                ++i)
+        {
+            srgb_to_linear_table[i] = srgb_to_linear(i / 255.0f);
+        }
+
+        is_srgb_to_linear_table_initialized = true;
+    }
+}
+
+// NOTE(joon) zeroth order modified bessel function of the first kind, only used for the kaiser window
+internal f32
+bessel_i0(f32 x)
+{
+    f32 result = 1.0f;
+
+    f32 term = 1.0f;
+    f32 quarter_x_square = 0.25f*x*x;
+    for(u32 k = 1;
+            k < 20;
+            ++k)
+    {
+        term *= quarter_x_square / (f32)(k*k);
+        result += term;
+    }
+
+    return result;
+}
+
+internal f32
+sinc(f32 x)
+{
+    f32 result = 1.0f;
+
+    if(x < -0.0001f || x > 0.0001f)
+    {
+        result = sinf(pi_32*x) / (pi_32*x);
+    }
+
+    return result;
+}
+
+internal MipFilterKernel
+get_mip_filter_kernel(MipFilter filter)
+{
+    MipFilterKernel result = {};
+
+    switch(filter)
+    {
+        case MipFilter_Box:
+        {
+            result.first_offset = 0;
+            result.tap_count = 2;
+            result.weights[0] = 0.5f;
+            result.weights[1] = 0.5f;
+        }break;
+
+        case MipFilter_Kaiser:
+        {
+            // NOTE(joon) radius is in source texels, and alpha is the trade off between the sharpness and the ringing.
+            // These are the values that most of the offline mip generators are using.
+            i32 radius = 4;
+            f32 alpha = 4.0f;
+
+            result.first_offset = -(radius - 1);
+            result.tap_count = 2*radius;
+            assert(result.tap_count <= array_count(result.weights));
+
+            f32 weight_sum = 0.0f;
+            for(u32 tap_index = 0;
+                    tap_index < result.tap_count;
+                    ++tap_index)
+            {
+                // NOTE(joon) center of the output texel i is at 2*i + 0.5 in source texel space
+                f32 d = (f32)(result.first_offset + (i32)tap_index) - 0.5f;
+                f32 t = d / (f32)radius;
+
+                f32 window = 0.0f;
+                if(t > -1.0f && t < 1.0f)
+                {
+                    window = bessel_i0(alpha*sqrtf(1.0f - t*t)) / bessel_i0(alpha);
+                }
+
+                // NOTE(joon) sinc is stretched by 2, because we are halving the frequency
+                f32 weight = sinc(0.5f*d) * window;
+
+                result.weights[tap_index] = weight;
+                weight_sum += weight;
+            }
+
+            for(u32 tap_index = 0;
+                    tap_index < result.tap_count;
+                    ++tap_index)
+            {
+                result.weights[tap_index] /= weight_sum;
+            }
+        }break;
+
+        default :
+        {
+            invalid_code_path;
+        }
+    }
+
+    return result;
+}
+
+// NOTE(joon) Halves the height of the source plane, and writes the result transposed
+// so that the next pass can do the exact same thing along the other axis.
+// dest should be able to hold source_width * max(source_height/2, 1) floats.
+internal void
+downsample_y_and_transpose(f32 *dest, f32 *source, u32 source_width, u32 source_height, MipFilterKernel *kernel)
+{
+    u32 dest_height = maximum(source_height/2, 1);
+    i32 max_source_y = (i32)source_height - 1;
+
+    u32 simd_end_x = source_width - (source_width % HB_LANE_WIDTH);
+
+    for(u32 dest_y = 0;
+            dest_y < dest_height;
+            ++dest_y)
+    {
+        // NOTE(joon) gather the source rows first, texels outside of the image are clamped to the edge
+        f32 *rows[array_count(kernel->weights)];
+        for(u32 tap_index = 0;
+                tap_index < kernel->tap_count;
+                ++tap_index)
+        {
+            i32 source_y = 2*(i32)dest_y + kernel->first_offset + (i32)tap_index;
+            source_y = clamp(0, source_y, max_source_y);
+
+            rows[tap_index] = source + source_y*source_width;
+        }
+
+        for(u32 x = 0;
+                x < simd_end_x;
+                x += HB_LANE_WIDTH)
+        {
+            simd_f32 sum = simd_f32_(0.0f);
+            for(u32 tap_index = 0;
+                    tap_index < kernel->tap_count;
+                    ++tap_index)
+            {
+                sum += simd_f32_(kernel->weights[tap_index]) * simd_f32_load(rows[tap_index] + x);
+            }
+
+            // NOTE(joon) transposed write, which means that the dest is dest_height wide
+            for(u32 lane = 0;
+                    lane < HB_LANE_WIDTH;
+                    ++lane)
+            {
+                dest[(x + lane)*dest_height + dest_y] = get_lane(sum, lane);
+            }
+        }
+
+        for(u32 x = simd_end_x;
+                x < source_width;
+                ++x)
+        {
+            f32 sum = 0.0f;
+            for(u32 tap_index = 0;
+                    tap_index < kernel->tap_count;
+                    ++tap_index)
+            {
+                sum += kernel->weights[tap_index] * rows[tap_index][x];
+            }
+
+            dest[x*dest_height + dest_y] = sum;
+        }
+    }
+}
+
+internal u32
+pack_linear_rgba_to_srgb_u32(f32 r, f32 g, f32 b, f32 a)
+{
+    u32 result = (round_r32_to_u32(255.0f*linear_to_srgb(clamp01(r))) << 0) |
+                 (round_r32_to_u32(255.0f*linear_to_srgb(clamp01(g))) << 8) |
+                 (round_r32_to_u32(255.0f*linear_to_srgb(clamp01(b))) << 16) |
+                 (round_r32_to_u32(255.0f*clamp01(a)) << 24);
+
+    return result;
+}
+
+// NOTE(joon) fills up the width & height of each mip, and returns the mip count
+internal u32
+get_mip_chain_dims(u32 width, u32 height, TextureMip *mips)
+{
+    u32 mip_count = 0;
+
+    while(mip_count < Max_Mip_Count)
+    {
+        TextureMip *mip = mips + mip_count++;
+        mip->width = width;
+        mip->height = height;
+
+        if(width == 1 && height == 1)
+        {
+            break;
+        }
+
+        width = maximum(width/2, 1);
+        height = maximum(height/2, 1);
+    }
+
+    return mip_count;
+}
+
+// NOTE(joon) Texel count of the level 1, which is the biggest one of the odd levels. 
+// Only the dims that are bigger than 1 get halved, so this is not always a quarter of the level 0(i.e 1xN image)
+internal u64
+get_mip_level_1_texel_count(u32 width, u32 height)
+{
+    u64 result = (u64)maximum(width/2, 1)*(u64)maximum(height/2, 1);
+
+    return result;
+}
+
+// NOTE(joon) Two sets of 4 planes that we ping pong between each level, and one plane for the transposed intermediate result
+internal u64
+get_mip_generation_temp_size(u32 width, u32 height)
+{
+    u64 texel_count = (u64)width*(u64)height;
+
+    u64 result = sizeof(f32)*(4*texel_count + // level 0, 2, 4...
+                              4*get_mip_level_1_texel_count(width, height) + // level 1, 3, 5...
+                              (texel_count/2 + width)); // intermediate
+
+    return result;
+}
+
+// NOTE(joon) pixels of all the mips except the 0th one should be already allocated,
+// and the mip dims should be already filled with get_mip_chain_dims
+internal void
+generate_mip_chain_(TempMemory *temp_memory, LoadedImage image, MipFilter filter, TextureMipChain *chain)
+{
+    initialize_srgb_to_linear_table();
+
+    MipFilterKernel kernel = get_mip_filter_kernel(filter);
+
+    u64 texel_count = (u64)image.width*(u64)image.height;
+    f32 *planes[2][4] = {};
+    for(u32 channel_index = 0;
+            channel_index < 4;
+            ++channel_index)
+    {
+        planes[0][channel_index] = push_array(temp_memory, f32, texel_count);
+        planes[1][channel_index] = push_array(temp_memory, f32, get_mip_level_1_texel_count(image.width, image.height));
+    }
+    f32 *intermediate = push_array(temp_memory, f32, (texel_count/2 + image.width));
+
+    // NOTE(joon) convert the level 0 to linear
+    for(u64 texel_index = 0;
+            texel_index < texel_count;
+            ++texel_index)
+    {
+        u32 pixel = image.pixels[texel_index];
+
+        planes[0][0][texel_index] = srgb_to_linear_table[(pixel >> 0) & 0xff];
+        planes[0][1][texel_index] = srgb_to_linear_table[(pixel >> 8) & 0xff];
+        planes[0][2][texel_index] = srgb_to_linear_table[(pixel >> 16) & 0xff];
+        planes[0][3][texel_index] = ((pixel >> 24) & 0xff) / 255.0f;
+    }
+
+    chain->mips[0].pixels = image.pixels;
+
+    for(u32 mip_index = 1;
+            mip_index < chain->mip_count;
+            ++mip_index)
+    {
+        TextureMip *source_mip = chain->mips + mip_index - 1;
+        TextureMip *dest_mip = chain->mips + mip_index;
+
+        // NOTE(joon) we keep the floating point result of the previous level instead of using the 8 bit one,
+        // so that the quantization error does not pile up as we go down the chain
+        f32 **source_planes = planes[(mip_index - 1) % 2];
+        f32 **dest_planes = planes[mip_index % 2];
+
+        u32 intermediate_width = maximum(source_mip->height/2, 1);
+        for(u32 channel_index = 0;
+                channel_index < 4;
+                ++channel_index)
+        {
+            downsample_y_and_transpose(intermediate, source_planes[channel_index],
+                                       source_mip->width, source_mip->height, &kernel);
+            downsample_y_and_transpose(dest_planes[channel_index], intermediate,
+                                       intermediate_width, source_mip->width, &kernel);
+        }
+
+        assert(dest_mip->width == maximum(source_mip->width/2, 1));
+        assert(dest_mip->height == intermediate_width);
+
+        u32 dest_texel_count = dest_mip->width*dest_mip->height;
+        for(u32 texel_index = 0;
+                texel_index < dest_texel_count;
+                ++texel_index)
+        {
+            dest_mip->pixels[texel_index] = pack_linear_rgba_to_srgb_u32(dest_planes[0][texel_index],
+                                                                        dest_planes[1][texel_index],
+                                                                        dest_planes[2][texel_index],
+                                                                        dest_planes[3][texel_index]);
+        }
+    }
+}
+
+// NOTE(joon) The 0th mip shares the pixels with the image
+internal TextureMipChain
+generate_mip_chain(MemoryArena *arena, MemoryArena *transient_arena, LoadedImage image, MipFilter filter)
+{
+    TextureMipChain result = {};
+    result.mip_count = get_mip_chain_dims(image.width, image.height, result.mips);
+
+    for(u32 mip_index = 1;
+            mip_index < result.mip_count;
+            ++mip_index)
+    {
+        TextureMip *mip = result.mips + mip_index;
+        mip->pixels = push_array(arena, u32, mip->width*mip->height);
+    }
+
+    TempMemory temp_memory = start_temp_memory(transient_arena, get_mip_generation_temp_size(image.width, image.height) + 64, false);
+    generate_mip_chain_(&temp_memory, image, filter, &result);
+    end_temp_memory(&temp_memory);
+
+    return result;
+}
+
+/*
+   NOTE(joon) Block compression
+
+   Every block compressed format works on 4x4 texel blocks. Blocks are completely independent,
+   so we split the block rows into a few work items and throw them into the work queue.
+
+   For all formats, the endpoints are found by using the bounding box of the block, with the 'diagonal' picked
+   by the covariance sign of each channel against the channel with the biggest range. Then the box is inset a bit,
+   as the extreme values are rarely the best endpoints. This is much cheaper than doing PCA,
+   and the quality loss is not that noticeable for the textures that we have.
+*/
+internal u32
+get_texture_format_block_size(TextureFormat format)
+{
+    u32 result = 0;
+
+    switch(format)
+    {
+        case TextureFormat_BC1:
+        {
+            result = 8;
+        }break;
+
+        case TextureFormat_BC3:
+        case TextureFormat_BC7:
+        {
+            result = 16;
+        }break;
+
+        default :
+        {
+            invalid_code_path;
+        }
+    }
+
+    return result;
+}
+
+internal u32
+get_texture_mip_data_size(TextureFormat format, u32 width, u32 height)
+{
+    u32 result = 0;
+
+    if(format == TextureFormat_RGBA8)
+    {
+        result = sizeof(u32)*width*height;
+    }
+    else
+    {
+        u32 block_count_x = (width + 3)/4;
+        u32 block_count_y = (height + 3)/4;
+
+        result = get_texture_format_block_size(format)*block_count_x*block_count_y;
+    }
+
+    return result;
+}
+
+// NOTE(joon) texels outside of the mip are clamped to the edge
+internal void
+load_texel_block(TextureMip *mip, u32 block_x, u32 block_y, u8 *texels)
+{
+    for(u32 y = 0;
+            y < 4;
+            ++y)
+    {
+        u32 texel_y = minimum(4*block_y + y, mip->height - 1);
+        for(u32 x = 0;
+                x < 4;
+                ++x)
+        {
+            u32 texel_x = minimum(4*block_x + x, mip->width - 1);
+            u32 pixel = mip->pixels[texel_y*mip->width + texel_x];
+
+            u8 *texel = texels + 4*(4*y + x);
+            texel[0] = (u8)((pixel >> 0) & 0xff);
+            texel[1] = (u8)((pixel >> 8) & 0xff);
+            texel[2] = (u8)((pixel >> 16) & 0xff);
+            texel[3] = (u8)((pixel >> 24) & 0xff);
+        }
+    }
+}
+
+// NOTE(joon) texels are always RGBA, but we only look at the first channel_count channels
+internal void
+get_block_endpoints(u8 *texels, u32 channel_count, u8 *e0, u8 *e1)
+{
+    i32 min_values[4] = {255, 255, 255, 255};
+    i32 max_values[4] = {};
+    i32 sums[4] = {};
+
+    for(u32 texel_index = 0;
+            texel_index < 16;
+            ++texel_index)
+    {
+        u8 *texel = texels + 4*texel_index;
+        for(u32 c = 0;
+                c < channel_count;
+                ++c)
+        {
+            min_values[c] = minimum(min_values[c], (i32)texel[c]);
+            max_values[c] = maximum(max_values[c], (i32)texel[c]);
+            sums[c] += texel[c];
+        }
+    }
+
+    u32 reference_channel = 0;
+    for(u32 c = 1;
+            c < channel_count;
+            ++c)
+    {
+        if(max_values[c] - min_values[c] > max_values[reference_channel] - min_values[reference_channel])
+        {
+            reference_channel = c;
+        }
+    }
+
+    // NOTE(joon) all values are multiplied by 16 to avoid dividing the sum to get the mean
+    i32 covariances[4] = {};
+    for(u32 texel_index = 0;
+            texel_index < 16;
+            ++texel_index)
+    {
+        u8 *texel = texels + 4*texel_index;
+        i32 reference_d = 16*texel[reference_channel] - sums[reference_channel];
+        for(u32 c = 0;
+                c < channel_count;
+                ++c)
+        {
+            covariances[c] += reference_d*(16*texel[c] - sums[c]);
+        }
+    }
+
+    for(u32 c = 0;
+            c < channel_count;
+            ++c)
+    {
+        i32 inset = (max_values[c] - min_values[c]) / 16;
+        i32 max_value = max_values[c] - inset;
+        i32 min_value = min_values[c] + inset;
+
+        if(covariances[c] >= 0)
+        {
+            e0[c] = (u8)max_value;
+            e1[c] = (u8)min_value;
+        }
+        else
+        {
+            e0[c] = (u8)min_value;
+            e1[c] = (u8)max_value;
+        }
+    }
+}
+
+internal u32
+get_squared_distance(u8 *a, u8 *b, u32 channel_count)
+{
+    u32 result = 0;
+    for(u32 c = 0;
+            c < channel_count;
+            ++c)
+    {
+        i32 d = (i32)a[c] - (i32)b[c];
+        result += (u32)(d*d);
+    }
+
+    return result;
+}
+
+internal u16
+pack_565(u8 *rgb)
+{
+    u32 r = (rgb[0]*31 + 127)/255;
+    u32 g = (rgb[1]*63 + 127)/255;
+    u32 b = (rgb[2]*31 + 127)/255;
+
+    u16 result = (u16)((r << 11) | (g << 5) | b);
+
+    return result;
+}
+
+internal void
+unpack_565(u16 color, u8 *rgb)
+{
+    u32 r = (color >> 11) & 31;
+    u32 g = (color >> 5) & 63;
+    u32 b = color & 31;
+
+    rgb[0] = (u8)((r << 3) | (r >> 2));
+    rgb[1] = (u8)((g << 2) | (g >> 4));
+    rgb[2] = (u8)((b << 3) | (b >> 2));
+}
+
+// NOTE(joon) 8 bytes : color0(565), color1(565), 2 bit index per texel.
+// We always make color0 > color1, which forces the 4 color mode.
+internal void
+encode_bc1_color_block(u8 *dest, u8 *texels)
+{
+    u8 e0[4] = {};
+    u8 e1[4] = {};
+    get_block_endpoints(texels, 3, e0, e1);
+
+    u16 color0 = pack_565(e0);
+    u16 color1 = pack_565(e1);
+    if(color0 < color1)
+    {
+        u16 temp = color0;
+        color0 = color1;
+        color1 = temp;
+    }
+
+    u32 indices = 0;
+    if(color0 != color1)
+    {
+        u8 palette[4][3] = {};
+        unpack_565(color0, palette[0]);
+        unpack_565(color1, palette[1]);
+        for(u32 c = 0;
+                c < 3;
+                ++c)
+        {
+            palette[2][c] = (u8)((2*palette[0][c] + palette[1][c] + 1)/3);
+            palette[3][c] = (u8)((palette[0][c] + 2*palette[1][c] + 1)/3);
+        }
+
+        for(u32 texel_index = 0;
+                texel_index < 16;
+                ++texel_index)
+        {
+            u8 *texel = texels + 4*texel_index;
+
+            u32 best_index = 0;
+            u32 best_distance = U32_Max;
+            for(u32 palette_index = 0;
+                    palette_index < 4;
+                    ++palette_index)
+            {
+                u32 distance = get_squared_distance(texel, palette[palette_index], 3);
+                if(distance < best_distance)
+                {
+                    best_distance = distance;
+                    best_index = palette_index;
+                }
+            }
+
+            indices |= (best_index << (2*texel_index));
+        }
+    }
+
+    dest[0] = (u8)(color0 & 0xff);
+    dest[1] = (u8)(color0 >> 8);
+    dest[2] = (u8)(color1 & 0xff);
+    dest[3] = (u8)(color1 >> 8);
+    dest[4] = (u8)(indices >> 0);
+    dest[5] = (u8)(indices >> 8);
+    dest[6] = (u8)(indices >> 16);
+    dest[7] = (u8)(indices >> 24);
+}
+
+// NOTE(joon) 8 bytes : alpha0, alpha1, 3 bit index per texel.
+// alpha0 > alpha1 is the 8 value mode, which is what we want unless the block has a constant alpha
+internal void
+encode_bc3_alpha_block(u8 *dest, u8 *texels)
+{
+    u8 alpha0 = 0;
+    u8 alpha1 = 255;
+    for(u32 texel_index = 0;
+            texel_index < 16;
+            ++texel_index)
+    {
+        u8 alpha = texels[4*texel_index + 3];
+        alpha0 = maximum(alpha0, alpha);
+        alpha1 = minimum(alpha1, alpha);
+    }
+
+    u64 indices = 0;
+    if(alpha0 > alpha1)
+    {
+        u8 palette[8] = {};
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        for(u32 i = 1;
+                i < 7;
+                ++i)
+        {
+            palette[i + 1] = (u8)(((7 - i)*alpha0 + i*alpha1 + 3)/7);
+        }
+
+        for(u32 texel_index = 0;
+                texel_index < 16;
+                ++texel_index)
+        {
+            i32 alpha = texels[4*texel_index + 3];
+
+            u64 best_index = 0;
+            i32 best_distance = I32_Max;
+            for(u32 palette_index = 0;
+                    palette_index < 8;
+                    ++palette_index)
+            {
+                i32 d = alpha - (i32)palette[palette_index];
+                if(d*d < best_distance)
+                {
+                    best_distance = d*d;
+                    best_index = palette_index;
+                }
+            }
+
+            indices |= (best_index << (3*texel_index));
+        }
+    }
+
+    dest[0] = alpha0;
+    dest[1] = alpha1;
+    for(u32 byte_index = 0;
+            byte_index < 6;
+            ++byte_index)
+    {
+        dest[2 + byte_index] = (u8)(indices >> (8*byte_index));
+    }
+}
+
+struct BitWriter
+{
+    u8 *dest;
+    u32 bit_offset;
+};
+
+// NOTE(joon) dest should be zeroed, bits are written from the LSB of each byte
+internal void
+write_bits(BitWriter *writer, u32 value, u32 bit_count)
+{
+    for(u32 bit_index = 0;
+            bit_index < bit_count;
+            ++bit_index)
+    {
+        if(value & (1 << bit_index))
+        {
+            writer->dest[writer->bit_offset/8] |= (u8)(1 << (writer->bit_offset%8));
+        }
+
+        writer->bit_offset++;
+    }
+}
+
+global u32 bc7_4bit_index_weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// NOTE(joon) mode 6 endpoints are 7 bits per channel + 1 p bit that is shared between the channels,
+// so we try both p bits and pick the one that is closer to the original endpoint
+internal void
+quantize_bc7_mode_6_endpoint(u8 *endpoint, u8 *quantized, u32 *p_bit, u8 *reconstructed)
+{
+    u32 best_error = U32_Max;
+    for(u32 p = 0;
+            p < 2;
+            ++p)
+    {
+        u8 q[4] = {};
+        u8 r[4] = {};
+        u32 error = 0;
+        for(u32 c = 0;
+                c < 4;
+                ++c)
+        {
+            i32 value = ((i32)endpoint[c] - (i32)p + 1) >> 1;
+            value = clamp(0, value, 127);
+
+            q[c] = (u8)value;
+            r[c] = (u8)((value << 1) | p);
+
+            i32 d = (i32)r[c] - (i32)endpoint[c];
+            error += (u32)(d*d);
+        }
+
+        if(error < best_error)
+        {
+            best_error = error;
+            *p_bit = p;
+            for(u32 c = 0;
+                    c < 4;
+                    ++c)
+            {
+                quantized[c] = q[c];
+                reconstructed[c] = r[c];
+            }
+        }
+    }
+}
+
+/*
+   NOTE(joon) BC7 mode 6 layout(128 bits, LSB first)
+   mode(7 bits, 0b1000000) | R0 R1 G0 G1 B0 B1 A0 A1 (7 bits each) | P0 P1 | indices(first one is 3 bits, rest are 4 bits)
+
+   The MSB of the first index(anchor index) is implicitly 0, so if the first texel ends up with the index >= 8,
+   we swap the endpoints and invert all the indices. Because the weights are symmetric, the result stays the same.
+*/
+internal void
+encode_bc7_mode_6_block(u8 *dest, u8 *texels)
+{
+    u8 e0[4] = {};
+    u8 e1[4] = {};
+    get_block_endpoints(texels, 4, e0, e1);
+
+    u8 quantized[2][4] = {};
+    u8 reconstructed[2][4] = {};
+    u32 p_bits[2] = {};
+    quantize_bc7_mode_6_endpoint(e0, quantized[0], p_bits + 0, reconstructed[0]);
+    quantize_bc7_mode_6_endpoint(e1, quantized[1], p_bits + 1, reconstructed[1]);
+
+    u8 palette[16][4] = {};
+    for(u32 palette_index = 0;
+            palette_index < 16;
+            ++palette_index)
+    {
+        u32 w = bc7_4bit_index_weights[palette_index];
+        for(u32 c = 0;
+                c < 4;
+                ++c)
+        {
+            palette[palette_index][c] = (u8)(((64 - w)*reconstructed[0][c] + w*reconstructed[1][c] + 32) >> 6);
+        }
+    }
+
+    u32 indices[16] = {};
+    for(u32 texel_index = 0;
+            texel_index < 16;
+            ++texel_index)
+    {
+        u8 *texel = texels + 4*texel_index;
+
+        u32 best_distance = U32_Max;
+        for(u32 palette_index = 0;
+                palette_index < 16;
+                ++palette_index)
+        {
+            u32 distance = get_squared_distance(texel, palette[palette_index], 4);
+            if(distance < best_distance)
+            {
+                best_distance = distance;
+                indices[texel_index] = palette_index;
+            }
+        }
+    }
+
+    u32 first = 0;
+    u32 second = 1;
+    if(indices[0] & 8)
+    {
+        first = 1;
+        second = 0;
+        for(u32 texel_index = 0;
+                texel_index < 16;
+                ++texel_index)
+        {
+            indices[texel_index] = 15 - indices[texel_index];
+        }
+    }
+
+    for(u32 byte_index = 0;
+            byte_index < 16;
+            ++byte_index)
+    {
+        dest[byte_index] = 0;
+    }
+
+    BitWriter writer = {};
+    writer.dest = dest;
+
+    write_bits(&writer, 1 << 6, 7);
+    for(u32 c = 0;
+            c < 4;
+            ++c)
+    {
+        write_bits(&writer, quantized[first][c], 7);
+        write_bits(&writer, quantized[second][c], 7);
+    }
+    write_bits(&writer, p_bits[first], 1);
+    write_bits(&writer, p_bits[second], 1);
+
+    write_bits(&writer, indices[0], 3);
+    for(u32 texel_index = 1;
+            texel_index < 16;
+            ++texel_index)
+    {
+        write_bits(&writer, indices[texel_index], 4);
+    }
+
+    assert(writer.bit_offset == 128);
+}
+
+struct BlockCompressionWork
+{
+    TextureFormat format;
+    TextureMip *mip;
+    u8 *dest;
+
+    u32 first_block_y;
+    u32 one_past_last_block_y;
+};
+
+internal void
+compress_block_rows(BlockCompressionWork *work)
+{
+    TextureMip *mip = work->mip;
+    u32 block_size = get_texture_format_block_size(work->format);
+    u32 block_count_x = (mip->width + 3)/4;
+
+    for(u32 block_y = work->first_block_y;
+            block_y < work->one_past_last_block_y;
+            ++block_y)
+    {
+        for(u32 block_x = 0;
+                block_x < block_count_x;
+                ++block_x)
+        {
+            u8 texels[4*16];
+            load_texel_block(mip, block_x, block_y, texels);
+
+            u8 *block = work->dest + block_size*(block_y*block_count_x + block_x);
+            switch(work->format)
+            {
+                case TextureFormat_BC1:
+                {
+                    encode_bc1_color_block(block, texels);
+                }break;
+
+                case TextureFormat_BC3:
+                {
+                    encode_bc3_alpha_block(block, texels);
+                    encode_bc1_color_block(block + 8, texels);
+                }break;
+
+                case TextureFormat_BC7:
+                {
+                    encode_bc7_mode_6_block(block, texels);
+                }break;
+
+                default :
+                {
+                    invalid_code_path;
+                }
+            }
+        }
+    }
+}
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_compress_block_rows)
+{
+    BlockCompressionWork *work = (BlockCompressionWork *)data;
+    compress_block_rows(work);
+}
+
+#define Max_Block_Compression_Work_Count_Per_Mip 32
+
+/*
+   NOTE(joon) cooked texture = CookedTextureHeader + CookedTextureMip[mip_count] + mip data,
+   and the whole thing is allocated in the arena, so that the caller can just write the memory into the file.
+   If the queue is 0, everything is done in this thread.
+*/
+internal CookedTexture
+cook_texture(MemoryArena *arena, MemoryArena *transient_arena, thread_work_queue *queue,
+             LoadedImage image, TextureFormat format, MipFilter filter)
+{
+    CookedTexture result = {};
+
+    TextureMipChain chain = {};
+    chain.mip_count = get_mip_chain_dims(image.width, image.height, chain.mips);
+
+    u64 mip_pixel_count = 0;
+    u32 cooked_size = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip)*chain.mip_count;
+    for(u32 mip_index = 0;
+            mip_index < chain.mip_count;
+            ++mip_index)
+    {
+        TextureMip *mip = chain.mips + mip_index;
+        if(mip_index != 0)
+        {
+            mip_pixel_count += mip->width*mip->height;
+        }
+
+        cooked_size += get_texture_mip_data_size(format, mip->width, mip->height);
+    }
+
+    u64 temp_size = get_mip_generation_temp_size(image.width, image.height) +
+                    sizeof(u32)*mip_pixel_count +
+                    sizeof(BlockCompressionWork)*Max_Block_Compression_Work_Count_Per_Mip*chain.mip_count +
+                    64;
+    TempMemory temp_memory = start_temp_memory(transient_arena, temp_size, false);
+
+    for(u32 mip_index = 1;
+            mip_index < chain.mip_count;
+            ++mip_index)
+    {
+        TextureMip *mip = chain.mips + mip_index;
+        mip->pixels = push_array(&temp_memory, u32, mip->width*mip->height);
+    }
+    BlockCompressionWork *works = push_array(&temp_memory, BlockCompressionWork, Max_Block_Compression_Work_Count_Per_Mip*chain.mip_count);
+
+    generate_mip_chain_(&temp_memory, image, filter, &chain);
+
+    result.size = cooked_size;
+    result.memory = (u8 *)push_size(arena, result.size);
+
+    CookedTextureHeader *header = (CookedTextureHeader *)result.memory;
+    header->magic = Cooked_Texture_Magic;
+    header->version = Cooked_Texture_Version;
+    header->format = format;
+    header->width = image.width;
+    header->height = image.height;
+    header->mip_count = chain.mip_count;
+
+    CookedTextureMip *cooked_mips = (CookedTextureMip *)(header + 1);
+    u32 offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip)*chain.mip_count;
+
+    u32 work_count = 0;
+    for(u32 mip_index = 0;
+            mip_index < chain.mip_count;
+            ++mip_index)
+    {
+        TextureMip *mip = chain.mips + mip_index;
+
+        CookedTextureMip *cooked_mip = cooked_mips + mip_index;
+        cooked_mip->width = mip->width;
+        cooked_mip->height = mip->height;
+        cooked_mip->offset = offset;
+        cooked_mip->size = get_texture_mip_data_size(format, mip->width, mip->height);
+
+        u8 *dest = result.memory + offset;
+        offset += cooked_mip->size;
+
+        if(format == TextureFormat_RGBA8)
+        {
+            memcpy(dest, mip->pixels, cooked_mip->size);
+        }
+        else
+        {
+            u32 block_count_y = (mip->height + 3)/4;
+            u32 block_row_count_per_work = (block_count_y + Max_Block_Compression_Work_Count_Per_Mip - 1) / Max_Block_Compression_Work_Count_Per_Mip;
+
+            for(u32 block_y = 0;
+                    block_y < block_count_y;
+                    block_y += block_row_count_per_work)
+            {
+                BlockCompressionWork *work = works + work_count++;
+                work->format = format;
+                work->mip = mip;
+                work->dest = dest;
+                work->first_block_y = block_y;
+                work->one_past_last_block_y = minimum(block_y + block_row_count_per_work, block_count_y);
+
+                if(queue)
+                {
+                    queue->add_thread_work_queue_item(queue, thread_work_callback_compress_block_rows, (void *)work);
+                }
+                else
+                {
+                    thread_work_callback_compress_block_rows((void *)work);
+                }
+            }
+        }
+    }
+    assert(offset == result.size);
+
+    if(queue)
+    {
+        queue->complete_all_thread_work_queue_items(queue);
+    }
+
+    end_temp_memory(&temp_memory);
+
+    return result;
+}
+
+internal CookedTextureMip *
+get_cooked_texture_mip(CookedTextureHeader *header, u32 mip_index)
+{
+    assert(header->magic == Cooked_Texture_Magic);
+    assert(mip_index < header->mip_count);
+
+    CookedTextureMip *result = (CookedTextureMip *)(header + 1) + mip_index;
+
+    return result;
+}
+
+// NOTE(joon) Returns 0 if the memory is not a cooked texture that we can read,
+// or if any of the mips would go past the end of it
+internal CookedTextureHeader *
+get_cooked_texture_header(u8 *memory, u64 size)
+{
+    CookedTextureHeader *result = 0;
+
+    CookedTextureHeader *header = (CookedTextureHeader *)memory;
+    if(size >= sizeof(CookedTextureHeader) &&
+       header->magic == Cooked_Texture_Magic &&
+       header->version == Cooked_Texture_Version &&
+       header->format <= TextureFormat_BC7 &&
+       header->mip_count > 0 && header->mip_count <= Max_Mip_Count &&
+       size >= sizeof(CookedTextureHeader) + sizeof(CookedTextureMip)*header->mip_count)
+    {
+        result = header;
+        for(u32 mip_index = 0;
+                mip_index < header->mip_count;
+                ++mip_index)
+        {
+            CookedTextureMip *mip = get_cooked_texture_mip(header, mip_index);
+            if((u64)mip->offset + (u64)mip->size > size ||
+               mip->size != get_texture_mip_data_size((TextureFormat)header->format, mip->width, mip->height))
+            {
+                result = 0;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef HB_TEXTURE_H
+#define HB_TEXTURE_H
+
+// NOTE(joon) 8 bits per channel, and the order in memory is always R G B A,
+// which means that in u32 it looks like 0xAABBGGRR
+struct LoadedImage
+{
+    u32 width;
+    u32 height;
+
+    u32 *pixels;
+};
+
+enum TextureFormat
+{
+    TextureFormat_RGBA8,
+
+    // NOTE(joon) All of the block compressed formats work on 4x4 texel blocks
+    TextureFormat_BC1, // 8 bytes per block, RGB only(we never use the 1 bit alpha mode)
+    TextureFormat_BC3, // 16 bytes per block, BC1 color + 8 bit interpolated alpha
+    TextureFormat_BC7, // 16 bytes per block, only mode 6 for now(single subset, RGBA 7.7.7.7 + p bit, 4 bit indices)
+};
+
+enum MipFilter
+{
+    MipFilter_Box, // 2x2 average, cheap but blurry & aliases a bit
+    MipFilter_Kaiser, // kaiser windowed sinc, sharper mips
+};
+
+struct TextureMip
+{
+    u32 width;
+    u32 height;
+
+    u32 *pixels; // same layout as LoadedImage
+};
+
+// NOTE(joon) Each mip level is at most half the size of the previous one,
+// so 16 levels are enough for 32k x 32k textures
+#define Max_Mip_Count 16
+
+struct TextureMipChain
+{
+    TextureMip mips[Max_Mip_Count];
+    u32 mip_count;
+};
+
+// NOTE(joon) Separable 1D kernel that is used to get the half sized image.
+// The output texel i uses the source texels starting from 2*i + first_offset
+struct MipFilterKernel
+{
+    i32 first_offset;
+    u32 tap_count;
+    f32 weights[16];
+};
+
+struct CookedTexture
+{
+    u8 *memory;
+    u32 size;
+};
+
+#endif
@@ -2,9 +2,6 @@
 #define Hash_Is_Empty U32_Max
 
 #if 1
-// NOTE(joon) if the chunk was empty, x value of the chunk hash is set to this value
-#define Empty_Hash U32_Max
-
 internal void
 initialize_voxel_world(VoxelWorld *world)
 {
@@ -19,20 +16,29 @@ initialize_voxel_world(VoxelWorld *world)
         hash->z = Empty_Hash;
 
         hash->first_node_offset = Empty_Hash; 
-    }
-
-    // TODO(joon) this helps when we simulate the voxels, but we can use SVO or DAG when we 'store' the voxels as a map!
-    // or, we can just store the leaf nodes sparsely, as the leaf nodes takes the most of the space
-    for(u32 i = 0;
-            i < 8;
-            ++i)
-    {
-        world->node_count_per_chunk += power((u32)8, (u32)i);
+        hash->first_child_offset = 0;
+        hash->first_node_voxel_count_offset = 0;
+        hash->first_brick_offset = 0;
+        hash->first_color_offset = 0;
+        hash->root_node_index = 0;
+        hash->node_count = 0;
+        hash->child_count = 0;
+        hash->brick_count = 0;
+        hash->voxel_count = 0;
+
+        hash->baked_face_keys = 0;
+        hash->baked_face_lighting = 0;
+        hash->baked_face_count = 0;
     }
 
     world->chunk_dim = 256;
     world->lod = 8;
     assert(power((u32)2, (u32)world->lod) == world->chunk_dim);
+    assert(world->lod <= Max_Voxel_Lod);
+    // NOTE(joon) the last 2 levels are inside the bricks, see VoxelOctree
+    assert(world->lod >= 3);
+
+    world->voxel_dim = 1.0f;
 }
 
 internal VoxelChunkHash *
@@ -200,179 +206,538 @@ struct voxel_chunk_surface_mask
     u8 *neg_z_mask;
 };
 
-internal void
-insert_voxel(u8 *start, u32 stride, u32 x, u32 y, u32 z, u32 dim, u32 lod)
+// NOTE(joon) x, y, z are inside the chunk. Interleaves the bits from the most significant one, 
+// with x being the lowest of each 3 bits. This is the same order as the octree, as the bit index of a child is (z << 2 | y << 1 | x)
+internal u64
+get_voxel_morton_code(u32 x, u32 y, u32 z, u32 lod)
 {
-    if(dim == 1)
+    u64 result = 0;
+    for(i32 bit = (i32)lod - 1;
+            bit >= 0;
+            --bit)
     {
-        return;
+        result = (result << 3) | 
+                 ((x >> bit) & 1) | 
+                 (((y >> bit) & 1) << 1) | 
+                 (((z >> bit) & 1) << 2);
     }
 
-    u8 x_mask = 0;
-    u8 y_mask = 0;
-    u8 z_mask = 0;
+    return result;
+}
 
-    u32 half_dim = dim/2;
-    if(z >= half_dim)
-    {
-        z_mask = voxel_pos_z_mask;
-        z -= half_dim;
-    }
-    else
+// NOTE(joon) LSD radix sort, 8 bits at a time. Only the lowest key_bit_count bits are used, and the result ends up in keys
+internal void
+radix_sort_u64(u64 *keys, u64 *temp, u32 count, u32 key_bit_count)
+{
+    u64 *source = keys;
+    u64 *dest = temp;
+    for(u32 shift = 0;
+            shift < key_bit_count;
+            shift += 8)
     {
-        z_mask = voxel_neg_z_mask;
-    }
+        u32 offsets[256] = {};
+        for(u32 key_index = 0;
+                key_index < count;
+                ++key_index)
+        {
+            offsets[(source[key_index] >> shift) & 0xff]++;
+        }
 
-    if(x >= half_dim)
-    {
-        x_mask = voxel_pos_x_mask;
-        x -= half_dim;
+        u32 offset = 0;
+        for(u32 digit = 0;
+                digit < 256;
+                ++digit)
+        {
+            u32 digit_count = offsets[digit];
+            offsets[digit] = offset;
+            offset += digit_count;
+        }
+
+        for(u32 key_index = 0;
+                key_index < count;
+                ++key_index)
+        {
+            dest[offsets[(source[key_index] >> shift) & 0xff]++] = source[key_index];
+        }
+
+        u64 *temp_pointer = source;
+        source = dest;
+        dest = temp_pointer;
     }
-    else
+
+    if(source != keys)
     {
-        x_mask = voxel_neg_x_mask;
+        memcpy(keys, source, sizeof(u64)*count);
     }
+}
+
+/*
+   NOTE(joon) Where build_voxel_chunk_dag puts everything before it knows how many unique nodes there are.
+   Sized for the chunk with the most voxels(see get_voxel_dag_build_scratch_size), and reused for every chunk.
+*/
+struct VoxelDAGBuildScratch
+{
+    // NOTE(joon) unique prefixes of the morton codes at the current level & the next level, 
+    // with the index of the node(or the brick) that each of them ended up as
+    u64 *prefixes[2];
+    u32 *indices[2];
+
+    u64 *bricks;
+    u32 *nodes;
+    u32 *children;
+    u32 *node_voxel_counts;
+
+    // NOTE(joon) open addressing, indices of the unique nodes(or the bricks) of the current level
+    u32 *hash_table;
+    u32 hash_table_size;
+};
 
-    if(y >= half_dim)
+struct VoxelDAGBuildBounds
+{
+    u32 max_brick_count;
+    u32 max_node_count;
+    u32 max_child_count;
+    u32 hash_table_size;
+};
+
+// NOTE(joon) a level can not have more prefixes than the voxels, or the cells of that level
+internal VoxelDAGBuildBounds
+get_voxel_dag_build_bounds(u32 lod, u32 max_voxel_count)
+{
+    VoxelDAGBuildBounds result = {};
+
+    u32 node_level_count = lod - 2;
+    for(u32 level = 0;
+            level <= node_level_count;
+            ++level)
     {
-        y_mask = voxel_pos_y_mask;
-        y -= half_dim;
+        u32 max_level_count = (u32)minimum((u64)max_voxel_count, (u64)1 << (3*level));
+        if(level < node_level_count)
+        {
+            result.max_node_count += max_level_count;
+        }
+        else
+        {
+            result.max_brick_count = max_level_count;
+        }
+
+        if(level > 0)
+        {
+            result.max_child_count += max_level_count;
+        }
     }
-    else
+
+    // NOTE(joon) the bricks are the level with the most prefixes. Keep the table at most half full
+    result.hash_table_size = 1;
+    while(result.hash_table_size < 2*result.max_brick_count)
     {
-        y_mask = voxel_neg_y_mask;
+        result.hash_table_size *= 2;
     }
 
-    u8 *node = start + stride;
-
-    u32 node_size = 1;
+    return result;
+}
 
-    u8 voxel_mask = x_mask & y_mask & z_mask; 
-    *node = *node | voxel_mask;
+internal u64
+get_voxel_dag_build_scratch_size(u32 lod, u32 max_voxel_count)
+{
+    VoxelDAGBuildBounds bounds = get_voxel_dag_build_bounds(lod, max_voxel_count);
 
-    u8 *next_lod_start = start + node_size * power((u32)8, (u32)lod);
-    u32 set_bit_index = find_most_significant_bit(voxel_mask);
-    u32 next_stride = 8 * stride + set_bit_index * node_size;
+    u64 result = 2*(sizeof(u64) + sizeof(u32))*(u64)bounds.max_brick_count + 
+                 sizeof(u64)*(u64)bounds.max_brick_count + 
+                 2*sizeof(u32)*(u64)bounds.max_node_count + 
+                 sizeof(u32)*(u64)bounds.max_child_count + 
+                 sizeof(u32)*(u64)bounds.hash_table_size;
 
-    insert_voxel(next_lod_start, next_stride, x, y, z, dim/2, lod+1);
+    return result;
 }
 
-
-internal void
-allocate_voxel_chunk_from_vox_file(VoxelWorld *world, MemoryArena *arena, load_vox_result vox)
+/*
+   NOTE(joon) The most that allocate_voxel_chunk_from_vox_file can push into the voxel memory.
+   Each level of a chunk is bounded the same way as the scratch(see get_voxel_dag_build_bounds),
+   but the voxels can be spread across every chunk of the world, so the cells of a level are multiplied by the chunk count.
+*/
+internal u64
+get_max_voxel_memory_size(VoxelWorld *world, u32 voxel_count)
 {
-    for(u32 voxel_index = 0;
-            voxel_index < vox.voxel_count;
-            ++voxel_index)
-    {
-        // TODO(joon) we also need to take account of the chunk pos?
-        u8 x = vox.xs[voxel_index];
-        u8 y = vox.ys[voxel_index];
-        u8 z = vox.zs[voxel_index];
-
-        // TODO(joon) This might take more time, but is necessarily because the order of the voxels are unpredictable
-        // because we are keep loading the voxels from the vox file without keeping the chunk information.
-        // we can definitely do better here
-        VoxelChunkHash *chunk = get_voxel_chunk_hash(world->chunk_hashes, array_count(world->chunk_hashes), x, y, z);
+    u64 result = voxel_count; // color ids
 
-        u8 *nodes = 0;
-        if(chunk->first_node_offset == U32_Max)
+    u64 chunk_count = array_count(world->chunk_hashes);
+    u32 node_level_count = world->lod - 2;
+    for(u32 level = 0;
+            level <= node_level_count;
+            ++level)
+    {
+        u64 max_level_count = minimum((u64)voxel_count, chunk_count << (3*level));
+        if(level < node_level_count)
         {
-            u32 prev_used_amount = arena->used;
-            nodes = (u8 *)push_size(arena, world->node_count_per_chunk);
-            chunk->first_node_offset = prev_used_amount;
+            // NOTE(joon) node & the voxel count
+            result += 2*sizeof(u32)*max_level_count;
         }
         else
         {
-            nodes = (u8 *)arena->base + chunk->first_node_offset;
+            result += sizeof(u64)*max_level_count;
         }
 
-        insert_voxel(nodes, 0, x, y, z, world->chunk_dim, 0);
+        if(level > 0)
+        {
+            result += sizeof(u32)*max_level_count;
+        }
     }
 
-    //validate_voxels_with_vox_file(loaded_vox, nodes);
+    return result;
 }
 
-// NOTE(joon) inputs are represented in raw voxel space
-// TODO(joon) also take account of the the chunk!
+internal VoxelDAGBuildScratch
+push_voxel_dag_build_scratch(TempMemory *temp_memory, u32 lod, u32 max_voxel_count)
+{
+    VoxelDAGBuildBounds bounds = get_voxel_dag_build_bounds(lod, max_voxel_count);
+
+    VoxelDAGBuildScratch result = {};
+    for(u32 buffer_index = 0;
+            buffer_index < 2;
+            ++buffer_index)
+    {
+        result.prefixes[buffer_index] = push_array(temp_memory, u64, bounds.max_brick_count);
+        result.indices[buffer_index] = push_array(temp_memory, u32, bounds.max_brick_count);
+    }
+    result.bricks = push_array(temp_memory, u64, bounds.max_brick_count);
+    result.nodes = push_array(temp_memory, u32, bounds.max_node_count);
+    result.node_voxel_counts = push_array(temp_memory, u32, bounds.max_node_count);
+    result.children = push_array(temp_memory, u32, bounds.max_child_count);
+    result.hash_table = push_array(temp_memory, u32, bounds.hash_table_size);
+    result.hash_table_size = bounds.hash_table_size;
 
-struct GetVoxelResult
+    return result;
+}
+
+// NOTE(joon) index of the brick that has the same occupancy, which gets added if there was no such brick
+internal u32
+find_or_add_voxel_dag_brick(VoxelDAGBuildScratch *scratch, u32 *brick_count, u64 occupancy)
 {
-    b32 exist;
-};
+    u32 result = Hash_Is_Empty;
 
-internal void
-get_voxel(u8 *start, u32 stride, u32 x, u32 y, u32 z, u32 dim, u32 lod, GetVoxelResult *result)
+    u32 slot = hash_u32((u32)occupancy ^ hash_u32((u32)(occupancy >> 32))) & (scratch->hash_table_size - 1);
+    while(scratch->hash_table[slot] != Hash_Is_Empty)
+    {
+        if(scratch->bricks[scratch->hash_table[slot]] == occupancy)
+        {
+            result = scratch->hash_table[slot];
+            break;
+        }
+
+        slot = (slot + 1) & (scratch->hash_table_size - 1);
+    }
+
+    if(result == Hash_Is_Empty)
+    {
+        result = (*brick_count)++;
+        scratch->bricks[result] = occupancy;
+        scratch->hash_table[slot] = result;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) index of the node that has the same child mask & the children, which gets added if there was no such node.
+   Because the children were already merged, comparing the indices of the children is the same as comparing the whole subtree.
+   The hash table should only have the nodes of the same level, as the same children mean different things in different levels.
+*/
+internal u32
+find_or_add_voxel_dag_node(VoxelDAGBuildScratch *scratch, u32 *node_count, u32 *child_count,
+                           u32 child_mask, u32 *children, u32 node_child_count, u32 voxel_count)
 {
-    u32 node_size = 1;
+    u32 result = Hash_Is_Empty;
 
-    u8 x_mask = 0;
-    u8 y_mask = 0;
-    u8 z_mask = 0;
+    u32 hash = hash_u32(child_mask);
+    for(u32 child_index = 0;
+            child_index < node_child_count;
+            ++child_index)
+    {
+        hash = hash_u32(hash ^ children[child_index]);
+    }
 
-    u32 half_dim = dim/2;
-    if(z >= half_dim)
+    u32 slot = hash & (scratch->hash_table_size - 1);
+    while(scratch->hash_table[slot] != Hash_Is_Empty)
     {
-        z_mask = voxel_pos_z_mask;
-        z -= half_dim;
+        u32 node = scratch->nodes[scratch->hash_table[slot]];
+        if((node & 0xff) == child_mask && 
+           memcmp(scratch->children + (node >> 8), children, sizeof(children[0])*node_child_count) == 0)
+        {
+            result = scratch->hash_table[slot];
+            break;
+        }
+
+        slot = (slot + 1) & (scratch->hash_table_size - 1);
     }
-    else
+
+    if(result == Hash_Is_Empty)
     {
-        z_mask = voxel_neg_z_mask;
+        // NOTE(joon) the first child index only has 24 bits
+        assert(*child_count + node_child_count <= (1 << 24));
+
+        result = (*node_count)++;
+        scratch->nodes[result] = child_mask | (*child_count << 8);
+        scratch->node_voxel_counts[result] = voxel_count;
+        memcpy(scratch->children + *child_count, children, sizeof(children[0])*node_child_count);
+        *child_count += node_child_count;
+
+        scratch->hash_table[slot] = result;
     }
 
-    if(x >= half_dim)
+    return result;
+}
+
+/*
+   NOTE(joon) keys are (morton code << 8 | color id) of the voxels inside the chunk, sorted.
+   Because the children of a node are always in the order of their bit index, sorting by the morton code puts the voxels
+   in the same order as the octree, so the nodes of each level are just the unique prefixes of the codes.
+   The DAG gets built bottom-up from the bricks, and each level merges the nodes that have the same children
+   with a hash table before going up. This way, the whole octree never has to exist.
+   The color ids are already in the right order(see VoxelOctree), so they are stored as they are.
+*/
+internal void
+build_voxel_chunk_dag(VoxelWorld *world, MemoryArena *arena, VoxelChunkHash *chunk, u64 *keys, u32 key_count,
+                      VoxelDAGBuildScratch *scratch)
+{
+    u32 lod = world->lod;
+    u32 node_level_count = lod - 2;
+
+    // NOTE(joon) the duplicates keep the smallest color id
+    u32 voxel_count = 0;
+    for(u32 key_index = 0;
+            key_index < key_count;
+            ++key_index)
     {
-        x_mask = voxel_pos_x_mask;
-        x -= half_dim;
+        if(voxel_count == 0 || (keys[key_index] >> 8) != (keys[voxel_count - 1] >> 8))
+        {
+            keys[voxel_count++] = keys[key_index];
+        }
     }
-    else
+
+    u32 brick_count = 0;
+    u32 node_count = 0;
+    u32 child_count = 0;
+
+    u64 *prefixes = scratch->prefixes[0];
+    u32 *indices = scratch->indices[0];
+    u32 prefix_count = 0;
+
+    memset(scratch->hash_table, 0xff, sizeof(scratch->hash_table[0])*scratch->hash_table_size);
+    u64 occupancy = 0;
+    for(u32 voxel_index = 0;
+            voxel_index < voxel_count;
+            ++voxel_index)
     {
-        x_mask = voxel_neg_x_mask;
+        u64 morton_code = keys[voxel_index] >> 8;
+        occupancy |= (1ull << (morton_code & 63));
+
+        if(voxel_index + 1 == voxel_count || (morton_code >> 6) != (keys[voxel_index + 1] >> 14))
+        {
+            prefixes[prefix_count] = morton_code >> 6;
+            indices[prefix_count] = find_or_add_voxel_dag_brick(scratch, &brick_count, occupancy);
+            prefix_count++;
+
+            occupancy = 0;
+        }
     }
 
-    if(y >= half_dim)
+    for(i32 level = (i32)node_level_count - 1;
+            level >= 0;
+            --level)
     {
-        y_mask = voxel_pos_y_mask;
-        y -= half_dim;
+        u64 *child_prefixes = prefixes;
+        u32 *child_indices = indices;
+        u32 child_prefix_count = prefix_count;
+
+        u32 buffer_index = (node_level_count - level) & 1;
+        prefixes = scratch->prefixes[buffer_index];
+        indices = scratch->indices[buffer_index];
+        prefix_count = 0;
+
+        memset(scratch->hash_table, 0xff, sizeof(scratch->hash_table[0])*scratch->hash_table_size);
+        for(u32 child_prefix_index = 0;
+                child_prefix_index < child_prefix_count;
+           )
+        {
+            // NOTE(joon) the parent is the child prefix without the last 3 bits
+            u64 prefix = child_prefixes[child_prefix_index] >> 3;
+
+            u32 child_mask = 0;
+            u32 children[8];
+            u32 node_child_count = 0;
+            u32 node_voxel_count = 0;
+            while(child_prefix_index < child_prefix_count && 
+                  (child_prefixes[child_prefix_index] >> 3) == prefix)
+            {
+                u32 child = child_indices[child_prefix_index];
+                child_mask |= (1 << (child_prefixes[child_prefix_index] & 7));
+                children[node_child_count++] = child;
+                node_voxel_count += ((u32)level + 1 < node_level_count) ? 
+                                    scratch->node_voxel_counts[child] : count_set_bit_u64(scratch->bricks[child]);
+
+                child_prefix_index++;
+            }
+
+            prefixes[prefix_count] = prefix;
+            indices[prefix_count] = find_or_add_voxel_dag_node(scratch, &node_count, &child_count, 
+                                                               child_mask, children, node_child_count, node_voxel_count);
+            prefix_count++;
+        }
+    }
+    assert(prefix_count == 1);
+
+    u32 *nodes = push_array(arena, u32, node_count);
+    u32 *children = push_array(arena, u32, child_count);
+    u32 *node_voxel_counts = push_array(arena, u32, node_count);
+    u64 *bricks = push_array(arena, u64, brick_count);
+    u8 *color_ids = push_array(arena, u8, voxel_count);
+
+    memcpy(nodes, scratch->nodes, sizeof(nodes[0])*node_count);
+    memcpy(children, scratch->children, sizeof(children[0])*child_count);
+    memcpy(node_voxel_counts, scratch->node_voxel_counts, sizeof(node_voxel_counts[0])*node_count);
+    memcpy(bricks, scratch->bricks, sizeof(bricks[0])*brick_count);
+    for(u32 voxel_index = 0;
+            voxel_index < voxel_count;
+            ++voxel_index)
+    {
+        color_ids[voxel_index] = (u8)(keys[voxel_index] & 0xff);
     }
-    else
+
+    chunk->first_node_offset = (u32)pointer_diff(nodes, arena->base);
+    chunk->first_child_offset = (u32)pointer_diff(children, arena->base);
+    chunk->first_node_voxel_count_offset = (u32)pointer_diff(node_voxel_counts, arena->base);
+    chunk->first_brick_offset = (u32)pointer_diff(bricks, arena->base);
+    chunk->first_color_offset = (u32)pointer_diff(color_ids, arena->base);
+    chunk->root_node_index = indices[0];
+    chunk->node_count = node_count;
+    chunk->child_count = child_count;
+    chunk->brick_count = brick_count;
+    chunk->voxel_count = voxel_count;
+}
+
+/*
+   NOTE(joon) Builds the DAG of every chunk that the voxels of the vox file go into, which should not exist yet.
+   Unlike inserting the voxels one by one, the children of a node should be next to each other,
+   so the voxels are bucketed by their chunk & sorted first(see build_voxel_chunk_dag).
+*/
+internal void
+allocate_voxel_chunk_from_vox_file(VoxelWorld *world, MemoryArena *arena, MemoryArena *transient_arena, load_vox_result vox)
+{
+    u32 chunk_dim = world->chunk_dim;
+    u32 hash_count = array_count(world->chunk_hashes);
+    u32 voxel_count = vox.voxel_count;
+
+    TempMemory sort_memory = start_temp_memory(transient_arena, 
+                                               (2*sizeof(u64) + sizeof(u32))*voxel_count + 
+                                               get_voxel_dag_build_scratch_size(world->lod, voxel_count) + 1, false);
+    u64 *keys = push_array(&sort_memory, u64, voxel_count);
+    u64 *sort_temp = push_array(&sort_memory, u64, voxel_count);
+    u32 *hash_indices = push_array(&sort_memory, u32, voxel_count);
+    // NOTE(joon) none of the chunks can have more voxels than the whole file
+    VoxelDAGBuildScratch dag_scratch = push_voxel_dag_build_scratch(&sort_memory, world->lod, voxel_count);
+
+    u32 chunk_voxel_counts[array_count(world->chunk_hashes)] = {};
+    for(u32 voxel_index = 0;
+            voxel_index < voxel_count;
+            ++voxel_index)
+    {
+        // TODO(joon) we also need to take account of the chunk pos?
+        u8 x = vox.xs[voxel_index];
+        u8 y = vox.ys[voxel_index];
+        u8 z = vox.zs[voxel_index];
+
+        VoxelChunkHash *chunk = get_voxel_chunk_hash(world->chunk_hashes, hash_count, 
+                                                    x/chunk_dim, y/chunk_dim, z/chunk_dim);
+        // TODO(joon) merge with the voxels that the chunk already has?
+        assert(chunk->first_node_offset == Empty_Hash);
+
+        hash_indices[voxel_index] = (u32)(chunk - world->chunk_hashes);
+        chunk_voxel_counts[hash_indices[voxel_index]]++;
+    }
+
+    u32 chunk_first_keys[array_count(world->chunk_hashes)];
+    u32 key_offset = 0;
+    for(u32 hash_index = 0;
+            hash_index < hash_count;
+            ++hash_index)
     {
-        y_mask = voxel_neg_y_mask;
+        chunk_first_keys[hash_index] = key_offset;
+        key_offset += chunk_voxel_counts[hash_index];
     }
 
-    u8 *node = start + stride;
-    u8 voxel_mask = x_mask & y_mask & z_mask; 
+    for(u32 voxel_index = 0;
+            voxel_index < voxel_count;
+            ++voxel_index)
+    {
+        u64 morton_code = get_voxel_morton_code(vox.xs[voxel_index] % chunk_dim, vox.ys[voxel_index] % chunk_dim, vox.zs[voxel_index] % chunk_dim,
+                                                world->lod);
+        keys[chunk_first_keys[hash_indices[voxel_index]]++] = (morton_code << 8) | vox.colorIDs[voxel_index];
+    }
 
-    if(*node & voxel_mask)
+    for(u32 hash_index = 0;
+            hash_index < hash_count;
+            ++hash_index)
     {
-        if(dim == 2)
+        u32 chunk_voxel_count = chunk_voxel_counts[hash_index];
+        if(chunk_voxel_count)
         {
-            assert(x < 2);
-            assert(y < 2);
-            assert(z < 2);
+            // NOTE(joon) chunk_first_keys is now pointing at the end of the keys of the chunk
+            u64 *chunk_keys = keys + chunk_first_keys[hash_index] - chunk_voxel_count;
+            radix_sort_u64(chunk_keys, sort_temp, chunk_voxel_count, 3*world->lod + 8);
 
-            result->exist = true;
-            return;
+            build_voxel_chunk_dag(world, arena, world->chunk_hashes + hash_index, chunk_keys, chunk_voxel_count, &dag_scratch);
         }
+    }
 
-        u8 *next_lod_start = start + node_size * power((u32)8, (u32)lod);
-        u32 set_bit_index = find_most_significant_bit(voxel_mask);
-        u32 next_stride = 8 * stride + set_bit_index * node_size;
+    end_temp_memory(&sort_memory);
 
-        get_voxel(next_lod_start, next_stride, x, y, z, dim/2, lod+1, result);
-    }
-    else
+    memcpy(world->palette, vox.palette, sizeof(world->palette));
+}
+
+// NOTE(joon) x, y, z are in the raw voxel space, including the chunk offset. The voxels inside the chunks that don't exist are empty
+internal b32
+does_voxel_exist(VoxelWorld *world, u8 *voxel_memory, u32 x, u32 y, u32 z)
+{
+    b32 result = false;
+
+    u32 chunk_x = x / world->chunk_dim;
+    u32 chunk_y = y / world->chunk_dim;
+    u32 chunk_z = z / world->chunk_dim;
+    for(u32 hash_index = 0;
+            hash_index < array_count(world->chunk_hashes);
+            ++hash_index)
     {
-        result->exist = false;
-        return;
+        VoxelChunkHash *chunk = world->chunk_hashes + hash_index;
+        if(chunk->first_node_offset != Empty_Hash &&
+           chunk->x == chunk_x && chunk->y == chunk_y && chunk->z == chunk_z)
+        {
+            VoxelOctree octree = get_voxel_octree(world, voxel_memory, chunk);
+            result = get_voxel(&octree, x % world->chunk_dim, y % world->chunk_dim, z % world->chunk_dim).exist;
+
+            break;
+        }
     }
+
+    return result;
 }
 
 // NOTE(joon) 
 internal void
-validate_voxels_with_vox_file(load_vox_result vox, u8 *nodes)
+validate_voxels_with_vox_file(load_vox_result vox, VoxelOctree *octree)
 {
+    // NOTE(joon) decode the whole row at once
+    u8 row_xs[256];
+    u8 row_ys[256];
+    u8 row_zs[256];
+    b32 row_exists[256];
+    for(u32 x = 0;
+            x < 256;
+            ++x)
+    {
+        row_xs[x] = (u8)x;
+    }
+
     for(u32 z = 0;
             z < 256;
             ++z)
@@ -381,6 +746,10 @@ validate_voxels_with_vox_file(load_vox_result vox, u8 *nodes)
                 y < 256;
                 ++y)
         {
+            memset(row_ys, y, sizeof(row_ys));
+            memset(row_zs, z, sizeof(row_zs));
+            hot_kernels.decode_voxels(octree, row_xs, row_ys, row_zs, 256, row_exists);
+
             for(u32 x = 0;
                     x < 256;
                     ++x)                       
@@ -403,104 +772,8 @@ validate_voxels_with_vox_file(load_vox_result vox, u8 *nodes)
 
                 }
 
-                if(x == 0 && y == 0 && z == 2)
-                {
-                    int breakhere = 0;
-                }
-
-                GetVoxelResult voxel = {};
-                get_voxel(nodes, 0, x, y, z, 256, 0, &voxel);
-
-                assert(voxel.exist == should_exist);
+                assert(row_exists[x] == should_exist);
             }
         }
     }
 }
-
-internal void
-push_all_voxels(void *push_buffer, u32 *push_buffer_size, u32 total_push_buffer_size, u8 *start, u32 stride, u32 x, u32 y, u32 z, u32 dim, u32 lod)
-{
-    if(dim == 1)
-    {
-        v3 center = get_voxel_center_in_meter(x, y, z, V3(1, 1, 1));
-
-        // TODO(joon) : push here!
-        return;
-    }
-
-    u8 *node = start + stride;
-    u32 node_size = 1;
-
-    u32 half_dim = dim/2;
-
-    u8 child_mask = *node;
-    u8 scan_mask = 128;
-    for(u32 bit_shift_index = 0;
-            bit_shift_index < 8;
-            ++bit_shift_index)
-    {
-        if(child_mask & scan_mask)
-        {
-            u8 *next_lod_start = start + node_size * power((u32)8, (u32)lod);
-            u32 next_stride = 8 * stride + bit_shift_index * node_size;
-
-            u32 next_x = x;
-            u32 next_y = y;
-            u32 next_z = z;
-
-            switch(scan_mask)
-            {
-                case voxel_p_000:
-                {
-                }break;
-
-                case voxel_p_100:
-                {
-                    next_x += half_dim;
-                }break;
-
-                case voxel_p_010:
-                {
-                    next_y += half_dim;
-                }break;
-
-                case voxel_p_110:
-                {
-                    next_x += half_dim;
-                    next_y += half_dim;
-                }break;
-
-                case voxel_p_001:
-                {
-                    next_z += half_dim;
-                }break;
-
-                case voxel_p_101:
-                {
-                    next_x += half_dim;
-                    next_z += half_dim;
-                }break;
-
-                case voxel_p_011:
-                {
-                    next_y += half_dim;
-                    next_z += half_dim;
-                }break;
-
-                case voxel_p_111:
-                {
-                    next_x += half_dim;
-                    next_y += half_dim;
-                    next_z += half_dim;
-                }break;
-
-            }
-
-            //mtl_render_all_voxels(render_encoder, per_object_data, next_lod_start, next_stride, next_x, next_y, next_z, dim/2, lod+1);
-        }
-
-        scan_mask = scan_mask >> 1;
-    }
-}
-
-
@@ -1,6 +1,7 @@
 #ifndef HB_VOXEL_H
 #define HB_VOXEL_H
 
+struct BakedLighting;
 struct VoxelChunkHash
 {
     // TODO(joon) Do we want these values to be i32?
@@ -8,9 +9,32 @@ struct VoxelChunkHash
     u32 y;
     u32 z;
 
-    u32 first_node_offset; // only the chunk hash has this value, as 24 bit is not enough to represent the whole world
+    // NOTE(joon) Where the sparse voxel DAG of the chunk is(see VoxelOctree), in bytes from the voxel memory
+    // (the base of the arena that was passed to allocate_voxel_chunk_from_vox_file). 
+    // Only the chunk hash has these values, as 24 bit is not enough to represent the whole world
+    u32 first_node_offset;
+    u32 first_child_offset;
+    u32 first_node_voxel_count_offset;
+    u32 first_brick_offset;
+    u32 first_color_offset;
+
+    u32 root_node_index;
+    // NOTE(joon) unique ones, after the identical subtrees were merged
+    u32 node_count;
+    u32 child_count;
+    u32 brick_count;
+    u32 voxel_count;
+
+    // NOTE(joon) Optional, see bake_voxel_world_lighting. Only the faces that are not covered by another voxel get baked,
+    // sorted by their key(see get_baked_voxel_face_key)
+    u32 *baked_face_keys;
+    BakedLighting *baked_face_lighting;
+    u32 baked_face_count;
 };
 
+// NOTE(joon) if the chunk was empty, x value of the chunk hash is set to this value
+#define Empty_Hash U32_Max
+
 struct Material
 {
     u32 color;
@@ -23,10 +47,230 @@ struct VoxelWorld
     // The number of chunk hashes has been significantly reduced, as we are not doing the chunk based culling
     VoxelChunkHash chunk_hashes[32];
 
-    u32 node_count_per_chunk;
+    u32 chunk_dim;
+    u32 lod;
+
+    // NOTE(joon) size of a voxel in meters. The voxel (0, 0, 0) of the chunk (0, 0, 0) starts at the origin
+    r32 voxel_dim;
+
+    // NOTE(joon) color ids of the voxels index into this, same format as the vox file
+    u32 palette[256];
+};
+
+// NOTE(joon) the tree can not be deeper than this(chunk_dim 65536)
+#define Max_Voxel_Lod 16
+
+/*
+   NOTE(joon) Sparse voxel DAG of a chunk, which is a sparse octree(only has the nodes that have at least one voxel under them)
+   where the identical subtrees are merged into one, so the repeating parts of the chunk are only stored once.
+   Each node is child mask(low 8 bits, same bit order as the voxel masks below) | index of the first child << 8,
+   and the children(indices of the nodes of the next level) that exist are next to each other in the children array in the order of their bit index,
+   so the child with the bit index i is at first child + number of the children before i(see get_voxel_octree_child_handle).
+   The children of the last level of the nodes(dim 8) are the indices of the 4x4x4 bricks instead, 
+   which are the occupancy bits in the morton order(see get_voxel_morton_code),
+   so each byte is one of the 2x2x2 blocks and the bits inside the byte are the voxels of that block.
+
+   As a subtree can be shared, the colors can not live inside the subtree. Instead, the color ids are stored separately 
+   in the morton order of the voxels, and each node knows how many voxels it has under it,
+   so the color index of a voxel is the number of the voxels before it, which gets added up on the way down(see get_voxel).
+
+   The traversals go through all lod levels the same way with a handle per level, which is
+   - the node index, for the levels of the nodes
+   - the brick index, for the level of the brick(dim 4)
+   - brick index << 3 | the index of the 2x2x2 block, for the last level(dim 2)
+*/
+struct VoxelOctree
+{
+    u32 *nodes;
+    u32 *children;
+    // NOTE(joon) one per node
+    u32 *node_voxel_counts;
+    u64 *bricks;
+    u8 *color_ids;
+
+    u32 root_node_index;
 
     u32 chunk_dim;
     u32 lod;
+    // NOTE(joon) lod - 2, as the last 2 levels are inside the bricks
+    u32 node_level_count;
+};
+
+// NOTE(joon) voxel_memory is what the offsets of the chunk are relative to
+force_inline VoxelOctree
+get_voxel_octree(VoxelWorld *world, u8 *voxel_memory, VoxelChunkHash *chunk)
+{
+    VoxelOctree result = {};
+
+    result.nodes = (u32 *)(voxel_memory + chunk->first_node_offset);
+    result.children = (u32 *)(voxel_memory + chunk->first_child_offset);
+    result.node_voxel_counts = (u32 *)(voxel_memory + chunk->first_node_voxel_count_offset);
+    result.bricks = (u64 *)(voxel_memory + chunk->first_brick_offset);
+    result.color_ids = voxel_memory + chunk->first_color_offset;
+    result.root_node_index = chunk->root_node_index;
+    result.chunk_dim = world->chunk_dim;
+    result.lod = world->lod;
+    result.node_level_count = world->lod - 2;
+
+    return result;
+}
+
+// NOTE(joon) bit i is set when the 2x2x2 block i(byte i of the occupancy) has any voxel
+force_inline u32
+get_voxel_brick_child_mask(u64 occupancy)
+{
+    // NOTE(joon) OR every byte down to its lowest bit, and then gather the lowest bits with a multiply.
+    // The shifts also bring in the bits of the next byte, but only to the bits that get masked out
+    u64 any = occupancy;
+    any |= (any >> 4);
+    any |= (any >> 2);
+    any |= (any >> 1);
+    any &= 0x0101010101010101ull;
+
+    u32 result = (u32)((any*0x0102040810204080ull) >> 56);
+
+    return result;
+}
+
+// NOTE(joon) child mask of the node that the handle points to, at that level
+force_inline u32
+get_voxel_octree_child_mask(VoxelOctree *octree, u32 level, u32 handle)
+{
+    u32 result = 0;
+
+    if(level < octree->node_level_count)
+    {
+        result = octree->nodes[handle] & 0xff;
+    }
+    else if(level == octree->node_level_count)
+    {
+        result = get_voxel_brick_child_mask(octree->bricks[handle]);
+    }
+    else
+    {
+        result = (u32)((octree->bricks[handle >> 3] >> (8*(handle & 7))) & 0xff);
+    }
+
+    return result;
+}
+
+// NOTE(joon) handle of the child with the bit index at the next level, which should exist. level + 1 should be less than the lod
+force_inline u32
+get_voxel_octree_child_handle(VoxelOctree *octree, u32 level, u32 handle, u32 bit_index)
+{
+    u32 result = 0;
+
+    if(level < octree->node_level_count)
+    {
+        u32 node = octree->nodes[handle];
+        result = octree->children[(node >> 8) + count_set_bit_u64(node & ((1 << bit_index) - 1))];
+    }
+    else
+    {
+        result = (handle << 3) | bit_index;
+    }
+
+    return result;
+}
+
+// NOTE(joon) number of the voxels under the node(or the brick, for the last level of the children) at that level
+force_inline u32
+get_voxel_octree_voxel_count(VoxelOctree *octree, u32 level, u32 index)
+{
+    u32 result = 0;
+
+    if(level < octree->node_level_count)
+    {
+        result = octree->node_voxel_counts[index];
+    }
+    else
+    {
+        result = count_set_bit_u64(octree->bricks[index]);
+    }
+
+    return result;
+}
+
+struct GetVoxelResult
+{
+    b32 exist;
+    u8 color_id;
+};
+
+/*
+   NOTE(joon) x, y, z are inside the chunk. 
+   Also adds up the voxels of the siblings that come before the child on the way down, 
+   which becomes the index of the color of the voxel at the end.
+   The traversals only need the child masks, so they come back here for the color after they hit something.
+*/
+force_inline GetVoxelResult
+get_voxel(VoxelOctree *octree, u32 x, u32 y, u32 z)
+{
+    GetVoxelResult result = {};
+
+    u32 node_index = octree->root_node_index;
+    u32 color_index = 0;
+    b32 is_inside_node = true;
+    for(u32 level = 0;
+            level < octree->node_level_count && is_inside_node;
+            ++level)
+    {
+        u32 half_dim = octree->chunk_dim >> (level + 1);
+        u32 bit_index = ((x & half_dim) ? 1 : 0) | 
+                        ((y & half_dim) ? 2 : 0) | 
+                        ((z & half_dim) ? 4 : 0);
+
+        u32 node = octree->nodes[node_index];
+        if(node & (1 << bit_index))
+        {
+            u32 *children = octree->children + (node >> 8);
+            u32 child_count_before = count_set_bit_u64(node & ((1 << bit_index) - 1));
+            for(u32 child_index = 0;
+                    child_index < child_count_before;
+                    ++child_index)
+            {
+                color_index += get_voxel_octree_voxel_count(octree, level + 1, children[child_index]);
+            }
+
+            node_index = children[child_count_before];
+        }
+        else
+        {
+            is_inside_node = false;
+        }
+    }
+
+    if(is_inside_node)
+    {
+        // NOTE(joon) same as the lowest 6 bits of the morton code
+        u32 brick_bit_index = (x & 1) | ((y & 1) << 1) | ((z & 1) << 2) |
+                              ((x & 2) << 2) | ((y & 2) << 3) | ((z & 2) << 4);
+        u64 occupancy = octree->bricks[node_index];
+        if(occupancy & (1ull << brick_bit_index))
+        {
+            result.exist = true;
+            result.color_id = octree->color_ids[color_index + count_set_bit_u64(occupancy & ((1ull << brick_bit_index) - 1))];
+        }
+    }
+
+    return result;
+}
+
+struct VoxelRayHit
+{
+    // NOTE(joon) same as RayIntersectResult, negative when there was no hit
+    r32 hit_t;
+    v3 hit_p;
+    // NOTE(joon) normal of the voxel face that the ray went through, always axis aligned
+    v3 hit_normal;
+
+    u32 color;
+    u8 color_id;
+
+    // NOTE(joon) raw voxel space, including the chunk offset
+    u32 voxel_x;
+    u32 voxel_y;
+    u32 voxel_z;
 };
 
 #define voxel_pos_x_mask 0b10101010
@@ -0,0 +1,280 @@
+/*
+   NOTE(joon) Ray queries against the voxel world(see VoxelWorld). Unlike the rest of hb_voxel.cpp, these don't need the vox loader,
+   so this is separate from it and the raytracer(which also gets compiled once per ISA, see hb_kernel_isa.cpp) can include it.
+*/
+
+/*
+    NOTE(joon) voxel should be axis aligned!
+    Normal plane can be expressed in : N * P = d, where N being a normal and P being any point in plane.
+
+    Because the planes are axis aligned, we can also simplify the typical ray - plane intersection code.
+    For example, when we solve the equation above with a ray, we get t = (d - dot(N, O)) / dot(N, V).
+    Because the planes are axis aligned, the normals should be (1, 0, 0), (0, 1, 0), (0, 0, 1).
+    So tx = (Px - Ox) / Vx;
+    So ty = (Py - Oy) / Vy;
+    So tz = (Pz - Oz) / Vz;
+
+    The ray is inside the box between the last slab that it enters(t_min) and the first slab that it exits(t_max),
+    so it only hits the box when t_min <= t_max.
+*/
+struct SlabIntersectResult
+{
+    r32 t_min;
+    r32 t_max;
+
+    // NOTE(joon) axis of the slab that the ray entered last, which is the face of the box that the ray goes through
+    u32 entry_axis;
+};
+
+internal SlabIntersectResult
+ray_intersect_with_slab(v3 p0, v3 p1, v3 ray_origin, v3 inv_ray_dir)
+{
+    SlabIntersectResult result = {};
+
+    v3 t0 = hadamard((p0 - ray_origin), inv_ray_dir); // each component represents t against the slab that is aligned for each axis
+    v3 t1 = hadamard((p1 - ray_origin), inv_ray_dir); // each component represents t against the slab that is aligned for each axis
+
+    v3 t_near = gather_min_elements(t0, t1);
+    v3 t_far = gather_max_elements(t0, t1);
+
+    result.t_min = max_element(t_near);
+    result.t_max = min_element(t_far);
+
+    if(t_near.y >= t_near.x && t_near.y >= t_near.z)
+    {
+        result.entry_axis = 1;
+    }
+    else if(t_near.z >= t_near.x && t_near.z >= t_near.y)
+    {
+        result.entry_axis = 2;
+    }
+
+    return result;
+}
+
+// NOTE(joon) The components that are 0 become very small instead, so that the slab test never does 0*inf
+internal v3
+get_safe_inverse_ray_dir(v3 ray_dir)
+{
+    v3 result = {};
+
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        r32 d = ray_dir.e[axis];
+        if(d == 0.0f)
+        {
+            d = 1e-20f;
+        }
+
+        result.e[axis] = 1.0f / d;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Hierarchical DDA inside the chunk, in the chunk voxel space.
+   Starting from the cell that the ray is in, we walk down the tree until we find the first node that doesn't have
+   the child that the cell is in. Then the whole child octant is empty, so the ray can jump to the exit of that octant
+   at once. When the octant is a single voxel, this is the same as the usual DDA(Amanatides & Woo).
+   The cell that the ray goes into always shares the ancestors above the highest bit that changed, 
+   so we only need to walk down from there instead of starting over from the root.
+   The cell coordinates are integers, and only the ones that the ray did not step along are found using t,
+   clamped inside the octant so that the float error never makes the ray skip or revisit the cells.
+*/
+internal VoxelRayHit
+ray_intersect_with_voxel_chunk(VoxelWorld *world, VoxelOctree *octree, v3 ray_origin, v3 ray_dir, v3 inv_ray_dir, 
+                               r32 start_t, r32 end_t, u32 entry_axis)
+{
+    VoxelRayHit result = {};
+    result.hit_t = -1.0f;
+
+    u32 chunk_dim = world->chunk_dim;
+    u32 lod = world->lod;
+
+    // NOTE(joon) handles of the nodes that the cell is in, see VoxelOctree
+    u32 handles[Max_Voxel_Lod];
+    handles[0] = octree->root_node_index;
+
+    u32 cell[3];
+    v3 start_p = ray_origin + start_t*ray_dir;
+    for(u32 axis = 0;
+            axis < 3;
+            ++axis)
+    {
+        // NOTE(joon) casting works as floor here, as the negative values get clamped to 0 anyway
+        cell[axis] = (u32)clamp(0, (i32)start_p.e[axis], (i32)chunk_dim - 1);
+    }
+
+    v3 normal = {};
+    normal.e[entry_axis] = (inv_ray_dir.e[entry_axis] > 0.0f) ? -1.0f : 1.0f;
+
+    r32 t = start_t;
+    u32 restart_level = 0;
+    while(1)
+    {
+        // NOTE(joon) dim of the empty octant that the cell is in, or 0 if the cell is a voxel
+        u32 octant_dim = 0;
+        for(u32 level = restart_level;
+                level < lod;
+                ++level)
+        {
+            u32 half_dim = chunk_dim >> (level + 1);
+            u32 bit_index = ((cell[0] & half_dim) ? 1 : 0) | 
+                            ((cell[1] & half_dim) ? 2 : 0) | 
+                            ((cell[2] & half_dim) ? 4 : 0);
+
+            if(!(get_voxel_octree_child_mask(octree, level, handles[level]) & (1 << bit_index)))
+            {
+                octant_dim = half_dim;
+                break;
+            }
+
+            if(level + 1 < lod)
+            {
+                handles[level + 1] = get_voxel_octree_child_handle(octree, level, handles[level], bit_index);
+            }
+        }
+
+        if(octant_dim == 0)
+        {
+            result.hit_t = t;
+            result.hit_normal = normal;
+            result.color_id = get_voxel(octree, cell[0], cell[1], cell[2]).color_id;
+            result.color = world->palette[result.color_id];
+            result.voxel_x = cell[0];
+            result.voxel_y = cell[1];
+            result.voxel_z = cell[2];
+
+            break;
+        }
+
+        u32 octant_min[3];
+        r32 exit_t = Flt_Max;
+        u32 exit_axis = 0;
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            octant_min[axis] = cell[axis] & ~(octant_dim - 1);
+
+            u32 boundary = (inv_ray_dir.e[axis] > 0.0f) ? (octant_min[axis] + octant_dim) : octant_min[axis];
+            r32 axis_t = ((r32)boundary - ray_origin.e[axis]) * inv_ray_dir.e[axis];
+            if(axis_t < exit_t)
+            {
+                exit_t = axis_t;
+                exit_axis = axis;
+            }
+        }
+
+        if(exit_t > end_t)
+        {
+            break;
+        }
+
+        // NOTE(joon) wraps around when the ray goes out from the negative side, which is also outside of the chunk
+        u32 next_cell[3];
+        if(inv_ray_dir.e[exit_axis] > 0.0f)
+        {
+            next_cell[exit_axis] = octant_min[exit_axis] + octant_dim;
+        }
+        else
+        {
+            next_cell[exit_axis] = octant_min[exit_axis] - 1;
+        }
+
+        if(next_cell[exit_axis] >= chunk_dim)
+        {
+            break;
+        }
+
+        v3 exit_p = ray_origin + exit_t*ray_dir;
+        u32 changed_bits = 0;
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            if(axis != exit_axis)
+            {
+                next_cell[axis] = (u32)clamp((i32)octant_min[axis], (i32)exit_p.e[axis], (i32)(octant_min[axis] + octant_dim - 1));
+            }
+
+            changed_bits |= (cell[axis] ^ next_cell[axis]);
+            cell[axis] = next_cell[axis];
+        }
+
+        // NOTE(joon) first level where the cell went into a different child
+        restart_level = 0;
+        while(!(changed_bits & (chunk_dim >> (restart_level + 1))))
+        {
+            restart_level++;
+        }
+
+        normal = V3(0, 0, 0);
+        normal.e[exit_axis] = (inv_ray_dir.e[exit_axis] > 0.0f) ? -1.0f : 1.0f;
+        t = exit_t;
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) Returns the closest voxel that the ray hits between min_t & max_t. voxel_memory is what the offsets of
+   the chunks are relative to(i.e base of the arena that was passed to allocate_voxel_chunk_from_vox_file).
+   For the line of sight, we can pass the distance to the target as the max_t and check if there was any hit.
+*/
+internal VoxelRayHit
+ray_intersect_with_voxel_world(VoxelWorld *world, u8 *voxel_memory, v3 ray_origin, v3 ray_dir, r32 min_t, r32 max_t)
+{
+    VoxelRayHit result = {};
+    result.hit_t = -1.0f;
+
+    // NOTE(joon) The ray is traced in the raw voxel space, which doesn't change t
+    r32 inv_voxel_dim = 1.0f / world->voxel_dim;
+    v3 voxel_ray_origin = inv_voxel_dim*ray_origin;
+    v3 voxel_ray_dir = inv_voxel_dim*ray_dir;
+    v3 inv_ray_dir = get_safe_inverse_ray_dir(voxel_ray_dir);
+
+    r32 chunk_dim = (r32)world->chunk_dim;
+    for(u32 hash_index = 0;
+            hash_index < array_count(world->chunk_hashes);
+            ++hash_index)
+    {
+        VoxelChunkHash *chunk = world->chunk_hashes + hash_index;
+        if(chunk->first_node_offset != Empty_Hash)
+        {
+            v3 chunk_min = chunk_dim*V3((r32)chunk->x, (r32)chunk->y, (r32)chunk->z);
+            SlabIntersectResult slab = ray_intersect_with_slab(chunk_min, chunk_min + V3(chunk_dim, chunk_dim, chunk_dim), 
+                                                               voxel_ray_origin, inv_ray_dir);
+
+            // NOTE(joon) max_t gets smaller whenever we find a hit, so that the chunks that are further away are skipped
+            r32 start_t = maximum(slab.t_min, min_t);
+            r32 end_t = minimum(slab.t_max, max_t);
+            if(start_t <= end_t)
+            {
+                VoxelOctree octree = get_voxel_octree(world, voxel_memory, chunk);
+                VoxelRayHit chunk_hit = ray_intersect_with_voxel_chunk(world, &octree, 
+                                                                       voxel_ray_origin - chunk_min, voxel_ray_dir, inv_ray_dir,
+                                                                       start_t, end_t, slab.entry_axis);
+                if(chunk_hit.hit_t >= 0.0f)
+                {
+                    result = chunk_hit;
+                    result.voxel_x += chunk->x*world->chunk_dim;
+                    result.voxel_y += chunk->y*world->chunk_dim;
+                    result.voxel_z += chunk->z*world->chunk_dim;
+
+                    max_t = chunk_hit.hit_t;
+                }
+            }
+        }
+    }
+
+    if(result.hit_t >= 0.0f)
+    {
+        result.hit_p = ray_origin + result.hit_t*ray_dir;
+    }
+
+    return result;
+}
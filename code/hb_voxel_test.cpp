@@ -0,0 +1,435 @@
+/*
+    NOTE(joon) Checks the sparse voxel DAG(see VoxelOctree) against a dense grid of the same voxels.
+    Each test world gets built from the voxels with allocate_voxel_chunk_from_vox_file, and then every voxel inside the test extent
+    is looked up with get_voxel(which also gives the color id) and with decode_voxels of each ISA.
+    The ISAs that this cpu can't run are skipped.
+    The worlds are random boxes, some of them repeated at the aligned positions so that the identical subtrees get merged,
+    with a few different chunk dims so that the voxels also go into multiple chunks.
+    With a vox file as the argument, the voxels of the file also get tested.
+    Like linux_hb_render.cpp, this is one translation unit that gets linked with the kernel objects(see voxel_test in the makefile).
+    Returns non-zero if anything did not match.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <x86intrin.h>
+
+#include "hb_types.h"
+#include "hb_simd.h"
+#include "hb_intrinsic.h"
+#include "hb_platform.h"
+#include "hb_math.h"
+#include "hb_random.h"
+#include "hb_simulation.h"
+#include "hb_voxel.h"
+#include "hb_render_group.h"
+#include "hb_asset.h"
+#include "hb_texture.h"
+#include "hb_bvh.h"
+#include "hb_sampler.h"
+#include "hb_brdf.h"
+#include "hb_ray.h"
+#include "hb_denoiser.h"
+#include "hb_bake.h"
+#include "hb_kernel.h"
+
+#include "hb_kernel.cpp"
+#include "hb_mesh_loader.cpp"
+#include "hb_voxel.cpp"
+
+// NOTE(joon) vox files can't be bigger than this, as the coordinates are u8
+#define Voxel_Test_Grid_Dim 256
+
+struct VoxelTestGrid
+{
+    // NOTE(joon) 0 when the voxel does not exist, color id + 1 otherwise
+    u16 *voxels;
+
+    // NOTE(joon) the voxels are always inside [0, extent)
+    u32 extent;
+
+    load_vox_result vox;
+};
+
+struct VoxelTestDecoder
+{
+    char *name;
+    CpuFeatureLevel required_level;
+    decode_voxels_kernel *decode_voxels;
+};
+
+internal u32
+get_voxel_test_grid_index(u32 x, u32 y, u32 z)
+{
+    u32 result = x + Voxel_Test_Grid_Dim*(y + Voxel_Test_Grid_Dim*z);
+
+    return result;
+}
+
+internal void
+add_voxel_test_voxel(VoxelTestGrid *grid, u32 x, u32 y, u32 z, u8 color_id)
+{
+    u16 *voxel = grid->voxels + get_voxel_test_grid_index(x, y, z);
+    if(*voxel == 0)
+    {
+        *voxel = (u16)color_id + 1;
+
+        load_vox_result *vox = &grid->vox;
+        vox->xs[vox->voxel_count] = (u8)x;
+        vox->ys[vox->voxel_count] = (u8)y;
+        vox->zs[vox->voxel_count] = (u8)z;
+        vox->colorIDs[vox->voxel_count] = color_id;
+        vox->voxel_count++;
+    }
+}
+
+/*
+   NOTE(joon) Half of the boxes are hollow with a pattern that only depends on the position inside the box,
+   and the repeated ones are copies of the previous box at the positions that are aligned to 16,
+   which end up as the same subtrees of the DAG.
+*/
+internal void
+fill_random_voxel_test_grid(VoxelTestGrid *grid, u32 extent, u32 box_count, u32 seed)
+{
+    grid->extent = extent;
+    memset(grid->voxels, 0, sizeof(grid->voxels[0])*Voxel_Test_Grid_Dim*Voxel_Test_Grid_Dim*Voxel_Test_Grid_Dim);
+    grid->vox.voxel_count = 0;
+
+    Pcg32 pcg = start_pcg32(seed, 0);
+    u32 box_min[3] = {};
+    u32 box_dim[3] = {};
+    u32 box_pattern = 0;
+    u8 box_color_id = 0;
+    for(u32 box_index = 0;
+            box_index < box_count;
+            ++box_index)
+    {
+        b32 is_repeated = (box_index > 0 && random_u32(&pcg) % 3 == 0);
+        for(u32 axis = 0;
+                axis < 3;
+                ++axis)
+        {
+            if(!is_repeated)
+            {
+                box_dim[axis] = 1 + random_u32(&pcg) % 16;
+                box_min[axis] = random_u32(&pcg) % (extent - box_dim[axis]);
+            }
+            else
+            {
+                box_min[axis] = 16*(random_u32(&pcg) % (extent/16 - 1)) + (box_min[axis] % 16);
+            }
+        }
+
+        if(!is_repeated)
+        {
+            box_pattern = random_u32(&pcg) % 4;
+            box_color_id = (u8)random_u32(&pcg);
+        }
+
+        for(u32 z = 0;
+                z < box_dim[2];
+                ++z)
+        {
+            for(u32 y = 0;
+                    y < box_dim[1];
+                    ++y)
+            {
+                for(u32 x = 0;
+                        x < box_dim[0];
+                        ++x)
+                {
+                    if(box_pattern == 0 || (7*x + 3*y + z) % (box_pattern + 1) != 0)
+                    {
+                        add_voxel_test_voxel(grid, box_min[0] + x, box_min[1] + y, box_min[2] + z, box_color_id);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// NOTE(joon) returns the number of the mismatches
+internal u32
+run_voxel_test(VoxelTestGrid *grid, char *name, u32 chunk_dim, u32 lod,
+               VoxelTestDecoder *decoders, u32 decoder_count, MemoryArena *transient_arena)
+{
+    VoxelWorld world = {};
+    initialize_voxel_world(&world);
+    world.chunk_dim = chunk_dim;
+    world.lod = lod;
+
+    u64 voxel_memory_size = get_max_voxel_memory_size(&world, (u32)grid->vox.voxel_count);
+    u8 *voxel_memory = (u8 *)malloc(voxel_memory_size);
+    MemoryArena voxel_arena = start_memory_arena(voxel_memory, voxel_memory_size);
+    allocate_voxel_chunk_from_vox_file(&world, &voxel_arena, transient_arena, grid->vox);
+
+    u32 get_voxel_mismatch_count = 0;
+    u32 decode_mismatch_counts[8] = {};
+    u32 chunk_count = 0;
+    u32 node_count = 0;
+    u32 brick_count = 0;
+
+    u8 row_xs[Voxel_Test_Grid_Dim];
+    u8 row_ys[Voxel_Test_Grid_Dim];
+    u8 row_zs[Voxel_Test_Grid_Dim];
+    b32 row_exists[Voxel_Test_Grid_Dim];
+    for(u32 x = 0;
+            x < chunk_dim;
+            ++x)
+    {
+        row_xs[x] = (u8)x;
+    }
+
+    u32 chunk_count_per_axis = (grid->extent + chunk_dim - 1) / chunk_dim;
+    for(u32 chunk_z = 0;
+            chunk_z < chunk_count_per_axis;
+            ++chunk_z)
+    {
+        for(u32 chunk_y = 0;
+                chunk_y < chunk_count_per_axis;
+                ++chunk_y)
+        {
+            for(u32 chunk_x = 0;
+                    chunk_x < chunk_count_per_axis;
+                    ++chunk_x)
+            {
+                VoxelChunkHash *chunk = 0;
+                for(u32 hash_index = 0;
+                        hash_index < array_count(world.chunk_hashes);
+                        ++hash_index)
+                {
+                    VoxelChunkHash *hash = world.chunk_hashes + hash_index;
+                    if(hash->first_node_offset != Empty_Hash &&
+                       hash->x == chunk_x && hash->y == chunk_y && hash->z == chunk_z)
+                    {
+                        chunk = hash;
+                        break;
+                    }
+                }
+
+                VoxelOctree octree = {};
+                if(chunk)
+                {
+                    octree = get_voxel_octree(&world, voxel_memory, chunk);
+                    chunk_count++;
+                    node_count += chunk->node_count;
+                    brick_count += chunk->brick_count;
+                }
+
+                u32 chunk_voxel_count = 0;
+                for(u32 z = 0;
+                        z < chunk_dim;
+                        ++z)
+                {
+                    for(u32 y = 0;
+                            y < chunk_dim;
+                            ++y)
+                    {
+                        u32 first_grid_index = get_voxel_test_grid_index(chunk_x*chunk_dim, chunk_y*chunk_dim + y, chunk_z*chunk_dim + z);
+                        if(chunk)
+                        {
+                            for(u32 x = 0;
+                                    x < chunk_dim;
+                                    ++x)
+                            {
+                                u16 expected = grid->voxels[first_grid_index + x];
+                                GetVoxelResult voxel = get_voxel(&octree, x, y, z);
+                                if((voxel.exist ? (u16)voxel.color_id + 1 : 0) != expected)
+                                {
+                                    if(get_voxel_mismatch_count == 0)
+                                    {
+                                        printf("%s get_voxel : chunk (%u, %u, %u) voxel (%u, %u, %u), expected %u but got %u(exist %u)\n",
+                                               name, chunk_x, chunk_y, chunk_z, x, y, z, expected, voxel.color_id, voxel.exist);
+                                    }
+                                    get_voxel_mismatch_count++;
+                                }
+
+                                chunk_voxel_count += (expected != 0);
+                            }
+
+                            memset(row_ys, y, sizeof(row_ys));
+                            memset(row_zs, z, sizeof(row_zs));
+                            for(u32 decoder_index = 0;
+                                    decoder_index < decoder_count;
+                                    ++decoder_index)
+                            {
+                                VoxelTestDecoder *decoder = decoders + decoder_index;
+                                memset(row_exists, 0xff, sizeof(row_exists));
+                                decoder->decode_voxels(&octree, row_xs, row_ys, row_zs, chunk_dim, row_exists);
+
+                                for(u32 x = 0;
+                                        x < chunk_dim;
+                                        ++x)
+                                {
+                                    if((row_exists[x] != 0) != (grid->voxels[first_grid_index + x] != 0))
+                                    {
+                                        if(decode_mismatch_counts[decoder_index] == 0)
+                                        {
+                                            printf("%s decode_voxels %s : chunk (%u, %u, %u) voxel (%u, %u, %u), expected %u but got %u\n",
+                                                   name, decoder->name, chunk_x, chunk_y, chunk_z, x, y, z,
+                                                   grid->voxels[first_grid_index + x] != 0, row_exists[x] != 0);
+                                        }
+                                        decode_mismatch_counts[decoder_index]++;
+                                    }
+                                }
+                            }
+                        }
+                        else
+                        {
+                            // NOTE(joon) the chunks that were not built should not have any voxel
+                            for(u32 x = 0;
+                                    x < chunk_dim;
+                                    ++x)
+                            {
+                                if(grid->voxels[first_grid_index + x])
+                                {
+                                    if(get_voxel_mismatch_count == 0)
+                                    {
+                                        printf("%s : chunk (%u, %u, %u) does not exist, but has voxel (%u, %u, %u)\n",
+                                               name, chunk_x, chunk_y, chunk_z, x, y, z);
+                                    }
+                                    get_voxel_mismatch_count++;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if(chunk && chunk->voxel_count != chunk_voxel_count)
+                {
+                    printf("%s : chunk (%u, %u, %u) has %u voxels, expected %u\n",
+                           name, chunk_x, chunk_y, chunk_z, chunk->voxel_count, chunk_voxel_count);
+                    get_voxel_mismatch_count++;
+                }
+            }
+        }
+    }
+
+    printf("voxel test %s : %d voxels, chunk dim %u, %u chunks, %u nodes, %u bricks, %u bytes\n",
+           name, grid->vox.voxel_count, chunk_dim, chunk_count, node_count, brick_count, (u32)voxel_arena.used);
+    printf("    get_voxel : %u mismatches\n", get_voxel_mismatch_count);
+    u32 result = get_voxel_mismatch_count;
+    for(u32 decoder_index = 0;
+            decoder_index < decoder_count;
+            ++decoder_index)
+    {
+        printf("    decode_voxels %s : %u mismatches\n", decoders[decoder_index].name, decode_mismatch_counts[decoder_index]);
+        result += decode_mismatch_counts[decoder_index];
+    }
+
+    free(voxel_memory);
+
+    return result;
+}
+
+int
+main(int argc, char **argv)
+{
+    VoxelTestDecoder all_decoders[] =
+    {
+#if HB_ARM
+        {(char *)"neon", CpuFeatureLevel_NEON, decode_voxels_neon},
+#else
+        {(char *)"sse41", CpuFeatureLevel_SSE41, decode_voxels_sse41},
+        {(char *)"avx2", CpuFeatureLevel_AVX2, decode_voxels_avx2},
+        {(char *)"avx512", CpuFeatureLevel_AVX512, decode_voxels_avx512},
+#endif
+    };
+
+    CpuFeatureLevel cpu_feature_level = get_cpu_feature_level();
+    VoxelTestDecoder decoders[array_count(all_decoders)];
+    u32 decoder_count = 0;
+    for(u32 decoder_index = 0;
+            decoder_index < array_count(all_decoders);
+            ++decoder_index)
+    {
+        if(cpu_feature_level < all_decoders[decoder_index].required_level)
+        {
+            printf("voxel test : skipping %s, not supported by this cpu\n", all_decoders[decoder_index].name);
+            continue;
+        }
+
+        decoders[decoder_count++] = all_decoders[decoder_index];
+    }
+
+    u32 grid_voxel_count = Voxel_Test_Grid_Dim*Voxel_Test_Grid_Dim*Voxel_Test_Grid_Dim;
+    VoxelTestGrid grid = {};
+    grid.voxels = (u16 *)malloc(sizeof(grid.voxels[0])*grid_voxel_count);
+    grid.vox.xs = (u8 *)malloc(grid_voxel_count);
+    grid.vox.ys = (u8 *)malloc(grid_voxel_count);
+    grid.vox.zs = (u8 *)malloc(grid_voxel_count);
+    grid.vox.colorIDs = (u8 *)malloc(grid_voxel_count);
+    grid.vox.palette = (u32 *)calloc(256, sizeof(u32));
+
+    MemoryArena transient_arena = start_memory_arena(malloc(gigabytes(1)), gigabytes(1));
+
+    struct VoxelTestWorld
+    {
+        char *name;
+        u32 extent;
+        u32 box_count;
+        u32 chunk_dim;
+        u32 lod;
+    };
+    VoxelTestWorld worlds[] =
+    {
+        {(char *)"boxes", 256, 400, 256, 8},
+        {(char *)"boxes", 256, 400, 128, 7},
+        // NOTE(joon) 27 chunks, the world only has 32 of them
+        {(char *)"boxes", 96, 200, 32, 5},
+        {(char *)"single box", 32, 1, 256, 8},
+    };
+
+    u32 total_mismatch_count = 0;
+    for(u32 world_index = 0;
+            world_index < array_count(worlds);
+            ++world_index)
+    {
+        VoxelTestWorld *world = worlds + world_index;
+        fill_random_voxel_test_grid(&grid, world->extent, world->box_count, 0x12345678 + world_index);
+        total_mismatch_count += run_voxel_test(&grid, world->name, world->chunk_dim, world->lod, decoders, decoder_count, &transient_arena);
+    }
+
+    if(argc > 1)
+    {
+        FILE *file = fopen(argv[1], "rb");
+        if(file)
+        {
+            fseek(file, 0, SEEK_END);
+            u32 file_size = (u32)ftell(file);
+            fseek(file, 0, SEEK_SET);
+            u8 *file_memory = (u8 *)malloc(file_size);
+            fread(file_memory, 1, file_size, file);
+            fclose(file);
+
+            load_vox_result vox = load_vox(file_memory, file_size);
+            free(file_memory);
+
+            grid.extent = Voxel_Test_Grid_Dim;
+            memset(grid.voxels, 0, sizeof(grid.voxels[0])*grid_voxel_count);
+            grid.vox.voxel_count = 0;
+            for(u32 voxel_index = 0;
+                    voxel_index < (u32)vox.voxel_count;
+                    ++voxel_index)
+            {
+                add_voxel_test_voxel(&grid, vox.xs[voxel_index], vox.ys[voxel_index], vox.zs[voxel_index], vox.colorIDs[voxel_index]);
+            }
+
+            total_mismatch_count += run_voxel_test(&grid, argv[1], 256, 8, decoders, decoder_count, &transient_arena);
+
+            free_loaded_vox(&vox);
+            free(vox.colorIDs);
+            free(vox.palette);
+        }
+        else
+        {
+            printf("voxel test : failed to read %s\n", argv[1]);
+            total_mismatch_count++;
+        }
+    }
+
+    int result = (total_mismatch_count == 0) ? 0 : 1;
+
+    return result;
+}
@@ -0,0 +1,1344 @@
+/*
+   NOTE(joon) Headless offline renderer, so that the raytracer can be benchmarked on the linux machines without the game.
+   Renders the scene once with the hot kernels on all the threads, writes the image as a bmp,
+   and prints how many rays were traced, how fast, and how many of the simd lanes were doing something useful per bounce.
+
+   usage : hb_render [scene file] [-w width] [-h height] [-spp count] [-threads count] [-o output.bmp]
+                     [-sampler sobol|bluenoise|pcg] [-wavefront] [-tonemap none|reinhard|aces] [-exposure stops] [-dither]
+                     [-passes count] [-error relative_error] [-denoise]
+           hb_render [scene file] -bake output.obj [-threads count]
+           hb_render -cook texture.tga [-format rgba8|bc1|bc3|bc7] [-mipfilter box|kaiser] [-mips] [-threads count] [-o texture.hbtx]
+   Without the scene file, renders a small built in scene of spheres & planes.
+   With -passes, the image is rendered by the progressive raytracer instead(see hb_progressive_raytracer.h),
+   where each pass adds -spp rays to the pixels that have not converged to -error yet(0.02 by default).
+   It stops after that many passes, or once every pixel has converged.
+   With -denoise, the raytracer also writes the features of the first hits, and the image goes through
+   the denoiser(see hb_denoiser.h) before it gets written.
+   With -bake, nothing gets rendered either. The lighting of the obj meshes & the voxels of the scene gets baked
+   like the game would(see hb_bake.h), and written as an obj with the baked vertex colors(see bake_offline_scene).
+   With -cook, nothing gets rendered. The texture gets mipmapped & block compressed(see cook_texture),
+   and written as a cooked texture(see CookedTextureHeader) that the game can use as it is.
+   -mips also writes each mip level as a bmp next to the output, to compare the mip filters.
+
+   Scene file, one thing per line. Material 0 is the sky, and the rest get the indices in the order they show up.
+       # comment
+       camera px py pz  tx ty tz                      position & the target, z is up
+       sky r g b
+       material er eg eb  rr rg rb  reflectivity      emit color, reflection color
+       sphere cx cy cz radius material
+       plane nx ny nz d material                     dot(n, p) + d = 0
+       obj path material [scale tx ty tz]
+       vox path [voxel_dim tx ty tz]                 each palette color that the model uses becomes a diffuse material,
+                                                     only one per scene as it becomes the voxel world of the scene
+       merl path material                            measured brdf from the MERL database, replaces the reflection of the material
+   The paths are relative to the working directory.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <x86intrin.h>
+
+#include "hb_types.h"
+#include "hb_simd.h"
+#include "hb_intrinsic.h"
+#include "hb_platform.h"
+#include "hb_math.h"
+#include "hb_random.h"
+#include "hb_simulation.h"
+#include "hb_voxel.h"
+#include "hb_render_group.h"
+#include "hb_asset.h"
+#include "hb_texture.h"
+#include "hb_bvh.h"
+#include "hb_sampler.h"
+#include "hb_brdf.h"
+#include "hb_ray.h"
+#include "hb_progressive_raytracer.h"
+#include "hb_denoiser.h"
+#include "hb_bake.h"
+#include "hb_kernel.h"
+
+#include "hb_kernel.cpp"
+#include "hb_mesh_loader.cpp"
+#include "hb_voxel.cpp"
+#include "hb_voxel_ray.cpp"
+#include "hb_sampler.cpp"
+#include "hb_brdf.cpp"
+#include "hb_ray.cpp"
+#include "hb_progressive_raytracer.cpp"
+#include "hb_denoiser.cpp"
+#include "hb_bvh.cpp"
+#include "hb_image_loader.cpp"
+#include "hb_texture.cpp"
+#include "hb_bake.cpp"
+
+global sem_t semaphore;
+
+internal r64
+get_seconds(void)
+{
+    timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    r64 result = (r64)time.tv_sec + 1.0e-9*(r64)time.tv_nsec;
+
+    return result;
+}
+
+PLATFORM_READ_FILE(debug_linux_read_file)
+{
+    PlatformReadFileResult result = {};
+
+    int file = open(filename, O_RDONLY);
+    if(file >= 0)
+    {
+        struct stat file_stat;
+        fstat(file, &file_stat);
+        off_t file_size = file_stat.st_size;
+
+        if(file_size > 0)
+        {
+            result.size = file_size;
+            result.memory = (u8 *)malloc(result.size);
+            if(read(file, result.memory, file_size) != file_size)
+            {
+                free(result.memory);
+                result.memory = 0;
+                result.size = 0;
+            }
+        }
+
+        close(file);
+    }
+
+    return result;
+}
+
+PLATFORM_WRITE_ENTIRE_FILE(debug_linux_write_entire_file)
+{
+    int file = open(file_name, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+
+    if(file >= 0)
+    {
+        if(write(file, memory_to_write, size) == -1)
+        {
+            printf("Failed to write %s\n", file_name);
+        }
+
+        close(file);
+    }
+    else
+    {
+        printf("Failed to create %s\n", file_name);
+    }
+}
+
+PLATFORM_FREE_FILE_MEMORY(debug_linux_free_file_memory)
+{
+    free(memory);
+}
+
+// NOTE(joon) Same single producer multiple consumer queue as the macos one
+struct linux_thread
+{
+    u32 ID;
+    thread_work_queue *queue;
+};
+
+internal
+PLATFORM_ADD_THREAD_WORK_QUEUE_ITEM(linux_add_thread_work_item)
+{
+    assert(data);
+    thread_work_item *item = queue->items + queue->add_index;
+    item->callback = threadWorkCallback;
+    item->data = data;
+    item->written = true;
+    queue->completion_goal++;
+
+    __sync_synchronize();
+    queue->add_index = (queue->add_index + 1) % array_count(queue->items);
+
+    sem_post(&semaphore);
+}
+
+internal b32
+linux_do_thread_work_item(thread_work_queue *queue, u32 thread_index)
+{
+    b32 did_work = false;
+    if(queue->work_index != queue->add_index)
+    {
+        int original_work_index = queue->work_index;
+        int desired_work_index = (original_work_index + 1) % array_count(queue->items);
+
+        if(atomic_compare_exchange(&queue->work_index, original_work_index, desired_work_index))
+        {
+            thread_work_item *item = queue->items + original_work_index;
+            item->callback(item->data);
+            atomic_increment(&queue->completion_count);
+
+            did_work = true;
+        }
+    }
+
+    return did_work;
+}
+
+internal
+PLATFORM_COMPLETE_ALL_THREAD_WORK_QUEUE_ITEMS(linux_complete_all_thread_work_queue_items)
+{
+    // NOTE(joon) Same as the macos version, helps with the items that are left and then waits for the rest
+    while(queue->completion_count != queue->completion_goal)
+    {
+        if(!linux_do_thread_work_item(queue, 0))
+        {
+            _mm_pause();
+        }
+    }
+}
+
+internal void *
+thread_proc(void *data)
+{
+    linux_thread *thread = (linux_thread *)data;
+    while(1)
+    {
+        if(!linux_do_thread_work_item(thread->queue, thread->ID))
+        {
+            sem_wait(&semaphore);
+        }
+    }
+
+    return 0;
+}
+
+struct OfflineRenderTile
+{
+    RaytracerData data;
+    RaytracerOutput output;
+};
+
+internal
+THREAD_WORK_CALLBACK(thread_work_callback_render_offline_tile)
+{
+    OfflineRenderTile *tile = (OfflineRenderTile *)data;
+    tile->output = hot_kernels.render_raytraced_image_tile(&tile->data);
+}
+
+internal void
+write_offline_render_bmp(MemoryArena *arena, char *path, u32 *pixels, u32 width, u32 height)
+{
+    u32 bmp_size = get_bmp_file_size(width, height);
+    u8 *bmp = (u8 *)push_size(arena, bmp_size);
+    export_bmp(bmp, pixels, width, height);
+    debug_linux_write_entire_file(path, bmp, bmp_size);
+}
+
+// NOTE(joon) mip pixels are 0xAABBGGRR, while the bmp wants 0xAARRGGBB & the bottom row first
+internal void
+write_offline_mip_bmp(MemoryArena *arena, char *path, TextureMip *mip)
+{
+    u32 *pixels = push_array(arena, u32, mip->width*mip->height);
+    for(u32 y = 0;
+            y < mip->height;
+            ++y)
+    {
+        u32 *source_row = mip->pixels + y*mip->width;
+        u32 *dest_row = pixels + (mip->height - 1 - y)*mip->width;
+        for(u32 x = 0;
+                x < mip->width;
+                ++x)
+        {
+            u32 c = source_row[x];
+            dest_row[x] = (c & 0xff00ff00) | ((c & 0xff) << 16) | ((c >> 16) & 0xff);
+        }
+    }
+
+    write_offline_render_bmp(arena, path, pixels, mip->width, mip->height);
+}
+
+/*
+   NOTE(joon) Cooks the tga the same way the game wants it, and then reads the file back like the game would,
+   so that a broken cooked texture shows up here instead of in the game.
+*/
+internal b32
+cook_offline_texture(MemoryArena *arena, MemoryArena *transient_arena, thread_work_queue *queue,
+                     char *source_path, char *output_path, TextureFormat format, MipFilter filter, b32 write_mips)
+{
+    b32 result = false;
+
+    PlatformReadFileResult source_file = debug_linux_read_file(source_path);
+    if(!source_file.memory)
+    {
+        printf("Failed to read the texture %s\n", source_path);
+        return false;
+    }
+
+    LoadedImage image = load_tga(arena, source_file);
+    debug_linux_free_file_memory(source_file.memory);
+
+    r64 cook_begin_seconds = get_seconds();
+    CookedTexture cooked = cook_texture(arena, transient_arena, queue, image, format, filter);
+    r64 cook_seconds = get_seconds() - cook_begin_seconds;
+
+    debug_linux_write_entire_file(output_path, cooked.memory, cooked.size);
+
+    PlatformReadFileResult cooked_file = debug_linux_read_file(output_path);
+    CookedTextureHeader *header = 0;
+    if(cooked_file.memory)
+    {
+        header = get_cooked_texture_header(cooked_file.memory, cooked_file.size);
+    }
+
+    if(header)
+    {
+        char *format_names[] = {(char *)"rgba8", (char *)"bc1", (char *)"bc3", (char *)"bc7"};
+        printf("texture : %s, %ux%u\n", source_path, image.width, image.height);
+        printf("cook : %s, %u mips, %u bytes, %.3fms\n", format_names[header->format], header->mip_count, cooked.size, 1000.0*cook_seconds);
+        for(u32 mip_index = 0;
+                mip_index < header->mip_count;
+                ++mip_index)
+        {
+            CookedTextureMip *mip = get_cooked_texture_mip(header, mip_index);
+            printf("mip %u : %ux%u, %u bytes\n", mip_index, mip->width, mip->height, mip->size);
+        }
+        printf("output : %s\n", output_path);
+
+        result = true;
+    }
+    else
+    {
+        printf("Failed to read back the cooked texture %s\n", output_path);
+    }
+
+    if(cooked_file.memory)
+    {
+        debug_linux_free_file_memory(cooked_file.memory);
+    }
+
+    if(result && write_mips)
+    {
+        TextureMipChain chain = generate_mip_chain(arena, transient_arena, image, filter);
+        for(u32 mip_index = 0;
+                mip_index < chain.mip_count;
+                ++mip_index)
+        {
+            char mip_path[1024];
+            snprintf(mip_path, sizeof(mip_path), "%s.mip%u.bmp", output_path, mip_index);
+            write_offline_mip_bmp(arena, mip_path, chain.mips + mip_index);
+        }
+    }
+
+    return result;
+}
+
+internal
+PROGRESSIVE_RAYTRACER_CALLBACK(print_progressive_raytracer_pass)
+{
+    printf("pass %u : %u/%u pixels converged\n", pass_index, converged_pixel_count, width*height);
+}
+
+// NOTE(joon) obj file that is already inside the world as the triangles, kept around so that it can be baked
+struct OfflineMesh
+{
+    RawMesh mesh;
+    u32 material_index;
+};
+
+struct OfflineScene
+{
+    RaytracerWorld world;
+    u32 max_material_count;
+    u32 max_plane_count;
+    u32 max_sphere_count;
+    u32 max_triangle_count;
+
+    OfflineMesh *meshes;
+    u32 mesh_count;
+    u32 max_mesh_count;
+
+    // NOTE(joon) only exists when the scene had a vox file, see add_offline_vox
+    VoxelWorld voxel_world;
+    u8 *voxel_memory;
+
+    v3 camera_p;
+    v3 camera_target;
+};
+
+internal u32
+add_offline_material(OfflineScene *scene, v3 emit_color, v3 reflection_color, r32 reflectivity)
+{
+    RaytracerWorld *world = &scene->world;
+    assert(world->material_count < scene->max_material_count);
+
+    u32 result = world->material_count++;
+    RaytracerMaterial *material = world->materials + result;
+    *material = {};
+    material->emit_color = emit_color;
+    material->reflection_color = reflection_color;
+    material->reflectivity = reflectivity;
+
+    return result;
+}
+
+internal void
+add_offline_sphere(OfflineScene *scene, v3 center, r32 radius, u32 material_index)
+{
+    RaytracerWorld *world = &scene->world;
+    assert(world->sphere_count < scene->max_sphere_count);
+
+    RaytracerSphere *sphere = world->spheres + world->sphere_count++;
+    sphere->center = center;
+    sphere->radius = radius;
+    sphere->material_index = material_index;
+}
+
+internal void
+add_offline_plane(OfflineScene *scene, v3 normal, r32 d, u32 material_index)
+{
+    RaytracerWorld *world = &scene->world;
+    assert(world->plane_count < scene->max_plane_count);
+
+    RaytracerPlane *plane = world->planes + world->plane_count++;
+    plane->normal = normalize(normal);
+    plane->d = d;
+    plane->material_index = material_index;
+}
+
+internal void
+add_offline_triangle(OfflineScene *scene, v3 v0, v3 v1, v3 v2, u32 material_index)
+{
+    RaytracerWorld *world = &scene->world;
+    assert(world->triangle_count < scene->max_triangle_count);
+
+    RaytracerTriangle *triangle = world->triangles + world->triangle_count++;
+    triangle->v0 = v0;
+    triangle->v1 = v1;
+    triangle->v2 = v2;
+    triangle->material_index = material_index;
+}
+
+// NOTE(joon) The positions & the indices of the mesh go into the arena(already scaled & offset), see OfflineMesh
+internal b32
+add_offline_obj(OfflineScene *scene, MemoryArena *arena, MemoryArena *transient_arena, char *path, u32 material_index, r32 scale, v3 offset)
+{
+    b32 result = false;
+
+    PlatformReadFileResult file = {};
+    if(scene->mesh_count < scene->max_mesh_count)
+    {
+        file = debug_linux_read_file(path);
+    }
+
+    if(file.memory)
+    {
+        TempMemory mesh_memory = start_temp_memory(transient_arena, file.size*8 + megabytes(1), false);
+        // NOTE(joon) parse_obj_tokens wants an arena, so lend it the temp memory
+        MemoryArena mesh_arena = start_memory_arena(mesh_memory.base, mesh_memory.total_size);
+        RawMesh mesh = parse_obj_tokens(&mesh_arena, file.memory, file.size);
+
+        OfflineMesh *offline_mesh = scene->meshes + scene->mesh_count++;
+        *offline_mesh = {};
+        offline_mesh->material_index = material_index;
+        offline_mesh->mesh.position_count = mesh.position_count;
+        offline_mesh->mesh.positions = push_array(arena, v3, mesh.position_count);
+        for(u32 position_index = 0;
+                position_index < mesh.position_count;
+                ++position_index)
+        {
+            offline_mesh->mesh.positions[position_index] = scale*mesh.positions[position_index] + offset;
+        }
+        offline_mesh->mesh.index_count = 3*(mesh.index_count/3);
+        offline_mesh->mesh.indices = push_array(arena, u32, offline_mesh->mesh.index_count);
+        memcpy(offline_mesh->mesh.indices, mesh.indices, sizeof(u32)*offline_mesh->mesh.index_count);
+
+        for(u32 index = 0;
+                index < offline_mesh->mesh.index_count;
+                index += 3)
+        {
+            u32 *indices = offline_mesh->mesh.indices + index;
+            add_offline_triangle(scene, offline_mesh->mesh.positions[indices[0]], offline_mesh->mesh.positions[indices[1]],
+                                 offline_mesh->mesh.positions[indices[2]], material_index);
+        }
+
+        end_temp_memory(&mesh_memory);
+        debug_linux_free_file_memory(file.memory);
+        result = true;
+    }
+
+    return result;
+}
+
+// NOTE(joon) The material should already exist, and keeps the emit color
+internal b32
+add_offline_merl_brdf(OfflineScene *scene, MemoryArena *arena, char *path, u32 material_index)
+{
+    b32 result = false;
+
+    RaytracerWorld *world = &scene->world;
+    PlatformReadFileResult file = debug_linux_read_file(path);
+    if(file.memory)
+    {
+        // NOTE(joon) load_merl_brdf only asserts on the dimensions, so make sure that the whole table is there
+        if(material_index < world->material_count &&
+           file.size == 3*sizeof(i32) + 3*Merl_Brdf_Channel_Size*sizeof(r64))
+        {
+            // NOTE(joon) the table is malloced, and stays alive until the process ends, same as the world
+            MerlBrdf *brdf = push_struct(arena, MerlBrdf);
+            build_merl_brdf(brdf, load_merl_brdf(file), arena);
+
+            world->materials[material_index].merl_brdf = brdf;
+            result = true;
+        }
+
+        debug_linux_free_file_memory(file.memory);
+    }
+
+    return result;
+}
+
+/*
+   NOTE(joon) The vox file becomes the voxel world of the scene(see allocate_voxel_chunk_from_vox_file), which the raytracer
+   traces as it is. The voxel memory of the world gets its own block from the arena, as the chunks are relative to it.
+*/
+internal b32
+add_offline_vox(OfflineScene *scene, MemoryArena *arena, MemoryArena *transient_arena, char *path, r32 voxel_dim, v3 offset)
+{
+    b32 result = false;
+
+    // NOTE(joon) the voxels of the vox file are always inside the first chunk, which can only be built once
+    PlatformReadFileResult file = {};
+    if(!scene->voxel_memory)
+    {
+        file = debug_linux_read_file(path);
+    }
+
+    if(file.memory)
+    {
+        load_vox_result vox = load_vox(file.memory, file.size);
+        debug_linux_free_file_memory(file.memory);
+
+        VoxelWorld *voxel_world = &scene->voxel_world;
+        initialize_voxel_world(voxel_world);
+        voxel_world->voxel_dim = voxel_dim;
+
+        u64 voxel_memory_size = get_max_voxel_memory_size(voxel_world, (u32)vox.voxel_count);
+        scene->voxel_memory = (u8 *)push_size(arena, voxel_memory_size);
+        MemoryArena voxel_arena = start_memory_arena(scene->voxel_memory, voxel_memory_size);
+        allocate_voxel_chunk_from_vox_file(voxel_world, &voxel_arena, transient_arena, vox);
+
+        // NOTE(joon) only the palette colors that the voxels use get the materials
+        RaytracerWorld *world = &scene->world;
+        world->voxel_material_indices = push_array(arena, u32, 256);
+        zero_memory(world->voxel_material_indices, sizeof(u32)*256);
+        for(u32 voxel_index = 0;
+                voxel_index < (u32)vox.voxel_count;
+                ++voxel_index)
+        {
+            u8 color_id = vox.colorIDs[voxel_index];
+            if(world->voxel_material_indices[color_id] == 0)
+            {
+                u32 color = voxel_world->palette[color_id];
+                v3 reflection_color = V3(srgb_to_linear((color & 0xff) / 255.0f),
+                                         srgb_to_linear(((color >> 8) & 0xff) / 255.0f),
+                                         srgb_to_linear(((color >> 16) & 0xff) / 255.0f));
+                world->voxel_material_indices[color_id] = add_offline_material(scene, V3(0, 0, 0), reflection_color, 0.0f);
+            }
+        }
+
+        world->voxel_world = voxel_world;
+        world->voxel_memory = scene->voxel_memory;
+        world->voxel_world_p = offset;
+
+        free_loaded_vox(&vox);
+        free(vox.colorIDs);
+        free(vox.palette);
+
+        result = true;
+    }
+
+    return result;
+}
+
+internal void
+load_default_offline_scene(OfflineScene *scene)
+{
+    scene->world.materials[0].emit_color = V3(0.3f, 0.4f, 0.5f);
+
+    u32 floor_material = add_offline_material(scene, V3(0, 0, 0), V3(0.5f, 0.5f, 0.5f), 0.0f);
+    u32 red_material = add_offline_material(scene, V3(0, 0, 0), V3(0.7f, 0.2f, 0.2f), 0.0f);
+    u32 mirror_material = add_offline_material(scene, V3(0, 0, 0), V3(0.9f, 0.9f, 0.9f), 0.95f);
+    u32 glossy_material = add_offline_material(scene, V3(0, 0, 0), V3(0.2f, 0.6f, 0.3f), 0.5f);
+    u32 light_material = add_offline_material(scene, V3(8.0f, 7.0f, 6.0f), V3(0, 0, 0), 0.0f);
+
+    add_offline_plane(scene, V3(0, 0, 1), 0.0f, floor_material);
+
+    add_offline_sphere(scene, V3(0, 0, 1), 1.0f, red_material);
+    add_offline_sphere(scene, V3(2.5f, 1.0f, 1.0f), 1.0f, mirror_material);
+    add_offline_sphere(scene, V3(-2.5f, 1.5f, 1.5f), 1.5f, glossy_material);
+    add_offline_sphere(scene, V3(0.0f, -3.0f, 4.0f), 0.5f, light_material);
+
+    // NOTE(joon) a few triangles, so that the bvh & the light list also get some work
+    add_offline_triangle(scene, V3(-4, 4, 0), V3(4, 4, 0), V3(4, 4, 3), glossy_material);
+    add_offline_triangle(scene, V3(-4, 4, 0), V3(4, 4, 3), V3(-4, 4, 3), glossy_material);
+    add_offline_triangle(scene, V3(-1, 3.5f, 5), V3(1, 3.5f, 5), V3(0, 2.5f, 5), light_material);
+
+    scene->camera_p = V3(0, -10, 3);
+    scene->camera_target = V3(0, 0, 1);
+}
+
+internal b32
+load_offline_scene(OfflineScene *scene, MemoryArena *arena, MemoryArena *transient_arena, char *path)
+{
+    b32 result = true;
+
+    PlatformReadFileResult file = debug_linux_read_file(path);
+    if(!file.memory)
+    {
+        printf("Failed to read the scene file %s\n", path);
+        return false;
+    }
+
+    // NOTE(joon) null terminated copy, so that we can use sscanf on it
+    char *text = (char *)malloc(file.size + 1);
+    memcpy(text, file.memory, file.size);
+    text[file.size] = 0;
+    debug_linux_free_file_memory(file.memory);
+
+    u32 line_number = 0;
+    char *line = text;
+    while(line && *line && result)
+    {
+        line_number++;
+        char *next_line = strchr(line, '\n');
+        if(next_line)
+        {
+            *next_line++ = 0;
+        }
+
+        char command[32] = {};
+        char path_buffer[512] = {};
+        r32 v[10] = {};
+        u32 material_index = 0;
+        if(sscanf(line, "%31s", command) != 1 || command[0] == '#')
+        {
+            // NOTE(joon) empty line or comment
+        }
+        else if(strcmp(command, "camera") == 0 &&
+                sscanf(line, "%*s %f %f %f %f %f %f", v + 0, v + 1, v + 2, v + 3, v + 4, v + 5) == 6)
+        {
+            scene->camera_p = V3(v[0], v[1], v[2]);
+            scene->camera_target = V3(v[3], v[4], v[5]);
+        }
+        else if(strcmp(command, "sky") == 0 &&
+                sscanf(line, "%*s %f %f %f", v + 0, v + 1, v + 2) == 3)
+        {
+            scene->world.materials[0].emit_color = V3(v[0], v[1], v[2]);
+        }
+        else if(strcmp(command, "material") == 0 &&
+                sscanf(line, "%*s %f %f %f %f %f %f %f", v + 0, v + 1, v + 2, v + 3, v + 4, v + 5, v + 6) == 7)
+        {
+            add_offline_material(scene, V3(v[0], v[1], v[2]), V3(v[3], v[4], v[5]), v[6]);
+        }
+        else if(strcmp(command, "sphere") == 0 &&
+                sscanf(line, "%*s %f %f %f %f %u", v + 0, v + 1, v + 2, v + 3, &material_index) == 5)
+        {
+            add_offline_sphere(scene, V3(v[0], v[1], v[2]), v[3], material_index);
+        }
+        else if(strcmp(command, "plane") == 0 &&
+                sscanf(line, "%*s %f %f %f %f %u", v + 0, v + 1, v + 2, v + 3, &material_index) == 5)
+        {
+            add_offline_plane(scene, V3(v[0], v[1], v[2]), v[3], material_index);
+        }
+        else if(strcmp(command, "obj") == 0)
+        {
+            // NOTE(joon) scale & offset are optional
+            v[0] = 1.0f;
+            i32 count = sscanf(line, "%*s %511s %u %f %f %f %f", path_buffer, &material_index, v + 0, v + 1, v + 2, v + 3);
+            if(count < 2 || !add_offline_obj(scene, arena, transient_arena, path_buffer, material_index, v[0], V3(v[1], v[2], v[3])))
+            {
+                printf("Failed to load the obj file at line %u\n", line_number);
+                result = false;
+            }
+        }
+        else if(strcmp(command, "vox") == 0)
+        {
+            v[0] = 1.0f;
+            i32 count = sscanf(line, "%*s %511s %f %f %f %f", path_buffer, v + 0, v + 1, v + 2, v + 3);
+            if(count < 1 || !add_offline_vox(scene, arena, transient_arena, path_buffer, v[0], V3(v[1], v[2], v[3])))
+            {
+                printf("Failed to load the vox file at line %u\n", line_number);
+                result = false;
+            }
+        }
+        else if(strcmp(command, "merl") == 0)
+        {
+            i32 count = sscanf(line, "%*s %511s %u", path_buffer, &material_index);
+            if(count < 2 || !add_offline_merl_brdf(scene, arena, path_buffer, material_index))
+            {
+                printf("Failed to load the merl brdf at line %u\n", line_number);
+                result = false;
+            }
+        }
+        else
+        {
+            printf("Could not parse line %u of the scene file : %s\n", line_number, line);
+            result = false;
+        }
+
+        line = next_line;
+    }
+
+    free(text);
+
+    // NOTE(joon) the materials that come after the primitives are fine, but they all should exist by now
+    RaytracerWorld *world = &scene->world;
+    for(u32 sphere_index = 0;
+            sphere_index < world->sphere_count;
+            ++sphere_index)
+    {
+        result &= (world->spheres[sphere_index].material_index < world->material_count);
+    }
+    for(u32 plane_index = 0;
+            plane_index < world->plane_count;
+            ++plane_index)
+    {
+        result &= (world->planes[plane_index].material_index < world->material_count);
+    }
+    for(u32 triangle_index = 0;
+            triangle_index < world->triangle_count;
+            ++triangle_index)
+    {
+        result &= (world->triangles[triangle_index].material_index < world->material_count);
+    }
+
+    if(!result)
+    {
+        printf("Failed to load the scene %s\n", path);
+    }
+
+    return result;
+}
+
+// NOTE(joon) Diffuse surface that is lit by the baked irradiance, as the srgb vertex color of the obj
+internal v3
+get_offline_baked_color(BakedLighting *lighting, v3 normal, RaytracerMaterial *material)
+{
+    v3 radiance = material->emit_color + (1.0f / pi_32)*hadamard(material->reflection_color, get_baked_irradiance(lighting, normal));
+
+    v3 result = V3(linear_to_srgb(clamp01(radiance.r)),
+                   linear_to_srgb(clamp01(radiance.g)),
+                   linear_to_srgb(clamp01(radiance.b)));
+
+    return result;
+}
+
+/*
+   NOTE(joon) Bakes the lighting of the obj meshes(see bake_mesh_lighting) & the voxel world(see bake_voxel_world_lighting)
+   of the scene, the same way as the game would after loading them, and writes them out as an obj with the vertex colors
+   so that the bake can be checked in any mesh viewer. The voxel faces that are covered by another voxel are not written.
+   The raytracer world should be already built, as the meshes are baked against it.
+*/
+internal b32
+bake_offline_scene(OfflineScene *scene, MemoryArena *arena, MemoryArena *transient_arena, thread_work_queue *queue, char *output_path)
+{
+    FILE *file = fopen(output_path, "w");
+    if(!file)
+    {
+        printf("Failed to open %s\n", output_path);
+        return false;
+    }
+
+    RaytracerWorld *world = &scene->world;
+    LightingBakeSettings settings = get_default_lighting_bake_settings();
+    // NOTE(joon) so that the voxels see the same sky as the meshes
+    settings.sky_color = world->materials[0].emit_color;
+
+    r64 bake_begin_seconds = get_seconds();
+    r64 ambient_occlusion_sum = 0.0;
+    u32 sample_count = 0;
+    u32 vertex_count = 0;
+    fprintf(file, "# baked by hb_render\n");
+    for(u32 mesh_index = 0;
+            mesh_index < scene->mesh_count;
+            ++mesh_index)
+    {
+        OfflineMesh *offline_mesh = scene->meshes + mesh_index;
+        RawMesh *mesh = &offline_mesh->mesh;
+        RaytracerMaterial *material = world->materials + offline_mesh->material_index;
+
+        hot_kernels.generate_vertex_normals(arena, transient_arena, mesh);
+        bake_mesh_lighting(world, mesh, arena, transient_arena, queue, settings);
+
+        fprintf(file, "o mesh%u\n", mesh_index);
+        for(u32 position_index = 0;
+                position_index < mesh->position_count;
+                ++position_index)
+        {
+            BakedLighting *lighting = mesh->baked_lighting + position_index;
+            v3 p = mesh->positions[position_index];
+            v3 color = get_offline_baked_color(lighting, normalize(mesh->normals[position_index]), material);
+            fprintf(file, "v %f %f %f %f %f %f\n", p.x, p.y, p.z, color.r, color.g, color.b);
+
+            ambient_occlusion_sum += get_baked_ambient_occlusion(lighting);
+        }
+        for(u32 index = 0;
+                index < mesh->index_count;
+                index += 3)
+        {
+            u32 *indices = mesh->indices + index;
+            fprintf(file, "f %u %u %u\n", vertex_count + indices[0] + 1, vertex_count + indices[1] + 1, vertex_count + indices[2] + 1);
+        }
+
+        vertex_count += mesh->position_count;
+        sample_count += mesh->position_count;
+    }
+
+    u32 voxel_face_count = 0;
+    VoxelWorld *voxel_world = world->voxel_world;
+    if(voxel_world)
+    {
+        bake_voxel_world_lighting(voxel_world, world->voxel_memory, arena, transient_arena, queue, settings);
+
+        fprintf(file, "o voxels\n");
+        u32 chunk_dim = voxel_world->chunk_dim;
+        r32 voxel_dim = voxel_world->voxel_dim;
+        for(u32 hash_index = 0;
+                hash_index < array_count(voxel_world->chunk_hashes);
+                ++hash_index)
+        {
+            VoxelChunkHash *chunk = voxel_world->chunk_hashes + hash_index;
+            if(chunk->first_node_offset == Empty_Hash || chunk->voxel_count == 0)
+            {
+                continue;
+            }
+            VoxelOctree octree = get_voxel_octree(voxel_world, world->voxel_memory, chunk);
+
+            TempMemory voxel_memory = start_temp_memory(transient_arena, 3*sizeof(u8)*chunk->voxel_count + 1, false);
+            u8 *xs = push_array(&voxel_memory, u8, chunk->voxel_count);
+            u8 *ys = push_array(&voxel_memory, u8, chunk->voxel_count);
+            u8 *zs = push_array(&voxel_memory, u8, chunk->voxel_count);
+            u32 gathered_voxel_count = 0;
+            gather_voxels_inside_chunk(&octree, 0, octree.root_node_index, 0, 0, 0, chunk_dim, xs, ys, zs, &gathered_voxel_count);
+
+            for(u32 voxel_index = 0;
+                    voxel_index < gathered_voxel_count;
+                    ++voxel_index)
+            {
+                u32 x = xs[voxel_index];
+                u32 y = ys[voxel_index];
+                u32 z = zs[voxel_index];
+                u8 color_id = get_voxel(&octree, x, y, z).color_id;
+                RaytracerMaterial *material = world->materials + world->voxel_material_indices[color_id];
+                v3 voxel_min = world->voxel_world_p + voxel_dim*V3((r32)(chunk->x*chunk_dim + x),
+                                                                   (r32)(chunk->y*chunk_dim + y),
+                                                                   (r32)(chunk->z*chunk_dim + z));
+
+                for(u32 face_index = 0;
+                        face_index < Voxel_Face_Count;
+                        ++face_index)
+                {
+                    BakedLighting *lighting = get_baked_voxel_face_lighting(chunk, x, y, z, face_index);
+                    if(lighting)
+                    {
+                        // NOTE(joon) the quad goes counter clockwise when looking at it from the outside
+                        u32 axis = face_index/2;
+                        b32 is_positive = !(face_index & 1);
+                        v3 normal = {};
+                        normal.e[axis] = is_positive ? 1.0f : -1.0f;
+                        v3 u = {};
+                        u.e[(axis + 1) % 3] = voxel_dim;
+                        v3 v = {};
+                        v.e[(axis + 2) % 3] = voxel_dim;
+                        if(!is_positive)
+                        {
+                            v3 temp = u;
+                            u = v;
+                            v = temp;
+                        }
+
+                        v3 corner = voxel_min;
+                        if(is_positive)
+                        {
+                            corner.e[axis] += voxel_dim;
+                        }
+                        v3 corners[4] = {corner, corner + u, corner + u + v, corner + v};
+
+                        v3 color = get_offline_baked_color(lighting, normal, material);
+                        for(u32 corner_index = 0;
+                                corner_index < 4;
+                                ++corner_index)
+                        {
+                            v3 p = corners[corner_index];
+                            fprintf(file, "v %f %f %f %f %f %f\n", p.x, p.y, p.z, color.r, color.g, color.b);
+                        }
+                        fprintf(file, "f %u %u %u %u\n", vertex_count + 1, vertex_count + 2, vertex_count + 3, vertex_count + 4);
+
+                        vertex_count += 4;
+                        voxel_face_count++;
+                        ambient_occlusion_sum += get_baked_ambient_occlusion(lighting);
+                    }
+                }
+            }
+
+            end_temp_memory(&voxel_memory);
+        }
+
+        sample_count += voxel_face_count;
+    }
+    r64 bake_seconds = get_seconds() - bake_begin_seconds;
+
+    fclose(file);
+
+    printf("bake : %u meshes, %u voxel faces, %u rays per sample, %.3fs\n",
+            scene->mesh_count, voxel_face_count, get_valid_lighting_bake_settings(settings).ray_per_sample_count, bake_seconds);
+    printf("average ambient occlusion : %.3f\n", sample_count ? ambient_occlusion_sum/(r64)sample_count : 1.0);
+    printf("output : %s\n", output_path);
+
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    char *scene_path = 0;
+    char *output_path = 0;
+    u32 output_width = 960;
+    u32 output_height = 540;
+    u32 ray_per_pixel_count = 16;
+    u32 thread_count = (u32)sysconf(_SC_NPROCESSORS_ONLN);
+    SamplerType sampler_type = SamplerType_Sobol;
+    b32 use_wavefront = false;
+    OutputEncoding output_encoding = {};
+    b32 is_progressive = false;
+    u32 max_pass_count = 0;
+    r32 max_relative_error = 0.02f;
+    b32 use_denoiser = false;
+    char *bake_path = 0;
+    char *cook_path = 0;
+    TextureFormat cook_format = TextureFormat_BC7;
+    MipFilter mip_filter = MipFilter_Kaiser;
+    b32 write_mips = false;
+
+    for(i32 arg_index = 1;
+            arg_index < argc;
+            ++arg_index)
+    {
+        char *arg = argv[arg_index];
+        b32 has_value = (arg_index + 1 < argc);
+        if(strcmp(arg, "-w") == 0 && has_value)
+        {
+            output_width = (u32)atoi(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-h") == 0 && has_value)
+        {
+            output_height = (u32)atoi(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-spp") == 0 && has_value)
+        {
+            ray_per_pixel_count = (u32)atoi(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-threads") == 0 && has_value)
+        {
+            thread_count = (u32)atoi(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-o") == 0 && has_value)
+        {
+            output_path = argv[++arg_index];
+        }
+        else if(strcmp(arg, "-sampler") == 0 && has_value)
+        {
+            char *sampler_name = argv[++arg_index];
+            if(strcmp(sampler_name, "bluenoise") == 0)
+            {
+                sampler_type = SamplerType_BlueNoiseSobol;
+            }
+            else if(strcmp(sampler_name, "pcg") == 0)
+            {
+                sampler_type = SamplerType_Pcg;
+            }
+        }
+        else if(strcmp(arg, "-wavefront") == 0)
+        {
+            use_wavefront = true;
+        }
+        else if(strcmp(arg, "-tonemap") == 0 && has_value)
+        {
+            char *tone_map_name = argv[++arg_index];
+            if(strcmp(tone_map_name, "reinhard") == 0)
+            {
+                output_encoding.tone_map_type = ToneMapType_Reinhard;
+            }
+            else if(strcmp(tone_map_name, "aces") == 0)
+            {
+                output_encoding.tone_map_type = ToneMapType_ACES;
+            }
+        }
+        else if(strcmp(arg, "-exposure") == 0 && has_value)
+        {
+            output_encoding.exposure = (r32)atof(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-dither") == 0)
+        {
+            output_encoding.use_dithering = true;
+        }
+        else if(strcmp(arg, "-passes") == 0 && has_value)
+        {
+            is_progressive = true;
+            max_pass_count = (u32)atoi(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-error") == 0 && has_value)
+        {
+            max_relative_error = (r32)atof(argv[++arg_index]);
+        }
+        else if(strcmp(arg, "-denoise") == 0)
+        {
+            use_denoiser = true;
+        }
+        else if(strcmp(arg, "-bake") == 0 && has_value)
+        {
+            bake_path = argv[++arg_index];
+        }
+        else if(strcmp(arg, "-cook") == 0 && has_value)
+        {
+            cook_path = argv[++arg_index];
+        }
+        else if(strcmp(arg, "-format") == 0 && has_value)
+        {
+            char *format_name = argv[++arg_index];
+            if(strcmp(format_name, "rgba8") == 0)
+            {
+                cook_format = TextureFormat_RGBA8;
+            }
+            else if(strcmp(format_name, "bc1") == 0)
+            {
+                cook_format = TextureFormat_BC1;
+            }
+            else if(strcmp(format_name, "bc3") == 0)
+            {
+                cook_format = TextureFormat_BC3;
+            }
+            else if(strcmp(format_name, "bc7") == 0)
+            {
+                cook_format = TextureFormat_BC7;
+            }
+        }
+        else if(strcmp(arg, "-mipfilter") == 0 && has_value)
+        {
+            char *filter_name = argv[++arg_index];
+            if(strcmp(filter_name, "box") == 0)
+            {
+                mip_filter = MipFilter_Box;
+            }
+            else if(strcmp(filter_name, "kaiser") == 0)
+            {
+                mip_filter = MipFilter_Kaiser;
+            }
+        }
+        else if(strcmp(arg, "-mips") == 0)
+        {
+            write_mips = true;
+        }
+        else if(arg[0] != '-' && !scene_path)
+        {
+            scene_path = arg;
+        }
+        else
+        {
+            printf("usage : %s [scene file] [-w width] [-h height] [-spp count] [-threads count] [-o output.bmp]"
+                   " [-sampler sobol|bluenoise|pcg] [-wavefront] [-tonemap none|reinhard|aces] [-exposure stops] [-dither]"
+                   " [-passes count] [-error relative_error] [-denoise]\n"
+                   "        %s [scene file] -bake output.obj [-threads count]\n"
+                   "        %s -cook texture.tga [-format rgba8|bc1|bc3|bc7] [-mipfilter box|kaiser] [-mips] [-threads count] [-o texture.hbtx]\n",
+                   argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    if(output_width == 0 || output_height == 0 || ray_per_pixel_count == 0)
+    {
+        printf("The resolution & the ray per pixel count should not be 0\n");
+        return 1;
+    }
+    // NOTE(joon) the pixels around the small lights can take forever to converge, so there should always be a limit
+    if(is_progressive && max_pass_count == 0)
+    {
+        printf("The pass count should not be 0\n");
+        return 1;
+    }
+    thread_count = maximum(thread_count, 1);
+
+    init_hot_kernels(&hot_kernels);
+
+    // NOTE(joon) malloc gives us the pages lazily, so it's fine to ask for a lot
+    MemoryArena arena = start_memory_arena(malloc(gigabytes(2)), gigabytes(2));
+    MemoryArena transient_arena = start_memory_arena(malloc(gigabytes(1)), gigabytes(1));
+
+    // NOTE(joon) worker threads, the main thread also works on the queue
+    thread_work_queue queue = {};
+    queue.add_thread_work_queue_item = linux_add_thread_work_item;
+    queue.complete_all_thread_work_queue_items = linux_complete_all_thread_work_queue_items;
+    sem_init(&semaphore, 0, 0);
+
+    u32 worker_thread_count = thread_count - 1;
+    linux_thread *threads = (linux_thread *)malloc(sizeof(linux_thread)*maximum(worker_thread_count, 1));
+    for(u32 thread_index = 0;
+            thread_index < worker_thread_count;
+            ++thread_index)
+    {
+        linux_thread *thread = threads + thread_index;
+        thread->ID = thread_index + 1;
+        thread->queue = &queue;
+
+        pthread_t thread_id;
+        pthread_create(&thread_id, 0, thread_proc, thread);
+    }
+
+    if(cook_path)
+    {
+        if(!output_path)
+        {
+            output_path = (char *)"texture.hbtx";
+        }
+
+        return cook_offline_texture(&arena, &transient_arena, &queue, cook_path, output_path, cook_format, mip_filter, write_mips) ? 0 : 1;
+    }
+
+    if(!output_path)
+    {
+        output_path = (char *)"render.bmp";
+    }
+
+    OfflineScene scene = {};
+    scene.max_material_count = 1024;
+    scene.max_plane_count = 256;
+    scene.max_sphere_count = 4096;
+    scene.max_triangle_count = 16*1024*1024;
+    scene.max_mesh_count = 256;
+
+    RaytracerWorld *world = &scene.world;
+    world->materials = push_array(&arena, RaytracerMaterial, scene.max_material_count);
+    world->planes = push_array(&arena, RaytracerPlane, scene.max_plane_count);
+    world->spheres = push_array(&arena, RaytracerSphere, scene.max_sphere_count);
+    world->triangles = push_array(&arena, RaytracerTriangle, scene.max_triangle_count);
+    scene.meshes = push_array(&arena, OfflineMesh, scene.max_mesh_count);
+
+    // NOTE(joon) sky
+    add_offline_material(&scene, V3(0, 0, 0), V3(0, 0, 0), 0.0f);
+
+    if(scene_path)
+    {
+        if(!load_offline_scene(&scene, &arena, &transient_arena, scene_path))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        scene_path = (char *)"default scene";
+        load_default_offline_scene(&scene);
+    }
+
+    r64 build_begin_seconds = get_seconds();
+    build_bvh(&world->bvh, &arena, &transient_arena, world->triangles, world->triangle_count, &queue);
+    build_wide_bvh(&world->wide_bvh, &arena, &world->bvh, world->triangles);
+    build_raytracer_light_list(world, &arena, &transient_arena);
+    r64 build_seconds = get_seconds() - build_begin_seconds;
+
+    if(bake_path)
+    {
+        printf("scene : %s, %u triangles, %u meshes\n", scene_path, world->triangle_count, scene.mesh_count);
+        return bake_offline_scene(&scene, &arena, &transient_arena, &queue, bake_path) ? 0 : 1;
+    }
+
+    BlueNoiseMask *blue_noise_mask = 0;
+    if(sampler_type == SamplerType_BlueNoiseSobol)
+    {
+        blue_noise_mask = push_struct(&arena, BlueNoiseMask);
+        build_blue_noise_mask(blue_noise_mask, &transient_arena, 1234);
+    }
+
+    u32 pixel_count = output_width*output_height;
+    u32 *pixels = push_array(&arena, u32, pixel_count);
+
+    // NOTE(joon) the film is 1m away from the camera, with the height of 1m
+    RaytracerData data = {};
+    data.world = world;
+    data.pixels = pixels;
+    data.output_width = output_width;
+    data.output_height = output_height;
+    data.ray_per_pixel_count = ray_per_pixel_count;
+
+    data.camera_p = scene.camera_p;
+    data.camera_z_axis = normalize(scene.camera_p - scene.camera_target);
+    data.camera_x_axis = normalize(cross(V3(0, 0, 1), data.camera_z_axis));
+    data.camera_y_axis = normalize(cross(data.camera_z_axis, data.camera_x_axis));
+
+    data.film_center = scene.camera_p - data.camera_z_axis;
+    data.film_height = 1.0f;
+    data.film_width = data.film_height*(r32)output_width/(r32)output_height;
+
+    data.sampler_type = sampler_type;
+    data.sampler_seed = 1234;
+    data.blue_noise_mask = blue_noise_mask;
+    data.use_wavefront = use_wavefront;
+    data.output_encoding = output_encoding;
+
+    RaytracerDenoiser denoiser = {};
+    if(use_denoiser)
+    {
+        data.features = push_array(&arena, RaytracerPixelFeature, pixel_count);
+        zero_memory(data.features, sizeof(RaytracerPixelFeature)*pixel_count);
+
+        start_raytracer_denoiser(&denoiser, &arena, output_width, output_height);
+        denoiser.output_encoding = output_encoding;
+    }
+
+    if(is_progressive)
+    {
+        // NOTE(joon) the variance estimate of the pixels is not reliable with less rays than this
+        data.min_ray_per_pixel_count = maximum(ray_per_pixel_count, 16);
+        data.max_relative_error = max_relative_error;
+        data.random_seed = 1234;
+
+        ProgressiveRaytracer *raytracer = push_struct(&arena, ProgressiveRaytracer);
+        start_progressive_raytracer(raytracer, &arena, &data, print_progressive_raytracer_pass, 0);
+        raytracer->max_pass_count = max_pass_count;
+
+        r64 render_begin_seconds = get_seconds();
+        while(!update_progressive_raytracer(raytracer, &queue))
+        {
+            // NOTE(joon) helps the worker threads, and then waits for the last tiles of the pass
+            queue.complete_all_thread_work_queue_items(&queue);
+        }
+        r64 render_seconds = get_seconds() - render_begin_seconds;
+
+        r64 denoise_seconds = 0.0;
+        if(use_denoiser)
+        {
+            r64 denoise_begin_seconds = get_seconds();
+            denoise_raytraced_image(&denoiser, raytracer->data.features, raytracer->data.pixels, &queue);
+            denoise_seconds = get_seconds() - denoise_begin_seconds;
+        }
+
+        write_offline_render_bmp(&arena, output_path, raytracer->data.pixels, output_width, output_height);
+
+        u64 total_ray_count = (u64)raytracer->bounced_ray_count;
+        printf("scene : %s, %u triangles, %u spheres, %u planes, %u materials, %u lights\n",
+                scene_path, world->triangle_count, world->sphere_count, world->plane_count, world->material_count, world->light_count);
+        printf("kernels : %s%s, %u threads\n", hot_kernels.name, use_wavefront ? " wavefront" : "", thread_count);
+        printf("build : %.3fms\n", 1000.0*build_seconds);
+        printf("render : %ux%u, %u rays per pixel per pass, %u passes%s, %.3fs\n",
+                output_width, output_height, ray_per_pixel_count, raytracer->pass_index, 
+                raytracer->is_converged ? "(converged)" : "", render_seconds);
+        printf("total rays : %llu\n", (unsigned long long)total_ray_count);
+        printf("Mrays/s : %.3f\n", (r64)total_ray_count / render_seconds / 1.0e6);
+        if(use_denoiser)
+        {
+            printf("denoise : %u iterations, %.3fms\n", denoiser.iteration_count, 1000.0*denoise_seconds);
+        }
+        printf("output : %s\n", output_path);
+
+        return 0;
+    }
+
+    // NOTE(joon) The tiles are all in the queue at once, so they should be big enough to fit inside
+    u32 tile_dim = 32;
+    while(((output_width + tile_dim - 1)/tile_dim)*((output_height + tile_dim - 1)/tile_dim) >= array_count(queue.items))
+    {
+        tile_dim *= 2;
+    }
+    u32 tile_count_x = (output_width + tile_dim - 1)/tile_dim;
+    u32 tile_count_y = (output_height + tile_dim - 1)/tile_dim;
+    u32 tile_count = tile_count_x*tile_count_y;
+    OfflineRenderTile *tiles = push_array(&arena, OfflineRenderTile, tile_count);
+
+    r64 render_begin_seconds = get_seconds();
+    for(u32 tile_y = 0;
+            tile_y < tile_count_y;
+            ++tile_y)
+    {
+        for(u32 tile_x = 0;
+                tile_x < tile_count_x;
+                ++tile_x)
+        {
+            u32 tile_index = tile_y*tile_count_x + tile_x;
+            OfflineRenderTile *tile = tiles + tile_index;
+            tile->data = data;
+            tile->data.min_x = tile_x*tile_dim;
+            tile->data.min_y = tile_y*tile_dim;
+            tile->data.one_past_max_x = minimum(tile->data.min_x + tile_dim, output_width);
+            tile->data.one_past_max_y = minimum(tile->data.min_y + tile_dim, output_height);
+            tile->data.random_seed = 1234 + tile_index;
+
+            queue.add_thread_work_queue_item(&queue, thread_work_callback_render_offline_tile, tile);
+        }
+    }
+    queue.complete_all_thread_work_queue_items(&queue);
+    r64 render_seconds = get_seconds() - render_begin_seconds;
+
+    r64 denoise_seconds = 0.0;
+    if(use_denoiser)
+    {
+        r64 denoise_begin_seconds = get_seconds();
+        denoise_raytraced_image(&denoiser, data.features, pixels, &queue);
+        denoise_seconds = get_seconds() - denoise_begin_seconds;
+    }
+
+    RaytracerOutput total = {};
+    for(u32 tile_index = 0;
+            tile_index < tile_count;
+            ++tile_index)
+    {
+        RaytracerOutput *output = &tiles[tile_index].output;
+        total.bounced_ray_count += output->bounced_ray_count;
+        total.camera_ray_count += output->camera_ray_count;
+        for(u32 bounce_index = 0;
+                bounce_index < Raytracer_Max_Bounce_Count;
+                ++bounce_index)
+        {
+            total.bounce_lane_counts[bounce_index] += output->bounce_lane_counts[bounce_index];
+            total.bounce_alive_lane_counts[bounce_index] += output->bounce_alive_lane_counts[bounce_index];
+        }
+    }
+
+    write_offline_render_bmp(&arena, output_path, pixels, output_width, output_height);
+
+    // NOTE(joon) total is every ray that went through the intersection test, the bounced ones are the total minus the camera rays.
+    // The shadow rays of the next event estimation are not counted
+    u64 total_ray_count = total.bounced_ray_count;
+    u64 bounced_ray_count = total.bounced_ray_count - total.camera_ray_count;
+    printf("scene : %s, %u triangles, %u spheres, %u planes, %u materials, %u lights\n",
+            scene_path, world->triangle_count, world->sphere_count, world->plane_count, world->material_count, world->light_count);
+    printf("kernels : %s%s, %u threads\n", hot_kernels.name, use_wavefront ? " wavefront" : "", thread_count);
+    printf("build : %.3fms\n", 1000.0*build_seconds);
+    printf("render : %ux%u, %u rays per pixel, %u tiles of %u, %.3fs\n",
+            output_width, output_height, ray_per_pixel_count, tile_count, tile_dim, render_seconds);
+    printf("total rays : %llu\n", (unsigned long long)total_ray_count);
+    printf("bounced rays : %llu\n", (unsigned long long)bounced_ray_count);
+    printf("Mrays/s : %.3f\n", (r64)total_ray_count / render_seconds / 1.0e6);
+    for(u32 bounce_index = 0;
+            bounce_index < Raytracer_Max_Bounce_Count;
+            ++bounce_index)
+    {
+        u64 lane_count = total.bounce_lane_counts[bounce_index];
+        if(lane_count)
+        {
+            u64 alive_lane_count = total.bounce_alive_lane_counts[bounce_index];
+            printf("bounce %u : %llu rays, lane utilization %.1f%%\n", bounce_index, (unsigned long long)alive_lane_count,
+                    100.0*(r64)alive_lane_count/(r64)lane_count);
+        }
+    }
+    if(use_denoiser)
+    {
+        printf("denoise : %u iterations, %.3fms\n", denoiser.iteration_count, 1000.0*denoise_seconds);
+    }
+    printf("output : %s\n", output_path);
+
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <libkern/OSAtomic.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <unistd.h> // sysconf
 #include <Carbon/Carbon.h>
 #include <dlfcn.h> // dlsym
 #include <metalkit/metalkit.h>
@@ -348,35 +349,6 @@ THREAD_WORK_CALLBACK(print_string)
     printf("%s\n", stringToPrint);
 }
 
-#if 0
-struct thread_work_raytrace_tile_data
-{
-    raytracer_data raytracer_input;
-};
-
-global volatile u64 total_bounced_ray_count;
-internal 
-THREAD_WORK_CALLBACK(thread_work_callback_render_tile)
-{
-    thread_work_raytrace_tile_data *raytracer_data = (thread_work_raytrace_tile_data *)data;
-
-    //raytracer_output output = render_raytraced_image_tile(&raytracer_data->raytracer_input);
-    raytracer_output output = render_raytraced_image_tile_simd(&raytracer_data->raytracer_input);
-
-    // TODO(joon): double check the return value of the OSAtomicIncrement32, is it really a post incremented value? 
-    i32 rendered_tile_count = OSAtomicIncrement32Barrier((volatile int32_t *)&raytracer_data->raytracer_input.world->rendered_tile_count);
-
-    u64 ray_count = raytracer_data->raytracer_input.ray_per_pixel_count*
-                    (raytracer_data->raytracer_input.one_past_max_x - raytracer_data->raytracer_input.min_x) * 
-                    (raytracer_data->raytracer_input.one_past_max_y - raytracer_data->raytracer_input.min_y);
-
-    OSAtomicAdd64Barrier(ray_count, (volatile int64_t *)&raytracer_data->raytracer_input.world->total_ray_count);
-    OSAtomicAdd64Barrier(output.bounced_ray_count, (volatile int64_t *)&raytracer_data->raytracer_input.world->bounced_ray_count);
-
-    printf("%dth tile finished with %llu rays\n", rendered_tile_count, raytracer_data->raytracer_input.world->total_ray_count);
-}
-#endif
-
 // NOTE(joon): This is single producer multiple consumer - 
 // meaning, it _does not_ provide any thread safety
 // For example, if the two threads try to add the work item,
@@ -391,9 +363,10 @@ macos_add_thread_work_item(thread_work_queue *queue,
     item->callback = work_callback;
     item->data = data;
     item->written = true;
+    queue->completion_goal++;
 
     write_barrier();
-    queue->add_index++;
+    queue->add_index = (queue->add_index + 1) % array_count(queue->items);
 
     // increment the semaphore value by 1
     dispatch_semaphore_signal(semaphore);
@@ -406,12 +379,14 @@ macos_do_thread_work_item(thread_work_queue *queue, u32 thread_index)
     if(queue->work_index != queue->add_index)
     {
         int original_work_index = queue->work_index;
-        int desired_work_index = original_work_index + 1;
+        int desired_work_index = (original_work_index + 1) % array_count(queue->items);
 
         if(OSAtomicCompareAndSwapIntBarrier(original_work_index, desired_work_index, &queue->work_index))
         {
             thread_work_item *item = queue->items + original_work_index;
             item->callback(item->data);
+            // NOTE(joon) full barrier, so the results of the item are visible before the count is
+            atomic_increment(&queue->completion_count);
 
             //printf("Thread %u: Finished working\n", thread_index);
             did_work = true;
@@ -424,12 +399,17 @@ macos_do_thread_work_item(thread_work_queue *queue, u32 thread_index)
 internal 
 PLATFORM_COMPLETE_ALL_THREAD_WORK_QUEUE_ITEMS(macos_complete_all_thread_work_queue_items)
 {
-    // TODO(joon): If there was a last thread that was working on the item,
-    // this does not guarantee that the last work will be finished.
-    // Maybe add some flag inside the thread? (sleep / working / ...)
-    while(queue->work_index != queue->add_index) 
+    // NOTE(joon) Helps with the items that are left, and then waits for the ones that the other threads are working on
+    while(queue->completion_count != queue->completion_goal) 
     {
-        macos_do_thread_work_item(queue, 0);
+        if(!macos_do_thread_work_item(queue, 0))
+        {
+#if HB_ARM
+            __builtin_arm_yield();
+#else
+            _mm_pause();
+#endif
+        }
     }
 }
 
@@ -549,6 +529,7 @@ metal_render_and_display(MetalRenderContext *render_context, PlatformRenderPushB
         metal_set_vertex_bytes(render_encoder, &per_frame_data, sizeof(per_frame_data), 0);
 
         u32 voxel_instance_count = 0;
+        u32 text_glyph_count = 0;
         for(u32 consumed = 0;
                 consumed < render_push_buffer->used;
                 )
@@ -625,6 +606,18 @@ metal_render_and_display(MetalRenderContext *render_context, PlatformRenderPushB
                     metal_draw_indexed_instances(render_encoder, MTLPrimitiveTypeTriangle, 
                             render_context->cube_outward_facing_index_buffer.buffer, array_count(cube_outward_facing_indices), 1);
                 }break;
+
+                case RenderEntryType_Text:
+                {
+                    // NOTE(joon) glyphs from every text entry are gathered into one instance buffer,
+                    // and drawn with a single draw call after all the 3D entries
+                    RenderEntryText *entry = (RenderEntryText *)((u8 *)render_push_buffer->base + consumed);
+                    TextGlyphInstance *glyphs = (TextGlyphInstance *)(entry + 1);
+                    consumed += get_render_entry_text_size(entry->glyph_count);
+
+                    metal_append_to_managed_buffer(&render_context->text_glyph_instance_buffer, glyphs, sizeof(TextGlyphInstance) * entry->glyph_count);
+                    text_glyph_count += entry->glyph_count;
+                }break;
             }
         }
 
@@ -672,6 +665,40 @@ metal_render_and_display(MetalRenderContext *render_context, PlatformRenderPushB
             metal_draw_indexed_instances(render_encoder, MTLPrimitiveTypeTriangle, 
                     render_context->cube_outward_facing_index_buffer.buffer, array_count(cube_outward_facing_indices), voxel_instance_count);
         }
+
+        if(text_glyph_count)
+        {
+            if(!render_context->glyph_atlas_texture || 
+                render_context->glyph_atlas_generation != render_push_buffer->glyph_atlas_generation)
+            {
+                if(!render_context->glyph_atlas_texture)
+                {
+                    render_context->glyph_atlas_texture = metal_create_r8_texture(render_context->device, 
+                                                                                render_push_buffer->glyph_atlas_width, 
+                                                                                render_push_buffer->glyph_atlas_height);
+                }
+
+                metal_write_r8_texture(render_context->glyph_atlas_texture, render_push_buffer->glyph_atlas_pixels, 
+                                    render_push_buffer->glyph_atlas_width, render_push_buffer->glyph_atlas_height);
+                render_context->glyph_atlas_generation = render_push_buffer->glyph_atlas_generation;
+            }
+
+            metal_flush_managed_buffer(&render_context->text_glyph_instance_buffer);
+
+            metal_set_pipeline(render_encoder, render_context->text_pipeline_state);
+            metal_set_detph_stencil_state(render_encoder, render_context->text_depth_state);
+            metal_set_cull_mode(render_encoder, MTLCullModeNone);
+
+            f32 text_per_frame_data[4] = {(f32)render_push_buffer->width, (f32)render_push_buffer->height,
+                                        (f32)render_push_buffer->glyph_atlas_width, (f32)render_push_buffer->glyph_atlas_height};
+            metal_set_vertex_bytes(render_encoder, text_per_frame_data, sizeof(text_per_frame_data), 0);
+            metal_set_vertex_buffer(render_encoder, render_context->text_glyph_instance_buffer.buffer, 0, 1);
+            metal_set_fragment_texture(render_encoder, render_context->glyph_atlas_texture, 0);
+
+            // NOTE(joon) 4 vertices per glyph, the quad corners are generated from the vertex id
+            metal_draw_non_indexed_instances(render_encoder, MTLPrimitiveTypeTriangleStrip, 0, 4, 0, text_glyph_count);
+        }
+
 #if 0
 - (void)drawIndexedPrimitives:(MTLPrimitiveType)primitiveType 
                    indexCount:(NSUInteger)indexCount 
@@ -785,6 +812,28 @@ main(void)
     platform_api.write_entire_file = debug_macos_write_entire_file;
     platform_api.free_file_memory = debug_macos_free_file_memory;
 
+    // NOTE(joon) one worker thread per core except the main thread, which also does the items while it waits for them
+    semaphore = dispatch_semaphore_create(0);
+    thread_work_queue work_queue = {};
+    work_queue.add_thread_work_queue_item = macos_add_thread_work_item;
+    work_queue.complete_all_thread_work_queue_items = macos_complete_all_thread_work_queue_items;
+
+    u32 worker_thread_count = (u32)maximum(sysconf(_SC_NPROCESSORS_ONLN) - 1, 1);
+    macos_thread *threads = (macos_thread *)malloc(sizeof(macos_thread)*worker_thread_count);
+    for(u32 thread_index = 0;
+            thread_index < worker_thread_count;
+            ++thread_index)
+    {
+        macos_thread *thread = threads + thread_index;
+        *thread = {};
+        thread->ID = thread_index + 1;
+        thread->queue = &work_queue;
+
+        pthread_t thread_id;
+        pthread_create(&thread_id, 0, thread_proc, thread);
+    }
+    platform_api.work_queue = &work_queue;
+
     PlatformMemory platform_memory = {};
 
     platform_memory.permanent_memory_size = gigabytes(1);
@@ -861,6 +910,13 @@ main(void)
     id<MTLDepthStencilState> depth_state = [device newDepthStencilStateWithDescriptor:depth_descriptor];
     [depth_descriptor release];
 
+    // NOTE(joon) text is drawn on top of everything, without touching the depth buffer
+    MTLDepthStencilDescriptor *text_depth_descriptor = [MTLDepthStencilDescriptor new];
+    text_depth_descriptor.depthCompareFunction = MTLCompareFunctionAlways;
+    text_depth_descriptor.depthWriteEnabled = false;
+    id<MTLDepthStencilState> text_depth_state = [device newDepthStencilStateWithDescriptor:text_depth_descriptor];
+    [text_depth_descriptor release];
+
     NSError *error;
     // TODO(joon) : Put the metallib file inside the app
     char metallib_path[256] = {};
@@ -924,6 +980,30 @@ main(void)
     id<MTLRenderPipelineState> line_pipeline_state = [device newRenderPipelineStateWithDescriptor:line_pipeline_descriptor
                                                                 error:&error];
 
+    id<MTLFunction> text_vertex = [shader_library newFunctionWithName:@"text_vertex"];
+    id<MTLFunction> text_frag = [shader_library newFunctionWithName:@"text_frag"];
+    MTLRenderPipelineDescriptor *text_pipeline_descriptor = [MTLRenderPipelineDescriptor new];
+    text_pipeline_descriptor.label = @"Text Pipeline";
+    text_pipeline_descriptor.vertexFunction = text_vertex;
+    text_pipeline_descriptor.fragmentFunction = text_frag;
+    text_pipeline_descriptor.sampleCount = 1;
+    text_pipeline_descriptor.rasterSampleCount = text_pipeline_descriptor.sampleCount;
+    text_pipeline_descriptor.rasterizationEnabled = true;
+    text_pipeline_descriptor.inputPrimitiveTopology = MTLPrimitiveTopologyClassTriangle;
+    text_pipeline_descriptor.colorAttachments[0].pixelFormat = MTLPixelFormatBGRA8Unorm;
+    text_pipeline_descriptor.colorAttachments[0].writeMask = MTLColorWriteMaskAll;
+    text_pipeline_descriptor.colorAttachments[0].blendingEnabled = true;
+    text_pipeline_descriptor.colorAttachments[0].rgbBlendOperation = MTLBlendOperationAdd;
+    text_pipeline_descriptor.colorAttachments[0].alphaBlendOperation = MTLBlendOperationAdd;
+    text_pipeline_descriptor.colorAttachments[0].sourceRGBBlendFactor = MTLBlendFactorSourceAlpha;
+    text_pipeline_descriptor.colorAttachments[0].sourceAlphaBlendFactor = MTLBlendFactorOne;
+    text_pipeline_descriptor.colorAttachments[0].destinationRGBBlendFactor = MTLBlendFactorOneMinusSourceAlpha;
+    text_pipeline_descriptor.colorAttachments[0].destinationAlphaBlendFactor = MTLBlendFactorOneMinusSourceAlpha;
+    text_pipeline_descriptor.depthAttachmentPixelFormat = view.depthStencilPixelFormat;
+
+    id<MTLRenderPipelineState> text_pipeline_state = [device newRenderPipelineStateWithDescriptor:text_pipeline_descriptor
+                                                                error:&error];
+
     check_ns_error(error);
 
     id<MTLCommandQueue> command_queue = [device newCommandQueue];
@@ -936,9 +1016,12 @@ main(void)
     metal_render_context.voxel_pipeline_state = voxel_pipeline_state;
     metal_render_context.cube_pipeline_state = cube_pipeline_state;
     metal_render_context.line_pipeline_state = line_pipeline_state;
+    metal_render_context.text_pipeline_state = text_pipeline_state;
+    metal_render_context.text_depth_state = text_depth_state;
     // TODO(joon) More robust way to manage these buffers??(i.e asset system?)
     metal_render_context.voxel_position_buffer = metal_create_managed_buffer(device, megabytes(16));
     metal_render_context.voxel_color_buffer = metal_create_managed_buffer(device, megabytes(4));
+    metal_render_context.text_glyph_instance_buffer = metal_create_managed_buffer(device, megabytes(1));
     metal_render_context.cube_outward_facing_index_buffer = metal_create_managed_buffer(device, sizeof(u32) * array_count(cube_outward_facing_indices));
     metal_append_to_managed_buffer(&metal_render_context.cube_outward_facing_index_buffer, 
                                     cube_outward_facing_indices, 
@@ -958,6 +1041,8 @@ main(void)
     platform_render_push_buffer.base = (u8 *)malloc(platform_render_push_buffer.total_size);
     // TODO(joon) Make sure to update this value whenever we resize the window
     platform_render_push_buffer.width_over_height = (f32)window_width / (f32)window_height;
+    platform_render_push_buffer.width = window_width;
+    platform_render_push_buffer.height = window_height;
 
     [app activateIgnoringOtherApps:YES];
     [app run];
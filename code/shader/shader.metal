@@ -158,3 +158,65 @@ cube_frag(CubeVertexOutput vertex_output [[stage_in]])
     return result;
 }
 
+
+struct TextPerFrameData
+{
+    float2 screen_dim; // in pixels
+    float2 atlas_dim; // in texels
+};
+
+// NOTE(joon) should match with the TextGlyphInstance in hb_render_group.h
+struct TextGlyphInstance
+{
+    short2 p;
+    ushort2 atlas_p;
+    ushort2 dim;
+    uint color;
+};
+
+struct TextVertexOutput
+{
+    float4 clip_p [[position]];
+    float2 uv;
+    float4 color [[flat]];
+};
+
+// NOTE(joon) drawn as a triangle strip with 4 vertices per instance, 
+// so the corner of the quad can be derived from the vertex id
+vertex TextVertexOutput
+text_vertex(uint vertex_ID [[vertex_id]],
+            uint instance_ID [[instance_id]],
+            constant TextPerFrameData *per_frame_data [[buffer(0)]],
+            const device TextGlyphInstance *glyphs [[buffer(1)]])
+{
+    TextVertexOutput result = {};
+
+    TextGlyphInstance glyph = glyphs[instance_ID];
+    float2 corner = float2(vertex_ID >> 1, vertex_ID & 1);
+
+    float2 pixel_p = float2(glyph.p) + corner * float2(glyph.dim);
+    // NOTE(joon) pixel space has y going down, NDC has y going up
+    float2 ndc_p = 2.0f * (pixel_p / per_frame_data->screen_dim) - 1.0f;
+    ndc_p.y = -ndc_p.y;
+
+    result.clip_p = float4(ndc_p, 0.0f, 1.0f);
+    result.uv = (float2(glyph.atlas_p) + corner * float2(glyph.dim)) / per_frame_data->atlas_dim;
+    result.color = unpack_unorm4x8_to_float(glyph.color);
+
+    return result;
+}
+
+fragment float4 
+text_frag(TextVertexOutput vertex_output [[stage_in]],
+          texture2d<float> glyph_atlas [[texture(0)]])
+{
+    // NOTE(joon) glyphs are rasterized at the exact pixel size, so no filtering is needed
+    constexpr sampler atlas_sampler(coord::normalized, filter::nearest, address::clamp_to_edge);
+
+    float coverage = glyph_atlas.sample(atlas_sampler, vertex_output.uv).r;
+
+    float4 result = vertex_output.color;
+    result.a *= coverage;
+
+    return result;
+}